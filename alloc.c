@@ -0,0 +1,322 @@
+/*******************************************************************************
+ * CbAlloc -- Allocation hooks with memory statistics
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_CBC_PLAT_WNDS)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#else
+#include <malloc.h>
+#endif
+#include "alloc.h"
+#include "error_handling.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+static CbAllocStats subsystem_stats[CB_ALLOC_SUBSYSTEM_COUNT];
+static uint64_t total_live = 0;
+static uint64_t total_peak = 0;
+static uint64_t quota_limit = 0; // maximum of live bytes (0: no quota)
+static bool quota_extended = false; // quota was extended for a handler
+
+static const char* subsystem_names[CB_ALLOC_SUBSYSTEM_COUNT] = {
+    "values", "arrays", "strings", "symbols", "ast", "stacks"
+};
+
+static size_t cb_alloc_size(void* memory);
+static void cb_alloc_account(void* memory, enum cb_alloc_subsystem subsystem);
+static void cb_alloc_update_peak(CbAllocStats* stats);
+static void cb_alloc_exceed_quota(bool failed);
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Allocate memory (malloc)
+// -----------------------------------------------------------------------------
+void* cb_alloc(size_t size, enum cb_alloc_subsystem subsystem)
+{
+    void* memory = malloc(size);
+    cb_alloc_account(memory, subsystem);
+    
+    return memory;
+}
+
+// -----------------------------------------------------------------------------
+// Allocate zeroed memory (calloc)
+// -----------------------------------------------------------------------------
+void* cb_alloc_zeroed(size_t count, size_t size,
+                      enum cb_alloc_subsystem subsystem)
+{
+    void* memory = calloc(count, size);
+    cb_alloc_account(memory, subsystem);
+    
+    return memory;
+}
+
+// -----------------------------------------------------------------------------
+// Resize memory (realloc)
+//
+//    Resizing isn't counted as allocation, only growth adds to the bytes.
+// -----------------------------------------------------------------------------
+void* cb_realloc(void* memory, size_t size, enum cb_alloc_subsystem subsystem)
+{
+    if (memory == NULL)
+        return cb_alloc(size, subsystem);
+    
+    size_t old_size = cb_alloc_size(memory);
+    void* result    = realloc(memory, size);
+    if (result == NULL)
+        return NULL; // the old memory is still allocated
+    
+    size_t new_size     = cb_alloc_size(result);
+    CbAllocStats* stats = &subsystem_stats[subsystem];
+    
+    if (new_size > old_size)
+        stats->bytes += new_size - old_size;
+    
+    stats->live += new_size - old_size; // wraps correctly, if it shrinks
+    total_live  += new_size - old_size;
+    cb_alloc_update_peak(stats);
+    
+    if (quota_limit && total_live > quota_limit)
+        cb_alloc_exceed_quota(false);
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Duplicate a string (strdup)
+// -----------------------------------------------------------------------------
+char* cb_alloc_strdup(const char* string, enum cb_alloc_subsystem subsystem)
+{
+    size_t length = strlen(string) + 1;
+    char* result  = (char*) cb_alloc(length, subsystem);
+    memcpy(result, string, length);
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Account memory allocated by malloc(), which is passed to a subsystem
+// -----------------------------------------------------------------------------
+void cb_alloc_adopt(void* memory, enum cb_alloc_subsystem subsystem)
+{
+    cb_alloc_account(memory, subsystem);
+}
+
+// -----------------------------------------------------------------------------
+// Free memory (free)
+// -----------------------------------------------------------------------------
+void cb_free(void* memory, enum cb_alloc_subsystem subsystem)
+{
+    if (memory == NULL)
+        return;
+    
+    cb_alloc_account_free(cb_alloc_size(memory), subsystem);
+    free(memory);
+}
+
+// -----------------------------------------------------------------------------
+// Account an allocation of the given size by another allocator
+// -----------------------------------------------------------------------------
+void cb_alloc_account_size(size_t size, enum cb_alloc_subsystem subsystem)
+{
+    CbAllocStats* stats = &subsystem_stats[subsystem];
+    
+    stats->allocations++;
+    stats->bytes += size;
+    stats->live  += size;
+    total_live   += size;
+    
+    cb_alloc_update_peak(stats);
+    
+    if (quota_limit && total_live > quota_limit)
+        cb_alloc_exceed_quota(false);
+}
+
+// -----------------------------------------------------------------------------
+// Account a free of the given size by another allocator
+// -----------------------------------------------------------------------------
+void cb_alloc_account_free(size_t size, enum cb_alloc_subsystem subsystem)
+{
+    CbAllocStats* stats = &subsystem_stats[subsystem];
+    
+    stats->frees++;
+    stats->live -= size;
+    total_live  -= size;
+}
+
+// -----------------------------------------------------------------------------
+// Start a quota of bytes, which may be allocated in addition to the live bytes
+// -----------------------------------------------------------------------------
+void cb_alloc_start_quota(uint64_t quota)
+{
+    quota_limit    = (quota) ? total_live + quota : 0;
+    quota_extended = false;
+}
+
+// -----------------------------------------------------------------------------
+// Stop the quota
+// -----------------------------------------------------------------------------
+void cb_alloc_stop_quota()
+{
+    quota_limit = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Check if the given count of bytes may be allocated (false and an error is
+// set, if the quota would be exceeded)
+//
+//    The size is passed as double, so that sizes computed by scripts don't
+//    overflow.
+// -----------------------------------------------------------------------------
+bool cb_alloc_reserve(double size)
+{
+    if (quota_limit == 0 || (double) total_live + size <= (double) quota_limit)
+        return true;
+    
+    cb_alloc_exceed_quota(true);
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Get the statistics of a subsystem
+// -----------------------------------------------------------------------------
+void cb_alloc_get_stats(enum cb_alloc_subsystem subsystem, CbAllocStats* stats)
+{
+    *stats = subsystem_stats[subsystem];
+}
+
+// -----------------------------------------------------------------------------
+// Get the statistics of all subsystems (the peak is the peak of the sum)
+// -----------------------------------------------------------------------------
+void cb_alloc_get_total_stats(CbAllocStats* stats)
+{
+    memset(stats, 0, sizeof(CbAllocStats));
+    
+    int i = 0;
+    for (; i < CB_ALLOC_SUBSYSTEM_COUNT; i++)
+    {
+        stats->allocations += subsystem_stats[i].allocations;
+        stats->frees       += subsystem_stats[i].frees;
+        stats->bytes       += subsystem_stats[i].bytes;
+    }
+    
+    stats->live = total_live;
+    stats->peak = total_peak;
+}
+
+// -----------------------------------------------------------------------------
+// Get the name of a subsystem
+// -----------------------------------------------------------------------------
+const char* cb_alloc_get_subsystem_name(enum cb_alloc_subsystem subsystem)
+{
+    return subsystem_names[subsystem];
+}
+
+// -----------------------------------------------------------------------------
+// Print the statistics of all subsystems as table
+// -----------------------------------------------------------------------------
+void cb_alloc_print_stats(FILE* output)
+{
+    CbAllocStats stats;
+    
+    fprintf(output, "\nMemory statistics\n");
+    fprintf(output, "%-10s %12s %12s %12s %12s %12s\n", "Subsystem",
+            "Allocs", "Frees", "Bytes", "Live", "Peak");
+    
+    int i = 0;
+    for (; i <= CB_ALLOC_SUBSYSTEM_COUNT; i++)
+    {
+        if (i < CB_ALLOC_SUBSYSTEM_COUNT)
+            cb_alloc_get_stats((enum cb_alloc_subsystem) i, &stats);
+        else
+            cb_alloc_get_total_stats(&stats);
+        
+        fprintf(output, "%-10s %12llu %12llu %12llu %12llu %12llu\n",
+                (i < CB_ALLOC_SUBSYSTEM_COUNT) ? subsystem_names[i] : "total",
+                (unsigned long long) stats.allocations,
+                (unsigned long long) stats.frees,
+                (unsigned long long) stats.bytes,
+                (unsigned long long) stats.live,
+                (unsigned long long) stats.peak);
+    }
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Get the usable size of allocated memory (internal)
+// -----------------------------------------------------------------------------
+static size_t cb_alloc_size(void* memory)
+{
+#if defined(_CBC_PLAT_WNDS)
+    return _msize(memory);
+#elif defined(__APPLE__)
+    return malloc_size(memory);
+#else
+    return malloc_usable_size(memory);
+#endif
+}
+
+// -----------------------------------------------------------------------------
+// Account an allocation (internal)
+// -----------------------------------------------------------------------------
+static void cb_alloc_account(void* memory, enum cb_alloc_subsystem subsystem)
+{
+    if (memory == NULL)
+        return;
+    
+    cb_alloc_account_size(cb_alloc_size(memory), subsystem);
+    
+}
+
+// -----------------------------------------------------------------------------
+// Update the peaks of a subsystem and of all subsystems (internal)
+// -----------------------------------------------------------------------------
+static void cb_alloc_update_peak(CbAllocStats* stats)
+{
+    if (stats->live > stats->peak)
+        stats->peak = stats->live;
+    if (total_live > total_peak)
+        total_peak = total_live;
+}
+
+// -----------------------------------------------------------------------------
+// Raise the error of an exceeded quota (internal)
+//
+//    A failed reservation raises the error, unless there is an uncatched error
+//    already. An allocation, which succeeded, raises it only, if no error is
+//    set, so that an exception block is able to release memory. The first
+//    time, the quota is extended to leave the exception block some headroom.
+// -----------------------------------------------------------------------------
+static void cb_alloc_exceed_quota(bool failed)
+{
+    if (!cb_error_handling_is_initialized())
+        return;
+    
+    if (cb_error_is_set() && !(failed && cb_error_is_catched()))
+        return;
+    
+    cb_error_set(CB_ERR_CODE_MEMORYQUOTA);
+    
+    if (!quota_extended)
+    {
+        quota_limit    = ((total_live > quota_limit) ? total_live : quota_limit)
+                         + CB_ALLOC_QUOTA_HEADROOM;
+        quota_extended = true;
+    }
+}
@@ -0,0 +1,86 @@
+/*******************************************************************************
+ * CbAlloc -- Allocation hooks with memory statistics
+ *
+ *            All memory of values, arrays and hashes, strings of values,
+ *            symbols, syntax-trees and stacks is allocated and freed through
+ *            these hooks, which count the allocations and the allocated,
+ *            live and peak live bytes per subsystem. Sizes are the usable
+ *            sizes reported by the C library, so the statistics include the
+ *            allocator's rounding.
+ *
+ *            Memory allocated elsewhere, whose ownership passes to a
+ *            subsystem (e.g. the buffer of a new string value), is accounted
+ *            with cb_alloc_adopt(), so that freeing it balances. Memory of
+ *            other allocators (see pool.h) is accounted by its size.
+ *
+ *            An execution may have a quota of bytes, which may be allocated
+ *            in addition to the live bytes at its start. Allocations, whose
+ *            size depends on the script (like growing arrays or strings), ask
+ *            cb_alloc_reserve() first and fail, if the quota would be
+ *            exceeded. Every other allocation succeeds, but exceeding the
+ *            quota raises the error as well, if no error is set, so the
+ *            execution stops at the next node. Either way the error can be
+ *            catched by an exception block, which may release memory. To run
+ *            the handler, the quota is extended once by
+ *            CB_ALLOC_QUOTA_HEADROOM bytes beyond the live bytes, when the
+ *            error is raised.
+ ******************************************************************************/
+
+#ifndef ALLOC_H
+#define ALLOC_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// bytes granted beyond the quota to handle an exceeded quota
+#define CB_ALLOC_QUOTA_HEADROOM (64 * 1024)
+
+// subsystems owning memory
+enum cb_alloc_subsystem
+{
+    CB_ALLOC_VALUE = 0,             // value structs
+    CB_ALLOC_ARRAY,                 // arrays and hashes
+    CB_ALLOC_STRING,                // strings of values
+    CB_ALLOC_SYMBOL,                // symbols, scopes, symbol-tables, functions
+    CB_ALLOC_AST,                   // syntax-tree nodes and their strings
+    CB_ALLOC_STACK,                 // stacks and stack items
+    CB_ALLOC_SUBSYSTEM_COUNT
+};
+
+// statistics of a subsystem (or of all subsystems)
+typedef struct
+{
+    uint64_t allocations;           // count of allocations
+    uint64_t frees;                 // count of frees
+    uint64_t bytes;                 // allocated bytes in total
+    uint64_t live;                  // currently allocated bytes
+    uint64_t peak;                  // maximum of live bytes
+} CbAllocStats;
+
+
+// interface functions
+void* cb_alloc(size_t size, enum cb_alloc_subsystem subsystem);
+void* cb_alloc_zeroed(size_t count, size_t size,
+                      enum cb_alloc_subsystem subsystem);
+void* cb_realloc(void* memory, size_t size, enum cb_alloc_subsystem subsystem);
+char* cb_alloc_strdup(const char* string, enum cb_alloc_subsystem subsystem);
+void cb_alloc_adopt(void* memory, enum cb_alloc_subsystem subsystem);
+void cb_free(void* memory, enum cb_alloc_subsystem subsystem);
+void cb_alloc_account_size(size_t size, enum cb_alloc_subsystem subsystem);
+void cb_alloc_account_free(size_t size, enum cb_alloc_subsystem subsystem);
+
+void cb_alloc_start_quota(uint64_t quota);
+void cb_alloc_stop_quota();
+bool cb_alloc_reserve(double size);
+
+void cb_alloc_get_stats(enum cb_alloc_subsystem subsystem,
+                        CbAllocStats* stats);
+void cb_alloc_get_total_stats(CbAllocStats* stats);
+const char* cb_alloc_get_subsystem_name(enum cb_alloc_subsystem subsystem);
+void cb_alloc_print_stats(FILE* output);
+
+
+#endif // ALLOC_H
@@ -4,8 +4,12 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <limits.h>
 #include <assert.h>
 #include "array.h"
+#include "alloc.h"
+#include "pool.h"
+#include "value.h"
 
 
 // #############################################################################
@@ -15,17 +19,34 @@
 struct CbArray
 {
     size_t count;
-    CbArrayItem* elements;
-    int element_size;
-    int block_size;
-    int alloc_size;
+    size_t capacity;                // allocated elements
+    size_t block_size;              // minimum count of allocated elements
+    unsigned int references;        // count of owners sharing this array
+    enum cb_array_layout layout;    // storage layout
+    bool packable;                  // may use a dense layout
+    
+    union
+    {
+        CbArrayItem* elements;      // CB_ARRAY_LAYOUT_BOXED
+        CbNumeric* numerics;        // CB_ARRAY_LAYOUT_NUMERIC
+        unsigned char* bits;        // CB_ARRAY_LAYOUT_BOOLEAN
+    };
+    
     bool element_ownership;
     CbArrayItemDestructor element_destructor_cb;
     CbArrayItemCopy element_copy_cb;
 };
 
 static bool cb_array_is_full(CbArray* array);
-static bool cb_array_increase_size(CbArray* array, unsigned int blocks);
+static bool cb_array_increase_size(CbArray* array, size_t min_capacity);
+static size_t cb_array_storage_size(enum cb_array_layout layout,
+                                    size_t capacity);
+static bool cb_array_fits_layout(CbArray* array, const CbArrayItem item);
+static void cb_array_choose_layout(CbArray* array, const CbArrayItem item);
+static void cb_array_unpack(CbArray* array);
+static void cb_array_store(CbArray* array, int index, const CbArrayItem item);
+static void cb_array_move(CbArray* array, int destination, int source,
+                          size_t count);
 
 
 // #############################################################################
@@ -37,13 +58,19 @@ static bool cb_array_increase_size(CbArray* array, unsigned int blocks);
 // -----------------------------------------------------------------------------
 CbArray* cb_array_create()
 {
-    CbArray* array      = (CbArray*) malloc(sizeof(CbArray));
+    CbArray* array      = (CbArray*) cb_pool_alloc(sizeof(CbArray),
+                                                   CB_ALLOC_ARRAY);
     array->count        = 0;
     // default block size is the size of 16 elements
-    array->element_size = sizeof(CbArrayItem);
-    array->block_size   = array->element_size * 16;
-    array->elements     = (CbArrayItem*) malloc(array->block_size);
-    array->alloc_size   = array->block_size;
+    array->block_size   = 16;
+    array->capacity     = array->block_size;
+    array->references   = 1;
+    array->layout       = CB_ARRAY_LAYOUT_BOXED;
+    array->packable     = false;
+    array->elements     = (CbArrayItem*) cb_alloc(cb_array_storage_size(
+                                                    array->layout,
+                                                    array->capacity),
+                                                  CB_ALLOC_ARRAY);
     
     // array should not own its elements by default, since there is no
     // destructor callback available yet
@@ -66,12 +93,49 @@ CbArray* cb_array_create_with_ownership(CbArrayItemDestructor destructor_cb,
     return array;
 }
 
+// -----------------------------------------------------------------------------
+// Constructor (array of codeblock-values, that may use a dense layout)
+// -----------------------------------------------------------------------------
+CbArray* cb_array_create_valarray()
+{
+    CbArray* array = cb_array_create_with_ownership(
+                         (CbArrayItemDestructor) cb_value_free,
+                         (CbArrayItemCopy) cb_value_copy);
+    array->packable = true;
+    
+    return array;
+}
+
+// -----------------------------------------------------------------------------
+// Constructor (numeric array with the given count of zero-elements)
+// -----------------------------------------------------------------------------
+CbArray* cb_array_create_numeric(size_t count)
+{
+    CbArray* array = cb_array_create_valarray();
+    
+    cb_free(array->elements, CB_ALLOC_ARRAY);
+    array->layout   = CB_ARRAY_LAYOUT_NUMERIC;
+    array->capacity = (count > 0) ? count : array->block_size;
+    array->numerics = (CbNumeric*) cb_alloc_zeroed(array->capacity,
+                                                   sizeof(CbNumeric),
+                                                   CB_ALLOC_ARRAY);
+    array->count    = count;
+    
+    return array;
+}
+
 // -----------------------------------------------------------------------------
 // Destructur
 // -----------------------------------------------------------------------------
 void cb_array_free(CbArray* array)
 {
-    if (array->element_ownership) // if array owns its elements -> free all
+    // array is still referenced by another owner
+    if (--array->references > 0)
+        return;
+    
+    // if array owns its elements -> free all
+    // (elements of dense layouts are not separately allocated)
+    if (array->element_ownership && array->layout == CB_ARRAY_LAYOUT_BOXED)
     {
         int i = 0;
         for (; i < array->count; i++)
@@ -79,8 +143,8 @@ void cb_array_free(CbArray* array)
                 array->element_destructor_cb(array->elements[i]);
     }
     
-    free(array->elements);
-    free(array);
+    cb_free(array->elements, CB_ALLOC_ARRAY);
+    cb_pool_free(array, sizeof(CbArray), CB_ALLOC_ARRAY);
 }
 
 // -----------------------------------------------------------------------------
@@ -88,21 +152,35 @@ void cb_array_free(CbArray* array)
 // -----------------------------------------------------------------------------
 CbArray* cb_array_copy(CbArray* array)
 {
-    CbArray* new_array               = (CbArray*) malloc(sizeof(CbArray));
+    size_t size                      = cb_array_storage_size(array->layout,
+                                                             array->capacity);
+    CbArray* new_array               = (CbArray*) cb_pool_alloc(
+                                           sizeof(CbArray), CB_ALLOC_ARRAY);
     new_array->count                 = array->count;
-    new_array->element_size          = array->element_size;
+    new_array->capacity              = array->capacity;
     new_array->block_size            = array->block_size;
-    new_array->alloc_size            = array->alloc_size;
-    new_array->elements              = (CbArrayItem*) malloc(array->alloc_size);
+    new_array->references            = 1;
+    new_array->layout                = array->layout;
+    new_array->packable              = array->packable;
+    new_array->elements              = (CbArrayItem*) cb_alloc(size,
+                                                           CB_ALLOC_ARRAY);
     new_array->element_ownership     = array->element_ownership;
     new_array->element_destructor_cb = array->element_destructor_cb;
     new_array->element_copy_cb       = array->element_copy_cb;
     
+    // dense layouts don't hold any references -> copy the whole buffer
+    if (array->layout != CB_ARRAY_LAYOUT_BOXED)
+    {
+        memcpy(new_array->elements, array->elements, size);
+        return new_array;
+    }
+    
     // apply all values within array as well
     int i = 0;
     for (; i < array->count; i++)
     {
-        if (array->element_ownership) // copy values if array owns its elements
+        if (array->element_ownership && array->elements[i] != NULL)
+            // copy values if array owns its elements
             new_array->elements[i] = array->element_copy_cb(array->elements[i]);
         else
             new_array->elements[i] = array->elements[i];
@@ -111,6 +189,25 @@ CbArray* cb_array_copy(CbArray* array)
     return new_array;
 }
 
+// -----------------------------------------------------------------------------
+// Share array with another owner
+// 
+//    The array is freed after cb_array_free() was called for every owner.
+// -----------------------------------------------------------------------------
+CbArray* cb_array_share(CbArray* array)
+{
+    array->references++;
+    return array;
+}
+
+// -----------------------------------------------------------------------------
+// Check if array is shared by more than one owner
+// -----------------------------------------------------------------------------
+bool cb_array_is_shared(CbArray* array)
+{
+    return array->references > 1;
+}
+
 // -----------------------------------------------------------------------------
 // Get count of elements in array
 // -----------------------------------------------------------------------------
@@ -119,6 +216,14 @@ size_t cb_array_get_count(CbArray* array)
     return array->count;
 }
 
+// -----------------------------------------------------------------------------
+// Get storage layout of array
+// -----------------------------------------------------------------------------
+enum cb_array_layout cb_array_get_layout(CbArray* array)
+{
+    return array->layout;
+}
+
 // -----------------------------------------------------------------------------
 // Get element ownership attribute of array
 // -----------------------------------------------------------------------------
@@ -146,52 +251,125 @@ void cb_array_enable_element_ownership(CbArray* array,
 // -----------------------------------------------------------------------------
 void cb_array_disable_element_ownership(CbArray* array)
 {
+    // elements of dense layouts only exist as long as the array owns them
+    cb_array_unpack(array);
+    array->packable = false;
+    
     array->element_ownership     = false;
     array->element_destructor_cb = NULL;
     array->element_copy_cb       = NULL;
 }
 
+// -----------------------------------------------------------------------------
+// Reserve memory for at least the given count of elements
+// -----------------------------------------------------------------------------
+bool cb_array_reserve(CbArray* array, size_t capacity)
+{
+    if (capacity <= array->capacity)
+        return true;
+    
+    size_t old_size = cb_array_storage_size(array->layout, array->capacity);
+    size_t new_size = cb_array_storage_size(array->layout, capacity);
+    
+    // the growth of the element buffer is limited by the memory quota
+    if (!cb_alloc_reserve((double) new_size - (double) old_size))
+        return false;
+    
+    CbArrayItem* temp = cb_realloc(array->elements, new_size, CB_ALLOC_ARRAY);
+    if (temp == NULL)
+        return false;
+    
+    array->elements = temp;
+    array->capacity = capacity;
+    
+    return true;
+}
+
 // -----------------------------------------------------------------------------
 // Append element to array
 // -----------------------------------------------------------------------------
 bool cb_array_append(CbArray* array, const CbArrayItem item)
 {
-    if (cb_array_is_full(array))
-        cb_array_increase_size(array, 1);
+    if (array->count == 0)
+        cb_array_choose_layout(array, item);
+    
+    if (cb_array_is_full(array) &&
+        !cb_array_increase_size(array, array->count + 1))
+    {
+        if (array->element_ownership && item != NULL)
+            array->element_destructor_cb(item);
+        
+        return false;
+    }
     
     array->count++;
-    array->elements[array->count - 1] = NULL; // clear allocated memory
+    // clear allocated memory
+    cb_array_store(array, (array->count - 1), NULL);
     
     return cb_array_set(array, (array->count - 1), item);
 }
 
+// -----------------------------------------------------------------------------
+// Append several elements to array
+// -----------------------------------------------------------------------------
+bool cb_array_append_many(CbArray* array, const CbArrayItem* items,
+                          size_t count)
+{
+    if (count == 0)
+        return true;
+    
+    if (array->count == 0)
+        cb_array_choose_layout(array, items[0]);
+    
+    // allocate once for all elements
+    if (!cb_array_reserve(array, array->count + count))
+    {
+        if (array->element_ownership)
+        {
+            size_t i = 0;
+            for (; i < count; i++)
+                if (items[i] != NULL)
+                    array->element_destructor_cb(items[i]);
+        }
+        
+        return false;
+    }
+    
+    bool result = true;
+    size_t i    = 0;
+    for (; i < count; i++)
+        result = cb_array_append(array, items[i]) && result;
+    
+    return result;
+}
+
 // -----------------------------------------------------------------------------
 // Insert element in array
 // -----------------------------------------------------------------------------
 bool cb_array_insert(CbArray* array, const CbArrayItem item, int index)
 {
-    bool result = false;
-    
     if (index >= array->count)
         return cb_array_append(array, item);
     
-    if (cb_array_is_full(array))
-        cb_array_increase_size(array, 1);
+    if (!cb_array_fits_layout(array, item))
+        cb_array_unpack(array);
     
-    array->count++;
-    array->elements[array->count - 1] = NULL; // clear allocated memory
+    if (cb_array_is_full(array) &&
+        !cb_array_increase_size(array, array->count + 1))
+    {
+        if (array->element_ownership && item != NULL)
+            array->element_destructor_cb(item);
+        
+        return false;
+    }
     
-    void* source      = array->elements + index;
-    void* destination = array->elements + index + 1;
-    size_t size       = (array->count - index) * array->element_size;
-    memmove(destination, source, size);
+    array->count++;
+    cb_array_move(array, index + 1, index, array->count - (index + 1));
     
-    bool ownership_backup    = array->element_ownership;
-    array->element_ownership = false; // temporarily disable element ownership
-    result = cb_array_set(array, index, item);
-    array->element_ownership = ownership_backup; // restore ownership attribute
+    // the previous element was moved -> overwrite without freeing it
+    cb_array_store(array, index, item);
     
-    return result;
+    return true;
 }
 
 // -----------------------------------------------------------------------------
@@ -202,13 +380,12 @@ bool cb_array_remove(CbArray* array, int index)
     if (index >= array->count)
         return false;
     
-    if (!cb_array_set(array, index, NULL))
+    // free element (dense layouts do not have to free anything)
+    if (array->layout == CB_ARRAY_LAYOUT_BOXED &&
+        !cb_array_set(array, index, NULL))
         return false;
     
-    void* source      = array->elements + index + 1;
-    void* destination = array->elements + index;
-    size_t size       = (array->count - (index + 1)) * array->element_size;
-    memmove(destination, source, size);
+    cb_array_move(array, index, index + 1, array->count - (index + 1));
     
     array->count--;
     
@@ -228,28 +405,98 @@ bool cb_array_set(CbArray* array, int index, const CbArrayItem item)
         return false;
     }
     
+    // fall back to the boxed layout on the first heterogeneous store
+    if (!cb_array_fits_layout(array, item))
+        cb_array_unpack(array);
+    
     // free previous element, if necessary
-    if (array->element_ownership && array->elements[index] != NULL)
+    if (array->layout == CB_ARRAY_LAYOUT_BOXED &&
+        array->element_ownership && array->elements[index] != NULL)
         array->element_destructor_cb(array->elements[index]);
     
-    array->elements[index] = item;
+    cb_array_store(array, index, item);
     return true;
 }
 
 // -----------------------------------------------------------------------------
 // Get element in array
+// 
+//    NOTE: Elements of dense layouts don't exist as items, so they can't be
+//          fetched by this function (see cb_array_get_value()). Without a
+//          destination it only checks the index.
 // -----------------------------------------------------------------------------
 bool cb_array_get(CbArray* array, int index, CbArrayItem* destination)
 {
     if (array->count <= index)
         return false;
     
-    if (destination != NULL)
-        *destination = array->elements[index];
+    if (destination == NULL)
+        return true;
     
+    if (array->layout != CB_ARRAY_LAYOUT_BOXED)
+    {
+        *destination = NULL;
+        return false;
+    }
+    
+    *destination = array->elements[index];
     return true;
 }
 
+// -----------------------------------------------------------------------------
+// Get a codeblock-value of an array of codeblock-values
+//
+//    The returned value is owned by the caller: elements of dense layouts are
+//    created from the packed storage and boxed elements are shared. NULL is
+//    returned, if the index is out of bounds or the element is empty.
+// -----------------------------------------------------------------------------
+CbValue* cb_array_get_value(CbArray* array, int index)
+{
+    if (array->count <= index)
+        return NULL;
+    
+    switch (array->layout)
+    {
+        case CB_ARRAY_LAYOUT_NUMERIC:
+            return cb_numeric_create(array->numerics[index]);
+        
+        case CB_ARRAY_LAYOUT_BOOLEAN:
+            return cb_boolean_create((array->bits[index / CHAR_BIT] >>
+                                      (index % CHAR_BIT)) & 1);
+        
+        case CB_ARRAY_LAYOUT_BOXED:
+        default:
+            if (array->elements[index] == NULL)
+                return NULL;
+            
+            return cb_value_share(array->elements[index]);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Get the contiguous buffer of a numeric array
+// (NULL, if the array doesn't use the numeric layout)
+// -----------------------------------------------------------------------------
+const CbNumeric* cb_array_get_numeric_data(CbArray* array)
+{
+    if (array->layout != CB_ARRAY_LAYOUT_NUMERIC)
+        return NULL;
+    
+    return array->numerics;
+}
+
+// -----------------------------------------------------------------------------
+// Get the contiguous buffer of a numeric array for modification
+// (NULL, if the array doesn't use the numeric layout)
+// -----------------------------------------------------------------------------
+CbNumeric* cb_array_get_numeric_data_mutable(CbArray* array)
+{
+    if (array->layout != CB_ARRAY_LAYOUT_NUMERIC)
+        return NULL;
+    
+    return array->numerics;
+}
+
 
 // #############################################################################
 // internal functions
@@ -260,19 +507,186 @@ bool cb_array_get(CbArray* array, int index, CbArrayItem* destination)
 // -----------------------------------------------------------------------------
 static bool cb_array_is_full(CbArray* array)
 {
-    return ((array->count * array->element_size) >= array->alloc_size);
+    return array->count >= array->capacity;
 }
 
 // -----------------------------------------------------------------------------
 // Increase array allocation size
+// 
+//    The capacity is doubled, so that appending n elements only reallocates
+//    O(log n) times.
 // -----------------------------------------------------------------------------
-static bool cb_array_increase_size(CbArray* array, unsigned int blocks)
+static bool cb_array_increase_size(CbArray* array, size_t min_capacity)
 {
-    size_t new_size   = array->alloc_size + (array->block_size * blocks);
-    CbArrayItem* temp = realloc(array->elements, new_size);
-    if (temp == NULL)
-        return false;
+    size_t new_capacity = array->capacity * 2;
+    if (new_capacity < array->block_size)
+        new_capacity = array->block_size;
+    if (new_capacity < min_capacity)
+        new_capacity = min_capacity;
+    
+    return cb_array_reserve(array, new_capacity);
+}
+
+// -----------------------------------------------------------------------------
+// Size of the element buffer for the given layout and capacity in bytes
+// -----------------------------------------------------------------------------
+static size_t cb_array_storage_size(enum cb_array_layout layout,
+                                    size_t capacity)
+{
+    switch (layout)
+    {
+        case CB_ARRAY_LAYOUT_NUMERIC:
+            return capacity * sizeof(CbNumeric);
+        
+        case CB_ARRAY_LAYOUT_BOOLEAN:
+            return (capacity + CHAR_BIT - 1) / CHAR_BIT;
+        
+        case CB_ARRAY_LAYOUT_BOXED:
+        default:
+            return capacity * sizeof(CbArrayItem);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Check if an item can be stored in the current layout of the array
+// -----------------------------------------------------------------------------
+static bool cb_array_fits_layout(CbArray* array, const CbArrayItem item)
+{
+    switch (array->layout)
+    {
+        case CB_ARRAY_LAYOUT_NUMERIC:
+            return item != NULL && cb_value_is_type(item, CB_VT_NUMERIC) &&
+                   !cb_numeric_is_float(item);
+        
+        case CB_ARRAY_LAYOUT_BOOLEAN:
+            return item != NULL && cb_value_is_type(item, CB_VT_BOOLEAN);
+        
+        case CB_ARRAY_LAYOUT_BOXED:
+        default:
+            return true;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Choose the layout of an empty array by the type of its first element
+// -----------------------------------------------------------------------------
+static void cb_array_choose_layout(CbArray* array, const CbArrayItem item)
+{
+    assert(array->count == 0);
+    
+    enum cb_array_layout layout = CB_ARRAY_LAYOUT_BOXED;
+    
+    if (array->packable && item != NULL)
+    {
+        if (cb_value_is_type(item, CB_VT_NUMERIC) && !cb_numeric_is_float(item))
+            layout = CB_ARRAY_LAYOUT_NUMERIC;
+        else if (cb_value_is_type(item, CB_VT_BOOLEAN))
+            layout = CB_ARRAY_LAYOUT_BOOLEAN;
+    }
+    
+    if (layout == array->layout)
+        return;
     
-    array->elements   = temp;
-    array->alloc_size = new_size;
+    cb_free(array->elements, CB_ALLOC_ARRAY);
+    array->layout   = layout;
+    array->elements = cb_alloc(cb_array_storage_size(layout, array->capacity),
+                               CB_ALLOC_ARRAY);
+}
+
+// -----------------------------------------------------------------------------
+// Convert a dense layout into the boxed layout
+// -----------------------------------------------------------------------------
+static void cb_array_unpack(CbArray* array)
+{
+    if (array->layout == CB_ARRAY_LAYOUT_BOXED)
+        return;
+    
+    CbArrayItem* elements = (CbArrayItem*) cb_alloc(cb_array_storage_size(
+                                                      CB_ARRAY_LAYOUT_BOXED,
+                                                      array->capacity),
+                                                    CB_ALLOC_ARRAY);
+    
+    int i = 0;
+    for (; i < array->count; i++)
+        elements[i] = cb_array_get_value(array, i);
+    
+    cb_free(array->elements, CB_ALLOC_ARRAY);
+    array->elements = elements;
+    array->layout   = CB_ARRAY_LAYOUT_BOXED;
+}
+
+// -----------------------------------------------------------------------------
+// Store an item in the element buffer, without freeing the previous element
+// 
+//    For dense layouts the item is unboxed and freed, since the array owns it.
+// -----------------------------------------------------------------------------
+static void cb_array_store(CbArray* array, int index, const CbArrayItem item)
+{
+    switch (array->layout)
+    {
+        case CB_ARRAY_LAYOUT_BOXED:
+            array->elements[index] = item;
+            break;
+        
+        case CB_ARRAY_LAYOUT_NUMERIC:
+            array->numerics[index] = (item) ? cb_numeric_get(item) : 0;
+            break;
+        
+        case CB_ARRAY_LAYOUT_BOOLEAN:
+        {
+            unsigned char mask = 1 << (index % CHAR_BIT);
+            
+            if (item && cb_boolean_get(item))
+                array->bits[index / CHAR_BIT] |= mask;
+            else
+                array->bits[index / CHAR_BIT] &= ~mask;
+            
+            break;
+        }
+    }
+    
+    if (item && array->layout != CB_ARRAY_LAYOUT_BOXED)
+        array->element_destructor_cb(item);
+}
+
+// -----------------------------------------------------------------------------
+// Move a range of elements within the element buffer
+// -----------------------------------------------------------------------------
+static void cb_array_move(CbArray* array, int destination, int source,
+                          size_t count)
+{
+    switch (array->layout)
+    {
+        case CB_ARRAY_LAYOUT_BOXED:
+            memmove(array->elements + destination, array->elements + source,
+                    count * sizeof(CbArrayItem));
+            break;
+        
+        case CB_ARRAY_LAYOUT_NUMERIC:
+            memmove(array->numerics + destination, array->numerics + source,
+                    count * sizeof(CbNumeric));
+            break;
+        
+        case CB_ARRAY_LAYOUT_BOOLEAN:
+        {
+            // move bit by bit, in the direction that doesn't overwrite
+            // pending source bits
+            bool forward = (destination < source);
+            size_t i     = 0;
+            for (; i < count; i++)
+            {
+                size_t offset = forward ? i : (count - 1 - i);
+                size_t from   = source + offset;
+                size_t to     = destination + offset;
+                
+                unsigned char mask = 1 << (to % CHAR_BIT);
+                if ((array->bits[from / CHAR_BIT] >> (from % CHAR_BIT)) & 1)
+                    array->bits[to / CHAR_BIT] |= mask;
+                else
+                    array->bits[to / CHAR_BIT] &= ~mask;
+            }
+            
+            break;
+        }
+    }
 }
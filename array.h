@@ -3,6 +3,18 @@
  * 
  *            The array can hold a dynamic amount of pointers to a
  *            CbValue-object (defined as CbArrayItem).
+ *
+ *            Arrays created by cb_array_create_valarray() own CbValue-objects
+ *            and choose a dense layout as long as all elements share the same
+ *            type: integers are stored as a contiguous CbNumeric buffer
+ *            and boolean values as a bitset. The first store of an element
+ *            with a different type converts the array to the generic (boxed)
+ *            layout, which it keeps until it is emptied. Elements of dense
+ *            layouts aren't stored as items, so they are fetched by
+ *            cb_array_get_value(), which returns a value owned by the caller.
+ * 
+ *            Arrays may be shared by several owners: cb_array_share() adds
+ *            an owner and cb_array_free() releases one.
  ******************************************************************************/
 
 #ifndef ARRAY_H
@@ -11,6 +23,7 @@
 
 #include <stdlib.h>
 #include <stdbool.h>
+#include "value.h"
 
 
 typedef struct CbArray CbArray;
@@ -18,15 +31,28 @@ typedef void* CbArrayItem;
 typedef void (*CbArrayItemDestructor)(CbArrayItem item);
 typedef CbArrayItem (*CbArrayItemCopy)(const CbArrayItem item);
 
+// storage layout of the array elements
+enum cb_array_layout
+{
+    CB_ARRAY_LAYOUT_BOXED,   // array of CbArrayItem pointers
+    CB_ARRAY_LAYOUT_NUMERIC, // contiguous CbNumeric buffer
+    CB_ARRAY_LAYOUT_BOOLEAN  // bitset
+};
+
 
 // interface functions
 CbArray* cb_array_create();
 CbArray* cb_array_create_with_ownership(CbArrayItemDestructor destructor_cb,
                                         CbArrayItemCopy copy_cb);
+CbArray* cb_array_create_valarray();
+CbArray* cb_array_create_numeric(size_t count);
 void cb_array_free(CbArray* array);
 CbArray* cb_array_copy(CbArray* array);
+CbArray* cb_array_share(CbArray* array);
+bool cb_array_is_shared(CbArray* array);
 
 size_t cb_array_get_count(CbArray* array);
+enum cb_array_layout cb_array_get_layout(CbArray* array);
 bool cb_array_get_element_ownership(CbArray* array);
 void cb_array_enable_element_ownership(CbArray* array,
                                        CbArrayItemDestructor destructor_cb,
@@ -35,9 +61,15 @@ void cb_array_disable_element_ownership(CbArray* array);
 
 bool cb_array_set(CbArray* array, int index, const CbArrayItem item);
 bool cb_array_get(CbArray* array, int index, CbArrayItem* destination);
+CbValue* cb_array_get_value(CbArray* array, int index);
+bool cb_array_reserve(CbArray* array, size_t capacity);
 bool cb_array_append(CbArray* array, const CbArrayItem item);
+bool cb_array_append_many(CbArray* array, const CbArrayItem* items,
+                          size_t count);
 bool cb_array_insert(CbArray* array, const CbArrayItem item, int index);
 bool cb_array_remove(CbArray* array, int index);
+const CbNumeric* cb_array_get_numeric_data(CbArray* array);
+CbNumeric* cb_array_get_numeric_data_mutable(CbArray* array);
 
 
 #endif // ARRAY_H
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <assert.h>
 #include "array_access_node.h"
+#include "alloc.h"
 #include "syntree.h"
 #include "symref.h"
 #include "array.h"
@@ -22,10 +23,10 @@
 // -----------------------------------------------------------------------------
 CbSyntree* cb_array_access_node_create(const char* identifier, int index)
 {
-    CbArrayAccessNode* node = malloc(sizeof(CbArrayAccessNode));
+    CbArrayAccessNode* node = cb_alloc(sizeof(CbArrayAccessNode), CB_ALLOC_AST);
     node->type        = SNT_VALARRAY_ACCESS;
     node->line_no     = 0;
-    node->sym_id      = strdup(identifier);
+    node->sym_id      = cb_alloc_strdup(identifier, CB_ALLOC_AST);
     node->table_sym   = NULL;
     node->index       = index;
     
@@ -7,6 +7,7 @@
 #include <string.h>
 #include <assert.h>
 #include "array_assignment_node.h"
+#include "alloc.h"
 #include "syntree.h"
 #include "symref.h"
 #include "error_handling.h"
@@ -22,10 +23,11 @@
 CbSyntree* cb_array_assignment_node_create(const char* identifier, int index,
                                            CbSyntree* value_node)
 {
-    CbArrayAssignmentNode* node = malloc(sizeof(CbArrayAssignmentNode));
+    CbArrayAssignmentNode* node = cb_alloc(sizeof(CbArrayAssignmentNode),
+                                           CB_ALLOC_AST);
     node->type                  = SNT_VALARRAY_ASSIGNMENT;
     node->line_no               = 0;
-    node->sym_id                = strdup(identifier);
+    node->sym_id                = cb_alloc_strdup(identifier, CB_ALLOC_AST);
     node->table_sym             = NULL;
     node->index                 = index;
     node->value_node            = value_node;
@@ -48,8 +50,13 @@ CbValue* cb_array_assignment_node_eval(const CbArrayAssignmentNode* node,
     if (value == NULL)
         return NULL;
     
+    // the array must not share the value with any other one
+    cb_value_detach(value);
+    
+    // NOTE: the array takes ownership of the value and may store it unboxed,
+    //       so the stored element is fetched again as a value of its own
     if (cb_valarray_set_element(valarray, node->index, value))
-        return value;
+        return cb_valarray_get_element(valarray, node->index);
     else
     {
         cb_print_error(CB_ERR_RUNTIME, node->line_no,
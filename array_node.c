@@ -4,8 +4,17 @@
 
 #include <stdlib.h>
 #include "array_node.h"
+#include "alloc.h"
 #include "syntree.h"
 #include "array.h"
+#include "error_handling.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+static void cb_array_node_cleanup(void* array);
 
 
 // #############################################################################
@@ -17,7 +26,7 @@
 // -----------------------------------------------------------------------------
 CbSyntree* cb_array_node_create(CbStrlist* values)
 {
-    CbArrayNode* node = malloc(sizeof(CbArrayNode));
+    CbArrayNode* node = cb_alloc(sizeof(CbArrayNode), CB_ALLOC_AST);
     node->type        = SNT_VALARRAY;
     node->line_no     = 0;
     node->values      = values;
@@ -31,15 +40,35 @@ CbSyntree* cb_array_node_create(CbStrlist* values)
 CbValue* cb_array_node_eval(const CbArrayNode* node, CbSymtab* symtab)
 {
     CbStrlist* item  = node->values;
-    CbArray*   array = cb_array_create_with_ownership((CbArrayItemDestructor) cb_value_free,
-                                                      (CbArrayItemCopy) cb_value_copy);
+    CbArray*   array = cb_array_create_valarray();
+    
+    // the array is held, while the elements are evaluated
+    cb_error_push_cleanup(array, cb_array_node_cleanup);
     
     while (item)
     {
         CbValue* value = cb_syntree_eval((CbSyntree*) item->data, symtab);
+        if (value)
+            cb_value_detach(value);
+        
         cb_array_append(array, (CbArrayItem) value);
         item = item->next;
     }
     
+    cb_error_pop_cleanup();
+    
     return cb_valarray_create(array);
 }
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Free an array, if an error unwinds its evaluation (internal)
+// -----------------------------------------------------------------------------
+static void cb_array_node_cleanup(void* array)
+{
+    cb_array_free((CbArray*) array);
+}
@@ -0,0 +1,381 @@
+/*******************************************************************************
+ * cbc_bench -- Benchmark harness running codeblock workloads
+ *
+ *              Every workload is parsed, executed and freed once as warm-up
+ *              and then <runs> times while being timed. The median, the 95th
+ *              percentile and the operations (runs) per second are printed
+ *              and written as JSON, one benchmark per line:
+ *
+ *                cbc_bench [-n <runs>] [-o <results.json>] <workload>...
+ *
+ *              Results can be compared with a saved baseline. Benchmarks,
+ *              whose median is slower by more than the threshold (default:
+ *              10 percent), are flagged as regressions and make the exit
+ *              status EXIT_FAILURE:
+ *
+ *                cbc_bench --compare <baseline.json> <results.json> [percent]
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "../codeblock.h"
+#include "../error_handling.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+// default count of timed runs per workload
+#define BENCH_DEFAULT_RUNS 10
+
+// default threshold of regressions in percent
+#define BENCH_DEFAULT_THRESHOLD 10.0
+
+// maximum length of a benchmark's name
+#define BENCH_NAME_LENGTH 64
+
+// result of a benchmark
+typedef struct
+{
+    char name[BENCH_NAME_LENGTH];
+    double median;                  // in milliseconds
+    double p95;                     // in milliseconds
+    double ops_per_sec;
+} BenchResult;
+
+static double bench_now();
+static char* bench_read_file(const char* file_name);
+static void bench_get_name(const char* file_name, char* name);
+static int bench_compare_durations(const void* a, const void* b);
+static int bench_run(const char* file_name, int runs, BenchResult* result);
+static int bench_write_json(const char* file_name, const BenchResult* results,
+                            int count, int runs);
+static int bench_read_json(const char* file_name, BenchResult** results);
+static int bench_compare(const char* baseline_name, const char* results_name,
+                         double threshold);
+
+
+// #############################################################################
+// main
+// #############################################################################
+
+int main(int argc, char* argv[])
+{
+    if (argc > 1 && strcmp(argv[1], "--compare") == 0)
+    {
+        if (argc < 4)
+        {
+            fprintf(stderr, "Usage: %s --compare <baseline.json> "
+                            "<results.json> [percent]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+        
+        double threshold = (argc > 4) ? atof(argv[4]) : BENCH_DEFAULT_THRESHOLD;
+        
+        return bench_compare(argv[2], argv[3], threshold);
+    }
+    
+    int runs                = BENCH_DEFAULT_RUNS;
+    const char* output_name = NULL;
+    
+    int i = 1;
+    for (; i < argc - 1 && argv[i][0] == '-'; i += 2)
+    {
+        if (strcmp(argv[i], "-n") == 0)
+            runs = atoi(argv[i + 1]);
+        else if (strcmp(argv[i], "-o") == 0)
+            output_name = argv[i + 1];
+        else
+            break;
+    }
+    
+    if (i >= argc || runs < 1)
+    {
+        fprintf(stderr, "Usage: %s [-n <runs>] [-o <results.json>] "
+                        "<workload>...\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    
+    int count            = argc - i;
+    BenchResult* results = (BenchResult*) calloc(count, sizeof(BenchResult));
+    int status           = EXIT_SUCCESS;
+    
+    printf("%-20s %12s %12s %12s\n", "Benchmark", "Median (ms)", "P95 (ms)",
+           "Ops/sec");
+    
+    int b = 0;
+    for (; b < count; b++)
+    {
+        if (bench_run(argv[i + b], runs, &results[b]) != EXIT_SUCCESS)
+        {
+            fprintf(stderr, "Benchmark `%s' failed\n", argv[i + b]);
+            status = EXIT_FAILURE;
+            continue;
+        }
+        
+        printf("%-20s %12.3f %12.3f %12.1f\n", results[b].name,
+               results[b].median, results[b].p95, results[b].ops_per_sec);
+        fflush(stdout);
+    }
+    
+    if (output_name && status == EXIT_SUCCESS)
+        status = bench_write_json(output_name, results, count, runs);
+    
+    free(results);
+    
+    return status;
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Get a monotonic time stamp in milliseconds
+// -----------------------------------------------------------------------------
+static double bench_now()
+{
+#ifdef _CBC_PLAT_WNDS
+    return (double) clock() * 1000.0 / CLOCKS_PER_SEC;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return now.tv_sec * 1000.0 + now.tv_nsec / 1e6;
+#endif // _CBC_PLAT_WNDS
+}
+
+// -----------------------------------------------------------------------------
+// Read a whole file (NULL, if it can't be read)
+// -----------------------------------------------------------------------------
+static char* bench_read_file(const char* file_name)
+{
+    FILE* file = fopen(file_name, "rb");
+    if (!file)
+        return NULL;
+    
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    rewind(file);
+    
+    char* data = (length >= 0) ? (char*) malloc(length + 1) : NULL;
+    if (data && fread(data, 1, length, file) != (size_t) length)
+    {
+        free(data);
+        data = NULL;
+    }
+    
+    if (data)
+        data[length] = '\0';
+    
+    fclose(file);
+    
+    return data;
+}
+
+// -----------------------------------------------------------------------------
+// Get the name of a benchmark from its file-name (without path and extension)
+// -----------------------------------------------------------------------------
+static void bench_get_name(const char* file_name, char* name)
+{
+    const char* begin = strrchr(file_name, '/');
+    begin             = (begin) ? begin + 1 : file_name;
+    
+    snprintf(name, BENCH_NAME_LENGTH, "%s", begin);
+    
+    char* extension = strrchr(name, '.');
+    if (extension)
+        *extension = '\0';
+}
+
+// -----------------------------------------------------------------------------
+// Compare durations, ascending
+// -----------------------------------------------------------------------------
+static int bench_compare_durations(const void* a, const void* b)
+{
+    double l = *(const double*) a;
+    double r = *(const double*) b;
+    
+    return (l > r) - (l < r);
+}
+
+// -----------------------------------------------------------------------------
+// Run a workload (parse, execute, free) and take its statistics
+// -----------------------------------------------------------------------------
+static int bench_run(const char* file_name, int runs, BenchResult* result)
+{
+    char* source = bench_read_file(file_name);
+    if (!source)
+        return EXIT_FAILURE;
+    
+    bench_get_name(file_name, result->name);
+    
+    double* durations = (double*) malloc(runs * sizeof(double));
+    int status        = EXIT_SUCCESS;
+    
+    int i = -1; // the first run is the warm-up
+    for (; i < runs && status == EXIT_SUCCESS; i++)
+    {
+        double start  = bench_now();
+        Codeblock* cb = codeblock_create();
+        
+        if (codeblock_parse_string(cb, source) != EXIT_SUCCESS ||
+            codeblock_execute(cb)              != EXIT_SUCCESS)
+            status = EXIT_FAILURE;
+        
+        codeblock_free(cb);
+        
+        if (i >= 0)
+            durations[i] = bench_now() - start;
+    }
+    
+    if (status == EXIT_SUCCESS)
+    {
+        qsort(durations, runs, sizeof(double), bench_compare_durations);
+        
+        int p95             = (runs * 95 + 99) / 100 - 1; // nearest rank
+        result->median      = (runs % 2) ? durations[runs / 2]
+                                         : (durations[runs / 2 - 1] +
+                                            durations[runs / 2]) / 2;
+        result->p95         = durations[p95];
+        result->ops_per_sec = (result->median > 0) ? 1000.0 / result->median
+                                                   : 0.0;
+    }
+    
+    free(durations);
+    free(source);
+    
+    return status;
+}
+
+// -----------------------------------------------------------------------------
+// Write the results as JSON (one benchmark per line)
+// -----------------------------------------------------------------------------
+static int bench_write_json(const char* file_name, const BenchResult* results,
+                            int count, int runs)
+{
+    FILE* output = fopen(file_name, "w");
+    if (!output)
+    {
+        fprintf(stderr, "Unable to write file `%s'\n", file_name);
+        return EXIT_FAILURE;
+    }
+    
+    fprintf(output, "{\n  \"runs\": %d,\n  \"benchmarks\": [\n", runs);
+    
+    int i = 0;
+    for (; i < count; i++)
+        fprintf(output, "    {\"name\": \"%s\", \"median_ms\": %.6f, "
+                        "\"p95_ms\": %.6f, \"ops_per_sec\": %.3f}%s\n",
+                results[i].name, results[i].median, results[i].p95,
+                results[i].ops_per_sec, (i + 1 < count) ? "," : "");
+    
+    fprintf(output, "  ]\n}\n");
+    
+    return (fclose(output) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// -----------------------------------------------------------------------------
+// Read the results of a JSON file written by bench_write_json()
+//
+//    Returns the count of results (-1, if the file can't be read).
+// -----------------------------------------------------------------------------
+static int bench_read_json(const char* file_name, BenchResult** results)
+{
+    FILE* input = fopen(file_name, "r");
+    if (!input)
+    {
+        fprintf(stderr, "Unable to open file `%s'\n", file_name);
+        return -1;
+    }
+    
+    char line[512];
+    int count    = 0;
+    int capacity = 0;
+    *results     = NULL;
+    
+    while (fgets(line, sizeof(line), input))
+    {
+        BenchResult result;
+        if (sscanf(line, " {\"name\": \"%63[^\"]\", \"median_ms\": %lf, "
+                         "\"p95_ms\": %lf, \"ops_per_sec\": %lf",
+                   result.name, &result.median, &result.p95,
+                   &result.ops_per_sec) != 4)
+            continue;
+        
+        if (count == capacity)
+        {
+            capacity = (capacity) ? capacity * 2 : 16;
+            *results = (BenchResult*) realloc(*results,
+                                              capacity * sizeof(BenchResult));
+        }
+        
+        (*results)[count++] = result;
+    }
+    
+    fclose(input);
+    
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+// Compare results with a baseline and flag regressions
+// -----------------------------------------------------------------------------
+static int bench_compare(const char* baseline_name, const char* results_name,
+                         double threshold)
+{
+    BenchResult* baseline = NULL;
+    BenchResult* results  = NULL;
+    int baseline_count    = bench_read_json(baseline_name, &baseline);
+    int count             = bench_read_json(results_name, &results);
+    int regressions       = 0;
+    
+    if (baseline_count < 0 || count < 0)
+    {
+        free(baseline);
+        free(results);
+        return EXIT_FAILURE;
+    }
+    
+    printf("%-20s %14s %14s %9s\n", "Benchmark", "Baseline (ms)",
+           "Current (ms)", "Change");
+    
+    int i = 0;
+    for (; i < count; i++)
+    {
+        const BenchResult* base = NULL;
+        
+        int j = 0;
+        for (; j < baseline_count && !base; j++)
+            if (strcmp(baseline[j].name, results[i].name) == 0)
+                base = &baseline[j];
+        
+        if (!base || base->median <= 0)
+        {
+            printf("%-20s %14s %14.3f %9s\n", results[i].name, "-",
+                   results[i].median, "new");
+            continue;
+        }
+        
+        double change   = (results[i].median / base->median - 1.0) * 100.0;
+        bool regression = change > threshold;
+        regressions    += regression;
+        
+        printf("%-20s %14.3f %14.3f %+8.1f%%%s\n", results[i].name,
+               base->median, results[i].median, change,
+               (regression) ? "  REGRESSION" : "");
+    }
+    
+    if (regressions > 0)
+        printf("\n%d regression(s) beyond %.1f%%\n", regressions, threshold);
+    
+    free(baseline);
+    free(results);
+    
+    return (regressions > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -5,6 +5,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "builtin.h"
 #include "cblib.h"
 #include "symbol.h"
@@ -17,32 +18,52 @@
 // declarations
 // #############################################################################
 
-// {identifier, function-pointer, param_count} item
+// {identifier, function-pointer, param_count, effect} item
 typedef struct
 {
     char* identifier;
     CbBuiltinFunctionRef func;
     int param_count;
+    enum cb_builtin_effect effect;
 } CbBuiltinFunctionInfoItem;
 
 // registration list of all builtin functions
 // (will be registered by function 'register_builtin_all()')
 CbBuiltinFunctionInfoItem builtin_func_decl_list[] = {
-    {"WriteLn", bif_writeln, 1},
-    {"Mod", bif_mod, 2},
-    {"ValType", bif_valtype, 1},
-    {"Str", bif_str, 1},
-    {"Val", bif_val, 1},
-    {"Replicate", bif_replicate, 2},
-    {"Len", bif_len, 1},
-    {"Eval", bif_eval, 1},
-    {"GetEnv", bif_getenv, 1},
-    {"SetEnv", bif_setenv, 2},
-    {"SetError", bif_seterror, 1},
-    {"SetErrorIf", bif_seterrorif, 2},
-    {"GetErrorText", bif_geterrortext, 0}
+    {"WriteLn", bif_writeln, 1, CB_BIF_IMPURE},
+    {"Mod", bif_mod, 2, CB_BIF_PURE},
+    {"ValType", bif_valtype, 1, CB_BIF_PURE},
+    {"Str", bif_str, 1, CB_BIF_PURE},
+    {"Val", bif_val, 1, CB_BIF_PURE},
+    {"Replicate", bif_replicate, 2, CB_BIF_PURE},
+    {"Len", bif_len, 1, CB_BIF_PURE},
+    {"Eval", bif_eval, 1, CB_BIF_CHANGES_ANY},
+    {"GetEnv", bif_getenv, 1, CB_BIF_IMPURE},
+    {"SetEnv", bif_setenv, 2, CB_BIF_IMPURE},
+    {"SetError", bif_seterror, 1, CB_BIF_IMPURE},
+    {"SetErrorIf", bif_seterrorif, 2, CB_BIF_IMPURE},
+    {"GetErrorText", bif_geterrortext, 0, CB_BIF_IMPURE},
+    {"ASum", bif_asum, 1, CB_BIF_PURE},
+    {"AMin", bif_amin, 1, CB_BIF_PURE},
+    {"AMax", bif_amax, 1, CB_BIF_PURE},
+    {"AScale", bif_ascale, 2, CB_BIF_PURE},
+    {"ADot", bif_adot, 2, CB_BIF_PURE},
+    {"ArrayNew", bif_arraynew, 1, CB_BIF_PURE},
+    {"AAdd", bif_aadd, 2, CB_BIF_CHANGES_ARG},
+    {"ASize", bif_asize, 1, CB_BIF_PURE},
+    {"HGet", bif_hget, 2, CB_BIF_IMPURE},
+    {"HSet", bif_hset, 3, CB_BIF_CHANGES_ARG},
+    {"HHas", bif_hhas, 2, CB_BIF_PURE},
+    {"HDel", bif_hdel, 2, CB_BIF_CHANGES_ARG},
+    {"HKeys", bif_hkeys, 1, CB_BIF_PURE},
+    {"ReadLn", bif_readln, 0, CB_BIF_IMPURE},
+    {"FOpen", bif_fopen, 1, CB_BIF_IMPURE},
+    {"FReadLine", bif_freadline, 1, CB_BIF_IMPURE},
+    {"FClose", bif_fclose, 1, CB_BIF_IMPURE},
+    {"FReadAll", bif_freadall, 1, CB_BIF_IMPURE},
+    {"MemStats", bif_memstats, 0, CB_BIF_IMPURE}
 #ifdef _CBC_PLAT_WNDS
-    , {"Meld", bif_meld, 1}
+    , {"Meld", bif_meld, 1, CB_BIF_IMPURE}
 #endif // _CBC_PLAT_WNDS
 };
 
@@ -55,10 +76,12 @@ CbBuiltinFunctionInfoItem builtin_func_decl_list[] = {
 // register a builtin function in a symbol-table
 // -----------------------------------------------------------------------------
 int register_builtin_func(CbSymtab* symtab, char* identifier,
-                          CbBuiltinFunctionRef func, int expected_param_count)
+                          CbBuiltinFunctionRef func, int expected_param_count,
+                          enum cb_builtin_effect effect)
 {
     CbSymbol* s = cb_symbol_create_function(identifier,
-                      cb_function_create_builtin(identifier, expected_param_count, func));
+                      cb_function_create_builtin(identifier, expected_param_count,
+                                                 func, effect));
     
     if (cb_symtab_append(symtab, s) != NULL)
         return EXIT_SUCCESS;
@@ -81,7 +104,8 @@ int register_builtin_all(CbSymtab* symtab)
         result = register_builtin_func(symtab,
                                        builtin_func_decl_list[i].identifier,
                                        builtin_func_decl_list[i].func,
-                                       builtin_func_decl_list[i].param_count);
+                                       builtin_func_decl_list[i].param_count,
+                                       builtin_func_decl_list[i].effect);
         if (result != EXIT_SUCCESS)
         {
             cb_print_error_msg("Unable to register builtin symbol `%s'",
@@ -92,3 +116,38 @@ int register_builtin_all(CbSymtab* symtab)
     
     return result;
 }
+
+// -----------------------------------------------------------------------------
+// get the effect of a builtin function
+//
+//    Unknown identifiers are reported as CB_BIF_CHANGES_ANY, so a caller can't
+//    rely on functions, which aren't builtin ones.
+// -----------------------------------------------------------------------------
+enum cb_builtin_effect get_builtin_func_effect(const char* identifier)
+{
+    int lenght = sizeof(builtin_func_decl_list) /
+                 sizeof(CbBuiltinFunctionInfoItem);
+    int i      = 0;
+    
+    for (; i < lenght; i++)
+        if (strcmp(builtin_func_decl_list[i].identifier, identifier) == 0)
+            return builtin_func_decl_list[i].effect;
+    
+    return CB_BIF_CHANGES_ANY;
+}
+
+// -----------------------------------------------------------------------------
+// check if an identifier is the name of a builtin function
+// -----------------------------------------------------------------------------
+bool is_builtin_func(const char* identifier)
+{
+    int lenght = sizeof(builtin_func_decl_list) /
+                 sizeof(CbBuiltinFunctionInfoItem);
+    int i      = 0;
+    
+    for (; i < lenght; i++)
+        if (strcmp(builtin_func_decl_list[i].identifier, identifier) == 0)
+            return true;
+    
+    return false;
+}
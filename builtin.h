@@ -14,11 +14,24 @@
 // function-pointer to a generic builtin function
 typedef CbValue* (*CbBuiltinFunctionRef) (CbStack*);
 
+// effect of a builtin function on the script (used by the optimizer)
+enum cb_builtin_effect
+{
+    CB_BIF_PURE,        // the result only depends on the arguments
+    CB_BIF_IMPURE,      // no symbol is changed, but the result may differ
+    CB_BIF_CHANGES_ARG, // the array or hash of the first argument is changed
+                        // (copied on write, see cb_function_call())
+    CB_BIF_CHANGES_ANY  // any symbol may be changed (e.g. by evaluated code)
+};
+
 
 // interface functions
 int register_builtin_func(CbSymtab* symtab, char* identifier,
-                          CbBuiltinFunctionRef func, int expected_param_count);
+                          CbBuiltinFunctionRef func, int expected_param_count,
+                          enum cb_builtin_effect effect);
 int register_builtin_all(CbSymtab* symtab);
+enum cb_builtin_effect get_builtin_func_effect(const char* identifier);
+bool is_builtin_func(const char* identifier);
 
 
 #endif // BUILTIN_H
@@ -10,6 +10,7 @@
 #include "array_node.h"
 #include "array_access_node.h"
 #include "array_assignment_node.h"
+#include "hash_node.h"
 #include "strlist.h"
 #include "error_handling.h"
 
@@ -33,6 +34,7 @@ int yylineno_temp = -1;
     CbString str;
     CbBoolean boolval;
     CbNumeric val;
+    CbFloat real;
     enum cb_comparison_type cmp;
     CbStrlist* list;
 };
@@ -43,7 +45,9 @@ int yylineno_temp = -1;
 %token           IF THEN ELSE ENDIF
 %token           WHILE DO END
 %token           STARTSEQ STOPSEQ ONERROR ALWAYS
+%token           HASHOP
 %token <val>     NUMBER
+%token <real>    REAL
 %token <id>      IDENTIFIER
 %token <str>     STRING
 %token <boolval> BOOLEAN
@@ -57,7 +61,7 @@ int yylineno_temp = -1;
 %nonassoc AND
 %nonassoc OR
 
-%type <ast>  decllist decl stmtlist stmt expr symref
+%type <ast>  decllist decl stmtlist stmt expr symref hashlist
 %type <list> params paramlist exprlist args
 
 /* Output parameter: Abstract syntax tree of the parsed codeblock */
@@ -66,8 +70,9 @@ int yylineno_temp = -1;
 
 /* Destructors: Free discarded symbols in case of errors */
 %destructor {
-    cb_syntree_free($$);
-} decllist decl stmtlist stmt expr symref
+    if ($$) // empty lists are NULL
+        cb_syntree_free($$);
+} decllist decl stmtlist stmt expr symref hashlist
 
 %destructor {
     cb_strlist_free($$);
@@ -256,11 +261,28 @@ exprlist:
                                 }
     ;
 
+/* Key-value pairs of a hash */
+hashlist:
+    expr HASHOP expr            {
+                                    $$ = cb_hash_node_create();
+                                    $$->line_no = yylineno;
+                                    cb_hash_node_append($$, $1, $3);
+                                }
+    | hashlist ',' expr HASHOP expr {
+                                    cb_hash_node_append($1, $3, $5);
+                                    $$ = $1;
+                                }
+    ;
+
 expr:
     NUMBER                      {
                                     $$ = cb_constval_create($1);
                                     $$->line_no = yylineno;
                                 }
+    | REAL                      {
+                                    $$ = cb_constfloat_create($1);
+                                    $$->line_no = yylineno;
+                                }
     | BOOLEAN                   {
                                     $$ = cb_constbool_create($1);
                                     $$->line_no = yylineno;
@@ -327,6 +349,11 @@ expr:
     | '(' expr ')'              { $$ = $2; }
     | '{' exprlist '}'          { $$ = cb_array_node_create($2); }
     | '{' '}'                   { $$ = cb_array_node_create(NULL); }
+    | '{' hashlist '}'          { $$ = $2; }
+    | '{' HASHOP '}'            {
+                                    $$ = cb_hash_node_create();
+                                    $$->line_no = yylineno;
+                                }
     | '-' expr                  {
                                     $$ = cb_syntree_create(SNT_UNARYMINUS, $2,
                                                            NULL);
@@ -5,11 +5,49 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include <assert.h>
 #include "cblib.h"
 #include "codeblock.h"
 #include "error_handling.h"
 #include "error_messages.h"
+#include "reader.h"
+#include "hash.h"
+#include "alloc.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+static const CbNumeric* cb_numeric_data_from_valarray(const CbValue* val,
+                                                      size_t* count,
+                                                      CbNumeric** buffer);
+static CbNumeric cb_numeric_kernel_sum(const CbNumeric* data, size_t count);
+static CbNumeric cb_numeric_kernel_min(const CbNumeric* data, size_t count);
+static CbNumeric cb_numeric_kernel_max(const CbNumeric* data, size_t count);
+static void cb_numeric_kernel_scale(const CbNumeric* data, size_t count,
+                                    CbNumeric factor, CbNumeric* destination);
+static CbNumeric cb_numeric_kernel_dot(const CbNumeric* a, const CbNumeric* b,
+                                       size_t count);
+static CbFloat* cb_float_data_from_valarray(const CbValue* val);
+static CbFloat cb_float_kernel_sum(const CbFloat* data, size_t count);
+static CbFloat cb_float_kernel_min(const CbFloat* data, size_t count);
+static CbFloat cb_float_kernel_max(const CbFloat* data, size_t count);
+static void cb_float_kernel_scale(CbFloat* data, size_t count, CbFloat factor);
+static CbFloat cb_float_kernel_dot(const CbFloat* a, const CbFloat* b,
+                                   size_t count);
+static bool cb_argument_check(const CbValue* arg, enum cb_value_type type);
+static CbValue* cb_builtin_throw();
+static CbValue* cb_string_from_line(const char* line, size_t length);
+static CbReader* cb_file_get(const CbValue* handle);
+static CbValue* cb_memstats_create_hash(const char* name,
+                                        const CbAllocStats* stats);
+static void cb_memstats_set(CbHash* hash, const char* key, uint64_t value);
+
+// files opened by FOpen(), the handle is the index + 1
+static CbReader** open_files   = NULL;
+static size_t open_files_count = 0;
 
 
 // #############################################################################
@@ -26,10 +64,9 @@ CbValue* bif_writeln(CbStack* arg_stack)
     CbValue* arg;
     cb_stack_pop(arg_stack, (void*) &arg);
     
-    cb_value_print(arg);
+    // print value and newline
+    cb_output_write_line(cb_output_get_current(), arg);
     cb_value_free(arg);
-    // print newline
-    printf("\n");
     
     return cb_value_create(); // return empty value
 }
@@ -46,12 +83,25 @@ CbValue* bif_mod(CbStack* arg_stack)
     cb_stack_pop(arg_stack, (void*) &arg2); // first pop -> last argument
     cb_stack_pop(arg_stack, (void*) &arg1);
     
-    CbValue* result = cb_numeric_create(cb_numeric_get(arg1) %
-                                        cb_numeric_get(arg2));
+    CbValue* result = NULL;
+    
+    if (cb_numeric_get_float(arg2) == 0)
+        cb_error_set(CB_ERR_CODE_DIVISIONBYZERO);
+    else if (cb_numeric_is_float(arg1) || cb_numeric_is_float(arg2))
+        result = cb_float_create(fmod(cb_numeric_get_float(arg1),
+                                      cb_numeric_get_float(arg2)));
+    else if (cb_numeric_get(arg2) == -1) // INT64_MIN % -1 would overflow
+        result = cb_numeric_create(0);
+    else
+        result = cb_numeric_create(cb_numeric_get(arg1) %
+                                   cb_numeric_get(arg2));
     
     cb_value_free(arg1);
     cb_value_free(arg2);
     
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
     return result;
 }
 
@@ -84,6 +134,10 @@ CbValue* bif_valtype(CbStack* arg_stack)
             result = cb_string_create(strdup("A"));
             break;
         
+        case CB_VT_HASH:
+            result = cb_string_create(strdup("H"));
+            break;
+        
         case CB_VT_UNDEFINED:
         default:
             result = cb_string_create(strdup("U"));
@@ -124,8 +178,7 @@ CbValue* bif_val(CbStack* arg_stack)
     
     assert(cb_value_is_type(arg, CB_VT_STRING));
     
-    CbValue* result = cb_numeric_create(0); // default result
-    cb_numeric_set(result, strtol(cb_string_get(arg), NULL, 10));
+    CbValue* result = cb_numeric_parse(cb_string_get(arg));
     
     cb_value_free(arg);
     
@@ -147,20 +200,27 @@ CbValue* bif_replicate(CbStack* arg_stack)
     assert(cb_value_is_type(str, CB_VT_STRING));
     assert(cb_value_is_type(count, CB_VT_NUMERIC));
     
-    CbValue* result;
+    CbValue* result = NULL;
     
     if (cb_numeric_get(count) > 0)
     {
-        char* input_str   = cb_string_get(str);
-        size_t alloc_size = (strlen(input_str) * cb_numeric_get(count)) + 1;
-        char* result_str  = (char*) malloc(alloc_size);
-        *result_str       = '\0'; // terminate string
+        char* input_str = cb_string_get(str);
+        size_t length   = strlen(input_str);
         
-        int i = 0;
-        for (; i < cb_numeric_get(count); i++)
-            strcat(result_str, input_str);
-        
-        result = cb_string_create(result_str);
+        // the result is left empty, if the memory quota would be exceeded
+        if (cb_alloc_reserve((double) length * cb_numeric_get(count) + 1))
+        {
+            size_t alloc_size = (length * cb_numeric_get(count)) + 1;
+            char* result_str  = (char*) malloc(alloc_size);
+            char* end         = result_str;
+            
+            int i = 0;
+            for (; i < cb_numeric_get(count); i++, end += length)
+                memcpy(end, input_str, length);
+            
+            *end   = '\0'; // terminate string
+            result = cb_string_create(result_str);
+        }
     }
     else
         result = cb_string_create(strdup(""));
@@ -168,6 +228,9 @@ CbValue* bif_replicate(CbStack* arg_stack)
     cb_value_free(str);
     cb_value_free(count);
     
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
     return result;
 }
 
@@ -219,6 +282,10 @@ CbValue* bif_eval(CbStack* arg_stack)
     
     codeblock_free(cb);
     
+    // an error, which isn't catched by the codeblock, is passed on
+    if (result == NULL && cb_error_is_pending())
+        return cb_builtin_throw();
+    
     return result;
 }
 
@@ -238,7 +305,7 @@ CbValue* bif_getenv(CbStack* arg_stack)
     
     char* value = getenv(cb_string_get(arg));
     if (value == NULL)
-        result = cb_string_create("");
+        result = cb_string_create(strdup(""));
     else
         result = cb_string_create(strdup(value));
     
@@ -298,11 +365,9 @@ CbValue* bif_seterror(CbStack* arg_stack)
     
     cb_error_set_msg(cb_string_get(arg)); // set error and print error message
     
-    CbValue* result = cb_value_create();
-    
     cb_value_free(arg);
     
-    return result;
+    return cb_builtin_throw();
 }
 
 // -----------------------------------------------------------------------------
@@ -320,15 +385,17 @@ CbValue* bif_seterrorif(CbStack* arg_stack)
     assert(cb_value_is_type(condition, CB_VT_BOOLEAN));
     assert(cb_value_is_type(message, CB_VT_STRING));
     
-    CbValue* result = cb_value_create();
-    
-    if (cb_boolean_get(condition))
+    bool raise = cb_boolean_get(condition);
+    if (raise)
         cb_error_set_msg(cb_string_get(message));
     
     cb_value_free(condition);
     cb_value_free(message);
     
-    return result;
+    if (raise)
+        return cb_builtin_throw();
+    
+    return cb_value_create();
 }
 
 // -----------------------------------------------------------------------------
@@ -342,3 +409,1104 @@ CbValue* bif_geterrortext(CbStack* arg_stack)
     
     return result;
 }
+
+// -----------------------------------------------------------------------------
+// ASum() -- Sum of all elements of a numeric array
+// -----------------------------------------------------------------------------
+CbValue* bif_asum(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 1);
+    
+    CbValue* arg;
+    cb_stack_pop(arg_stack, (void*) &arg);
+    
+    if (!cb_argument_check(arg, CB_VT_VALARRAY))
+    {
+        cb_value_free(arg);
+        return cb_builtin_throw();
+    }
+    
+    CbValue* result       = NULL;
+    size_t count          = 0;
+    CbNumeric* buffer     = NULL;
+    const CbNumeric* data = cb_numeric_data_from_valarray(arg, &count, &buffer);
+    CbFloat* floats       = (data) ? NULL : cb_float_data_from_valarray(arg);
+    
+    if (data == NULL && floats == NULL)
+        cb_error_set(CB_ERR_CODE_ARRAYNOTNUMERIC);
+    else if (data)
+        result = cb_numeric_create(cb_numeric_kernel_sum(data, count));
+    else
+        result = cb_float_create(cb_float_kernel_sum(floats, count));
+    
+    free(buffer);
+    free(floats);
+    cb_value_free(arg);
+    
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// AMin() -- Smallest element of a numeric array
+// -----------------------------------------------------------------------------
+CbValue* bif_amin(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 1);
+    
+    CbValue* arg;
+    cb_stack_pop(arg_stack, (void*) &arg);
+    
+    if (!cb_argument_check(arg, CB_VT_VALARRAY))
+    {
+        cb_value_free(arg);
+        return cb_builtin_throw();
+    }
+    
+    CbValue* result       = NULL;
+    size_t count          = 0;
+    CbNumeric* buffer     = NULL;
+    const CbNumeric* data = cb_numeric_data_from_valarray(arg, &count, &buffer);
+    CbFloat* floats       = (data) ? NULL : cb_float_data_from_valarray(arg);
+    
+    if (data == NULL && floats == NULL)
+        cb_error_set(CB_ERR_CODE_ARRAYNOTNUMERIC);
+    else if (count == 0)
+        cb_error_set(CB_ERR_CODE_ARRAYEMPTY);
+    else if (data)
+        result = cb_numeric_create(cb_numeric_kernel_min(data, count));
+    else
+        result = cb_float_create(cb_float_kernel_min(floats, count));
+    
+    free(buffer);
+    free(floats);
+    cb_value_free(arg);
+    
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// AMax() -- Largest element of a numeric array
+// -----------------------------------------------------------------------------
+CbValue* bif_amax(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 1);
+    
+    CbValue* arg;
+    cb_stack_pop(arg_stack, (void*) &arg);
+    
+    if (!cb_argument_check(arg, CB_VT_VALARRAY))
+    {
+        cb_value_free(arg);
+        return cb_builtin_throw();
+    }
+    
+    CbValue* result       = NULL;
+    size_t count          = 0;
+    CbNumeric* buffer     = NULL;
+    const CbNumeric* data = cb_numeric_data_from_valarray(arg, &count, &buffer);
+    CbFloat* floats       = (data) ? NULL : cb_float_data_from_valarray(arg);
+    
+    if (data == NULL && floats == NULL)
+        cb_error_set(CB_ERR_CODE_ARRAYNOTNUMERIC);
+    else if (count == 0)
+        cb_error_set(CB_ERR_CODE_ARRAYEMPTY);
+    else if (data)
+        result = cb_numeric_create(cb_numeric_kernel_max(data, count));
+    else
+        result = cb_float_create(cb_float_kernel_max(floats, count));
+    
+    free(buffer);
+    free(floats);
+    cb_value_free(arg);
+    
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// AScale() -- Multiply every element of a numeric array by a factor
+// -----------------------------------------------------------------------------
+CbValue* bif_ascale(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 2);
+    
+    CbValue* arg;
+    CbValue* factor;
+    cb_stack_pop(arg_stack, (void*) &factor); // first pop -> last argument
+    cb_stack_pop(arg_stack, (void*) &arg);
+    
+    if (!cb_argument_check(arg, CB_VT_VALARRAY) ||
+        !cb_argument_check(factor, CB_VT_NUMERIC))
+    {
+        cb_value_free(arg);
+        cb_value_free(factor);
+        return cb_builtin_throw();
+    }
+    
+    CbValue* result       = NULL;
+    size_t count          = 0;
+    CbNumeric* buffer     = NULL;
+    const CbNumeric* data = NULL;
+    CbFloat* floats       = NULL;
+    
+    // a float factor results in floats as well
+    if (!cb_numeric_is_float(factor))
+        data = cb_numeric_data_from_valarray(arg, &count, &buffer);
+    if (data == NULL)
+        floats = cb_float_data_from_valarray(arg);
+    
+    if (data == NULL && floats == NULL)
+        cb_error_set(CB_ERR_CODE_ARRAYNOTNUMERIC);
+    else if (data)
+    {
+        // scale directly into the packed buffer of the new array
+        CbArray* array = cb_array_create_numeric(count);
+        cb_numeric_kernel_scale(data, count, cb_numeric_get(factor),
+                                cb_array_get_numeric_data_mutable(array));
+        
+        result = cb_valarray_create(array);
+    }
+    else
+    {
+        // scale in place, the buffer is a private copy anyway
+        count = cb_array_get_count(cb_valarray_get(arg));
+        cb_float_kernel_scale(floats, count, cb_numeric_get_float(factor));
+        
+        CbArray* array = cb_array_create_valarray();
+        cb_array_reserve(array, count);
+        
+        size_t i = 0;
+        for (; i < count; i++)
+            cb_array_append(array, (CbArrayItem) cb_float_create(floats[i]));
+        
+        result = cb_valarray_create(array);
+    }
+    
+    free(buffer);
+    free(floats);
+    cb_value_free(arg);
+    cb_value_free(factor);
+    
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// ADot() -- Dot product of two numeric arrays
+// -----------------------------------------------------------------------------
+CbValue* bif_adot(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 2);
+    
+    CbValue* arg1;
+    CbValue* arg2;
+    cb_stack_pop(arg_stack, (void*) &arg2); // first pop -> last argument
+    cb_stack_pop(arg_stack, (void*) &arg1);
+    
+    if (!cb_argument_check(arg1, CB_VT_VALARRAY) ||
+        !cb_argument_check(arg2, CB_VT_VALARRAY))
+    {
+        cb_value_free(arg1);
+        cb_value_free(arg2);
+        return cb_builtin_throw();
+    }
+    
+    CbValue* result        = NULL;
+    size_t count1          = 0;
+    size_t count2          = 0;
+    CbNumeric* buffer1     = NULL;
+    CbNumeric* buffer2     = NULL;
+    const CbNumeric* data1 = cb_numeric_data_from_valarray(arg1, &count1,
+                                                           &buffer1);
+    const CbNumeric* data2 = cb_numeric_data_from_valarray(arg2, &count2,
+                                                           &buffer2);
+    CbFloat* floats1       = NULL;
+    CbFloat* floats2       = NULL;
+    
+    // both arrays are treated as floats, as soon as one contains a float
+    if (data1 == NULL || data2 == NULL)
+    {
+        floats1 = cb_float_data_from_valarray(arg1);
+        floats2 = cb_float_data_from_valarray(arg2);
+    }
+    
+    if ((data1 == NULL || data2 == NULL) &&
+        (floats1 == NULL || floats2 == NULL))
+        cb_error_set(CB_ERR_CODE_ARRAYNOTNUMERIC);
+    else if (count1 != count2)
+        cb_error_set(CB_ERR_CODE_ARRAYSIZEMISMATCH);
+    else if (data1 && data2)
+        result = cb_numeric_create(cb_numeric_kernel_dot(data1, data2, count1));
+    else
+        result = cb_float_create(cb_float_kernel_dot(floats1, floats2, count1));
+    
+    free(buffer1);
+    free(buffer2);
+    free(floats1);
+    free(floats2);
+    cb_value_free(arg1);
+    cb_value_free(arg2);
+    
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// ArrayNew() -- Create an empty array with space for the given count of
+//               elements
+// -----------------------------------------------------------------------------
+CbValue* bif_arraynew(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 1);
+    
+    CbValue* arg;
+    cb_stack_pop(arg_stack, (void*) &arg);
+    
+    if (!cb_argument_check(arg, CB_VT_NUMERIC))
+    {
+        cb_value_free(arg);
+        return cb_builtin_throw();
+    }
+    
+    CbValue* result = NULL;
+    
+    if (cb_numeric_get(arg) < 0)
+        cb_error_set(CB_ERR_CODE_ARRAYSIZENEGATIVE);
+    else
+    {
+        CbArray* array = cb_array_create_valarray();
+        if (cb_array_reserve(array, cb_numeric_get(arg)))
+            result = cb_valarray_create(array);
+        else
+        {
+            // the memory quota would be exceeded
+            cb_array_free(array);
+        }
+    }
+    
+    cb_value_free(arg);
+    
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// AAdd() -- Append a value to an array
+//
+//    The array is changed in place, so AAdd(aArray, x) changes the array of the
+//    variable 'aArray', but no other value sharing the array (see
+//    cb_function_call()). The appended value is returned.
+// -----------------------------------------------------------------------------
+CbValue* bif_aadd(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 2);
+    
+    CbValue* arg;
+    CbValue* element;
+    cb_stack_pop(arg_stack, (void*) &element); // first pop -> last argument
+    cb_stack_pop(arg_stack, (void*) &arg);
+    
+    if (!cb_argument_check(arg, CB_VT_VALARRAY))
+    {
+        cb_value_free(arg);
+        cb_value_free(element);
+        return cb_builtin_throw();
+    }
+    
+    // the array takes ownership of the element
+    cb_value_detach(element);
+    CbValue* result = cb_value_copy(element);
+    cb_array_append(cb_valarray_get(arg), (CbArrayItem) element);
+    
+    cb_value_free(arg);
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// ASize() -- Determines the count of elements of an array
+// -----------------------------------------------------------------------------
+CbValue* bif_asize(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 1);
+    
+    CbValue* arg;
+    cb_stack_pop(arg_stack, (void*) &arg);
+    
+    if (!cb_argument_check(arg, CB_VT_VALARRAY))
+    {
+        cb_value_free(arg);
+        return cb_builtin_throw();
+    }
+    
+    CbValue* result = cb_numeric_create(cb_array_get_count(cb_valarray_get(arg)));
+    
+    cb_value_free(arg);
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// HGet() -- Value of a key in a hash
+// -----------------------------------------------------------------------------
+CbValue* bif_hget(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 2);
+    
+    CbValue* arg;
+    CbValue* key;
+    cb_stack_pop(arg_stack, (void*) &key); // first pop -> last argument
+    cb_stack_pop(arg_stack, (void*) &arg);
+    
+    if (!cb_argument_check(arg, CB_VT_HASH))
+    {
+        cb_value_free(arg);
+        cb_value_free(key);
+        return cb_builtin_throw();
+    }
+    
+    CbValue* result = NULL;
+    CbValue* value  = cb_hash_get(cb_valhash_get(arg), key);
+    
+    if (!cb_hash_is_valid_key(key))
+        cb_error_set(CB_ERR_CODE_HASHKEYINVALID);
+    else if (value == NULL)
+        cb_error_set(CB_ERR_CODE_HASHKEYNOTFOUND);
+    else
+        result = cb_value_share(value);
+    
+    cb_value_free(arg);
+    cb_value_free(key);
+    
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// HSet() -- Set the value of a key in a hash
+//
+//    Like AAdd() the hash is changed in place. The value is returned.
+// -----------------------------------------------------------------------------
+CbValue* bif_hset(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 3);
+    
+    CbValue* arg;
+    CbValue* key;
+    CbValue* value;
+    cb_stack_pop(arg_stack, (void*) &value); // first pop -> last argument
+    cb_stack_pop(arg_stack, (void*) &key);
+    cb_stack_pop(arg_stack, (void*) &arg);
+    
+    if (!cb_argument_check(arg, CB_VT_HASH))
+    {
+        cb_value_free(arg);
+        cb_value_free(key);
+        cb_value_free(value);
+        return cb_builtin_throw();
+    }
+    
+    CbValue* result = NULL;
+    
+    if (!cb_hash_is_valid_key(key))
+    {
+        cb_error_set(CB_ERR_CODE_HASHKEYINVALID);
+        cb_value_free(value);
+    }
+    else
+    {
+        // the hash takes ownership of the value
+        cb_value_detach(value);
+        result = cb_value_copy(value);
+        cb_hash_set(cb_valhash_get(arg), key, value);
+    }
+    
+    cb_value_free(arg);
+    cb_value_free(key);
+    
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// HHas() -- Check if a key exists in a hash
+// -----------------------------------------------------------------------------
+CbValue* bif_hhas(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 2);
+    
+    CbValue* arg;
+    CbValue* key;
+    cb_stack_pop(arg_stack, (void*) &key); // first pop -> last argument
+    cb_stack_pop(arg_stack, (void*) &arg);
+    
+    if (!cb_argument_check(arg, CB_VT_HASH))
+    {
+        cb_value_free(arg);
+        cb_value_free(key);
+        return cb_builtin_throw();
+    }
+    
+    CbValue* result = cb_boolean_create(cb_hash_has(cb_valhash_get(arg), key));
+    
+    cb_value_free(arg);
+    cb_value_free(key);
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// HDel() -- Remove a key from a hash
+//
+//    Like AAdd() the hash is changed in place. Returns True, if the key
+//    existed.
+// -----------------------------------------------------------------------------
+CbValue* bif_hdel(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 2);
+    
+    CbValue* arg;
+    CbValue* key;
+    cb_stack_pop(arg_stack, (void*) &key); // first pop -> last argument
+    cb_stack_pop(arg_stack, (void*) &arg);
+    
+    if (!cb_argument_check(arg, CB_VT_HASH))
+    {
+        cb_value_free(arg);
+        cb_value_free(key);
+        return cb_builtin_throw();
+    }
+    
+    CbValue* result = cb_boolean_create(cb_hash_remove(cb_valhash_get(arg),
+                                                       key));
+    
+    cb_value_free(arg);
+    cb_value_free(key);
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// HKeys() -- Array of all keys of a hash (in insertion order)
+// -----------------------------------------------------------------------------
+CbValue* bif_hkeys(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 1);
+    
+    CbValue* arg;
+    cb_stack_pop(arg_stack, (void*) &arg);
+    
+    if (!cb_argument_check(arg, CB_VT_HASH))
+    {
+        cb_value_free(arg);
+        return cb_builtin_throw();
+    }
+    
+    CbHash* hash   = cb_valhash_get(arg);
+    CbArray* array = cb_array_create_valarray();
+    cb_array_reserve(array, cb_hash_get_count(hash));
+    
+    size_t position    = 0;
+    const CbValue* key = NULL;
+    CbValue* value     = NULL;
+    while (cb_hash_iterate(hash, &position, &key, &value))
+        cb_array_append(array, (CbArrayItem) cb_value_copy(key));
+    
+    CbValue* result = cb_valarray_create(array);
+    
+    cb_value_free(arg);
+    
+    return result;
+}
+
+
+// -----------------------------------------------------------------------------
+// ReadLn() -- Read a line from the input (stdin by default)
+//
+//    An empty value is returned at the end of the input.
+// -----------------------------------------------------------------------------
+CbValue* bif_readln(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 0);
+    
+    const char* line = NULL;
+    size_t length    = 0;
+    
+    if (cb_reader_read_line(cb_reader_get_input(), &line, &length))
+        return cb_string_from_line(line, length);
+    
+    return cb_value_create();
+}
+
+// -----------------------------------------------------------------------------
+// FOpen() -- Open a file for reading, returns a file handle
+// -----------------------------------------------------------------------------
+CbValue* bif_fopen(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 1);
+    
+    CbValue* name;
+    cb_stack_pop(arg_stack, (void*) &name);
+    
+    assert(cb_value_is_type(name, CB_VT_STRING));
+    
+    CbValue* result  = NULL;
+    CbReader* reader = cb_reader_open(cb_string_get(name));
+    
+    if (reader == NULL)
+        cb_error_set(CB_ERR_CODE_FILEOPEN);
+    else
+    {
+        // reuse the handle of a closed file
+        size_t i = 0;
+        while (i < open_files_count && open_files[i] != NULL)
+            i++;
+        
+        if (i == open_files_count)
+        {
+            open_files = (CbReader**) realloc(open_files, (open_files_count + 1) *
+                                                          sizeof(CbReader*));
+            open_files_count++;
+        }
+        
+        open_files[i] = reader;
+        result        = cb_numeric_create(i + 1);
+    }
+    
+    cb_value_free(name);
+    
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// FReadLine() -- Read the next line of a file
+//
+//    An empty value is returned at the end of the file.
+// -----------------------------------------------------------------------------
+CbValue* bif_freadline(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 1);
+    
+    CbValue* handle;
+    cb_stack_pop(arg_stack, (void*) &handle);
+    
+    CbValue* result  = NULL;
+    CbReader* reader = cb_file_get(handle);
+    const char* line = NULL;
+    size_t length    = 0;
+    
+    if (reader == NULL)
+        cb_error_set(CB_ERR_CODE_FILEHANDLEINVALID);
+    else if (cb_reader_read_line(reader, &line, &length))
+        result = cb_string_from_line(line, length);
+    else
+        result = cb_value_create();
+    
+    cb_value_free(handle);
+    
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// FClose() -- Close a file
+// -----------------------------------------------------------------------------
+CbValue* bif_fclose(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 1);
+    
+    CbValue* handle;
+    cb_stack_pop(arg_stack, (void*) &handle);
+    
+    CbValue* result  = NULL;
+    CbReader* reader = cb_file_get(handle);
+    
+    if (reader == NULL)
+        cb_error_set(CB_ERR_CODE_FILEHANDLEINVALID);
+    else
+    {
+        cb_reader_free(reader);
+        open_files[cb_numeric_get(handle) - 1] = NULL;
+        result = cb_boolean_create(true);
+    }
+    
+    cb_value_free(handle);
+    
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// FReadAll() -- Read a whole file into a string
+// -----------------------------------------------------------------------------
+CbValue* bif_freadall(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 1);
+    
+    CbValue* name;
+    cb_stack_pop(arg_stack, (void*) &name);
+    
+    assert(cb_value_is_type(name, CB_VT_STRING));
+    
+    CbValue* result  = NULL;
+    CbReader* reader = cb_reader_open(cb_string_get(name));
+    
+    if (reader == NULL)
+        cb_error_set(CB_ERR_CODE_FILEOPEN);
+    else
+    {
+        result = cb_string_create(cb_reader_read_all(reader, NULL));
+        cb_reader_free(reader);
+    }
+    
+    cb_value_free(name);
+    
+    if (result == NULL)
+        return cb_builtin_throw(); // an error was raised
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// MemStats() -- Memory statistics of the subsystems
+//
+//    Every element is a hash with the keys 'subsystem', 'allocations',
+//    'frees', 'bytes', 'live' and 'peak', the last element holds the totals.
+// -----------------------------------------------------------------------------
+CbValue* bif_memstats(CbStack* arg_stack)
+{
+    assert(arg_stack->count == 0);
+    
+    // take the statistics, before the result allocates memory
+    CbAllocStats stats[CB_ALLOC_SUBSYSTEM_COUNT + 1];
+    
+    int i = 0;
+    for (; i < CB_ALLOC_SUBSYSTEM_COUNT; i++)
+        cb_alloc_get_stats((enum cb_alloc_subsystem) i, &stats[i]);
+    
+    cb_alloc_get_total_stats(&stats[CB_ALLOC_SUBSYSTEM_COUNT]);
+    
+    CbArray* array = cb_array_create_valarray();
+    cb_array_reserve(array, CB_ALLOC_SUBSYSTEM_COUNT + 1);
+    
+    for (i = 0; i <= CB_ALLOC_SUBSYSTEM_COUNT; i++)
+    {
+        const char* name = (i < CB_ALLOC_SUBSYSTEM_COUNT)
+                         ? cb_alloc_get_subsystem_name(
+                               (enum cb_alloc_subsystem) i)
+                         : "total";
+        
+        cb_array_append(array,
+                        (CbArrayItem) cb_memstats_create_hash(name, &stats[i]));
+    }
+    
+    return cb_valarray_create(array);
+}
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Close all files opened by FOpen() and release their handles
+// -----------------------------------------------------------------------------
+void cb_lib_close_files()
+{
+    size_t i = 0;
+    for (; i < open_files_count; i++)
+    {
+        if (open_files[i] != NULL)
+            cb_reader_free(open_files[i]);
+    }
+    
+    free(open_files);
+    open_files       = NULL;
+    open_files_count = 0;
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Get the elements of a numeric array as a contiguous buffer (internal)
+//
+//    Arrays with a packed numeric layout provide their buffer directly. Other
+//    arrays are copied into a new buffer, which is returned in 'buffer' and
+//    must be freed after usage (it's NULL, if nothing was allocated).
+//    In case the array contains any non-numeric element or a float, NULL is
+//    returned.
+// -----------------------------------------------------------------------------
+static const CbNumeric* cb_numeric_data_from_valarray(const CbValue* val,
+                                                      size_t* count,
+                                                      CbNumeric** buffer)
+{
+    CbArray* array = cb_valarray_get(val);
+    *count         = cb_array_get_count(array);
+    *buffer        = NULL;
+    
+    const CbNumeric* packed = cb_array_get_numeric_data(array);
+    if (packed != NULL)
+        return packed;
+    
+    // always allocate at least one element, so that NULL indicates an error
+    CbNumeric* data = (CbNumeric*) malloc((*count + 1) * sizeof(CbNumeric));
+    
+    size_t i = 0;
+    for (; i < *count; i++)
+    {
+        CbValue* item = NULL;
+        cb_array_get(array, i, (CbArrayItem*) &item);
+        
+        if (item == NULL || !cb_value_is_type(item, CB_VT_NUMERIC) ||
+            cb_numeric_is_float(item))
+        {
+            free(data);
+            return NULL;
+        }
+        
+        data[i] = cb_numeric_get(item);
+    }
+    
+    *buffer = data;
+    return data;
+}
+
+// -----------------------------------------------------------------------------
+// Copy the elements of a numeric array into a new float buffer (internal)
+//
+//    The returned buffer must be freed after usage.
+//    In case the array contains any non-numeric element, NULL is returned.
+// -----------------------------------------------------------------------------
+static CbFloat* cb_float_data_from_valarray(const CbValue* val)
+{
+    CbArray* array = cb_valarray_get(val);
+    size_t count   = cb_array_get_count(array);
+    // always allocate at least one element, so that NULL indicates an error
+    CbFloat* data  = (CbFloat*) malloc((count + 1) * sizeof(CbFloat));
+    
+    size_t i = 0;
+    
+    // packed integers are converted directly
+    const CbNumeric* packed = cb_array_get_numeric_data(array);
+    if (packed != NULL)
+    {
+        for (; i < count; i++)
+            data[i] = (CbFloat) packed[i];
+        
+        return data;
+    }
+    
+    for (; i < count; i++)
+    {
+        CbValue* item = NULL;
+        cb_array_get(array, i, (CbArrayItem*) &item);
+        
+        if (item == NULL || !cb_value_is_type(item, CB_VT_NUMERIC))
+        {
+            free(data);
+            return NULL;
+        }
+        
+        data[i] = cb_numeric_get_float(item);
+    }
+    
+    return data;
+}
+
+// -----------------------------------------------------------------------------
+// Sum of a numeric buffer (internal)
+// 
+//    The numeric kernels consist of plain loops over contiguous buffers without
+//    any data dependent branches, so that the compiler is able to vectorize
+//    them (SSE/AVX, NEON) as soon as optimizations are enabled.
+//    Independent accumulators break the loop-carried dependency of reductions.
+// -----------------------------------------------------------------------------
+static CbNumeric cb_numeric_kernel_sum(const CbNumeric* data, size_t count)
+{
+    CbNumeric acc[4] = {0, 0, 0, 0};
+    size_t i         = 0;
+    
+    for (; i + 4 <= count; i += 4)
+    {
+        acc[0] += data[i];
+        acc[1] += data[i + 1];
+        acc[2] += data[i + 2];
+        acc[3] += data[i + 3];
+    }
+    
+    for (; i < count; i++) // remaining elements
+        acc[0] += data[i];
+    
+    return acc[0] + acc[1] + acc[2] + acc[3];
+}
+
+// -----------------------------------------------------------------------------
+// Smallest value of a numeric buffer (internal)
+// -----------------------------------------------------------------------------
+static CbNumeric cb_numeric_kernel_min(const CbNumeric* data, size_t count)
+{
+    assert(count > 0);
+    
+    CbNumeric result = data[0];
+    size_t i         = 1;
+    
+    for (; i < count; i++)
+        result = (data[i] < result) ? data[i] : result;
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Largest value of a numeric buffer (internal)
+// -----------------------------------------------------------------------------
+static CbNumeric cb_numeric_kernel_max(const CbNumeric* data, size_t count)
+{
+    assert(count > 0);
+    
+    CbNumeric result = data[0];
+    size_t i         = 1;
+    
+    for (; i < count; i++)
+        result = (data[i] > result) ? data[i] : result;
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Multiply a numeric buffer by a factor (internal)
+// -----------------------------------------------------------------------------
+static void cb_numeric_kernel_scale(const CbNumeric* data, size_t count,
+                                    CbNumeric factor, CbNumeric* destination)
+{
+    size_t i = 0;
+    
+    for (; i < count; i++)
+        destination[i] = data[i] * factor;
+}
+
+// -----------------------------------------------------------------------------
+// Dot product of two numeric buffers (internal)
+// -----------------------------------------------------------------------------
+static CbNumeric cb_numeric_kernel_dot(const CbNumeric* a, const CbNumeric* b,
+                                       size_t count)
+{
+    CbNumeric acc[4] = {0, 0, 0, 0};
+    size_t i         = 0;
+    
+    for (; i + 4 <= count; i += 4)
+    {
+        acc[0] += a[i] * b[i];
+        acc[1] += a[i + 1] * b[i + 1];
+        acc[2] += a[i + 2] * b[i + 2];
+        acc[3] += a[i + 3] * b[i + 3];
+    }
+    
+    for (; i < count; i++) // remaining elements
+        acc[0] += a[i] * b[i];
+    
+    return acc[0] + acc[1] + acc[2] + acc[3];
+}
+
+// -----------------------------------------------------------------------------
+// Sum of a float buffer (internal)
+// -----------------------------------------------------------------------------
+static CbFloat cb_float_kernel_sum(const CbFloat* data, size_t count)
+{
+    CbFloat acc[4] = {0, 0, 0, 0};
+    size_t i       = 0;
+    
+    for (; i + 4 <= count; i += 4)
+    {
+        acc[0] += data[i];
+        acc[1] += data[i + 1];
+        acc[2] += data[i + 2];
+        acc[3] += data[i + 3];
+    }
+    
+    for (; i < count; i++) // remaining elements
+        acc[0] += data[i];
+    
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+// -----------------------------------------------------------------------------
+// Smallest value of a float buffer (internal)
+// -----------------------------------------------------------------------------
+static CbFloat cb_float_kernel_min(const CbFloat* data, size_t count)
+{
+    assert(count > 0);
+    
+    CbFloat result = data[0];
+    size_t i       = 1;
+    
+    for (; i < count; i++)
+        result = (data[i] < result) ? data[i] : result;
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Largest value of a float buffer (internal)
+// -----------------------------------------------------------------------------
+static CbFloat cb_float_kernel_max(const CbFloat* data, size_t count)
+{
+    assert(count > 0);
+    
+    CbFloat result = data[0];
+    size_t i       = 1;
+    
+    for (; i < count; i++)
+        result = (data[i] > result) ? data[i] : result;
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Multiply a float buffer by a factor in place (internal)
+// -----------------------------------------------------------------------------
+static void cb_float_kernel_scale(CbFloat* data, size_t count, CbFloat factor)
+{
+    size_t i = 0;
+    
+    for (; i < count; i++)
+        data[i] *= factor;
+}
+
+// -----------------------------------------------------------------------------
+// Dot product of two float buffers (internal)
+// -----------------------------------------------------------------------------
+static CbFloat cb_float_kernel_dot(const CbFloat* a, const CbFloat* b,
+                                   size_t count)
+{
+    CbFloat acc[4] = {0, 0, 0, 0};
+    size_t i       = 0;
+    
+    for (; i + 4 <= count; i += 4)
+    {
+        acc[0] += a[i] * b[i];
+        acc[1] += a[i + 1] * b[i + 1];
+        acc[2] += a[i + 2] * b[i + 2];
+        acc[3] += a[i + 3] * b[i + 3];
+    }
+    
+    for (; i < count; i++) // remaining elements
+        acc[0] += a[i] * b[i];
+    
+    return (acc[0] + acc[1]) + (acc[2] + acc[3]);
+}
+
+// -----------------------------------------------------------------------------
+// Check the value-type of an argument and raise an error, if it differs
+// (internal)
+//
+//    Arguments are values of the script, so a wrong type is a catchable error
+//    instead of a failed assertion.
+// -----------------------------------------------------------------------------
+static bool cb_argument_check(const CbValue* arg, enum cb_value_type type)
+{
+    if (cb_value_is_type(arg, type))
+        return true;
+    
+    cb_error_set(CB_ERR_CODE_ARGUMENTTYPE);
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Throw the error raised by a builtin function, after its arguments were
+// freed (internal)
+//
+//    Without an enclosing frame the error stays set and an empty value is
+//    returned instead.
+// -----------------------------------------------------------------------------
+static CbValue* cb_builtin_throw()
+{
+    cb_error_throw();
+    return cb_value_create();
+}
+
+// -----------------------------------------------------------------------------
+// Create a string value from a line of input (internal)
+// -----------------------------------------------------------------------------
+static CbValue* cb_string_from_line(const char* line, size_t length)
+{
+    char* string = (char*) malloc(length + 1);
+    memcpy(string, line, length);
+    string[length] = '\0';
+    
+    return cb_string_create(string);
+}
+
+// -----------------------------------------------------------------------------
+// Get the reader of a file handle (NULL, if the handle is invalid) (internal)
+// -----------------------------------------------------------------------------
+static CbReader* cb_file_get(const CbValue* handle)
+{
+    if (!cb_value_is_type(handle, CB_VT_NUMERIC))
+        return NULL;
+    
+    CbNumeric index = cb_numeric_get(handle) - 1;
+    if (index < 0 || (size_t) index >= open_files_count)
+        return NULL;
+    
+    return open_files[index];
+}
+
+// -----------------------------------------------------------------------------
+// Create the hash of a subsystem's memory statistics (internal)
+// -----------------------------------------------------------------------------
+static CbValue* cb_memstats_create_hash(const char* name,
+                                        const CbAllocStats* stats)
+{
+    CbHash* hash = cb_hash_create();
+    CbValue* key = cb_string_create(strdup("subsystem"));
+    
+    cb_hash_set(hash, key, cb_string_create(strdup(name)));
+    cb_value_free(key);
+    
+    cb_memstats_set(hash, "allocations", stats->allocations);
+    cb_memstats_set(hash, "frees", stats->frees);
+    cb_memstats_set(hash, "bytes", stats->bytes);
+    cb_memstats_set(hash, "live", stats->live);
+    cb_memstats_set(hash, "peak", stats->peak);
+    
+    return cb_valhash_create(hash);
+}
+
+// -----------------------------------------------------------------------------
+// Set a numeric entry of a hash (internal)
+// -----------------------------------------------------------------------------
+static void cb_memstats_set(CbHash* hash, const char* key, uint64_t value)
+{
+    CbValue* key_value = cb_string_create(strdup(key));
+    
+    cb_hash_set(hash, key_value, cb_numeric_create((CbNumeric) value));
+    cb_value_free(key_value);
+}
@@ -27,6 +27,28 @@ CbValue* bif_getenv(CbStack* arg_stack);
 CbValue* bif_seterror(CbStack* arg_stack);
 CbValue* bif_seterrorif(CbStack* arg_stack);
 CbValue* bif_geterrortext(CbStack* arg_stack);
+CbValue* bif_asum(CbStack* arg_stack);
+CbValue* bif_amin(CbStack* arg_stack);
+CbValue* bif_amax(CbStack* arg_stack);
+CbValue* bif_ascale(CbStack* arg_stack);
+CbValue* bif_adot(CbStack* arg_stack);
+CbValue* bif_arraynew(CbStack* arg_stack);
+CbValue* bif_aadd(CbStack* arg_stack);
+CbValue* bif_asize(CbStack* arg_stack);
+CbValue* bif_hget(CbStack* arg_stack);
+CbValue* bif_hset(CbStack* arg_stack);
+CbValue* bif_hhas(CbStack* arg_stack);
+CbValue* bif_hdel(CbStack* arg_stack);
+CbValue* bif_hkeys(CbStack* arg_stack);
+CbValue* bif_readln(CbStack* arg_stack);
+CbValue* bif_fopen(CbStack* arg_stack);
+CbValue* bif_freadline(CbStack* arg_stack);
+CbValue* bif_fclose(CbStack* arg_stack);
+CbValue* bif_freadall(CbStack* arg_stack);
+CbValue* bif_memstats(CbStack* arg_stack);
+
+// interface functions
+void cb_lib_close_files();
 
 
 #endif // CBLIB_H
@@ -11,6 +11,8 @@
 #include "cbc_parse.h"
 #include "syntree.h"
 #include "builtin.h"
+#include "image.h"
+#include "optimizer.h"
 
 
 // #############################################################################
@@ -19,6 +21,7 @@
 
 static void codeblock_reset(Codeblock* cb);
 static void codeblock_reset_result(Codeblock* cb);
+static void codeblock_execute_internal(Codeblock* cb, bool shared_symtab);
 static int codeblock_parse_internal(Codeblock* cb);
 
 
@@ -36,6 +39,10 @@ Codeblock* codeblock_create()
     cb->ast       = NULL;
     cb->result    = NULL;
     cb->embedded  = false;
+    cb->output    = NULL;
+    cb->limits    = NULL;
+    cb->optimize  = true;
+    cb->optimized = false;
     
     return cb;
 }
@@ -89,6 +96,39 @@ int codeblock_parse_string(Codeblock* cb, const char* string)
     return result;
 }
 
+// -----------------------------------------------------------------------------
+// load a compiled image file instead of parsing the source
+// -----------------------------------------------------------------------------
+int codeblock_load_image(Codeblock* cb, const char* file_name)
+{
+    codeblock_reset(cb);
+    
+    cb->ast = cb_image_load_file(file_name);
+    if (cb->ast == NULL)
+    {
+        cb_print_error_msg("Invalid or corrupted image `%s'", file_name);
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+// save the parsed codeblock as compiled image file
+// -----------------------------------------------------------------------------
+int codeblock_save_image(Codeblock* cb, const char* file_name)
+{
+    assert(cb->ast);
+    
+    if (cb_image_save_file(cb->ast, file_name) != EXIT_SUCCESS)
+    {
+        cb_print_error_msg("Unable to write image `%s'", file_name);
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}
+
 // -----------------------------------------------------------------------------
 // execute codeblock
 // -----------------------------------------------------------------------------
@@ -101,29 +141,34 @@ int codeblock_execute(Codeblock* cb)
     
     cb->symtab = cb_symtab_create();                      // create symbol table
     if (register_builtin_all(cb->symtab) == EXIT_SUCCESS) // register builtin symbols
-    {
-        clock_t begin = clock(); // begin tracking of execution duration
-        
-        bool error_handling_initialized = cb_error_handling_is_initialized();
-        if (!error_handling_initialized)
-            cb_error_handling_initialize();
-        
-        // execute codeblock
-        cb->result = cb_syntree_eval(cb->ast, cb->symtab);
-        
-        // check if there was an uncatched error
-        if (cb_error_is_set() && !cb->embedded)
-            // print last error message, if executed codeblock is not embedded
-            cb_print_error_msg(cb_error_get_message());
-        
-        if (!error_handling_initialized)
-            cb_error_handling_finalize();
-        
-        clock_t end  = clock(); // end tracking of execution duration
-        cb->duration = ((double) end - (double) begin) / CLOCKS_PER_SEC;
-    }
+        codeblock_execute_internal(cb, false);
     
     cb_symtab_free(cb->symtab); // cleanup symbol table
+    cb->symtab = NULL;
+    
+    if (cb->result == NULL)
+        return EXIT_FAILURE;
+    else
+        return EXIT_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+// execute codeblock with a symbol-table owned by the caller
+//
+//    The builtin symbols have to be registered already. Symbols declared by
+//    the codeblock are kept in the symbol-table, so the codeblock must not be
+//    freed before the symbol-table, if it declares functions.
+// -----------------------------------------------------------------------------
+int codeblock_execute_with_symtab(Codeblock* cb, CbSymtab* symtab)
+{
+    assert(cb->ast);
+    
+    cb->duration = 0;
+    codeblock_reset_result(cb);
+    
+    cb->symtab = symtab;
+    codeblock_execute_internal(cb, true);
+    cb->symtab = NULL;
     
     if (cb->result == NULL)
         return EXIT_FAILURE;
@@ -146,6 +191,8 @@ static void codeblock_reset(Codeblock* cb)
         cb_syntree_free(cb->ast);
         cb->ast = NULL;
     }
+    
+    cb->optimized = false;
 }
 
 // -----------------------------------------------------------------------------
@@ -160,6 +207,66 @@ static void codeblock_reset_result(Codeblock* cb)
     }
 }
 
+// -----------------------------------------------------------------------------
+// evaluate the syntax-tree with the codeblock's symbol-table (internal)
+//
+//    The syntax-tree is optimized for its first execution, i.e. symbols
+//    declared at top level are kept, if the symbol-table is shared then.
+// -----------------------------------------------------------------------------
+static void codeblock_execute_internal(Codeblock* cb, bool shared_symtab)
+{
+    clock_t begin = clock(); // begin tracking of execution duration
+    
+    if (cb->optimize && !cb->optimized)
+    {
+        cb_optimizer_run(&cb->ast, shared_symtab);
+        cb->optimized = true;
+    }
+    
+    bool error_handling_initialized = cb_error_handling_is_initialized();
+    if (!error_handling_initialized)
+        cb_error_handling_initialize();
+    
+    // install output sink of the codeblock
+    CbOutput* output          = (cb->output) ? cb->output
+                                             : cb_output_get_current();
+    CbOutput* previous_output = cb_output_set_current(output);
+    
+    // activate the limits, unless an enclosing execution is limited already
+    bool limited = cb->limits && !cb_limits_enabled;
+    if (limited)
+        cb_limits_start(cb->limits);
+    
+    // execute codeblock, uncatched errors unwind to here
+    CbErrorFrame frame;
+    if (setjmp(frame.env) == 0)
+    {
+        cb_error_push_frame(&frame);
+        cb->result = cb_syntree_eval(cb->ast, cb->symtab);
+        cb_error_pop_frame(&frame);
+    }
+    else
+        cb->result = NULL;
+    
+    if (limited)
+        cb_limits_stop();
+    
+    // write pending output, before an error message is printed
+    cb_output_flush(output);
+    cb_output_set_current(previous_output);
+    
+    // check if there was an uncatched error
+    if (cb_error_is_set() && !cb->embedded)
+        // print last error message, if executed codeblock is not embedded
+        cb_print_error_msg(cb_error_get_message());
+    
+    if (!error_handling_initialized)
+        cb_error_handling_finalize();
+    
+    clock_t end  = clock(); // end tracking of execution duration
+    cb->duration = ((double) end - (double) begin) / CLOCKS_PER_SEC;
+}
+
 // -----------------------------------------------------------------------------
 // parse codeblock (internal)
 // -----------------------------------------------------------------------------
@@ -13,6 +13,8 @@
 #include "symtab.h"
 #include "syntree_if.h"
 #include "value.h"
+#include "output.h"
+#include "exec_limits.h"
 
 typedef struct
 {
@@ -21,6 +23,10 @@ typedef struct
     CbValue* result;  // the result, after executing the codeblock
     double duration;  // execution duration
     bool embedded;    // determine if codeblock is embedded
+    CbOutput* output; // output sink (NULL: use the current output)
+    CbLimits* limits; // execution limits (NULL: unlimited)
+    bool optimize;    // optimize the syntax-tree before the first execution
+    bool optimized;   // the syntax-tree was optimized already
 } Codeblock;
 
 
@@ -29,7 +35,10 @@ Codeblock* codeblock_create();
 void codeblock_free(Codeblock* cb);
 int codeblock_parse_file(Codeblock* cb, FILE* input);
 int codeblock_parse_string(Codeblock* cb, const char* string);
+int codeblock_load_image(Codeblock* cb, const char* file_name);
+int codeblock_save_image(Codeblock* cb, const char* file_name);
 int codeblock_execute(Codeblock* cb);
+int codeblock_execute_with_symtab(Codeblock* cb, CbSymtab* symtab);
 
 
 #endif // CODEBLOCK_H
@@ -14,6 +14,7 @@
 #include <assert.h>
 #include "error_handling.h"
 #include "error_messages.h"
+#include "value.h"
 
 
 // #############################################################################
@@ -32,6 +33,21 @@ static bool error_handling_initialized;
 // Default error output stream
 static FILE* err_out = NULL;
 
+// Innermost frame and the pushed cleanups
+typedef struct
+{
+    void* resource;
+    CbErrorCleanup cleanup;
+} CbErrorCleanupEntry;
+
+static CbErrorFrame* error_frame = NULL;
+static CbErrorCleanupEntry* cleanups = NULL;
+static size_t cleanup_count          = 0;
+static size_t cleanup_capacity       = 0;
+
+// Temporary values of the evaluation
+CbErrorTemporaries cb_error_temporaries = { NULL, 0, 0 };
+
 static void cb_print_error_internal(FILE* output, cb_error_type type, int line,
                                     const char* format, va_list* args);
 static void cb_print_error_msg_internal(FILE* output, const char* format,
@@ -287,6 +303,20 @@ void cb_error_handling_finalize()
         if (error_message != NULL)
             free(error_message);
         
+        if (cleanup_count == 0) // no evaluation holds resources anymore
+        {
+            free(cleanups);
+            cleanups         = NULL;
+            cleanup_capacity = 0;
+        }
+        
+        if (cb_error_temporaries.count == 0)
+        {
+            free(cb_error_temporaries.values);
+            cb_error_temporaries.values   = NULL;
+            cb_error_temporaries.capacity = 0;
+        }
+        
         error_handling_initialized = false;
     }
 }
@@ -299,6 +329,110 @@ bool cb_error_handling_is_initialized()
     return error_handling_initialized;
 }
 
+// -----------------------------------------------------------------------------
+// Test if an error is set, which isn't catched (i.e. which has to be thrown)
+// -----------------------------------------------------------------------------
+bool cb_error_is_pending()
+{
+    return error_flag != CB_ERR_CODE_NOERROR && !error_catched;
+}
+
+// -----------------------------------------------------------------------------
+// Push a frame, which catches thrown errors
+//
+//    The frame's jmp_buf has to be set by setjmp() before. If an error is
+//    thrown, setjmp() returns again with a non-zero value and the frame is
+//    popped already.
+// -----------------------------------------------------------------------------
+void cb_error_push_frame(CbErrorFrame* frame)
+{
+    frame->cleanup_count   = cleanup_count;
+    frame->temporary_count = cb_error_temporaries.count;
+    frame->prior           = error_frame;
+    error_frame            = frame;
+}
+
+// -----------------------------------------------------------------------------
+// Pop a frame, after the evaluation returned normally
+// -----------------------------------------------------------------------------
+void cb_error_pop_frame(CbErrorFrame* frame)
+{
+    assert(error_frame == frame);
+    assert(cleanup_count == frame->cleanup_count);
+    assert(cb_error_temporaries.count == frame->temporary_count);
+    
+    error_frame = frame->prior;
+}
+
+// -----------------------------------------------------------------------------
+// Unwind to the innermost frame
+//
+//    Without a frame nothing happens, so the caller has to return an invalid
+//    result afterwards, as for any other runtime error.
+// -----------------------------------------------------------------------------
+void cb_error_throw()
+{
+    CbErrorFrame* frame = error_frame;
+    if (frame == NULL)
+        return;
+    
+    // free the temporaries and release the resources of the unwound
+    // evaluations, innermost first
+    CbErrorTemporaries* temporaries = &cb_error_temporaries;
+    while (temporaries->count > frame->temporary_count)
+        cb_value_free(temporaries->values[--temporaries->count]);
+    
+    while (cleanup_count > frame->cleanup_count)
+    {
+        cleanup_count--;
+        cleanups[cleanup_count].cleanup(cleanups[cleanup_count].resource);
+    }
+    
+    error_frame = frame->prior;
+    longjmp(frame->env, 1);
+}
+
+// -----------------------------------------------------------------------------
+// Push a cleanup, which releases a resource, if the evaluation is unwound
+// -----------------------------------------------------------------------------
+void cb_error_push_cleanup(void* resource, CbErrorCleanup cleanup)
+{
+    if (cleanup_count == cleanup_capacity)
+    {
+        cleanup_capacity = (cleanup_capacity) ? cleanup_capacity * 2 : 256;
+        cleanups         = (CbErrorCleanupEntry*) realloc(cleanups,
+                               cleanup_capacity * sizeof(CbErrorCleanupEntry));
+    }
+    
+    cleanups[cleanup_count].resource = resource;
+    cleanups[cleanup_count].cleanup  = cleanup;
+    cleanup_count++;
+}
+
+// -----------------------------------------------------------------------------
+// Pop the last cleanup, after the resource was released or passed on
+// -----------------------------------------------------------------------------
+void cb_error_pop_cleanup()
+{
+    assert(cleanup_count > 0);
+    
+    cleanup_count--;
+}
+
+// -----------------------------------------------------------------------------
+// Grow the temporaries, before a value is pushed (see
+// cb_error_push_temporary())
+// -----------------------------------------------------------------------------
+void cb_error_grow_temporaries()
+{
+    CbErrorTemporaries* temporaries = &cb_error_temporaries;
+    
+    temporaries->capacity = (temporaries->capacity) ? temporaries->capacity * 2
+                                                    : 256;
+    temporaries->values   = (CbValue**) realloc(temporaries->values,
+                                temporaries->capacity * sizeof(CbValue*));
+}
+
 
 // #############################################################################
 // internal functions
@@ -320,6 +454,10 @@ static void cb_print_error_internal(FILE* output, cb_error_type type, int line,
             fprintf(output, "Syntax error: ");
             break;
         
+        case CB_ERR_TYPE:
+            fprintf(output, "Type error: ");
+            break;
+        
         default:
             fprintf(output, "Unknown error: ");
             break;
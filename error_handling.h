@@ -1,6 +1,19 @@
 /*******************************************************************************
  * error_handling -- Collection of error handling utilities.
  *                   This also includes the yyerror()-function for flex & bison.
+ *
+ *    Errors, which can be catched by an exception block, are raised by
+ *    setting the global error flag. The evaluation doesn't check the flag,
+ *    instead the builtin function or operation raising the error calls
+ *    cb_error_throw(), which unwinds to the innermost frame (an exception
+ *    block or the root of a codeblock) with longjmp(). An allocation beyond
+ *    the memory quota only sets the flag, it is thrown by the next step of
+ *    the execution limits.
+ *
+ *    Operands, which are held while evaluating other nodes, are pushed as
+ *    temporary values. Other evaluations holding resources push a cleanup.
+ *    Unwinding frees the temporaries and runs the cleanups pushed inside of
+ *    the frame, innermost first.
  ******************************************************************************/
 
 #ifndef ERROR_HANDLING_H
@@ -9,12 +22,15 @@
 
 #include <stdio.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <setjmp.h>
 
 typedef enum cb_error_type
 {
     CB_ERR_UNKNOWN,
     CB_ERR_SYNTAX,
-    CB_ERR_RUNTIME
+    CB_ERR_RUNTIME,
+    CB_ERR_TYPE
 } cb_error_type;
 
 typedef enum cb_yyerror_call_context
@@ -25,15 +41,50 @@ typedef enum cb_yyerror_call_context
 
 typedef enum cb_error_code
 {
-    CB_ERR_CODE_NOERROR = 0,    // 0 indicates "no error"
-    CB_ERR_CODE_DIVISIONBYZERO, // Division by zero error
+    CB_ERR_CODE_NOERROR = 0,       // 0 indicates "no error"
+    CB_ERR_CODE_DIVISIONBYZERO,    // Division by zero error
+    CB_ERR_CODE_ARRAYNOTNUMERIC,   // Array contains non-numeric elements
+    CB_ERR_CODE_ARRAYEMPTY,        // Operation not defined for empty arrays
+    CB_ERR_CODE_ARRAYSIZEMISMATCH, // Arrays differ in size
+    CB_ERR_CODE_ARRAYSIZENEGATIVE, // Negative array size
+    CB_ERR_CODE_HASHKEYINVALID,    // Key type not supported by hashes
+    CB_ERR_CODE_HASHKEYNOTFOUND,   // Key doesn't exist in hash
+    CB_ERR_CODE_FILEOPEN,          // File can't be opened
+    CB_ERR_CODE_FILEHANDLEINVALID, // File handle isn't open
+    CB_ERR_CODE_STEPLIMIT,         // Maximum count of steps exceeded
+    CB_ERR_CODE_DEADLINE,          // Wall-clock deadline exceeded
+    CB_ERR_CODE_CALLDEPTH,         // Maximum depth of nested calls exceeded
+    CB_ERR_CODE_MEMORYQUOTA,       // Memory quota exceeded
+    CB_ERR_CODE_ARGUMENTTYPE,      // Argument of a builtin has a wrong type
     
-    CB_ERR_CODE_END             // End of enumerations (this is not an error!)
+    CB_ERR_CODE_END                // End of enumerations (this is not an error!)
 } CbErrorCode;
 
 // Error code for custom error messages
 extern const CbErrorCode CB_ERR_CODE_CUSTOMERROR;
 
+// releases a resource, if an error unwinds the evaluation holding it
+typedef void (*CbErrorCleanup)(void* resource);
+
+// temporary values, which are freed by unwinding
+typedef struct
+{
+    struct CbValue** values;
+    size_t count;
+    size_t capacity;
+} CbErrorTemporaries;
+
+extern CbErrorTemporaries cb_error_temporaries;
+
+// frame catching thrown errors
+typedef struct CbErrorFrame
+{
+    jmp_buf env;                    // target of cb_error_throw()
+    size_t cleanup_count;           // count of cleanups pushed before
+    size_t temporary_count;         // count of temporaries pushed before
+    struct CbErrorFrame* prior;     // enclosing frame
+} CbErrorFrame;
+
 // interface functions for flex & bison
 void yyerror(void* call_context, const char* format, ...);
 
@@ -55,5 +106,32 @@ void cb_error_handling_initialize();
 void cb_error_handling_finalize();
 bool cb_error_handling_is_initialized();
 
+bool cb_error_is_pending();
+void cb_error_push_frame(CbErrorFrame* frame);
+void cb_error_pop_frame(CbErrorFrame* frame);
+void cb_error_throw();
+void cb_error_push_cleanup(void* resource, CbErrorCleanup cleanup);
+void cb_error_pop_cleanup();
+void cb_error_grow_temporaries();
+
+// -----------------------------------------------------------------------------
+// Push a temporary value, which is freed, if the evaluation is unwound
+// -----------------------------------------------------------------------------
+static inline void cb_error_push_temporary(struct CbValue* value)
+{
+    if (cb_error_temporaries.count == cb_error_temporaries.capacity)
+        cb_error_grow_temporaries();
+    
+    cb_error_temporaries.values[cb_error_temporaries.count++] = value;
+}
+
+// -----------------------------------------------------------------------------
+// Pop the last temporaries, after they were freed or passed on
+// -----------------------------------------------------------------------------
+static inline void cb_error_pop_temporaries(size_t count)
+{
+    cb_error_temporaries.count -= count;
+}
+
 
 #endif // ERROR_HANDLING_H
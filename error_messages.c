@@ -13,7 +13,20 @@
 // Constant error messages
 static const char* const cb_error_messages[CB_ERR_CODE_END] = {
     "No error",
-    "Division by zero is not allowed"
+    "Division by zero is not allowed",
+    "Array must contain numeric values only",
+    "Array must not be empty",
+    "Arrays must be of equal size",
+    "Array size must not be negative",
+    "Hash key must be a numeric or string value",
+    "Hash key not found",
+    "Unable to open file",
+    "Invalid file handle",
+    "Step limit exceeded",
+    "Execution deadline exceeded",
+    "Call depth limit exceeded",
+    "Memory quota exceeded",
+    "Argument has an invalid value-type"
 };
 
 // Unknown error
@@ -6,10 +6,19 @@
 #include <stdbool.h>
 #include <assert.h>
 #include "exception_block_node.h"
+#include "alloc.h"
 #include "syntree.h"
 #include "error_handling.h"
 
 
+// #############################################################################
+// declarations
+// #############################################################################
+
+static CbValue* cb_exception_block_try(CbSyntree* code_block,
+                                       CbSymtab* symtab);
+
+
 // #############################################################################
 // interface-functions
 // #############################################################################
@@ -24,7 +33,8 @@ CbSyntree* cb_exception_block_create(enum cb_exception_block_type type,
     assert(code_block);
     assert(exception_block);
     
-    CbExceptionBlockNode* node = malloc(sizeof(CbExceptionBlockNode));
+    CbExceptionBlockNode* node = cb_alloc(sizeof(CbExceptionBlockNode),
+                                          CB_ALLOC_AST);
     node->type                 = SNT_EXCEPTION_BLOCK;
     node->line_no              = 0;
     node->block_type           = type;
@@ -43,7 +53,7 @@ CbValue* cb_exception_block_execute(CbExceptionBlockNode* node, CbSymtab* symtab
     
     // execute code block
     CbValue* result       = NULL;
-    CbValue* block_result = cb_syntree_eval(node->code_block, symtab);
+    CbValue* block_result = cb_exception_block_try(node->code_block, symtab);
     // check for an uncatched error
     bool error_flag       = cb_error_is_set() && !cb_error_is_catched();
     
@@ -74,7 +84,8 @@ CbValue* cb_exception_block_execute(CbExceptionBlockNode* node, CbSymtab* symtab
             break;
             
         case EXBL_ALWAYS:
-            cb_value_free(block_result);
+            if (block_result != NULL)
+                cb_value_free(block_result);
             
             // temporarily catch error in order to execute the exception block
             cb_error_catch();
@@ -90,8 +101,11 @@ CbValue* cb_exception_block_execute(CbExceptionBlockNode* node, CbSymtab* symtab
             if (handle_prev_error)
             {
                 cb_error_reset_catch(); // -> mark error as "uncatched"
-                cb_value_free(result);  // TODO: ensure result is never NULL
+                if (result != NULL)
+                    cb_value_free(result);
+                
                 result = NULL;          // return invalid result due to error
+                cb_error_throw();       // -> pass error to the enclosing block
             }
             
             break;
@@ -99,3 +113,27 @@ CbValue* cb_exception_block_execute(CbExceptionBlockNode* node, CbSymtab* symtab
     
     return result;
 }
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Evaluate the code block, thrown errors unwind to here (internal)
+//
+//    In case of an error the return value is NULL
+// -----------------------------------------------------------------------------
+static CbValue* cb_exception_block_try(CbSyntree* code_block,
+                                       CbSymtab* symtab)
+{
+    CbErrorFrame frame;
+    if (setjmp(frame.env) != 0)
+        return NULL; // an error was thrown, the frame is popped already
+    
+    cb_error_push_frame(&frame);
+    CbValue* result = cb_syntree_eval(code_block, symtab);
+    cb_error_pop_frame(&frame);
+    
+    return result;
+}
@@ -0,0 +1,169 @@
+/*******************************************************************************
+ * CbLimits -- Implementation of execution limits
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+#include "exec_limits.h"
+#include "error_handling.h"
+#include "alloc.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+bool cb_limits_enabled = false;
+
+static CbLimits limits;             // limits of the current execution
+static unsigned long steps;         // steps of the current (or last) execution
+static unsigned int call_depth;     // current depth of nested calls
+static unsigned int clock_countdown;// steps until the clock is read again
+static uint64_t deadline;           // end of the execution in milliseconds
+static bool extended;               // limits were extended for a handler
+
+static void cb_limits_exceed(CbErrorCode code);
+static uint64_t cb_limits_now();
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Activate limits for the following execution
+// -----------------------------------------------------------------------------
+void cb_limits_start(const CbLimits* execution_limits)
+{
+    limits            = *execution_limits;
+    steps             = 0;
+    call_depth        = 0;
+    clock_countdown   = CB_LIMITS_CLOCK_INTERVAL;
+    deadline          = (limits.timeout) ? cb_limits_now() + limits.timeout
+                                         : 0;
+    extended          = false;
+    cb_limits_enabled = true;
+    
+    cb_alloc_start_quota(limits.max_memory);
+}
+
+// -----------------------------------------------------------------------------
+// Deactivate the limits
+// -----------------------------------------------------------------------------
+void cb_limits_stop()
+{
+    cb_limits_enabled = false;
+    
+    cb_alloc_stop_quota();
+}
+
+// -----------------------------------------------------------------------------
+// Count an evaluation step (false and an error is set, if a limit is exceeded)
+//
+//    An error raised by an allocation beyond the memory quota stops the
+//    execution as well.
+// -----------------------------------------------------------------------------
+bool cb_limits_step()
+{
+    if (cb_error_is_pending())
+        return false;
+    
+    steps++;
+    if (limits.max_steps && steps > limits.max_steps)
+    {
+        cb_limits_exceed(CB_ERR_CODE_STEPLIMIT);
+        return false;
+    }
+    
+    if (limits.timeout && --clock_countdown == 0)
+    {
+        clock_countdown = CB_LIMITS_CLOCK_INTERVAL;
+        if (cb_limits_now() >= deadline)
+        {
+            // read the clock on every step from now on
+            clock_countdown = 1;
+            cb_limits_exceed(CB_ERR_CODE_DEADLINE);
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Count a function call as step and enter it (false, if a limit is exceeded)
+// -----------------------------------------------------------------------------
+bool cb_limits_enter_call()
+{
+    if (!cb_limits_step())
+        return false;
+    
+    if (limits.max_call_depth && call_depth >= limits.max_call_depth)
+    {
+        cb_error_set(CB_ERR_CODE_CALLDEPTH);
+        return false;
+    }
+    
+    call_depth++;
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Leave a function call entered by cb_limits_enter_call()
+// -----------------------------------------------------------------------------
+void cb_limits_leave_call()
+{
+    if (call_depth > 0)
+        call_depth--;
+}
+
+// -----------------------------------------------------------------------------
+// Get the count of steps of the current (or last) execution
+// -----------------------------------------------------------------------------
+unsigned long cb_limits_get_steps()
+{
+    return steps;
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Raise the error of an exceeded limit (internal)
+//
+//    The first time, the step and time budgets are extended by a small amount
+//    to let an exception block handle the error. Once the extension is used
+//    up, the limit remains exceeded until the end of the execution.
+// -----------------------------------------------------------------------------
+static void cb_limits_exceed(CbErrorCode code)
+{
+    cb_error_set(code);
+    
+    if (extended)
+        return;
+    
+    if (limits.max_steps)
+        limits.max_steps = steps + CB_LIMITS_HANDLER_STEPS;
+    if (limits.timeout)
+        deadline = cb_limits_now() + CB_LIMITS_HANDLER_TIMEOUT;
+    
+    extended = true;
+}
+
+// -----------------------------------------------------------------------------
+// Get a monotonic time stamp in milliseconds (internal)
+// -----------------------------------------------------------------------------
+static uint64_t cb_limits_now()
+{
+#ifdef _CBC_PLAT_WNDS
+    return (uint64_t) ((double) clock() * 1e3 / CLOCKS_PER_SEC);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return (uint64_t) now.tv_sec * 1000u + (uint64_t) now.tv_nsec / 1000000u;
+#endif // _CBC_PLAT_WNDS
+}
@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * CbLimits -- Implementation of execution limits
+ *
+ *             A codeblock may be executed with a budget of evaluation steps,
+ *             a wall-clock deadline and a maximum depth of nested function
+ *             calls. A step is an iteration of a loop or a function call, so
+ *             the limits are checked on backward jumps and calls only, but
+ *             not on every evaluated node. The clock is read every
+ *             CB_LIMITS_CLOCK_INTERVAL steps. The memory quota is checked by
+ *             the allocation hooks (see alloc.h).
+ *
+ *             Exceeding a limit raises a runtime error, which can be catched
+ *             by an exception block. To run the handler, the step and time
+ *             budgets are extended once by CB_LIMITS_HANDLER_STEPS and
+ *             CB_LIMITS_HANDLER_TIMEOUT. After that, the limit remains
+ *             exceeded, so any further loop or call raises the error again.
+ *
+ *             If no limits are active, the checks are skipped by a single
+ *             test of cb_limits_enabled.
+ ******************************************************************************/
+
+#ifndef EXEC_LIMITS_H
+#define EXEC_LIMITS_H
+
+
+#include <stdbool.h>
+
+// count of steps between two reads of the clock
+#define CB_LIMITS_CLOCK_INTERVAL 256
+
+// steps and milliseconds granted to handle an exceeded limit
+#define CB_LIMITS_HANDLER_STEPS   1000
+#define CB_LIMITS_HANDLER_TIMEOUT 100
+
+// limits of an execution (0: unlimited)
+typedef struct
+{
+    unsigned long max_steps;        // maximum count of evaluation steps
+    unsigned long timeout;          // wall-clock deadline in milliseconds
+    unsigned int max_call_depth;    // maximum depth of nested calls
+    unsigned long max_memory;       // memory quota in bytes
+} CbLimits;
+
+// determines whether limits are active
+extern bool cb_limits_enabled;
+
+
+// interface functions
+void cb_limits_start(const CbLimits* limits);
+void cb_limits_stop();
+
+bool cb_limits_step();
+bool cb_limits_enter_call();
+void cb_limits_leave_call();
+unsigned long cb_limits_get_steps();
+
+
+#endif // EXEC_LIMITS_H
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "funccall.h"
+#include "alloc.h"
 #include "syntree.h"
 
 
@@ -17,10 +18,10 @@
 // -----------------------------------------------------------------------------
 CbSyntree* cb_funccall_create(char* identifier, CbStrlist* args)
 {
-    CbFuncCallNode* node = malloc(sizeof(CbFuncCallNode));
+    CbFuncCallNode* node = cb_alloc(sizeof(CbFuncCallNode), CB_ALLOC_AST);
     node->type           = SNT_FUNC_CALL;
     node->line_no        = 0;
-    node->sym_id         = strdup(identifier);
+    node->sym_id         = cb_alloc_strdup(identifier, CB_ALLOC_AST);
     node->table_sym      = NULL;
     node->args           = args;
     
@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "funcdecl.h"
+#include "alloc.h"
 #include "symbol.h"
 #include "symtab.h"
 #include "syntree.h"
@@ -21,10 +22,11 @@
 CbSyntree* cb_funcdecl_create(char* identifier, CbSyntree* body,
                               CbStrlist* params)
 {
-    CbFuncDeclarationNode* node = malloc(sizeof(CbFuncDeclarationNode));
+    CbFuncDeclarationNode* node = cb_alloc(sizeof(CbFuncDeclarationNode),
+                                           CB_ALLOC_AST);
     node->type                  = SNT_FUNC_DECL;
     node->line_no               = 0;
-    node->sym_id                = strdup(identifier);
+    node->sym_id                = cb_alloc_strdup(identifier, CB_ALLOC_AST);
     node->body                  = body;
     node->params                = params;
     
@@ -7,13 +7,35 @@
 #include <string.h>
 #include <assert.h>
 #include "function.h"
+#include "alloc.h"
 #include "symbol.h"
 #include "symtab.h"
 #include "syntree.h"
+#include "symref.h"
 #include "stack.h"
+#include "profile.h"
+#include "exec_limits.h"
 #include "error_handling.h"
 
 
+// #############################################################################
+// declarations
+// #############################################################################
+
+// state of a call, which is released, if an error unwinds the call
+typedef struct
+{
+    CbStack* arg_stack;             // evaluated arguments
+    CbStack* param_stack;           // names of the parameters
+    CbSymtab* symtab;
+    bool entered;                   // function-scope was entered
+} CbFunctionFrame;
+
+static CbValue* cb_function_eval_changed_arg(CbSyntree* node,
+                                             CbSymtab* symtab);
+static void cb_function_leave_frame(void* frame);
+
+
 // #############################################################################
 // interface-functions
 // #############################################################################
@@ -23,11 +45,13 @@
 // -----------------------------------------------------------------------------
 CbFunction* function_create(char* identifier)
 {
-    CbFunction* f  = (CbFunction*) malloc(sizeof(CbFunction));
-    f->id          = strdup(identifier);
+    CbFunction* f  = (CbFunction*) cb_alloc(sizeof(CbFunction),
+                                            CB_ALLOC_SYMBOL);
+    f->id          = cb_alloc_strdup(identifier, CB_ALLOC_SYMBOL);
     f->param_count = 0;
     f->result      = NULL;
     f->func_ref    = NULL;
+    f->changes_arg = false;
     f->params      = NULL;
     f->body        = NULL;
     
@@ -38,12 +62,16 @@ CbFunction* function_create(char* identifier)
 // constructor (builtin function)
 // -----------------------------------------------------------------------------
 CbFunction* cb_function_create_builtin(char* identifier, int param_count,
-                                       CbBuiltinFunctionRef func_ref)
+                                       CbBuiltinFunctionRef func_ref,
+                                       enum cb_builtin_effect effect)
 {
     CbFunction* f  = function_create(identifier);
     f->type        = FUNC_TYPE_BUILTIN;
     f->func_ref    = func_ref;
     f->param_count = param_count;
+    f->changes_arg = (effect == CB_BIF_CHANGES_ARG);
+    
+    return f;
 }
 
 // -----------------------------------------------------------------------------
@@ -54,6 +82,8 @@ CbFunction* cb_function_create_user_defined(char* identifier, CbSyntree* body)
     CbFunction* f = function_create(identifier);
     f->type       = FUNC_TYPE_USER_DEFINED;
     f->body       = body;
+    
+    return f;
 }
 
 // -----------------------------------------------------------------------------
@@ -64,9 +94,9 @@ void cb_function_free(CbFunction* f)
     cb_function_reset(f);
     
     if (f->id) // free identifier, if necessary
-        free(f->id);
+        cb_free(f->id, CB_ALLOC_SYMBOL);
     
-    free(f);
+    cb_free(f, CB_ALLOC_SYMBOL);
 }
 
 // -----------------------------------------------------------------------------
@@ -88,6 +118,8 @@ void cb_function_add_param(CbFunction* f, char* param_id)
 // -----------------------------------------------------------------------------
 // call function
 // if the function has no parameters, pass a NULL-value as arguments.
+// the array or hash changed by a builtin function is copied on write (see
+// cb_function_eval_changed_arg()).
 // -----------------------------------------------------------------------------
 int cb_function_call(CbFunction* f, CbStrlist* args, CbSymtab* symtab)
 {
@@ -112,8 +144,15 @@ int cb_function_call(CbFunction* f, CbStrlist* args, CbSymtab* symtab)
         return EXIT_FAILURE;
     }
     
-    CbStack* arg_stack   = cb_stack_create();
-    CbStack* param_stack = cb_stack_create();
+    CbFunctionFrame frame;
+    frame.arg_stack      = cb_stack_create();
+    frame.param_stack    = cb_stack_create();
+    frame.symtab         = symtab;
+    frame.entered        = false;
+    CbStack* arg_stack   = frame.arg_stack;
+    CbStack* param_stack = frame.param_stack;
+    cb_error_push_cleanup(&frame, cb_function_leave_frame);
+    
     // evaluate argument values
     if (count_params > 0)
     {
@@ -125,8 +164,13 @@ int cb_function_call(CbFunction* f, CbStrlist* args, CbSymtab* symtab)
                 cb_stack_push(param_stack, curr_param->string); // push param name
             
             // obtain argument value
-            CbValue* arg_value = cb_syntree_eval(((CbSyntree*) curr_arg->data),
-                                                 symtab);
+            CbValue* arg_value = NULL;
+            if (f->changes_arg && curr_arg == args)
+                arg_value = cb_function_eval_changed_arg(curr_arg->data,
+                                                         symtab);
+            else
+                arg_value = cb_syntree_eval(((CbSyntree*) curr_arg->data),
+                                            symtab);
             if (arg_value == NULL)
             {
                 result = EXIT_FAILURE;
@@ -142,10 +186,22 @@ int cb_function_call(CbFunction* f, CbStrlist* args, CbSymtab* symtab)
         }
     }
     
+    if (result == EXIT_SUCCESS && cb_limits_enabled && !cb_limits_enter_call())
+    {
+        // a limit of the execution was exceeded
+        cb_error_throw();
+        result = EXIT_FAILURE;
+    }
+    
     if (result == EXIT_SUCCESS)
     {
         cb_symtab_enter_scope(symtab, f->id); // enter function-scope
         
+        if (cb_profile_enabled)
+            cb_profile_enter_function(f->id);
+        
+        frame.entered = true;
+        
         if (f->type == FUNC_TYPE_USER_DEFINED)
         {
         
@@ -163,8 +219,7 @@ int cb_function_call(CbFunction* f, CbStrlist* args, CbSymtab* symtab)
                 char* param_id;
                 cb_stack_pop(param_stack, (void*) &param_id);
                 CbSymbol* arg = cb_symbol_create_variable(param_id);
-                cb_symbol_variable_assign_value(arg, arg_value);
-                cb_value_free(arg_value);
+                cb_symbol_variable_assign_and_free_value(arg, arg_value);
                 
                 // declare argument within function-scope
                 if (!cb_symtab_append(symtab, arg))
@@ -204,15 +259,10 @@ int cb_function_call(CbFunction* f, CbStrlist* args, CbSymtab* symtab)
             if (f->result == NULL)
                 result = EXIT_FAILURE;
         }
-        
-        // leave function-scope:
-        // all symbols, that were declared within this scope (like parameters),
-        // will be freed!
-        cb_symtab_leave_scope(symtab);
     }
     
-    cb_stack_free(arg_stack);
-    cb_stack_free(param_stack);
+    cb_error_pop_cleanup();
+    cb_function_leave_frame(&frame);
     
     return result;
 }
@@ -228,3 +278,84 @@ void cb_function_reset(CbFunction* f)
         f->result = NULL;
     }
 }
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Evaluate the first argument of a builtin function, which changes its array
+// or hash (internal)
+//
+//    Arrays and hashes are copied on write: A variable passed as argument is
+//    changed itself, so it mustn't share its array or hash with any other
+//    value (e.g. a previous argument of an enclosing call). Any other argument
+//    is changed as a copy of its own, so changing an element of an array
+//    doesn't change the array, just like changing a variable, which was
+//    assigned the element.
+// -----------------------------------------------------------------------------
+static CbValue* cb_function_eval_changed_arg(CbSyntree* node,
+                                             CbSymtab* symtab)
+{
+    if (node->type != SNT_SYMREF)
+    {
+        CbValue* value = cb_syntree_eval(node, symtab);
+        if (value)
+            cb_value_detach(value);
+        
+        return value;
+    }
+    
+    CbSymref* sr = (CbSymref*) node;
+    if (cb_symref_set_symbol_from_table(sr, symtab) == EXIT_FAILURE)
+        return NULL; // an error occurred
+    
+    if (!cb_symbol_is_variable(sr->table_sym))
+        return cb_syntree_eval(node, symtab);
+    
+    cb_symbol_variable_detach_value(sr->table_sym);
+    return cb_value_share(cb_symbol_variable_get_value(sr->table_sym));
+}
+
+// -----------------------------------------------------------------------------
+// Leave a call and free the arguments, which weren't passed (internal)
+//
+//    This is called at the end of every call and as cleanup, if an error
+//    unwinds the call.
+// -----------------------------------------------------------------------------
+static void cb_function_leave_frame(void* frame)
+{
+    CbFunctionFrame* call = (CbFunctionFrame*) frame;
+    
+    if (call->entered)
+    {
+        if (cb_profile_enabled)
+            cb_profile_leave_function();
+        
+        if (cb_limits_enabled)
+            cb_limits_leave_call();
+        
+        // leave function-scope:
+        // all symbols, that were declared within this scope (like parameters),
+        // will be freed!
+        cb_symtab_leave_scope(call->symtab);
+    }
+    
+    // arguments are left on the stacks, if the function wasn't entered
+    while (!cb_stack_is_empty(call->arg_stack))
+    {
+        CbValue* arg_value;
+        cb_stack_pop(call->arg_stack, (void*) &arg_value);
+        cb_value_free(arg_value);
+    }
+    
+    while (!cb_stack_is_empty(call->param_stack))
+    {
+        char* param_id;
+        cb_stack_pop(call->param_stack, (void*) &param_id);
+    }
+    
+    cb_stack_free(call->arg_stack);
+    cb_stack_free(call->param_stack);
+}
@@ -32,6 +32,7 @@ typedef struct
     
     // type-specific attributes: FUNC_TYPE_BUILTIN
     CbBuiltinFunctionRef func_ref;
+    bool changes_arg;  // the array or hash of the first argument is changed
     
     // type-specific attributes: FUNC_TYPE_USER_DEFINED
     CbSyntree* body;   // contains actual function-code
@@ -45,7 +46,8 @@ typedef struct
 
 // interface-functions
 CbFunction* cb_function_create_builtin(char* identifier, int param_count,
-                                       CbBuiltinFunctionRef func_ref);
+                                       CbBuiltinFunctionRef func_ref,
+                                       enum cb_builtin_effect effect);
 CbFunction* cb_function_create_user_defined(char* identifier, CbSyntree* body);
 void cb_function_free(CbFunction* f);
 void cb_function_add_param(CbFunction* f, char* param_id);
@@ -0,0 +1,399 @@
+/*******************************************************************************
+ * CbHash -- Implementation of an associative array (hash map)
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include "hash.h"
+#include "alloc.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+#define CB_HASH_SLOT_EMPTY   SIZE_MAX        // slot was never used
+#define CB_HASH_SLOT_REMOVED (SIZE_MAX - 1)  // entry of slot was removed
+
+typedef struct
+{
+    size_t hash;                    // hash of the key
+    CbValue* key;                   // NULL, if the entry was removed
+    CbValue* value;
+} CbHashEntry;
+
+struct CbHash
+{
+    size_t count;                   // count of keys
+    size_t used;                    // used entries (including removed ones)
+    size_t capacity;                // allocated entries
+    size_t slot_count;              // size of the index table (power of 2)
+    size_t* slots;                  // index table
+    CbHashEntry* entries;           // entries in insertion order
+    unsigned int references;        // count of owners sharing this hash
+};
+
+static size_t cb_hash_key_hash(const CbValue* key);
+static bool cb_hash_key_equals(const CbValue* l, const CbValue* r);
+static size_t* cb_hash_lookup(CbHash* hash, const CbValue* key, size_t h);
+static void cb_hash_resize(CbHash* hash, size_t slot_count);
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Constructor
+// -----------------------------------------------------------------------------
+CbHash* cb_hash_create()
+{
+    CbHash* hash     = (CbHash*) cb_alloc(sizeof(CbHash), CB_ALLOC_ARRAY);
+    hash->count      = 0;
+    hash->used       = 0;
+    hash->capacity   = 0;
+    hash->slot_count = 0;
+    hash->slots      = NULL;
+    hash->entries    = NULL;
+    hash->references = 1;
+    
+    // default size of the index table is 8 slots
+    cb_hash_resize(hash, 8);
+    
+    return hash;
+}
+
+// -----------------------------------------------------------------------------
+// Destructor
+// -----------------------------------------------------------------------------
+void cb_hash_free(CbHash* hash)
+{
+    // hash is still referenced by another owner
+    if (--hash->references > 0)
+        return;
+    
+    size_t i = 0;
+    for (; i < hash->used; i++)
+    {
+        if (hash->entries[i].key == NULL)
+            continue;
+        
+        cb_value_free(hash->entries[i].key);
+        cb_value_free(hash->entries[i].value);
+    }
+    
+    cb_free(hash->slots, CB_ALLOC_ARRAY);
+    cb_free(hash->entries, CB_ALLOC_ARRAY);
+    cb_free(hash, CB_ALLOC_ARRAY);
+}
+
+// -----------------------------------------------------------------------------
+// Copy hash (keys and values are copied as well)
+// -----------------------------------------------------------------------------
+CbHash* cb_hash_copy(CbHash* hash)
+{
+    CbHash* new_hash = cb_hash_create();
+    cb_hash_resize(new_hash, hash->slot_count);
+    
+    size_t position    = 0;
+    const CbValue* key = NULL;
+    CbValue* value     = NULL;
+    while (cb_hash_iterate(hash, &position, &key, &value))
+        cb_hash_set(new_hash, key, cb_value_copy(value));
+    
+    return new_hash;
+}
+
+// -----------------------------------------------------------------------------
+// Share hash with another owner
+//
+//    The hash is freed after cb_hash_free() was called for every owner.
+// -----------------------------------------------------------------------------
+CbHash* cb_hash_share(CbHash* hash)
+{
+    hash->references++;
+    return hash;
+}
+
+// -----------------------------------------------------------------------------
+// Check if hash is shared by more than one owner
+// -----------------------------------------------------------------------------
+bool cb_hash_is_shared(CbHash* hash)
+{
+    return hash->references > 1;
+}
+
+// -----------------------------------------------------------------------------
+// Get count of keys in hash
+// -----------------------------------------------------------------------------
+size_t cb_hash_get_count(CbHash* hash)
+{
+    return hash->count;
+}
+
+// -----------------------------------------------------------------------------
+// Check if a value can be used as key (numeric and string values only)
+// -----------------------------------------------------------------------------
+bool cb_hash_is_valid_key(const CbValue* key)
+{
+    return cb_value_is_type(key, CB_VT_NUMERIC) ||
+           cb_value_is_type(key, CB_VT_STRING);
+}
+
+// -----------------------------------------------------------------------------
+// Set value of a key
+//
+//    The hash takes ownership of the value, the key is copied.
+// -----------------------------------------------------------------------------
+bool cb_hash_set(CbHash* hash, const CbValue* key, CbValue* value)
+{
+    if (!cb_hash_is_valid_key(key))
+    {
+        cb_value_free(value);
+        return false;
+    }
+    
+    size_t h     = cb_hash_key_hash(key);
+    size_t* slot = cb_hash_lookup(hash, key, h);
+    
+    // replace value of an existing key
+    if (*slot != CB_HASH_SLOT_EMPTY && *slot != CB_HASH_SLOT_REMOVED)
+    {
+        cb_value_free(hash->entries[*slot].value);
+        hash->entries[*slot].value = value;
+        return true;
+    }
+    
+    // keep the load factor of the index table below 3/4
+    if (hash->used >= hash->capacity)
+    {
+        size_t slot_count = hash->slot_count;
+        if (hash->count >= hash->capacity / 2)
+            slot_count *= 2;
+        
+        cb_hash_resize(hash, slot_count);
+        slot = cb_hash_lookup(hash, key, h);
+    }
+    
+    CbHashEntry* entry = &hash->entries[hash->used];
+    entry->hash        = h;
+    entry->key         = cb_value_copy(key);
+    entry->value       = value;
+    
+    *slot = hash->used;
+    hash->used++;
+    hash->count++;
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Get value of a key (NULL, if the key doesn't exist)
+//
+//    The value is still owned by the hash.
+// -----------------------------------------------------------------------------
+CbValue* cb_hash_get(CbHash* hash, const CbValue* key)
+{
+    if (!cb_hash_is_valid_key(key))
+        return NULL;
+    
+    size_t* slot = cb_hash_lookup(hash, key, cb_hash_key_hash(key));
+    if (*slot == CB_HASH_SLOT_EMPTY || *slot == CB_HASH_SLOT_REMOVED)
+        return NULL;
+    
+    return hash->entries[*slot].value;
+}
+
+// -----------------------------------------------------------------------------
+// Check if a key exists
+// -----------------------------------------------------------------------------
+bool cb_hash_has(CbHash* hash, const CbValue* key)
+{
+    return cb_hash_get(hash, key) != NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Remove a key
+// -----------------------------------------------------------------------------
+bool cb_hash_remove(CbHash* hash, const CbValue* key)
+{
+    if (!cb_hash_is_valid_key(key))
+        return false;
+    
+    size_t* slot = cb_hash_lookup(hash, key, cb_hash_key_hash(key));
+    if (*slot == CB_HASH_SLOT_EMPTY || *slot == CB_HASH_SLOT_REMOVED)
+        return false;
+    
+    CbHashEntry* entry = &hash->entries[*slot];
+    cb_value_free(entry->key);
+    cb_value_free(entry->value);
+    entry->key   = NULL;
+    entry->value = NULL;
+    
+    // the slot must not be emptied, since it could be part of a probe chain
+    *slot = CB_HASH_SLOT_REMOVED;
+    hash->count--;
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Iterate over all keys in insertion order
+//
+//    'position' must be 0 for the first call. Returns false, if there are no
+//    more keys.
+// -----------------------------------------------------------------------------
+bool cb_hash_iterate(CbHash* hash, size_t* position, const CbValue** key,
+                     CbValue** value)
+{
+    for (; *position < hash->used; (*position)++)
+    {
+        CbHashEntry* entry = &hash->entries[*position];
+        if (entry->key == NULL)
+            continue;
+        
+        *key   = entry->key;
+        *value = entry->value;
+        (*position)++;
+        
+        return true;
+    }
+    
+    return false;
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Hash of a key (internal)
+// -----------------------------------------------------------------------------
+static size_t cb_hash_key_hash(const CbValue* key)
+{
+    if (cb_value_is_type(key, CB_VT_NUMERIC))
+    {
+        uint64_t h = (uint64_t) cb_numeric_get(key);
+        
+        // floats with a fractional part are hashed by their bit pattern, all
+        // others like the equal integer
+        if (cb_numeric_is_float(key) &&
+            cb_numeric_get_float(key) != (CbFloat) cb_numeric_get(key))
+        {
+            CbFloat f = cb_numeric_get_float(key);
+            memcpy(&h, &f, sizeof(h));
+        }
+        
+        // fibonacci hashing spreads consecutive numbers over the table
+        h *= 0x9E3779B97F4A7C15ull;
+        return (size_t) (h ^ (h >> 32));
+    }
+    
+    // FNV-1a
+    uint64_t h      = 0xCBF29CE484222325ull;
+    const char* str = cb_string_get(key);
+    for (; *str; str++)
+    {
+        h ^= (unsigned char) *str;
+        h *= 0x100000001B3ull;
+    }
+    
+    return (size_t) h;
+}
+
+// -----------------------------------------------------------------------------
+// Compare two keys (internal)
+// -----------------------------------------------------------------------------
+static bool cb_hash_key_equals(const CbValue* l, const CbValue* r)
+{
+    if (cb_value_get_type(l) != cb_value_get_type(r))
+        return false;
+    
+    if (cb_value_is_type(l, CB_VT_NUMERIC))
+    {
+        if (cb_numeric_is_float(l) || cb_numeric_is_float(r))
+            return cb_numeric_get_float(l) == cb_numeric_get_float(r);
+        
+        return cb_numeric_get(l) == cb_numeric_get(r);
+    }
+    
+    return strcmp(cb_string_get(l), cb_string_get(r)) == 0;
+}
+
+// -----------------------------------------------------------------------------
+// Find the slot of a key (internal)
+//
+//    If the key doesn't exist, the slot to insert it is returned, which is
+//    either empty or contains a removed entry.
+// -----------------------------------------------------------------------------
+static size_t* cb_hash_lookup(CbHash* hash, const CbValue* key, size_t h)
+{
+    size_t mask     = hash->slot_count - 1;
+    size_t i        = h & mask;
+    size_t* removed = NULL;
+    
+    for (;; i = (i + 1) & mask)
+    {
+        size_t* slot = &hash->slots[i];
+        
+        if (*slot == CB_HASH_SLOT_EMPTY)
+            return (removed) ? removed : slot;
+        
+        if (*slot == CB_HASH_SLOT_REMOVED)
+        {
+            if (removed == NULL)
+                removed = slot;
+            
+            continue;
+        }
+        
+        CbHashEntry* entry = &hash->entries[*slot];
+        if (entry->hash == h && cb_hash_key_equals(entry->key, key))
+            return slot;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Rebuild the index table with the given count of slots (internal)
+//
+//    Removed entries are dropped, so the entry array gets compacted.
+// -----------------------------------------------------------------------------
+static void cb_hash_resize(CbHash* hash, size_t slot_count)
+{
+    assert((slot_count & (slot_count - 1)) == 0); // must be a power of 2
+    
+    // compact entries
+    size_t used = 0;
+    size_t i    = 0;
+    for (; i < hash->used; i++)
+        if (hash->entries[i].key != NULL)
+            hash->entries[used++] = hash->entries[i];
+    
+    hash->used     = used;
+    hash->capacity = slot_count / 4 * 3;
+    hash->entries  = cb_realloc(hash->entries,
+                             hash->capacity * sizeof(CbHashEntry),
+                             CB_ALLOC_ARRAY);
+    
+    cb_free(hash->slots, CB_ALLOC_ARRAY);
+    hash->slot_count = slot_count;
+    hash->slots      = (size_t*) cb_alloc(slot_count * sizeof(size_t),
+                                          CB_ALLOC_ARRAY);
+    for (i = 0; i < slot_count; i++)
+        hash->slots[i] = CB_HASH_SLOT_EMPTY;
+    
+    // there are no removed slots anymore, so the first empty slot in the
+    // probe chain is always the right one
+    for (i = 0; i < hash->used; i++)
+    {
+        size_t mask = slot_count - 1;
+        size_t j    = hash->entries[i].hash & mask;
+        while (hash->slots[j] != CB_HASH_SLOT_EMPTY)
+            j = (j + 1) & mask;
+        
+        hash->slots[j] = i;
+    }
+}
@@ -0,0 +1,43 @@
+/*******************************************************************************
+ * CbHash -- Implementation of an associative array (hash map)
+ *
+ *           The hash maps numeric and string keys to CbValue-objects. It uses
+ *           open addressing with linear probing over a table of indices into a
+ *           dense entry array, so the keys keep their insertion order.
+ *
+ *           The hash owns its keys and values. Like CbArray it may be shared
+ *           by several owners: cb_hash_share() adds an owner and
+ *           cb_hash_free() releases one.
+ ******************************************************************************/
+
+#ifndef HASH_H
+#define HASH_H
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "value.h"
+
+
+typedef struct CbHash CbHash;
+
+
+// interface functions
+CbHash* cb_hash_create();
+void cb_hash_free(CbHash* hash);
+CbHash* cb_hash_copy(CbHash* hash);
+CbHash* cb_hash_share(CbHash* hash);
+bool cb_hash_is_shared(CbHash* hash);
+
+size_t cb_hash_get_count(CbHash* hash);
+bool cb_hash_is_valid_key(const CbValue* key);
+
+bool cb_hash_set(CbHash* hash, const CbValue* key, CbValue* value);
+CbValue* cb_hash_get(CbHash* hash, const CbValue* key);
+bool cb_hash_has(CbHash* hash, const CbValue* key);
+bool cb_hash_remove(CbHash* hash, const CbValue* key);
+bool cb_hash_iterate(CbHash* hash, size_t* position, const CbValue** key,
+                     CbValue** value);
+
+
+#endif // HASH_H
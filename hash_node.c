@@ -0,0 +1,137 @@
+/*******************************************************************************
+ * CbHashNode -- Represents a hash in the syntax tree.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <assert.h>
+#include "hash_node.h"
+#include "alloc.h"
+#include "syntree.h"
+#include "hash.h"
+#include "error_handling.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+static void cb_hash_node_cleanup(void* hash);
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// constructor (empty hash)
+// -----------------------------------------------------------------------------
+CbSyntree* cb_hash_node_create()
+{
+    CbHashNode* node = cb_alloc(sizeof(CbHashNode), CB_ALLOC_AST);
+    node->type       = SNT_VALHASH;
+    node->line_no    = 0;
+    node->keys       = NULL;
+    node->values     = NULL;
+    
+    return (CbSyntree*) node;
+}
+
+// -----------------------------------------------------------------------------
+// append a key-value pair
+// -----------------------------------------------------------------------------
+void cb_hash_node_append(CbSyntree* node, CbSyntree* key, CbSyntree* value)
+{
+    assert(node->type == SNT_VALHASH);
+    
+    CbHashNode* hash_node = (CbHashNode*) node;
+    CbStrlist* key_item   = NULL;
+    CbStrlist* value_item = NULL;
+    
+    if (hash_node->keys == NULL)
+    {
+        key_item          = cb_strlist_create("");
+        value_item        = cb_strlist_create("");
+        hash_node->keys   = key_item;
+        hash_node->values = value_item;
+    }
+    else
+    {
+        key_item   = cb_strlist_append(hash_node->keys, "");
+        value_item = cb_strlist_append(hash_node->values, "");
+    }
+    
+    key_item->data   = key;
+    value_item->data = value;
+}
+
+// -----------------------------------------------------------------------------
+// evaluation
+// -----------------------------------------------------------------------------
+CbValue* cb_hash_node_eval(const CbHashNode* node, CbSymtab* symtab)
+{
+    CbStrlist* key_item   = node->keys;
+    CbStrlist* value_item = node->values;
+    CbHash*    hash       = cb_hash_create();
+    
+    // the hash is held, while the keys and values are evaluated
+    cb_error_push_cleanup(hash, cb_hash_node_cleanup);
+    
+    while (key_item)
+    {
+        CbValue* key = cb_syntree_eval((CbSyntree*) key_item->data, symtab);
+        if (key == NULL)
+            break;
+        
+        cb_error_push_temporary(key);
+        CbValue* value = cb_syntree_eval((CbSyntree*) value_item->data, symtab);
+        cb_error_pop_temporaries(1);
+        
+        if (value == NULL)
+        {
+            cb_value_free(key);
+            break;
+        }
+        
+        if (!cb_hash_is_valid_key(key))
+        {
+            cb_error_pop_cleanup();
+            cb_value_free(key);
+            cb_value_free(value);
+            cb_hash_free(hash);
+            cb_print_error(CB_ERR_RUNTIME, node->line_no,
+                           "Hash keys must be numeric or string values");
+            return NULL;
+        }
+        
+        cb_value_detach(value);
+        cb_hash_set(hash, key, value);
+        cb_value_free(key);
+        
+        key_item   = key_item->next;
+        value_item = value_item->next;
+    }
+    
+    cb_error_pop_cleanup();
+    
+    // an error occurred
+    if (key_item)
+    {
+        cb_hash_free(hash);
+        return NULL;
+    }
+    
+    return cb_valhash_create(hash);
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Free a hash, if an error unwinds its evaluation (internal)
+// -----------------------------------------------------------------------------
+static void cb_hash_node_cleanup(void* hash)
+{
+    cb_hash_free((CbHash*) hash);
+}
@@ -0,0 +1,32 @@
+/*******************************************************************************
+ * CbHashNode -- Represents a hash in the syntax tree.
+ *
+ *      This structure is part of the abstract syntax-tree 'CbSyntree'.
+ ******************************************************************************/
+
+#ifndef HASH_NODE_H
+#define HASH_NODE_H
+
+
+#include "symtab_if.h"
+#include "syntree_if.h"
+#include "value.h"
+#include "strlist.h"
+
+// hash node
+typedef struct
+{
+    enum cb_syntree_node_type type; // node-type is SNT_VALHASH
+    int line_no;                    // line number
+    CbStrlist* keys;                // keys of the hash
+    CbStrlist* values;              // values of the hash
+} CbHashNode;
+
+
+// interface functions
+CbSyntree* cb_hash_node_create();
+void cb_hash_node_append(CbSyntree* node, CbSyntree* key, CbSyntree* value);
+CbValue* cb_hash_node_eval(const CbHashNode* node, CbSymtab* symtab);
+
+
+#endif // HASH_NODE_H
@@ -0,0 +1,821 @@
+/*******************************************************************************
+ * CbImage -- Serialization of a compiled codeblock into a binary image
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _CBC_PLAT_WNDS
+#include <io.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif // _CBC_PLAT_WNDS
+#include "image.h"
+#include "syntree.h"
+#include "symref.h"
+#include "funccall.h"
+#include "funcdecl.h"
+#include "exception_block_node.h"
+#include "array_node.h"
+#include "array_access_node.h"
+#include "array_assignment_node.h"
+#include "hash_node.h"
+#include "hash.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+// node-type of a missing node (e.g. an empty else-branch)
+#define CB_IMAGE_NODE_NONE 0
+
+// CbImageWriter -- State while writing an image
+typedef struct
+{
+    CbStrbuf nodes;                 // node stream
+    CbStrbuf offsets;               // string offsets
+    CbStrbuf strings;               // null-terminated strings
+    CbHash* string_index;           // maps strings to their index
+    uint32_t string_count;
+    uint32_t node_count;
+} CbImageWriter;
+
+// CbImageReader -- State while reading an image
+typedef struct
+{
+    const unsigned char* data;      // node stream
+    size_t size;                    // size of the node stream
+    size_t position;                // current position in the node stream
+    const char** strings;           // interned strings (inside the image)
+    uint32_t string_count;
+    uint32_t node_count;            // count of nodes read
+    uint32_t depth;                 // nesting depth of the current node
+    bool error;                     // image is malformed
+} CbImageReader;
+
+static uint32_t cb_image_checksum(const unsigned char* data, size_t size);
+static void cb_image_write_u32(CbStrbuf* buf, uint32_t value);
+static void cb_image_write_string(CbImageWriter* writer, const char* string);
+static void cb_image_write_strlist(CbImageWriter* writer,
+                                   const CbStrlist* list);
+static void cb_image_write_node(CbImageWriter* writer, const CbSyntree* node);
+static uint32_t cb_image_read_u32(CbImageReader* reader);
+static uint64_t cb_image_read_u64(CbImageReader* reader);
+static const char* cb_image_read_string(CbImageReader* reader);
+static CbStrlist* cb_image_read_strlist(CbImageReader* reader, bool nodes);
+static CbSyntree* cb_image_read_node(CbImageReader* reader);
+static CbSyntree* cb_image_read_child(CbImageReader* reader);
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Write the image of a syntax-tree into a growable buffer
+// -----------------------------------------------------------------------------
+void cb_image_write(const CbSyntree* ast, CbStrbuf* buf)
+{
+    assert(buf->flush == NULL);
+    
+    CbImageWriter writer;
+    cb_strbuf_init(&writer.nodes);
+    cb_strbuf_init(&writer.offsets);
+    cb_strbuf_init(&writer.strings);
+    writer.string_index = cb_hash_create();
+    writer.string_count = 0;
+    writer.node_count   = 0;
+    
+    cb_image_write_node(&writer, ast);
+    
+    // strings are padded, so the node stream starts aligned
+    while (writer.strings.length % sizeof(uint32_t) != 0)
+        cb_strbuf_append_char(&writer.strings, '\0');
+    
+    CbImageHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CB_IMAGE_MAGIC, sizeof(header.magic));
+    header.version        = CB_IMAGE_VERSION;
+    header.byte_order     = CB_IMAGE_BYTE_ORDER;
+    header.string_count   = writer.string_count;
+    header.strings_offset = sizeof(CbImageHeader);
+    header.nodes_offset   = header.strings_offset + writer.offsets.length +
+                            writer.strings.length;
+    header.size           = header.nodes_offset + writer.nodes.length;
+    header.node_count     = writer.node_count;
+    
+    size_t start = buf->length;
+    cb_strbuf_append(buf, (const char*) &header, sizeof(header));
+    cb_strbuf_append(buf, writer.offsets.data, writer.offsets.length);
+    cb_strbuf_append(buf, writer.strings.data, writer.strings.length);
+    cb_strbuf_append(buf, writer.nodes.data, writer.nodes.length);
+    
+    // the checksum covers the whole image, including the header
+    header.checksum = cb_image_checksum((const unsigned char*) buf->data + start,
+                                        header.size);
+    memcpy(buf->data + start + offsetof(CbImageHeader, checksum),
+           &header.checksum, sizeof(header.checksum));
+    
+    cb_strbuf_release(&writer.nodes);
+    cb_strbuf_release(&writer.offsets);
+    cb_strbuf_release(&writer.strings);
+    cb_hash_free(writer.string_index);
+}
+
+// -----------------------------------------------------------------------------
+// Rebuild a syntax-tree from an image (NULL, if the image is invalid)
+// -----------------------------------------------------------------------------
+CbSyntree* cb_image_read(const void* data, size_t size)
+{
+    if (!cb_image_is_image(data, size))
+        return NULL;
+    
+    const unsigned char* image = (const unsigned char*) data;
+    CbImageHeader header;
+    memcpy(&header, image, sizeof(header));
+    
+    // validate header and checksum
+    if (header.version != CB_IMAGE_VERSION ||
+        header.byte_order != CB_IMAGE_BYTE_ORDER ||
+        header.size != size ||
+        header.strings_offset != sizeof(CbImageHeader) ||
+        header.nodes_offset > size ||
+        (size_t) header.string_count * sizeof(uint32_t) >
+            header.nodes_offset - header.strings_offset ||
+        header.checksum != cb_image_checksum(image, size))
+        return NULL;
+    
+    CbImageReader reader;
+    reader.data         = image + header.nodes_offset;
+    reader.size         = size - header.nodes_offset;
+    reader.position     = 0;
+    reader.string_count = header.string_count;
+    reader.node_count   = 0;
+    reader.depth        = 0;
+    reader.error        = false;
+    reader.strings      = (const char**) malloc((header.string_count + 1) *
+                                                sizeof(const char*));
+    
+    // strings are referenced directly inside the image
+    const unsigned char* strings = image + header.strings_offset +
+                                   header.string_count * sizeof(uint32_t);
+    size_t strings_size          = image + header.nodes_offset - strings;
+    
+    uint32_t i = 0;
+    for (; i < header.string_count; i++)
+    {
+        uint32_t offset;
+        memcpy(&offset, image + header.strings_offset + i * sizeof(uint32_t),
+               sizeof(offset));
+        
+        if (offset >= strings_size ||
+            memchr(strings + offset, '\0', strings_size - offset) == NULL)
+        {
+            free(reader.strings);
+            return NULL;
+        }
+        
+        reader.strings[i] = (const char*) strings + offset;
+    }
+    
+    CbSyntree* ast = cb_image_read_node(&reader);
+    if (ast == NULL || reader.node_count != header.node_count ||
+        reader.position != reader.size)
+        reader.error = true;
+    
+    if (reader.error && ast)
+    {
+        cb_syntree_free(ast);
+        ast = NULL;
+    }
+    
+    free(reader.strings);
+    
+    return ast;
+}
+
+// -----------------------------------------------------------------------------
+// Check if data starts like an image
+// -----------------------------------------------------------------------------
+bool cb_image_is_image(const void* data, size_t size)
+{
+    return size >= sizeof(CbImageHeader) &&
+           memcmp(data, CB_IMAGE_MAGIC, strlen(CB_IMAGE_MAGIC)) == 0;
+}
+
+// -----------------------------------------------------------------------------
+// Write the image of a syntax-tree into a file
+// -----------------------------------------------------------------------------
+int cb_image_save_file(const CbSyntree* ast, const char* file_name)
+{
+    FILE* output = fopen(file_name, "wb");
+    if (!output)
+        return EXIT_FAILURE;
+    
+    CbStrbuf buf;
+    cb_strbuf_init(&buf);
+    cb_image_write(ast, &buf);
+    
+    int result = EXIT_SUCCESS;
+    if (fwrite(buf.data, 1, buf.length, output) != buf.length)
+        result = EXIT_FAILURE;
+    if (fclose(output) != 0)
+        result = EXIT_FAILURE;
+    
+    cb_strbuf_release(&buf);
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Load the syntax-tree of an image file (NULL, if the image is invalid)
+//
+//    The file is memory-mapped, so it is read only once, while the tree is
+//    rebuilt.
+// -----------------------------------------------------------------------------
+CbSyntree* cb_image_load_file(const char* file_name)
+{
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < (off_t) sizeof(CbImageHeader))
+    {
+        close(fd);
+        return NULL;
+    }
+    
+    size_t size    = (size_t) info.st_size;
+    CbSyntree* ast = NULL;
+
+#ifdef _CBC_PLAT_WNDS
+    // no mmap() available
+    void* data = malloc(size);
+    if (read(fd, data, size) == (int) size)
+        ast = cb_image_read(data, size);
+    
+    free(data);
+#else
+    void* data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data != MAP_FAILED)
+    {
+        ast = cb_image_read(data, size);
+        munmap(data, size);
+    }
+#endif // _CBC_PLAT_WNDS
+
+    close(fd);
+    
+    return ast;
+}
+
+// -----------------------------------------------------------------------------
+// Check if a file is an image
+// -----------------------------------------------------------------------------
+bool cb_image_file_is_image(const char* file_name)
+{
+    FILE* input = fopen(file_name, "rb");
+    if (!input)
+        return false;
+    
+    CbImageHeader header;
+    size_t size = fread(&header, 1, sizeof(header), input);
+    fclose(input);
+    
+    return cb_image_is_image(&header, size);
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// FNV-1a checksum of an image, the checksum field counts as 0 (internal)
+// -----------------------------------------------------------------------------
+static uint32_t cb_image_checksum(const unsigned char* data, size_t size)
+{
+    const size_t field = offsetof(CbImageHeader, checksum);
+    uint32_t h         = 0x811C9DC5u;
+    
+    size_t i = 0;
+    for (; i < size; i++)
+    {
+        unsigned char c = data[i];
+        if (i >= field && i < field + sizeof(uint32_t))
+            c = 0;
+        
+        h ^= c;
+        h *= 0x01000193u;
+    }
+    
+    return h;
+}
+
+// -----------------------------------------------------------------------------
+// Write an unsigned 32-bit value (internal)
+// -----------------------------------------------------------------------------
+static void cb_image_write_u32(CbStrbuf* buf, uint32_t value)
+{
+    cb_strbuf_append(buf, (const char*) &value, sizeof(value));
+}
+
+// -----------------------------------------------------------------------------
+// Write the index of an interned string (internal)
+// -----------------------------------------------------------------------------
+static void cb_image_write_string(CbImageWriter* writer, const char* string)
+{
+    CbValue* key   = cb_string_create(strdup(string));
+    CbValue* index = cb_hash_get(writer->string_index, key);
+    
+    if (index == NULL)
+    {
+        // intern new string
+        index = cb_numeric_create(writer->string_count++);
+        cb_hash_set(writer->string_index, key, index);
+        cb_image_write_u32(&writer->offsets, writer->strings.length);
+        cb_strbuf_append(&writer->strings, string, strlen(string) + 1);
+    }
+    
+    cb_image_write_u32(&writer->nodes, cb_numeric_get(index));
+    cb_value_free(key);
+}
+
+// -----------------------------------------------------------------------------
+// Write a list of strings (internal)
+// -----------------------------------------------------------------------------
+static void cb_image_write_strlist(CbImageWriter* writer,
+                                   const CbStrlist* list)
+{
+    cb_image_write_u32(&writer->nodes, (list) ? list->count : 0);
+    
+    for (; list; list = list->next)
+        cb_image_write_string(writer, list->string);
+}
+
+// -----------------------------------------------------------------------------
+// Write a node and its child-nodes (internal)
+// -----------------------------------------------------------------------------
+static void cb_image_write_node(CbImageWriter* writer, const CbSyntree* node)
+{
+    CbStrbuf* buf = &writer->nodes;
+    
+    if (node == NULL)
+    {
+        cb_image_write_u32(buf, CB_IMAGE_NODE_NONE);
+        return;
+    }
+    
+    writer->node_count++;
+    cb_image_write_u32(buf, node->type);
+    cb_image_write_u32(buf, (uint32_t) node->line_no);
+    
+    switch (node->type)
+    {
+        // two child-nodes
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case SNT_ASSIGNMENT:
+        case SNT_STATEMENTLIST:
+        case SNT_LOGICAL_AND:
+        case SNT_LOGICAL_OR:
+            cb_image_write_node(writer, node->l);
+            cb_image_write_node(writer, node->r);
+            break;
+        
+        // one child-node
+        case SNT_UNARYMINUS:
+        case SNT_DECLARATION:
+        case SNT_PRINT:
+        case SNT_LOGICAL_NOT:
+            cb_image_write_node(writer, node->l);
+            break;
+        
+        case SNT_CONSTVAL:
+        {
+            const CbValue* value = ((const CbConstvalNode*) node)->value;
+            bool is_float        = cb_numeric_is_float(value);
+            uint64_t bits        = 0;
+            
+            if (is_float)
+            {
+                CbFloat real = cb_numeric_get_float(value);
+                memcpy(&bits, &real, sizeof(bits));
+            }
+            else
+                bits = (uint64_t) cb_numeric_get(value);
+            
+            cb_image_write_u32(buf, is_float);
+            cb_strbuf_append(buf, (const char*) &bits, sizeof(bits));
+            break;
+        }
+        
+        case SNT_CONSTBOOL:
+            cb_image_write_u32(buf, cb_boolean_get(
+                                        ((const CbConstvalNode*) node)->value));
+            break;
+        
+        case SNT_CONSTSTR:
+            cb_image_write_string(writer, cb_string_get(
+                                              ((const CbConstvalNode*) node)->value));
+            break;
+        
+        case SNT_SYMREF:
+            cb_image_write_string(writer, ((const CbSymref*) node)->sym_id);
+            break;
+        
+        case SNT_FUNC_CALL:
+        {
+            const CbFuncCallNode* call = (const CbFuncCallNode*) node;
+            const CbStrlist* arg       = call->args;
+            
+            cb_image_write_string(writer, call->sym_id);
+            cb_image_write_u32(buf, (arg) ? arg->count : 0);
+            for (; arg; arg = arg->next)
+                cb_image_write_node(writer, (const CbSyntree*) arg->data);
+            
+            break;
+        }
+        
+        case SNT_FUNC_DECL:
+        {
+            const CbFuncDeclarationNode* decl =
+                (const CbFuncDeclarationNode*) node;
+            
+            cb_image_write_string(writer, decl->sym_id);
+            cb_image_write_strlist(writer, decl->params);
+            cb_image_write_node(writer, decl->body);
+            break;
+        }
+        
+        case SNT_FLOW_IF:
+        case SNT_FLOW_WHILE:
+            cb_image_write_node(writer, ((const CbFlowNode*) node)->cond);
+            cb_image_write_node(writer, ((const CbFlowNode*) node)->tb);
+            cb_image_write_node(writer, ((const CbFlowNode*) node)->fb);
+            break;
+        
+        case SNT_COMPARISON:
+            cb_image_write_u32(buf, ((const CbComparisonNode*) node)->cmp_type);
+            cb_image_write_node(writer, ((const CbComparisonNode*) node)->l);
+            cb_image_write_node(writer, ((const CbComparisonNode*) node)->r);
+            break;
+        
+        case SNT_VALARRAY:
+        {
+            const CbStrlist* item = ((const CbArrayNode*) node)->values;
+            
+            cb_image_write_u32(buf, (item) ? item->count : 0);
+            for (; item; item = item->next)
+                cb_image_write_node(writer, (const CbSyntree*) item->data);
+            
+            break;
+        }
+        
+        case SNT_VALARRAY_ACCESS:
+            cb_image_write_string(writer, ((const CbArrayAccessNode*) node)->sym_id);
+            cb_image_write_u32(buf, ((const CbArrayAccessNode*) node)->index);
+            break;
+        
+        case SNT_VALARRAY_ASSIGNMENT:
+        {
+            const CbArrayAssignmentNode* assignment =
+                (const CbArrayAssignmentNode*) node;
+            
+            cb_image_write_string(writer, assignment->sym_id);
+            cb_image_write_u32(buf, assignment->index);
+            cb_image_write_node(writer, assignment->value_node);
+            break;
+        }
+        
+        case SNT_VALHASH:
+        {
+            const CbStrlist* key   = ((const CbHashNode*) node)->keys;
+            const CbStrlist* value = ((const CbHashNode*) node)->values;
+            
+            cb_image_write_u32(buf, (key) ? key->count : 0);
+            for (; key; key = key->next, value = value->next)
+            {
+                cb_image_write_node(writer, (const CbSyntree*) key->data);
+                cb_image_write_node(writer, (const CbSyntree*) value->data);
+            }
+            
+            break;
+        }
+        
+        case SNT_EXCEPTION_BLOCK:
+        {
+            const CbExceptionBlockNode* block =
+                (const CbExceptionBlockNode*) node;
+            
+            cb_image_write_u32(buf, block->block_type);
+            cb_image_write_node(writer, block->code_block);
+            cb_image_write_node(writer, block->exception_block);
+            break;
+        }
+        
+        default:
+            assert(("Invalid node type", false));
+            break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Read an unsigned 32-bit value (internal)
+// -----------------------------------------------------------------------------
+static uint32_t cb_image_read_u32(CbImageReader* reader)
+{
+    uint32_t value = 0;
+    
+    if (reader->size - reader->position < sizeof(value))
+    {
+        reader->error = true;
+        return 0;
+    }
+    
+    memcpy(&value, reader->data + reader->position, sizeof(value));
+    reader->position += sizeof(value);
+    
+    return value;
+}
+
+// -----------------------------------------------------------------------------
+// Read an unsigned 64-bit value (internal)
+// -----------------------------------------------------------------------------
+static uint64_t cb_image_read_u64(CbImageReader* reader)
+{
+    uint64_t value = 0;
+    
+    if (reader->size - reader->position < sizeof(value))
+    {
+        reader->error = true;
+        return 0;
+    }
+    
+    memcpy(&value, reader->data + reader->position, sizeof(value));
+    reader->position += sizeof(value);
+    
+    return value;
+}
+
+// -----------------------------------------------------------------------------
+// Read an interned string (internal)
+// -----------------------------------------------------------------------------
+static const char* cb_image_read_string(CbImageReader* reader)
+{
+    uint32_t index = cb_image_read_u32(reader);
+    
+    if (index >= reader->string_count)
+    {
+        reader->error = true;
+        return "";
+    }
+    
+    return reader->strings[index];
+}
+
+// -----------------------------------------------------------------------------
+// Read a list of strings or child-nodes (internal)
+//
+//    Nodes are stored in the data-attribute of items with an empty string.
+// -----------------------------------------------------------------------------
+static CbStrlist* cb_image_read_strlist(CbImageReader* reader, bool nodes)
+{
+    uint32_t count  = cb_image_read_u32(reader);
+    CbStrlist* list = NULL;
+    CbStrlist* item = NULL;
+    
+    uint32_t i = 0;
+    for (; i < count && !reader->error; i++)
+    {
+        const char* string = (nodes) ? "" : cb_image_read_string(reader);
+        
+        // items are linked directly, instead of searching the list's end
+        if (list == NULL)
+            item = list = cb_strlist_create((char*) string);
+        else
+        {
+            item->next        = cb_strlist_create((char*) string);
+            item              = item->next;
+            item->count       = 0; // only the first item holds the count
+            list->count++;
+        }
+        
+        if (nodes)
+            item->data = cb_image_read_child(reader);
+    }
+    
+    return list;
+}
+
+// -----------------------------------------------------------------------------
+// Read a node and its child-nodes (NULL for a missing node) (internal)
+// -----------------------------------------------------------------------------
+static CbSyntree* cb_image_read_node(CbImageReader* reader)
+{
+    uint32_t type = cb_image_read_u32(reader);
+    if (type == CB_IMAGE_NODE_NONE || reader->error)
+        return NULL;
+    
+    // the nodes are read recursively, so the nesting must not exhaust the
+    // stack
+    if (reader->depth == CB_IMAGE_MAX_DEPTH)
+    {
+        reader->error = true;
+        return NULL;
+    }
+    
+    int line_no     = (int) cb_image_read_u32(reader);
+    CbSyntree* node = NULL;
+    reader->node_count++;
+    reader->depth++;
+    
+    switch (type)
+    {
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case SNT_ASSIGNMENT:
+        case SNT_STATEMENTLIST:
+        case SNT_LOGICAL_AND:
+        case SNT_LOGICAL_OR:
+        {
+            CbSyntree* l = cb_image_read_child(reader);
+            node         = cb_syntree_create(type, l,
+                                             cb_image_read_child(reader));
+            break;
+        }
+        
+        case SNT_UNARYMINUS:
+        case SNT_DECLARATION:
+        case SNT_PRINT:
+        case SNT_LOGICAL_NOT:
+            node = cb_syntree_create(type, cb_image_read_child(reader), NULL);
+            break;
+        
+        case SNT_CONSTVAL:
+        {
+            uint32_t is_float = cb_image_read_u32(reader);
+            uint64_t bits     = cb_image_read_u64(reader);
+            
+            if (is_float)
+            {
+                CbFloat real;
+                memcpy(&real, &bits, sizeof(real));
+                node = cb_constfloat_create(real);
+            }
+            else
+                node = cb_constval_create((CbNumeric) bits);
+            
+            break;
+        }
+        
+        case SNT_CONSTBOOL:
+            node = cb_constbool_create(cb_image_read_u32(reader) != 0);
+            break;
+        
+        case SNT_CONSTSTR:
+            node = cb_conststr_create((CbString) cb_image_read_string(reader));
+            break;
+        
+        case SNT_SYMREF:
+            node = cb_symref_create((char*) cb_image_read_string(reader));
+            break;
+        
+        case SNT_FUNC_CALL:
+        {
+            const char* name = cb_image_read_string(reader);
+            node = cb_funccall_create((char*) name,
+                                      cb_image_read_strlist(reader, true));
+            break;
+        }
+        
+        case SNT_FUNC_DECL:
+        {
+            const char* name  = cb_image_read_string(reader);
+            CbStrlist* params = cb_image_read_strlist(reader, false);
+            node = cb_funcdecl_create((char*) name, cb_image_read_child(reader),
+                                      params);
+            break;
+        }
+        
+        case SNT_FLOW_IF:
+        case SNT_FLOW_WHILE:
+        {
+            CbSyntree* cond = cb_image_read_child(reader);
+            CbSyntree* tb   = cb_image_read_node(reader);
+            node            = cb_flow_create(type, cond, tb,
+                                             cb_image_read_node(reader));
+            break;
+        }
+        
+        case SNT_COMPARISON:
+        {
+            uint32_t cmp_type = cb_image_read_u32(reader);
+            if (cmp_type > CMP_LT)
+            {
+                reader->error = true;
+                break;
+            }
+            
+            CbSyntree* l = cb_image_read_child(reader);
+            node         = cb_comparison_create(cmp_type, l,
+                                                cb_image_read_child(reader));
+            break;
+        }
+        
+        case SNT_VALARRAY:
+            node = cb_array_node_create(cb_image_read_strlist(reader, true));
+            break;
+        
+        case SNT_VALARRAY_ACCESS:
+        {
+            const char* name = cb_image_read_string(reader);
+            node = cb_array_access_node_create(name,
+                                               (int) cb_image_read_u32(reader));
+            break;
+        }
+        
+        case SNT_VALARRAY_ASSIGNMENT:
+        {
+            const char* name = cb_image_read_string(reader);
+            int index        = (int) cb_image_read_u32(reader);
+            node = cb_array_assignment_node_create(name, index,
+                                                   cb_image_read_child(reader));
+            break;
+        }
+        
+        case SNT_VALHASH:
+        {
+            uint32_t count = cb_image_read_u32(reader);
+            node           = cb_hash_node_create();
+            
+            uint32_t i = 0;
+            for (; i < count && !reader->error; i++)
+            {
+                CbSyntree* key = cb_image_read_child(reader);
+                cb_hash_node_append(node, key, cb_image_read_child(reader));
+            }
+            
+            break;
+        }
+        
+        case SNT_EXCEPTION_BLOCK:
+        {
+            uint32_t block_type = cb_image_read_u32(reader);
+            if (block_type > EXBL_ALWAYS)
+            {
+                reader->error = true;
+                break;
+            }
+            
+            CbSyntree* code_block = cb_image_read_child(reader);
+            node = cb_exception_block_create(block_type, code_block,
+                                             cb_image_read_child(reader));
+            break;
+        }
+        
+        default:
+            reader->error = true;
+            break;
+    }
+    
+    reader->depth--;
+    
+    if (node == NULL)
+        return NULL;
+    
+    node->line_no = line_no;
+    
+    return node;
+}
+
+// -----------------------------------------------------------------------------
+// Read a child-node, which must not be missing (internal)
+//
+//    A missing child-node of a malformed image is replaced, so the tree can
+//    still be freed.
+// -----------------------------------------------------------------------------
+static CbSyntree* cb_image_read_child(CbImageReader* reader)
+{
+    CbSyntree* node = cb_image_read_node(reader);
+    
+    if (node == NULL)
+    {
+        reader->error = true;
+        node          = cb_constbool_create(false);
+    }
+    
+    return node;
+}
@@ -0,0 +1,61 @@
+/*******************************************************************************
+ * CbImage -- Serialization of a compiled codeblock into a binary image
+ *
+ *            The image contains a header, a table of interned strings and
+ *            the syntax-tree as a stream of nodes in pre-order. It doesn't
+ *            contain any pointers, all references are indices or offsets.
+ *
+ *            Layout (all values in native byte order):
+ *              - header (see CbImageHeader)
+ *              - string offsets (uint32 per string, relative to the strings)
+ *              - null-terminated strings
+ *              - nodes: type, line number and type-specific fields, followed
+ *                by the child-nodes (type 0 denotes a missing node)
+ *
+ *            Loading an image rebuilds the syntax-tree in a single pass,
+ *            without running the lexer and parser.
+ ******************************************************************************/
+
+#ifndef IMAGE_H
+#define IMAGE_H
+
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "syntree_if.h"
+#include "strbuf.h"
+
+#define CB_IMAGE_MAGIC      "CBCIMAGE"
+#define CB_IMAGE_VERSION    1
+#define CB_IMAGE_BYTE_ORDER 0x01020304
+
+// maximal nesting depth of the nodes of an image (the parser stack depth)
+#define CB_IMAGE_MAX_DEPTH  10000
+
+// header of an image
+typedef struct
+{
+    char magic[8];                  // CB_IMAGE_MAGIC (not null-terminated)
+    uint32_t version;               // CB_IMAGE_VERSION
+    uint32_t byte_order;            // CB_IMAGE_BYTE_ORDER in native order
+    uint32_t size;                  // size of the whole image
+    uint32_t string_count;          // count of interned strings
+    uint32_t strings_offset;        // offset of the string offsets
+    uint32_t nodes_offset;          // offset of the node stream
+    uint32_t node_count;            // count of nodes
+    uint32_t checksum;              // FNV-1a of the image (this field as 0)
+} CbImageHeader;
+
+
+// interface functions
+void cb_image_write(const CbSyntree* ast, CbStrbuf* buf);
+CbSyntree* cb_image_read(const void* data, size_t size);
+bool cb_image_is_image(const void* data, size_t size);
+
+int cb_image_save_file(const CbSyntree* ast, const char* file_name);
+CbSyntree* cb_image_load_file(const char* file_name);
+bool cb_image_file_is_image(const char* file_name);
+
+
+#endif // IMAGE_H
@@ -0,0 +1,146 @@
+/*******************************************************************************
+ * CbInlineCallNode -- 'CbSyntree'-node, that evaluates an inlined call.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <assert.h>
+#include "inline_call_node.h"
+#include "alloc.h"
+#include "syntree.h"
+#include "exec_limits.h"
+#include "error_handling.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+// arguments of an inlined call, which are released, if an error unwinds it
+typedef struct
+{
+    CbValue* args[CB_INLINE_MAX_PARAMS]; // evaluated arguments
+    int count;                           // count of evaluated arguments
+    CbValue** prior;                     // arguments of the enclosing call
+} CbInlineFrame;
+
+// arguments of the inlined call, whose result-expression is evaluated
+static CbValue** current_args = NULL;
+
+static void cb_inline_call_node_leave_frame(void* frame);
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// constructor
+// -----------------------------------------------------------------------------
+CbSyntree* cb_inline_call_node_create(CbFuncCallNode* call, CbSyntree* body,
+                                      int param_count)
+{
+    assert(param_count <= CB_INLINE_MAX_PARAMS);
+    
+    CbInlineCallNode* node = cb_alloc(sizeof(CbInlineCallNode),
+                                      CB_ALLOC_AST);
+    node->type             = SNT_INLINE_CALL;
+    node->line_no          = call->line_no;
+    node->call             = call;
+    node->body             = body;
+    node->param_count      = param_count;
+    
+    return (CbSyntree*) node;
+}
+
+// -----------------------------------------------------------------------------
+// constructor
+// -----------------------------------------------------------------------------
+CbSyntree* cb_inline_param_node_create(int index)
+{
+    CbInlineParamNode* node = cb_alloc(sizeof(CbInlineParamNode),
+                                       CB_ALLOC_AST);
+    node->type              = SNT_INLINE_PARAM;
+    node->line_no           = 0;
+    node->index             = index;
+    
+    return (CbSyntree*) node;
+}
+
+// -----------------------------------------------------------------------------
+// Evaluate an inlined function-call
+//
+//    The arguments are evaluated in the caller's context and owned by the
+//    call, like the parameter symbols of a called function. The result is
+//    detached, like the copied result of a called function. An inlined call is
+//    a step of the execution limits like a called function, but doesn't add
+//    to the call depth.
+// -----------------------------------------------------------------------------
+CbValue* cb_inline_call_node_eval(const CbInlineCallNode* node,
+                                  CbSymtab* symtab)
+{
+    CbValue* result = NULL;
+    
+    CbInlineFrame frame;
+    frame.count = 0;
+    frame.prior = current_args;
+    cb_error_push_cleanup(&frame, cb_inline_call_node_leave_frame);
+    
+    CbStrlist* arg = node->call->args;
+    for (; arg; arg = arg->next)
+    {
+        CbValue* value = cb_syntree_eval((CbSyntree*) arg->data, symtab);
+        if (value == NULL)
+            break;
+        
+        cb_value_detach(value);
+        frame.args[frame.count++] = value;
+    }
+    
+    if (frame.count == node->param_count)
+    {
+        if (cb_limits_enabled && !cb_limits_step())
+            // a limit of the execution was exceeded
+            cb_error_throw();
+        else
+        {
+            current_args = frame.args;
+            result       = cb_syntree_eval(node->body, symtab);
+            if (result)
+                cb_value_detach(result);
+        }
+    }
+    
+    cb_error_pop_cleanup();
+    cb_inline_call_node_leave_frame(&frame);
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Evaluate a parameter of the inlined call
+// -----------------------------------------------------------------------------
+CbValue* cb_inline_param_node_eval(const CbInlineParamNode* node)
+{
+    return cb_value_share(current_args[node->index]);
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Leave an inlined call and free its arguments (internal)
+//
+//    This is called at the end of every inlined call and as cleanup, if an
+//    error unwinds the call.
+// -----------------------------------------------------------------------------
+static void cb_inline_call_node_leave_frame(void* frame)
+{
+    CbInlineFrame* call = (CbInlineFrame*) frame;
+    current_args        = call->prior;
+    
+    int i = 0;
+    for (; i < call->count; i++)
+        cb_value_free(call->args[i]);
+}
@@ -0,0 +1,55 @@
+/*******************************************************************************
+ * CbInlineCallNode -- 'CbSyntree'-node, that evaluates an inlined call.
+ *
+ *      This structure is part of the abstract syntax-tree 'CbSyntree'. It is
+ *      created by the optimizer (see optimizer.h) in place of a function-call
+ *      and contains a copy of the function's result-expression, whose
+ *      parameters are replaced by nodes of the type SNT_INLINE_PARAM. The
+ *      arguments are evaluated into a frame of the inlined call instead of
+ *      symbols of a function-scope.
+ *
+ *      The original function-call is kept, so it can be evaluated instead,
+ *      e.g. while the profiler records the calls of user functions.
+ ******************************************************************************/
+
+#ifndef INLINE_CALL_NODE_H
+#define INLINE_CALL_NODE_H
+
+
+#include "symtab_if.h"
+#include "syntree_if.h"
+#include "value.h"
+#include "funccall.h"
+
+// maximum count of parameters of an inlined function
+#define CB_INLINE_MAX_PARAMS 8
+
+// inlined function-call node
+typedef struct
+{
+    enum cb_syntree_node_type type; // node-type is SNT_INLINE_CALL
+    int line_no;                    // line number
+    CbFuncCallNode* call;           // original function-call with arguments
+    CbSyntree* body;                // result-expression of the function
+    int param_count;                // count of parameters
+} CbInlineCallNode;
+
+// parameter of an inlined function
+typedef struct
+{
+    enum cb_syntree_node_type type; // node-type is SNT_INLINE_PARAM
+    int line_no;                    // line number
+    int index;                      // index of the parameter
+} CbInlineParamNode;
+
+
+// interface functions
+CbSyntree* cb_inline_call_node_create(CbFuncCallNode* call, CbSyntree* body,
+                                      int param_count);
+CbSyntree* cb_inline_param_node_create(int index);
+CbValue* cb_inline_call_node_eval(const CbInlineCallNode* node,
+                                  CbSymtab* symtab);
+CbValue* cb_inline_param_node_eval(const CbInlineParamNode* node);
+
+
+#endif // INLINE_CALL_NODE_H
@@ -0,0 +1,121 @@
+/*******************************************************************************
+ * CbInvariantNode -- 'CbSyntree'-nodes, that evaluate loop-invariant
+ *                    expressions once per execution of a loop.
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include "invariant_node.h"
+#include "alloc.h"
+#include "syntree.h"
+#include "error_handling.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+static void cb_invariant_loop_node_release(void* node);
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// constructor
+// -----------------------------------------------------------------------------
+CbSyntree* cb_invariant_expr_node_create(CbSyntree* expr)
+{
+    CbInvariantExprNode* node = cb_alloc(sizeof(CbInvariantExprNode),
+                                         CB_ALLOC_AST);
+    node->type                = SNT_INVARIANT_EXPR;
+    node->line_no             = expr->line_no;
+    node->expr                = expr;
+    node->value               = NULL;
+    
+    return (CbSyntree*) node;
+}
+
+// -----------------------------------------------------------------------------
+// constructor (takes over the array of invariant expressions)
+// -----------------------------------------------------------------------------
+CbSyntree* cb_invariant_loop_node_create(CbSyntree* loop,
+                                         CbInvariantExprNode** invariants,
+                                         size_t invariant_count)
+{
+    CbInvariantLoopNode* node = cb_alloc(sizeof(CbInvariantLoopNode),
+                                         CB_ALLOC_AST);
+    node->type                = SNT_INVARIANT_LOOP;
+    node->line_no             = loop->line_no;
+    node->loop                = loop;
+    node->invariants          = invariants;
+    node->invariant_count     = invariant_count;
+    
+    return (CbSyntree*) node;
+}
+
+// -----------------------------------------------------------------------------
+// Evaluate a loop-invariant expression
+//
+//    The value is detached, so no copy of it shares an array or hash with the
+//    values of symbols.
+// -----------------------------------------------------------------------------
+CbValue* cb_invariant_expr_node_eval(CbInvariantExprNode* node,
+                                     CbSymtab* symtab)
+{
+    if (node->value == NULL)
+    {
+        CbValue* value = cb_syntree_eval(node->expr, symtab);
+        if (value == NULL)
+            return NULL;
+        
+        cb_value_detach(value);
+        node->value = value;
+    }
+    
+    return cb_value_copy(node->value);
+}
+
+// -----------------------------------------------------------------------------
+// Evaluate a loop with invariant expressions
+//
+//    The loop doesn't call user functions (see optimizer.h), so it can't be
+//    entered again, while it is executed.
+// -----------------------------------------------------------------------------
+CbValue* cb_invariant_loop_node_eval(CbInvariantLoopNode* node,
+                                     CbSymtab* symtab)
+{
+    cb_error_push_cleanup(node, cb_invariant_loop_node_release);
+    CbValue* result = cb_syntree_eval(node->loop, symtab);
+    cb_error_pop_cleanup();
+    
+    cb_invariant_loop_node_release(node);
+    
+    return result;
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Release the values of the invariant expressions of a loop (internal)
+//
+//    This is called at the end of every execution of the loop and as cleanup,
+//    if an error unwinds the loop.
+// -----------------------------------------------------------------------------
+static void cb_invariant_loop_node_release(void* node)
+{
+    CbInvariantLoopNode* loop = (CbInvariantLoopNode*) node;
+    
+    size_t i = 0;
+    for (; i < loop->invariant_count; i++)
+    {
+        if (loop->invariants[i]->value)
+        {
+            cb_value_free(loop->invariants[i]->value);
+            loop->invariants[i]->value = NULL;
+        }
+    }
+}
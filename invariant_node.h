@@ -0,0 +1,57 @@
+/*******************************************************************************
+ * CbInvariantNode -- 'CbSyntree'-nodes, that evaluate loop-invariant
+ *                    expressions once per execution of a loop.
+ *
+ *      This structure is part of the abstract syntax-tree 'CbSyntree'. The
+ *      optimizer (see optimizer.h) wraps every expression of a while-loop,
+ *      whose value doesn't change while the loop is executed, into a node of
+ *      the type SNT_INVARIANT_EXPR, and the loop into a node of the type
+ *      SNT_INVARIANT_LOOP, which knows these expressions.
+ *
+ *      An invariant expression is evaluated in place, when it is reached the
+ *      first time, so errors are reported at the same point of the execution
+ *      and with the same line number, and it isn't evaluated at all, if it
+ *      isn't reached. After that, copies of its value are returned, until
+ *      the loop is left, which releases the values.
+ ******************************************************************************/
+
+#ifndef INVARIANT_NODE_H
+#define INVARIANT_NODE_H
+
+
+#include "symtab_if.h"
+#include "syntree_if.h"
+#include "value.h"
+
+// loop-invariant expression node
+typedef struct
+{
+    enum cb_syntree_node_type type; // node-type is SNT_INVARIANT_EXPR
+    int line_no;                    // line number
+    CbSyntree* expr;                // invariant expression
+    CbValue* value;                 // value of the expression (or NULL)
+} CbInvariantExprNode;
+
+// loop node with invariant expressions
+typedef struct
+{
+    enum cb_syntree_node_type type; // node-type is SNT_INVARIANT_LOOP
+    int line_no;                    // line number
+    CbSyntree* loop;                // while-loop
+    CbInvariantExprNode** invariants; // invariant expressions of the loop
+    size_t invariant_count;         // count of invariant expressions
+} CbInvariantLoopNode;
+
+
+// interface functions
+CbSyntree* cb_invariant_expr_node_create(CbSyntree* expr);
+CbSyntree* cb_invariant_loop_node_create(CbSyntree* loop,
+                                         CbInvariantExprNode** invariants,
+                                         size_t invariant_count);
+CbValue* cb_invariant_expr_node_eval(CbInvariantExprNode* node,
+                                     CbSymtab* symtab);
+CbValue* cb_invariant_loop_node_eval(CbInvariantLoopNode* node,
+                                     CbSymtab* symtab);
+
+
+#endif // INVARIANT_NODE_H
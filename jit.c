@@ -0,0 +1,1113 @@
+/*******************************************************************************
+ * CbJit -- Template JIT compiler for hot integer loops
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include "jit.h"
+#ifdef CB_JIT_AVAILABLE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif // CB_JIT_AVAILABLE
+#include "alloc.h"
+#include "syntree.h"
+#include "symref.h"
+#include "symtab.h"
+#include "symbol.h"
+#include "inline_call_node.h"
+#include "error_handling.h"
+#include "exec_limits.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+// status of an execution of compiled code (flags)
+enum cb_jit_status
+{
+    CB_JIT_FINISHED     = 0,        // the loop was left
+    CB_JIT_ITERATED     = 1,        // iterations were executed
+    CB_JIT_DEOPTIMISED  = 2,        // a guard of an iteration failed
+    CB_JIT_GUARD_FAILED = 4         // a symbol isn't an integer
+};
+
+// stencils of machine code
+enum cb_jit_stencil_type
+{
+    JIT_PROLOGUE,
+    JIT_PUSH_SLOT,
+    JIT_POP_SLOT,
+    JIT_PUSH_IMM32,
+    JIT_PUSH_IMM64,
+    JIT_ADD,
+    JIT_SUB,
+    JIT_MUL,
+    JIT_DIV,
+    JIT_NEG,
+    JIT_COMPARE,
+    JIT_AND,
+    JIT_OR,
+    JIT_NOT,
+    JIT_JUMP_IF_FALSE,
+    JIT_JUMP,
+    JIT_ITERATED,
+    JIT_EXIT,
+    JIT_DEOPTIMISE
+};
+
+// kinds of the operand of a stencil
+enum cb_jit_hole_kind
+{
+    JIT_HOLE_NONE,                  // the stencil has no operand
+    JIT_HOLE_IMMEDIATE,             // immediate value
+    JIT_HOLE_SYMBOL,                // slot of a symbol
+    JIT_HOLE_CHECKPOINT,            // checkpoint slot of a symbol
+    JIT_HOLE_PARAM,                 // slot of a parameter of an inlined call
+    JIT_HOLE_LABEL                  // target of a jump
+};
+
+// precompiled machine code with holes for its operand and the targets of its
+// jumps to the deoptimisation exit
+typedef struct
+{
+    const unsigned char* code;
+    unsigned char size;
+    signed char hole;               // offset of the operand (or -1)
+    unsigned char hole_size;        // size of the operand in bytes
+    signed char deopts[3];          // offsets of the jump targets (or -1)
+} CbJitStencil;
+
+// operand of the generated code, which is patched after the code generation
+typedef struct
+{
+    size_t offset;                  // offset of the hole
+    enum cb_jit_hole_kind kind;     // slot or jump target
+    int index;                      // index of the slot or label
+} CbJitFixup;
+
+// entry point of compiled code
+typedef int (*CbJitFunction)(int64_t* slots);
+
+// machine code of a compiled loop
+struct CbJitCode
+{
+    CbJitFunction function;         // entry point
+    size_t size;                    // size of the mapped pages
+    const char* ids[CB_JIT_MAX_SLOTS]; // identifiers of the symbol slots
+    bool assigned[CB_JIT_MAX_SLOTS]; // the symbol is assigned by the loop
+    int symbol_count;               // count of symbol slots
+    int param_count;                // count of parameter slots
+    int result_slot;                // symbol assigned by the last statement
+};
+
+// state of the compilation of a loop
+typedef struct
+{
+    CbJitCode* code;
+    unsigned char* buffer;          // generated code
+    size_t size;
+    size_t capacity;
+    CbJitFixup* fixups;             // holes to be patched
+    size_t fixup_count;
+    size_t fixup_capacity;
+    size_t* labels;                 // offsets of the labels
+    int label_count;
+    int label_capacity;
+    int deopt_label;                // label of the deoptimisation exit
+    bool failed;                    // too many slots
+} CbJitCompiler;
+
+static bool cb_jit_check_condition(const CbSyntree* node, int param_count);
+static bool cb_jit_check_expr(const CbSyntree* node, int param_count);
+static bool cb_jit_check_statements(const CbSyntree* node, bool last);
+
+static void cb_jit_compile(CbJitLoopNode* node);
+static void cb_jit_collect_assigned(CbJitCompiler* compiler,
+                                    const CbSyntree* node);
+static void cb_jit_gen_statements(CbJitCompiler* compiler,
+                                  const CbSyntree* node);
+static void cb_jit_gen_condition(CbJitCompiler* compiler,
+                                 const CbSyntree* node, int param_base);
+static void cb_jit_gen_expr(CbJitCompiler* compiler, const CbSyntree* node,
+                            int param_base);
+static void cb_jit_emit(CbJitCompiler* compiler,
+                        enum cb_jit_stencil_type type,
+                        enum cb_jit_hole_kind kind, int64_t operand);
+static void cb_jit_add_fixup(CbJitCompiler* compiler, size_t offset,
+                             enum cb_jit_hole_kind kind, int index);
+static int cb_jit_new_label(CbJitCompiler* compiler);
+static void cb_jit_bind_label(CbJitCompiler* compiler, int label);
+static int cb_jit_get_slot(CbJitCompiler* compiler, const char* id);
+static bool cb_jit_finish(CbJitCompiler* compiler);
+
+static enum cb_jit_status cb_jit_run(const CbJitCode* code, CbSymtab* symtab,
+                                     CbValue** result);
+static void cb_jit_cleanup_value_ref(void* value_ref);
+
+// determines whether the JIT compiler is enabled
+bool cb_jit_enabled = false;
+
+static CbJitStats stats = { 0, 0, 0 };
+
+// mov r11, rsp; xor r10d, r10d
+static const unsigned char stencil_prologue[] = {
+    0x49, 0x89, 0xE3, 0x45, 0x31, 0xD2
+};
+// push qword [rdi + slot]
+static const unsigned char stencil_push_slot[] = {
+    0xFF, 0xB7, 0, 0, 0, 0
+};
+// pop qword [rdi + slot]
+static const unsigned char stencil_pop_slot[] = {
+    0x8F, 0x87, 0, 0, 0, 0
+};
+// push imm32 (sign-extended)
+static const unsigned char stencil_push_imm32[] = {
+    0x68, 0, 0, 0, 0
+};
+// mov rax, imm64; push rax
+static const unsigned char stencil_push_imm64[] = {
+    0x48, 0xB8, 0, 0, 0, 0, 0, 0, 0, 0, 0x50
+};
+// pop rcx; pop rax; add rax, rcx; jo deopt; push rax
+static const unsigned char stencil_add[] = {
+    0x59, 0x58, 0x48, 0x01, 0xC8, 0x0F, 0x80, 0, 0, 0, 0, 0x50
+};
+// pop rcx; pop rax; sub rax, rcx; jo deopt; push rax
+static const unsigned char stencil_sub[] = {
+    0x59, 0x58, 0x48, 0x29, 0xC8, 0x0F, 0x80, 0, 0, 0, 0, 0x50
+};
+// pop rcx; pop rax; imul rax, rcx; jo deopt; push rax
+static const unsigned char stencil_mul[] = {
+    0x59, 0x58, 0x48, 0x0F, 0xAF, 0xC1, 0x0F, 0x80, 0, 0, 0, 0, 0x50
+};
+// pop rcx; pop rax; test rcx, rcx; jz deopt; cmp rcx, -1; je deopt; cqo;
+// idiv rcx; test rdx, rdx; jnz deopt; push rax
+static const unsigned char stencil_div[] = {
+    0x59, 0x58, 0x48, 0x85, 0xC9, 0x0F, 0x84, 0, 0, 0, 0,
+    0x48, 0x83, 0xF9, 0xFF, 0x0F, 0x84, 0, 0, 0, 0,
+    0x48, 0x99, 0x48, 0xF7, 0xF9, 0x48, 0x85, 0xD2, 0x0F, 0x85, 0, 0, 0, 0,
+    0x50
+};
+// pop rax; neg rax; jo deopt; push rax
+static const unsigned char stencil_neg[] = {
+    0x58, 0x48, 0xF7, 0xD8, 0x0F, 0x80, 0, 0, 0, 0, 0x50
+};
+// pop rcx; pop rax; cmp rax, rcx; setcc al; movzx eax, al; push rax
+static const unsigned char stencil_compare[] = {
+    0x59, 0x58, 0x48, 0x39, 0xC8, 0x0F, 0, 0xC0, 0x0F, 0xB6, 0xC0, 0x50
+};
+// pop rcx; pop rax; and rax, rcx; push rax
+static const unsigned char stencil_and[] = {
+    0x59, 0x58, 0x48, 0x21, 0xC8, 0x50
+};
+// pop rcx; pop rax; or rax, rcx; push rax
+static const unsigned char stencil_or[] = {
+    0x59, 0x58, 0x48, 0x09, 0xC8, 0x50
+};
+// pop rax; xor rax, 1; push rax
+static const unsigned char stencil_not[] = {
+    0x58, 0x48, 0x83, 0xF0, 0x01, 0x50
+};
+// pop rax; test rax, rax; jz label
+static const unsigned char stencil_jump_if_false[] = {
+    0x58, 0x48, 0x85, 0xC0, 0x0F, 0x84, 0, 0, 0, 0
+};
+// jmp label
+static const unsigned char stencil_jump[] = {
+    0xE9, 0, 0, 0, 0
+};
+// mov r10d, 1
+static const unsigned char stencil_iterated[] = {
+    0x41, 0xBA, 0x01, 0x00, 0x00, 0x00
+};
+// mov eax, r10d; mov rsp, r11; ret
+static const unsigned char stencil_exit[] = {
+    0x44, 0x89, 0xD0, 0x4C, 0x89, 0xDC, 0xC3
+};
+// mov eax, r10d; or eax, CB_JIT_DEOPTIMISED; mov rsp, r11; ret
+static const unsigned char stencil_deoptimise[] = {
+    0x44, 0x89, 0xD0, 0x83, 0xC8, CB_JIT_DEOPTIMISED, 0x4C, 0x89, 0xDC, 0xC3
+};
+
+// stencils in the order of enum cb_jit_stencil_type
+static const CbJitStencil stencils[] = {
+    { stencil_prologue,      sizeof(stencil_prologue),      -1, 0,
+      { -1, -1, -1 } },
+    { stencil_push_slot,     sizeof(stencil_push_slot),      2, 4,
+      { -1, -1, -1 } },
+    { stencil_pop_slot,      sizeof(stencil_pop_slot),       2, 4,
+      { -1, -1, -1 } },
+    { stencil_push_imm32,    sizeof(stencil_push_imm32),     1, 4,
+      { -1, -1, -1 } },
+    { stencil_push_imm64,    sizeof(stencil_push_imm64),     2, 8,
+      { -1, -1, -1 } },
+    { stencil_add,           sizeof(stencil_add),           -1, 0,
+      {  7, -1, -1 } },
+    { stencil_sub,           sizeof(stencil_sub),           -1, 0,
+      {  7, -1, -1 } },
+    { stencil_mul,           sizeof(stencil_mul),           -1, 0,
+      {  8, -1, -1 } },
+    { stencil_div,           sizeof(stencil_div),           -1, 0,
+      {  7, 17, 31 } },
+    { stencil_neg,           sizeof(stencil_neg),           -1, 0,
+      {  6, -1, -1 } },
+    { stencil_compare,       sizeof(stencil_compare),        6, 1,
+      { -1, -1, -1 } },
+    { stencil_and,           sizeof(stencil_and),           -1, 0,
+      { -1, -1, -1 } },
+    { stencil_or,            sizeof(stencil_or),            -1, 0,
+      { -1, -1, -1 } },
+    { stencil_not,           sizeof(stencil_not),           -1, 0,
+      { -1, -1, -1 } },
+    { stencil_jump_if_false, sizeof(stencil_jump_if_false),  6, 4,
+      { -1, -1, -1 } },
+    { stencil_jump,          sizeof(stencil_jump),           1, 4,
+      { -1, -1, -1 } },
+    { stencil_iterated,      sizeof(stencil_iterated),      -1, 0,
+      { -1, -1, -1 } },
+    { stencil_exit,          sizeof(stencil_exit),          -1, 0,
+      { -1, -1, -1 } },
+    { stencil_deoptimise,    sizeof(stencil_deoptimise),    -1, 0,
+      { -1, -1, -1 } }
+};
+
+// second opcode byte of setcc in the order of enum cb_comparison_type
+static const unsigned char setcc_opcodes[] = {
+    0x94, // sete
+    0x95, // setne
+    0x9D, // setge
+    0x9E, // setle
+    0x9F, // setg
+    0x9C  // setl
+};
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Enable the JIT compiler for the following optimizations of syntax-trees
+// (returns EXIT_FAILURE, if it isn't available on this platform)
+// -----------------------------------------------------------------------------
+int cb_jit_enable()
+{
+#ifdef CB_JIT_AVAILABLE
+    cb_jit_enabled = true;
+    return EXIT_SUCCESS;
+#else
+    return EXIT_FAILURE;
+#endif // CB_JIT_AVAILABLE
+}
+
+// -----------------------------------------------------------------------------
+// Disable the JIT compiler (compiled loops of existing syntax-trees are kept)
+// -----------------------------------------------------------------------------
+void cb_jit_disable()
+{
+    cb_jit_enabled = false;
+}
+
+// -----------------------------------------------------------------------------
+// Check if a while-loop only computes integers (see jit.h)
+// -----------------------------------------------------------------------------
+bool cb_jit_can_compile(const CbSyntree* loop)
+{
+    const CbFlowNode* flow = (const CbFlowNode*) loop;
+    
+    return loop->type == SNT_FLOW_WHILE && flow->tb &&
+           cb_jit_check_condition(flow->cond, 0) &&
+           cb_jit_check_statements(flow->tb, true);
+}
+
+// -----------------------------------------------------------------------------
+// constructor
+// -----------------------------------------------------------------------------
+CbSyntree* cb_jit_loop_node_create(CbSyntree* loop)
+{
+    CbJitLoopNode* node = cb_alloc(sizeof(CbJitLoopNode), CB_ALLOC_AST);
+    node->type          = SNT_JIT_LOOP;
+    node->line_no       = loop->line_no;
+    node->loop          = loop;
+    node->code          = NULL;
+    node->iterations    = 0;
+    node->deopt_count   = 0;
+    node->failed        = false;
+    
+    return (CbSyntree*) node;
+}
+
+// -----------------------------------------------------------------------------
+// Free the machine code of a loop
+// -----------------------------------------------------------------------------
+void cb_jit_loop_node_free_code(CbJitLoopNode* node)
+{
+    if (node->code == NULL)
+        return;
+
+#ifdef CB_JIT_AVAILABLE
+    munmap((void*) node->code->function, node->code->size);
+#endif // CB_JIT_AVAILABLE
+    cb_free(node->code, CB_ALLOC_AST);
+    node->code = NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Evaluate a loop, which is compiled, when it is hot
+//
+//    The loop is interpreted like a while-loop, until its machine code is
+//    available. If the code is deoptimised, the rest of this execution of
+//    the loop is interpreted. The loop doesn't call user functions, so it
+//    can't be entered again, while it is executed.
+// -----------------------------------------------------------------------------
+CbValue* cb_jit_loop_node_eval(CbJitLoopNode* node, CbSymtab* symtab)
+{
+    // the execution limits count every iteration
+    if (node->failed || cb_limits_enabled)
+        return cb_syntree_eval(node->loop, symtab);
+    
+    const CbFlowNode* loop = (const CbFlowNode*) node->loop;
+    
+    // default result (in case the while-loop won't be entered)
+    CbValue* result = cb_value_create();
+    bool interpret  = false;
+    
+    // the result of the last iteration is held, while the condition is
+    // evaluated
+    cb_error_push_cleanup(&result, cb_jit_cleanup_value_ref);
+    
+    while (true)
+    {
+        if (node->code && !interpret)
+        {
+            enum cb_jit_status status = cb_jit_run(node->code, symtab,
+                                                   &result);
+            if ((status & (CB_JIT_DEOPTIMISED | CB_JIT_GUARD_FAILED)) == 0)
+                break;
+            
+            // the slots were stored, the interpreter takes over
+            interpret = true;
+            stats.deopts++;
+            if (++node->deopt_count >= CB_JIT_MAX_DEOPTS)
+            {
+                cb_jit_loop_node_free_code(node);
+                node->failed = true;
+            }
+        }
+        
+        CbValue* condition = cb_syntree_eval(loop->cond, symtab);
+        if (condition == NULL)
+        {
+            cb_value_free(result);
+            result = NULL;
+            break;
+        }
+        
+        assert(cb_value_is_type(condition, CB_VT_BOOLEAN));
+        
+        bool condition_true = cb_boolean_get(condition);
+        cb_value_free(condition);
+        if (!condition_true)
+            break;
+        
+        cb_value_free(result);
+        result = NULL;
+        result = cb_syntree_eval(loop->tb, symtab);
+        if (result == NULL)
+            break;
+        
+        if (node->code == NULL && !node->failed &&
+            ++node->iterations >= CB_JIT_HOT_ITERATIONS)
+            cb_jit_compile(node);
+    }
+    
+    cb_error_pop_cleanup();
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Get the statistics of the JIT compiler
+// -----------------------------------------------------------------------------
+void cb_jit_get_stats(CbJitStats* jit_stats)
+{
+    *jit_stats = stats;
+}
+
+// -----------------------------------------------------------------------------
+// Print the statistics of the JIT compiler
+// -----------------------------------------------------------------------------
+void cb_jit_print_stats(FILE* output)
+{
+    fprintf(output, "\nJIT: %lu compiled loops (%lu bytes), "
+            "%lu deoptimisations\n", (unsigned long) stats.compiled_loops,
+            (unsigned long) stats.code_bytes, (unsigned long) stats.deopts);
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Check if an expression is a comparison of integer expressions or a
+// combination of such comparisons (internal)
+// -----------------------------------------------------------------------------
+static bool cb_jit_check_condition(const CbSyntree* node, int param_count)
+{
+    switch (node->type)
+    {
+        case SNT_CONSTBOOL:
+            return true;
+        
+        case SNT_COMPARISON:
+        case SNT_NUMERIC_COMPARISON:
+            return cb_jit_check_expr(((const CbComparisonNode*) node)->l,
+                                     param_count) &&
+                   cb_jit_check_expr(((const CbComparisonNode*) node)->r,
+                                     param_count);
+        
+        case SNT_LOGICAL_AND:
+        case SNT_LOGICAL_OR:
+            return cb_jit_check_condition(node->l, param_count) &&
+                   cb_jit_check_condition(node->r, param_count);
+        
+        case SNT_LOGICAL_NOT:
+            return cb_jit_check_condition(node->l, param_count);
+        
+        default:
+            return false;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Check if an expression only computes integers (internal)
+//
+//    param_count is the count of parameters of the inlined call, whose
+//    result-expression contains the expression.
+// -----------------------------------------------------------------------------
+static bool cb_jit_check_expr(const CbSyntree* node, int param_count)
+{
+    switch (node->type)
+    {
+        case SNT_CONSTVAL:
+            return !cb_numeric_is_float(((const CbConstvalNode*) node)->value);
+        
+        case SNT_SYMREF:
+            return true;
+        
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case SNT_NUMERIC_ADD:
+        case SNT_NUMERIC_SUB:
+        case SNT_NUMERIC_MUL:
+        case SNT_NUMERIC_DIV:
+            return cb_jit_check_expr(node->l, param_count) &&
+                   cb_jit_check_expr(node->r, param_count);
+        
+        case SNT_UNARYMINUS:
+            return cb_jit_check_expr(node->l, param_count);
+        
+        case SNT_INLINE_PARAM:
+            return ((const CbInlineParamNode*) node)->index < param_count;
+        
+        case SNT_INLINE_CALL:
+        {
+            const CbInlineCallNode* call = (const CbInlineCallNode*) node;
+            
+            const CbStrlist* arg = call->call->args;
+            for (; arg; arg = arg->next)
+                if (!cb_jit_check_expr((const CbSyntree*) arg->data,
+                                       param_count))
+                    return false;
+            
+            return cb_jit_check_expr(call->body, call->param_count);
+        }
+        
+        default:
+            return false;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Check if statements only assign integer expressions (internal)
+//
+//    The last statement of the loop's body has to be an assignment.
+// -----------------------------------------------------------------------------
+static bool cb_jit_check_statements(const CbSyntree* node, bool last)
+{
+    const CbFlowNode* flow = (const CbFlowNode*) node;
+    
+    switch (node->type)
+    {
+        case SNT_STATEMENTLIST:
+            return cb_jit_check_statements(node->l, false) &&
+                   cb_jit_check_statements(node->r, last);
+        
+        case SNT_ASSIGNMENT:
+            return cb_jit_check_expr(node->r, 0);
+        
+        case SNT_FLOW_IF:
+            return !last && flow->tb &&
+                   cb_jit_check_condition(flow->cond, 0) &&
+                   cb_jit_check_statements(flow->tb, false) &&
+                   (flow->fb == NULL ||
+                    cb_jit_check_statements(flow->fb, false));
+        
+        default:
+            return false;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Compile a hot loop (internal)
+//
+//    The generated code is entered with the address of the slots in rdi and
+//    keeps the temporary values on the machine stack:
+//
+//          prologue
+//      top:
+//          checkpoint of the assigned symbols
+//          condition, jump to exit if false
+//          body
+//          iterated, jump to top
+//      exit:
+//          return CB_JIT_FINISHED (| CB_JIT_ITERATED)
+//      deopt:
+//          return CB_JIT_DEOPTIMISED (| CB_JIT_ITERATED)
+//
+//    The interpreter continues at the checkpoint with the evaluation of the
+//    condition, which doesn't change any symbol.
+// -----------------------------------------------------------------------------
+static void cb_jit_compile(CbJitLoopNode* node)
+{
+    node->failed = true;
+
+#ifdef CB_JIT_AVAILABLE
+    const CbFlowNode* loop = (const CbFlowNode*) node->loop;
+    
+    CbJitCompiler compiler;
+    memset(&compiler, 0, sizeof(CbJitCompiler));
+    compiler.code = cb_alloc(sizeof(CbJitCode), CB_ALLOC_AST);
+    memset(compiler.code, 0, sizeof(CbJitCode));
+    compiler.deopt_label = cb_jit_new_label(&compiler);
+    
+    cb_jit_collect_assigned(&compiler, loop->tb);
+    
+    int top  = cb_jit_new_label(&compiler);
+    int end  = cb_jit_new_label(&compiler);
+    
+    cb_jit_emit(&compiler, JIT_PROLOGUE, JIT_HOLE_NONE, 0);
+    cb_jit_bind_label(&compiler, top);
+    
+    int i = 0;
+    for (; i < compiler.code->symbol_count; i++)
+    {
+        if (!compiler.code->assigned[i])
+            continue;
+        
+        cb_jit_emit(&compiler, JIT_PUSH_SLOT, JIT_HOLE_SYMBOL, i);
+        cb_jit_emit(&compiler, JIT_POP_SLOT, JIT_HOLE_CHECKPOINT, i);
+    }
+    
+    cb_jit_gen_condition(&compiler, loop->cond, 0);
+    cb_jit_emit(&compiler, JIT_JUMP_IF_FALSE, JIT_HOLE_LABEL, end);
+    
+    cb_jit_gen_statements(&compiler, loop->tb);
+    cb_jit_emit(&compiler, JIT_ITERATED, JIT_HOLE_NONE, 0);
+    cb_jit_emit(&compiler, JIT_JUMP, JIT_HOLE_LABEL, top);
+    cb_jit_bind_label(&compiler, end);
+    cb_jit_emit(&compiler, JIT_EXIT, JIT_HOLE_NONE, 0);
+    cb_jit_bind_label(&compiler, compiler.deopt_label);
+    cb_jit_emit(&compiler, JIT_DEOPTIMISE, JIT_HOLE_NONE, 0);
+    
+    if (cb_jit_finish(&compiler))
+    {
+        node->code   = compiler.code;
+        node->failed = false;
+        stats.compiled_loops++;
+        stats.code_bytes += compiler.size;
+    }
+    else
+        cb_free(compiler.code, CB_ALLOC_AST);
+    
+    cb_free(compiler.buffer, CB_ALLOC_AST);
+    cb_free(compiler.fixups, CB_ALLOC_AST);
+    cb_free(compiler.labels, CB_ALLOC_AST);
+#endif // CB_JIT_AVAILABLE
+}
+
+// -----------------------------------------------------------------------------
+// Add the slots of the symbols assigned by statements (internal)
+// -----------------------------------------------------------------------------
+static void cb_jit_collect_assigned(CbJitCompiler* compiler,
+                                    const CbSyntree* node)
+{
+    const CbFlowNode* flow = (const CbFlowNode*) node;
+    
+    switch (node->type)
+    {
+        case SNT_STATEMENTLIST:
+            cb_jit_collect_assigned(compiler, node->l);
+            cb_jit_collect_assigned(compiler, node->r);
+            break;
+        
+        case SNT_ASSIGNMENT:
+        {
+            int slot = cb_jit_get_slot(compiler,
+                                       ((const CbSymref*) node->l)->sym_id);
+            compiler->code->assigned[slot] = true;
+            break;
+        }
+        
+        case SNT_FLOW_IF:
+            cb_jit_collect_assigned(compiler, flow->tb);
+            if (flow->fb)
+                cb_jit_collect_assigned(compiler, flow->fb);
+            break;
+        
+        default:
+            break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Generate the code of statements (internal)
+// -----------------------------------------------------------------------------
+static void cb_jit_gen_statements(CbJitCompiler* compiler,
+                                  const CbSyntree* node)
+{
+    const CbFlowNode* flow = (const CbFlowNode*) node;
+    
+    switch (node->type)
+    {
+        case SNT_STATEMENTLIST:
+            cb_jit_gen_statements(compiler, node->l);
+            cb_jit_gen_statements(compiler, node->r);
+            break;
+        
+        case SNT_ASSIGNMENT:
+        {
+            int slot = cb_jit_get_slot(compiler,
+                                       ((const CbSymref*) node->l)->sym_id);
+            cb_jit_gen_expr(compiler, node->r, 0);
+            cb_jit_emit(compiler, JIT_POP_SLOT, JIT_HOLE_SYMBOL, slot);
+            
+            // the last generated assignment is the last statement
+            compiler->code->result_slot = slot;
+            break;
+        }
+        
+        case SNT_FLOW_IF:
+        {
+            int false_branch = cb_jit_new_label(compiler);
+            
+            cb_jit_gen_condition(compiler, flow->cond, 0);
+            cb_jit_emit(compiler, JIT_JUMP_IF_FALSE, JIT_HOLE_LABEL,
+                        false_branch);
+            cb_jit_gen_statements(compiler, flow->tb);
+            
+            if (flow->fb)
+            {
+                int end = cb_jit_new_label(compiler);
+                cb_jit_emit(compiler, JIT_JUMP, JIT_HOLE_LABEL, end);
+                cb_jit_bind_label(compiler, false_branch);
+                cb_jit_gen_statements(compiler, flow->fb);
+                cb_jit_bind_label(compiler, end);
+            }
+            else
+                cb_jit_bind_label(compiler, false_branch);
+            
+            break;
+        }
+        
+        default:
+            assert(false); // see cb_jit_check_statements()
+            break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Generate the code of a condition, which pushes 1 (true) or 0 (false)
+// (internal)
+// -----------------------------------------------------------------------------
+static void cb_jit_gen_condition(CbJitCompiler* compiler,
+                                 const CbSyntree* node, int param_base)
+{
+    switch (node->type)
+    {
+        case SNT_CONSTBOOL:
+            cb_jit_emit(compiler, JIT_PUSH_IMM32, JIT_HOLE_IMMEDIATE,
+                        cb_boolean_get(((const CbConstvalNode*) node)->value));
+            break;
+        
+        case SNT_COMPARISON:
+        case SNT_NUMERIC_COMPARISON:
+        {
+            const CbComparisonNode* cmp = (const CbComparisonNode*) node;
+            
+            cb_jit_gen_expr(compiler, cmp->l, param_base);
+            cb_jit_gen_expr(compiler, cmp->r, param_base);
+            cb_jit_emit(compiler, JIT_COMPARE, JIT_HOLE_IMMEDIATE,
+                        setcc_opcodes[cmp->cmp_type]);
+            break;
+        }
+        
+        case SNT_LOGICAL_AND:
+        case SNT_LOGICAL_OR:
+            cb_jit_gen_condition(compiler, node->l, param_base);
+            cb_jit_gen_condition(compiler, node->r, param_base);
+            cb_jit_emit(compiler, (node->type == SNT_LOGICAL_AND) ? JIT_AND
+                                                                 : JIT_OR,
+                        JIT_HOLE_NONE, 0);
+            break;
+        
+        case SNT_LOGICAL_NOT:
+            cb_jit_gen_condition(compiler, node->l, param_base);
+            cb_jit_emit(compiler, JIT_NOT, JIT_HOLE_NONE, 0);
+            break;
+        
+        default:
+            assert(false); // see cb_jit_check_condition()
+            break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Generate the code of an integer expression, which pushes its value
+// (internal)
+//
+//    param_base is the first slot of the parameters of the inlined call,
+//    whose result-expression contains the expression.
+// -----------------------------------------------------------------------------
+static void cb_jit_gen_expr(CbJitCompiler* compiler, const CbSyntree* node,
+                            int param_base)
+{
+    switch (node->type)
+    {
+        case SNT_CONSTVAL:
+        {
+            CbNumeric value = cb_numeric_get(((const CbConstvalNode*)
+                                              node)->value);
+            cb_jit_emit(compiler, (value >= INT32_MIN && value <= INT32_MAX)
+                                  ? JIT_PUSH_IMM32 : JIT_PUSH_IMM64,
+                        JIT_HOLE_IMMEDIATE, value);
+            break;
+        }
+        
+        case SNT_SYMREF:
+            cb_jit_emit(compiler, JIT_PUSH_SLOT, JIT_HOLE_SYMBOL,
+                        cb_jit_get_slot(compiler,
+                                        ((const CbSymref*) node)->sym_id));
+            break;
+        
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case SNT_NUMERIC_ADD:
+        case SNT_NUMERIC_SUB:
+        case SNT_NUMERIC_MUL:
+        case SNT_NUMERIC_DIV:
+        {
+            enum cb_jit_stencil_type type = JIT_ADD;
+            if (node->type == '-' || node->type == SNT_NUMERIC_SUB)
+                type = JIT_SUB;
+            else if (node->type == '*' || node->type == SNT_NUMERIC_MUL)
+                type = JIT_MUL;
+            else if (node->type == '/' || node->type == SNT_NUMERIC_DIV)
+                type = JIT_DIV;
+            
+            cb_jit_gen_expr(compiler, node->l, param_base);
+            cb_jit_gen_expr(compiler, node->r, param_base);
+            cb_jit_emit(compiler, type, JIT_HOLE_NONE, 0);
+            break;
+        }
+        
+        case SNT_UNARYMINUS:
+            cb_jit_gen_expr(compiler, node->l, param_base);
+            cb_jit_emit(compiler, JIT_NEG, JIT_HOLE_NONE, 0);
+            break;
+        
+        case SNT_INLINE_PARAM:
+            cb_jit_emit(compiler, JIT_PUSH_SLOT, JIT_HOLE_PARAM,
+                        param_base + ((const CbInlineParamNode*) node)->index);
+            break;
+        
+        case SNT_INLINE_CALL:
+        {
+            const CbInlineCallNode* call = (const CbInlineCallNode*) node;
+            
+            // every inlined call has its own parameter slots
+            int base = compiler->code->param_count;
+            compiler->code->param_count += call->param_count;
+            
+            int i                = 0;
+            const CbStrlist* arg = call->call->args;
+            for (; arg; arg = arg->next, i++)
+            {
+                cb_jit_gen_expr(compiler, (const CbSyntree*) arg->data,
+                                param_base);
+                cb_jit_emit(compiler, JIT_POP_SLOT, JIT_HOLE_PARAM, base + i);
+            }
+            
+            cb_jit_gen_expr(compiler, call->body, base);
+            break;
+        }
+        
+        default:
+            assert(false); // see cb_jit_check_expr()
+            break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Copy a stencil to the generated code and patch its operand (internal)
+//
+//    Slots and jump targets are patched by cb_jit_finish(), when the count of
+//    slots and the offsets of the labels are known.
+// -----------------------------------------------------------------------------
+static void cb_jit_emit(CbJitCompiler* compiler,
+                        enum cb_jit_stencil_type type,
+                        enum cb_jit_hole_kind kind, int64_t operand)
+{
+    const CbJitStencil* stencil = &stencils[type];
+    
+    if (compiler->size + stencil->size > compiler->capacity)
+    {
+        compiler->capacity = (compiler->capacity) ? compiler->capacity * 2
+                                                  : 256;
+        compiler->buffer   = cb_realloc(compiler->buffer, compiler->capacity,
+                                        CB_ALLOC_AST);
+    }
+    
+    size_t offset = compiler->size;
+    memcpy(compiler->buffer + offset, stencil->code, stencil->size);
+    compiler->size += stencil->size;
+    
+    if (kind == JIT_HOLE_IMMEDIATE)
+        // little endian, the immediate value is truncated to the hole
+        memcpy(compiler->buffer + offset + stencil->hole, &operand,
+               stencil->hole_size);
+    else if (kind != JIT_HOLE_NONE)
+        cb_jit_add_fixup(compiler, offset + stencil->hole, kind,
+                         (int) operand);
+    
+    int i = 0;
+    for (; i < 3 && stencil->deopts[i] >= 0; i++)
+        cb_jit_add_fixup(compiler, offset + stencil->deopts[i],
+                         JIT_HOLE_LABEL, compiler->deopt_label);
+}
+
+// -----------------------------------------------------------------------------
+// Add a hole, which is patched after the code generation (internal)
+// -----------------------------------------------------------------------------
+static void cb_jit_add_fixup(CbJitCompiler* compiler, size_t offset,
+                             enum cb_jit_hole_kind kind, int index)
+{
+    if (compiler->fixup_count == compiler->fixup_capacity)
+    {
+        compiler->fixup_capacity = (compiler->fixup_capacity)
+                                 ? compiler->fixup_capacity * 2 : 32;
+        compiler->fixups         = cb_realloc(compiler->fixups,
+                                              compiler->fixup_capacity *
+                                              sizeof(CbJitFixup),
+                                              CB_ALLOC_AST);
+    }
+    
+    CbJitFixup* fixup = &compiler->fixups[compiler->fixup_count++];
+    fixup->offset     = offset;
+    fixup->kind       = kind;
+    fixup->index      = index;
+}
+
+// -----------------------------------------------------------------------------
+// Create a label, which isn't bound to an offset yet (internal)
+// -----------------------------------------------------------------------------
+static int cb_jit_new_label(CbJitCompiler* compiler)
+{
+    if (compiler->label_count == compiler->label_capacity)
+    {
+        compiler->label_capacity = (compiler->label_capacity)
+                                 ? compiler->label_capacity * 2 : 8;
+        compiler->labels         = cb_realloc(compiler->labels,
+                                              compiler->label_capacity *
+                                              sizeof(size_t), CB_ALLOC_AST);
+    }
+    
+    compiler->labels[compiler->label_count] = 0;
+    
+    return compiler->label_count++;
+}
+
+// -----------------------------------------------------------------------------
+// Bind a label to the current offset of the generated code (internal)
+// -----------------------------------------------------------------------------
+static void cb_jit_bind_label(CbJitCompiler* compiler, int label)
+{
+    compiler->labels[label] = compiler->size;
+}
+
+// -----------------------------------------------------------------------------
+// Get the slot of a symbol, which is added, if the loop didn't refer to the
+// symbol before (internal)
+// -----------------------------------------------------------------------------
+static int cb_jit_get_slot(CbJitCompiler* compiler, const char* id)
+{
+    CbJitCode* code = compiler->code;
+    
+    int i = 0;
+    for (; i < code->symbol_count; i++)
+        if (strcmp(code->ids[i], id) == 0)
+            return i;
+    
+    if (code->symbol_count == CB_JIT_MAX_SLOTS)
+    {
+        compiler->failed = true;
+        return 0;
+    }
+    
+    code->ids[code->symbol_count] = id;
+    
+    return code->symbol_count++;
+}
+
+// -----------------------------------------------------------------------------
+// Patch the slots and jump targets and copy the generated code to executable
+// pages (internal)
+//
+//    The slots of the symbols are followed by the slots of the parameters and
+//    the checkpoint slots of the symbols.
+// -----------------------------------------------------------------------------
+static bool cb_jit_finish(CbJitCompiler* compiler)
+{
+#ifdef CB_JIT_AVAILABLE
+    CbJitCode* code = compiler->code;
+    
+    if (compiler->failed || code->symbol_count * 2 + code->param_count >
+                            CB_JIT_MAX_SLOTS)
+        return false;
+    
+    size_t i = 0;
+    for (; i < compiler->fixup_count; i++)
+    {
+        const CbJitFixup* fixup = &compiler->fixups[i];
+        int32_t value           = 0;
+        
+        switch (fixup->kind)
+        {
+            case JIT_HOLE_SYMBOL:
+                value = fixup->index * (int32_t) sizeof(int64_t);
+                break;
+            
+            case JIT_HOLE_PARAM:
+                value = (code->symbol_count + fixup->index) *
+                        (int32_t) sizeof(int64_t);
+                break;
+            
+            case JIT_HOLE_CHECKPOINT:
+                value = (code->symbol_count + code->param_count +
+                         fixup->index) * (int32_t) sizeof(int64_t);
+                break;
+            
+            case JIT_HOLE_LABEL:
+                // relative to the end of the jump instruction
+                value = (int32_t) (compiler->labels[fixup->index] -
+                                   (fixup->offset + sizeof(int32_t)));
+                break;
+            
+            default:
+                break;
+        }
+        
+        memcpy(compiler->buffer + fixup->offset, &value, sizeof(int32_t));
+    }
+    
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+    code->size       = (compiler->size + page_size - 1) / page_size *
+                       page_size;
+    
+    void* memory = mmap(NULL, code->size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED)
+        return false;
+    
+    memcpy(memory, compiler->buffer, compiler->size);
+    if (mprotect(memory, code->size, PROT_READ | PROT_EXEC) != 0)
+    {
+        munmap(memory, code->size);
+        return false;
+    }
+    
+    code->function = (CbJitFunction) memory;
+    
+    return true;
+#else
+    (void) compiler;
+    return false;
+#endif // CB_JIT_AVAILABLE
+}
+
+// -----------------------------------------------------------------------------
+// Execute the machine code of a loop (internal)
+//
+//    The slots are loaded from the symbols, which have to be integer
+//    variables, and stored into the assigned symbols afterwards, from the
+//    checkpoint, if the code was deoptimised. The result of the last
+//    iteration (which is in the checkpoint, too) replaces the result.
+// -----------------------------------------------------------------------------
+static enum cb_jit_status cb_jit_run(const CbJitCode* code, CbSymtab* symtab,
+                                     CbValue** result)
+{
+    CbSymbol* symbols[CB_JIT_MAX_SLOTS];
+    int64_t slots[CB_JIT_MAX_SLOTS];
+    
+    int i = 0;
+    for (; i < code->symbol_count; i++)
+    {
+        symbols[i] = cb_symtab_lookup(symtab, code->ids[i], false);
+        if (symbols[i] == NULL || !cb_symbol_is_variable(symbols[i]))
+            return CB_JIT_GUARD_FAILED;
+        
+        const CbValue* value = cb_symbol_variable_get_value(symbols[i]);
+        if (!cb_value_is_type(value, CB_VT_NUMERIC) ||
+            cb_numeric_is_float(value))
+            return CB_JIT_GUARD_FAILED;
+        
+        slots[i] = cb_numeric_get(value);
+    }
+    
+    int status     = code->function(slots);
+    int checkpoint = (status & CB_JIT_DEOPTIMISED)
+                   ? code->symbol_count + code->param_count : 0;
+    
+    for (i = 0; i < code->symbol_count; i++)
+        if (code->assigned[i])
+            cb_symbol_variable_assign_and_free_value(symbols[i],
+                cb_numeric_create(slots[checkpoint + i]));
+    
+    if (status & CB_JIT_ITERATED)
+    {
+        cb_value_free(*result);
+        *result = cb_numeric_create(slots[checkpoint + code->result_slot]);
+    }
+    
+    return (enum cb_jit_status) status;
+}
+
+// -----------------------------------------------------------------------------
+// Free the value a variable refers to, if any (CbErrorCleanup) (internal)
+// -----------------------------------------------------------------------------
+static void cb_jit_cleanup_value_ref(void* value_ref)
+{
+    CbValue* value = *((CbValue**) value_ref);
+    if (value)
+        cb_value_free(value);
+}
@@ -0,0 +1,100 @@
+/*******************************************************************************
+ * CbJit -- Template JIT compiler for hot integer loops
+ *
+ *          If the JIT compiler is enabled (`--jit', see main.c), the
+ *          optimizer (see optimizer.h) wraps every while-loop, which only
+ *          computes integers, into a node of the type SNT_JIT_LOOP. Its
+ *          condition has to be a comparison of integer expressions (or a
+ *          combination of such comparisons by AND, OR and NOT), its body has
+ *          to consist of assignments of integer expressions and if-statements
+ *          of the same kind, and its last statement has to be an assignment,
+ *          whose value is the result of the loop. An integer expression
+ *          consists of symbols, integer constants, the arithmetic operations
+ *          and calls of inlined functions, whose result-expressions are
+ *          integer expressions.
+ *
+ *          The loop is interpreted, until CB_JIT_HOT_ITERATIONS iterations
+ *          were executed, then its condition and body are compiled to x86-64
+ *          machine code by copying precompiled stencils of machine code into
+ *          executable pages and patching their operands (copy-and-patch).
+ *          The compiled code keeps the values of the symbols in slots, which
+ *          are loaded from the symbols, when the code is entered, and stored
+ *          into the symbols, when it is left.
+ *
+ *          Guards deoptimise the loop back to the interpreter: If a symbol
+ *          isn't an integer, when the code is entered, the loop is
+ *          interpreted. If an operation would overflow, divide by zero or
+ *          result in a float, the code restores the slots from a checkpoint
+ *          taken at the beginning of the iteration, and the interpreter
+ *          executes the rest of the loop from there, so it produces the same
+ *          result and errors as without the JIT compiler. After
+ *          CB_JIT_MAX_DEOPTS deoptimisations, the loop isn't compiled
+ *          anymore. Loops are always interpreted, while the profiler or
+ *          execution limits are enabled.
+ *
+ *          The JIT compiler is available on x86-64 Linux only (unless it is
+ *          disabled by _CBC_NO_JIT) and disabled by default.
+ ******************************************************************************/
+
+#ifndef JIT_H
+#define JIT_H
+
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "symtab_if.h"
+#include "syntree_if.h"
+#include "value.h"
+
+#if defined(__x86_64__) && defined(__linux__) && !defined(_CBC_NO_JIT)
+#define CB_JIT_AVAILABLE
+#endif
+
+// count of interpreted iterations, after which a loop is compiled
+#define CB_JIT_HOT_ITERATIONS 64
+// count of deoptimisations, after which a loop isn't compiled anymore
+#define CB_JIT_MAX_DEOPTS     16
+// maximum count of slots of a compiled loop
+#define CB_JIT_MAX_SLOTS      64
+
+// machine code of a compiled loop
+typedef struct CbJitCode CbJitCode;
+
+// loop node, which is compiled, when it is hot
+typedef struct
+{
+    enum cb_syntree_node_type type; // node-type is SNT_JIT_LOOP
+    int line_no;                    // line number
+    CbSyntree* loop;                // while-loop
+    CbJitCode* code;                // machine code (or NULL)
+    unsigned int iterations;        // interpreted iterations
+    unsigned int deopt_count;       // count of deoptimisations
+    bool failed;                    // the loop isn't compiled (anymore)
+} CbJitLoopNode;
+
+// statistics of the JIT compiler
+typedef struct
+{
+    size_t compiled_loops;          // count of compiled loops
+    size_t code_bytes;              // size of the generated machine code
+    size_t deopts;                  // count of deoptimisations
+} CbJitStats;
+
+// determines whether the JIT compiler is enabled
+extern bool cb_jit_enabled;
+
+
+// interface functions
+int cb_jit_enable();
+void cb_jit_disable();
+
+bool cb_jit_can_compile(const CbSyntree* loop);
+CbSyntree* cb_jit_loop_node_create(CbSyntree* loop);
+void cb_jit_loop_node_free_code(CbJitLoopNode* node);
+CbValue* cb_jit_loop_node_eval(CbJitLoopNode* node, CbSymtab* symtab);
+
+void cb_jit_get_stats(CbJitStats* stats);
+void cb_jit_print_stats(FILE* output);
+
+
+#endif // JIT_H
@@ -2,7 +2,37 @@
  * main -- Running the parser and executing the abstract syntax tree.
  *         Also checking command line arguments:
  *           - if a file-name was passed, the file will be parsed and executed
- *           - if no argument was passed, stdin will be parsed and executed
+ *           - if no argument or `-' was passed, stdin will be parsed and
+ *             executed; without an argument an interactive session (REPL)
+ *             is started instead, if stdin is a terminal
+ *           - `--repl' starts a session reading stdin, which executes every
+ *             chunk of input, as soon as it is complete (see repl.h)
+ *           - an optional second argument names the input of ReadLn(): a
+ *             file-name or `-' for stdin (default), so a script can be used
+ *             as filter in a pipeline
+ *           - `--compile <file> -o <image>' parses the file, reports type
+ *             errors (see optimizer.h) and writes the syntax-tree as
+ *             compiled image, which can be passed instead of a source file
+ *             to skip parsing
+ *           - `--serve <socket> [workers]' runs a daemon executing the
+ *             requests sent to the Unix domain socket (see server.h); the
+ *             limit options replace the default limits of a request
+ *           - `--load <socket> <file> [requests] [connections]' sends the
+ *             script to a daemon repeatedly and prints the throughput and
+ *             latencies
+ *           - `--profile[=<file>]' in front of the other arguments profiles
+ *             the execution, prints hot spots and writes collapsed stacks to
+ *             the file (default: cbc.collapsed, see profile.h)
+ *           - `--sample[=<file>]' works like `--profile', but samples the
+ *             execution with a timer instead of timing every node
+ *           - `--mem-stats' in front of the other arguments prints the
+ *             memory statistics of the run (see alloc.h and pool.h) and
+ *             the statistics of the JIT compiler
+ *           - `--jit' in front of the other arguments (after `--mem-stats')
+ *             compiles hot integer loops to machine code (see jit.h)
+ *           - `--max-steps=<n>', `--timeout=<ms>', `--max-depth=<n>' and
+ *             `--max-memory=<bytes>' in front of the other arguments limit
+ *             the execution of the script (see exec_limits.h)
  * 
  *         Used macros:
  *           - _CBC_TRACK_EXECUTION_TIME: Determines whether to print the 
@@ -12,21 +42,204 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <string.h>
+#ifdef _CBC_PLAT_WNDS
+#include <io.h>
+#define STDIN_FILENO 0
+#else
+#include <unistd.h>
+#endif // _CBC_PLAT_WNDS
 #include "value.h"
 #include "codeblock.h"
+#include "output.h"
+#include "reader.h"
 #include "symtab.h"
 #include "error_handling.h"
+#include "image.h"
+#include "server.h"
+#include "repl.h"
+#include "profile.h"
+#include "alloc.h"
+#include "pool.h"
+#include "exec_limits.h"
+#include "optimizer.h"
+#include "jit.h"
 
+// default file of the collapsed stacks written by --profile
+#define PROFILE_STACKS_FILE "cbc.collapsed"
+
+
+// -----------------------------------------------------------------------------
+// Compile a source file into an image file
+// -----------------------------------------------------------------------------
+static int compile(const char* source_name, const char* image_name)
+{
+    FILE* input = fopen(source_name, "r");
+    if (!input)
+    {
+        cb_print_error_msg("Unable to open file `%s'", source_name);
+        return EXIT_FAILURE;
+    }
+    
+    Codeblock* cb = codeblock_create();
+    int result    = codeblock_parse_file(cb, input);
+    fclose(input);
+    
+    // type errors, which occur whenever a statement is executed, fail the
+    // compilation
+    if (result == EXIT_SUCCESS && cb_optimizer_check_types(cb->ast) > 0)
+        result = EXIT_FAILURE;
+    
+    if (result == EXIT_SUCCESS)
+        result = codeblock_save_image(cb, image_name);
+    
+    codeblock_free(cb);
+    
+    return result;
+}
 
 // -----------------------------------------------------------------------------
 // Main
 // -----------------------------------------------------------------------------
 int main(int argc, char* argv[])
 {
-    bool parse_file = argc > 1; // determine whether to parse a file
-    FILE* input     = NULL;
+    const char* stacks_name = NULL; // set, if the execution is profiled
+    bool sample             = false;
+    bool mem_stats          = false;
+    
+    if (argc > 1 && strcmp(argv[1], "--mem-stats") == 0)
+    {
+        mem_stats = true;
+        
+        // drop the option
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+    
+    if (argc > 1 && strcmp(argv[1], "--jit") == 0)
+    {
+        if (cb_jit_enable() != EXIT_SUCCESS)
+            cb_print_error_msg("The JIT compiler isn't available");
+        
+        // drop the option
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+    
+    if (argc > 1 && (strncmp(argv[1], "--profile", 9) == 0 ||
+                     strncmp(argv[1], "--sample", 8) == 0))
+    {
+        sample            = argv[1][3] == 'a';
+        const char* value = argv[1] + ((sample) ? 8 : 9);
+        if (*value != '\0' && *value != '=')
+        {
+            cb_print_error_msg("Unknown option `%s'", argv[1]);
+            return EXIT_FAILURE;
+        }
+        
+        stacks_name = (*value == '=') ? value + 1 : PROFILE_STACKS_FILE;
+        
+        // drop the option
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+    
+    CbLimits limits = { 0, 0, 0, 0 };
+    bool limited    = false;
+    
+    while (argc > 1 && (strncmp(argv[1], "--max-steps=", 12) == 0 ||
+                        strncmp(argv[1], "--timeout=", 10) == 0 ||
+                        strncmp(argv[1], "--max-depth=", 12) == 0 ||
+                        strncmp(argv[1], "--max-memory=", 13) == 0))
+    {
+        const char* value = strchr(argv[1], '=') + 1;
+        char* end         = NULL;
+        unsigned long n   = strtoul(value, &end, 10);
+        if (*value == '\0' || *end != '\0')
+        {
+            cb_print_error_msg("Invalid value of option `%s'", argv[1]);
+            return EXIT_FAILURE;
+        }
+        
+        if (argv[1][2] == 't')
+            limits.timeout = n;
+        else if (argv[1][6] == 's')
+            limits.max_steps = n;
+        else if (argv[1][6] == 'm')
+            limits.max_memory = n;
+        else
+            limits.max_call_depth = (unsigned int) n;
+        
+        limited = true;
+        
+        // drop the option
+        argv[1] = argv[0];
+        argv++;
+        argc--;
+    }
+    
+    if (argc > 1 && strcmp(argv[1], "--compile") == 0)
+    {
+        if (argc != 5 || strcmp(argv[3], "-o") != 0)
+        {
+            cb_print_error_msg("Usage: %s --compile <file> -o <image>",
+                               argv[0]);
+            return EXIT_FAILURE;
+        }
+        
+        return compile(argv[2], argv[4]);
+    }
+    
+    if ((argc > 1 && strcmp(argv[1], "--repl") == 0) ||
+        (argc == 1 && isatty(STDIN_FILENO)))
+    {
+        bool interactive = isatty(STDIN_FILENO);
+        CbRepl* repl     = cb_repl_create();
+        int result       = cb_repl_run(repl, cb_reader_get_input(),
+                                       cb_output_get_stdout(), interactive);
+        cb_repl_free(repl);
+        
+        return result;
+    }
+    
+    if (argc > 1 && strcmp(argv[1], "--serve") == 0)
+    {
+        if (argc < 3 || argc > 4)
+        {
+            cb_print_error_msg("Usage: %s --serve <socket> [workers]", argv[0]);
+            return EXIT_FAILURE;
+        }
+        
+        return cb_server_run(argv[2], (argc > 3) ? atoi(argv[3]) : 0,
+                             (limited) ? &limits : NULL);
+    }
+    
+    if (argc > 1 && strcmp(argv[1], "--load") == 0)
+    {
+        int request_count    = (argc > 4) ? atoi(argv[4]) : 10000;
+        int connection_count = (argc > 5) ? atoi(argv[5]) : 4;
+        
+        if (argc < 4 || argc > 6 || request_count <= 0 || connection_count <= 0)
+        {
+            cb_print_error_msg("Usage: %s --load <socket> <file> [requests] "
+                               "[connections]", argv[0]);
+            return EXIT_FAILURE;
+        }
+        
+        return cb_server_load_test(argv[2], argv[3], request_count,
+                                   connection_count);
+    }
+    
+    // determine whether to parse a file or to load an image
+    bool parse_file  = argc > 1 && strcmp(argv[1], "-") != 0;
+    bool load_image  = parse_file && cb_image_file_is_image(argv[1]);
+    FILE* input      = NULL;
+    CbReader* reader = NULL;
     
-    if (parse_file)
+    if (parse_file && !load_image)
     {
         input = fopen(argv[1], "r");
         if (!input)
@@ -35,24 +248,76 @@ int main(int argc, char* argv[])
             return EXIT_FAILURE;
         }
     }
+    
+    if (argc > 2 && strcmp(argv[2], "-") != 0) // input of ReadLn()
+    {
+        reader = cb_reader_open(argv[2]);
+        if (!reader)
+        {
+            cb_print_error_msg("Unable to open file `%s'", argv[2]);
+            if (input)
+                fclose(input);
+            
+            return EXIT_FAILURE;
+        }
+        
+        cb_reader_set_input(reader);
+    }
 
     Codeblock* cb     = codeblock_create();
-    int parser_result = codeblock_parse_file(cb, input);
+    cb->limits        = (limited) ? &limits : NULL;
+    int parser_result = (load_image) ? codeblock_load_image(cb, argv[1])
+                                     : codeblock_parse_file(cb, input);
     
-    if (parse_file)    // if a file was parsed
+    if (input)         // if a file was parsed
         fclose(input); // -> close file stream
     
+    if (stacks_name && parser_result == EXIT_SUCCESS)
+    {
+        if (!sample)
+            cb_profile_start();
+        else if (cb_profile_start_sampling(CB_PROFILE_SAMPLE_INTERVAL) !=
+                 EXIT_SUCCESS)
+            cb_print_error_msg("Sampling isn't available");
+    }
+    
     if (parser_result         == EXIT_SUCCESS &&
         codeblock_execute(cb) == EXIT_SUCCESS) // execute ...
     {
-        cb_value_print(cb->result);            // and print result
+        CbOutput* output = cb_output_get_stdout();
+        cb_output_write_value(output, cb->result); // and print result
+        cb_output_flush(output);
         
 #ifdef _CBC_TRACK_EXECUTION_TIME
         printf("\nExecution duration: %f seconds", cb->duration);
 #endif // _CBC_TRACK_EXECUTION_TIME
     }
     
+    if (stacks_name && parser_result == EXIT_SUCCESS)
+    {
+        cb_profile_stop();
+        cb_profile_report(stderr, (load_image) ? NULL : argv[1]);
+        
+        if (cb_profile_write_stacks(stacks_name) == EXIT_SUCCESS)
+            fprintf(stderr, "\nCollapsed stacks written to `%s'\n",
+                    stacks_name);
+        else
+            cb_print_error_msg("Unable to write file `%s'", stacks_name);
+        
+        cb_profile_reset();
+    }
+    
     codeblock_free(cb); // cleanup
+    if (reader)
+        cb_reader_free(reader);
+    
+    if (mem_stats) // after the cleanup, so live bytes show retained memory
+    {
+        cb_alloc_print_stats(stderr);
+        cb_pool_print_stats(stderr);
+        if (cb_jit_enabled)
+            cb_jit_print_stats(stderr);
+    }
     
     return 0;
 }
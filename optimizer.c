@@ -0,0 +1,2070 @@
+/*******************************************************************************
+ * CbOptimizer -- Optimization passes over the abstract syntax-tree
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "optimizer.h"
+#include "alloc.h"
+#include "syntree.h"
+#include "symref.h"
+#include "funccall.h"
+#include "funcdecl.h"
+#include "exception_block_node.h"
+#include "array_node.h"
+#include "array_assignment_node.h"
+#include "hash_node.h"
+#include "inline_call_node.h"
+#include "invariant_node.h"
+#include "jit.h"
+#include "array_access_node.h"
+#include "builtin.h"
+#include "error_handling.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+// name declared by the script
+typedef struct
+{
+    const char* id;                 // identifier
+    int function_count;             // count of declarations as function
+    bool variable;                  // declared as variable or parameter
+} CbOptimizerName;
+
+// names declared by the script
+typedef struct
+{
+    CbOptimizerName* items;
+    size_t count;
+    size_t capacity;
+} CbOptimizerNames;
+
+// use of a name by the script
+typedef struct
+{
+    const char* id;                 // identifier
+    int reads;                      // count of references and calls
+    int declarations;               // count of declarations as variable
+    int functions;                  // count of declarations as function
+    int statement_functions;        // ... as statement of a body
+    bool param;                     // declared as parameter
+    const CbSyntree* body;          // body declaring the variable first
+    const CbSyntree* assign_body;   // body assigning the variable
+    bool assigned_elsewhere;        // assigned by another body, too
+} CbEliminatorName;
+
+// state of the dead code elimination pass
+typedef struct
+{
+    CbEliminatorName* names;
+    size_t name_count;
+    size_t name_capacity;
+    const CbSyntree* body;          // body of the current node
+    bool leading;                   // in the leading declarations of the body
+    bool shared_symtab;             // top level names are used afterwards
+    bool changed;                   // the syntax-tree was changed
+    CbSyntree** removed;            // removed nodes (freed after a pass,
+    size_t removed_count;           // since the names refer to them)
+    size_t removed_capacity;
+} CbEliminator;
+
+// function, whose calls are inlined
+typedef struct
+{
+    const char* id;                 // identifier
+    CbStrlist* params;              // formal parameters
+    int param_count;                // count of parameters
+    CbSyntree* expr;                // result-expression
+} CbInlinerFunction;
+
+// state of the inlining pass
+typedef struct
+{
+    const CbOptimizerNames* names;
+    CbInlinerFunction* functions;
+    size_t function_count;
+    size_t function_capacity;
+} CbInliner;
+
+// state of the hoisting pass for a loop
+typedef struct
+{
+    const CbOptimizerNames* names;
+    const char** changed;           // symbols changed by the loop
+    size_t changed_count;
+    size_t changed_capacity;
+    bool changes_any;               // any symbol may be changed by the loop
+    CbInvariantExprNode** invariants; // invariant expressions of the loop
+    size_t invariant_count;
+    size_t invariant_capacity;
+} CbHoister;
+
+// set of value-types (bit 1 << CB_VT_x for every type)
+typedef unsigned int CbTypeSet;
+
+#define CB_TYPES_NONE    0u
+#define CB_TYPES_ANY     ((1u << (CB_VT_HASH + 1)) - 1)
+#define CB_TYPE(vt)      (1u << (vt))
+
+// value-types of a symbol
+typedef struct
+{
+    const char* id;                 // identifier
+    CbTypeSet types;                // possible value-types
+} CbTypeBinding;
+
+// value-types of the symbols at a point of the execution (symbols, which
+// aren't bound, may have any value-type)
+typedef struct
+{
+    CbTypeBinding* items;
+    size_t count;
+    size_t capacity;
+} CbTypeEnv;
+
+// state of the type inference pass
+typedef struct
+{
+    const CbOptimizerNames* names;
+    CbTypeEnv env;                  // value-types at the current node
+    const CbTypeSet* params;        // value-types of inlined parameters
+    bool specialize;                // replace nodes by specialised nodes
+    bool report;                    // report provable type errors
+    int error_count;                // count of reported type errors
+} CbTyper;
+
+static void cb_optimizer_collect_names(CbSyntree** node, void* names);
+static void cb_optimizer_add_name(CbOptimizerNames* names, const char* id,
+                                  bool function);
+static CbOptimizerName* cb_optimizer_find_name(const CbOptimizerNames* names,
+                                               const char* id);
+
+static void cb_optimizer_eliminate(CbSyntree** ast, bool shared_symtab);
+static void cb_eliminator_collect(CbEliminator* eliminator, CbSyntree* node,
+                                  bool statement);
+static void cb_eliminator_collect_child(CbSyntree** node, void* eliminator);
+static CbEliminatorName* cb_eliminator_get_name(CbEliminator* eliminator,
+                                                const char* id);
+static bool cb_eliminator_is_unused_variable(CbEliminator* eliminator,
+                                             const char* id);
+static bool cb_eliminator_is_unused_function(CbEliminator* eliminator,
+                                             const char* id);
+static CbSyntree* cb_eliminator_sweep(CbEliminator* eliminator,
+                                      CbSyntree* node, bool discarded);
+static CbSyntree* cb_eliminator_remove(CbEliminator* eliminator,
+                                       CbSyntree* node);
+static void cb_eliminator_sweep_child(CbSyntree** node, void* eliminator);
+static bool cb_eliminator_is_constant(const CbSyntree* node);
+
+static void cb_optimizer_inline(CbSyntree** ast,
+                                const CbOptimizerNames* names);
+static void cb_inliner_process_statements(CbInliner* inliner,
+                                          CbSyntree** node);
+static void cb_inliner_add_function(CbInliner* inliner,
+                                    const CbFuncDeclarationNode* fndecl);
+static bool cb_inliner_check_expr(const CbInliner* inliner,
+                                  const CbSyntree* node,
+                                  const CbStrlist* params, int* size);
+static int cb_inliner_count_nodes(const CbSyntree* node);
+static void cb_inliner_rewrite_calls(CbSyntree** node, void* inliner);
+static CbSyntree* cb_inliner_clone(const CbSyntree* node,
+                                   const CbStrlist* params);
+static CbStrlist* cb_inliner_clone_args(const CbStrlist* args,
+                                        const CbStrlist* params);
+static int cb_inliner_get_param_index(const CbStrlist* params,
+                                      const char* id);
+static void cb_inliner_count_node(CbSyntree** node, void* count);
+
+static void cb_optimizer_compile_loops(CbSyntree** node, void* context);
+
+static void cb_optimizer_hoist(CbSyntree** ast,
+                               const CbOptimizerNames* names);
+static void cb_hoister_process_loops(CbSyntree** node, void* hoister);
+static void cb_hoister_find_changes(CbSyntree** node, void* hoister);
+static void cb_hoister_add_changed(CbSyntree** node, void* hoister);
+static bool cb_hoister_is_changed(const CbHoister* hoister, const char* id);
+static void cb_hoister_hoist_invariants(CbSyntree** node, void* hoister);
+static bool cb_hoister_check_expr(const CbHoister* hoister,
+                                  const CbSyntree* node, bool inlined,
+                                  bool* variable);
+
+static void cb_optimizer_infer_types(CbSyntree** ast,
+                                     const CbOptimizerNames* names);
+static CbTypeSet cb_typer_infer(CbTyper* typer, CbSyntree** node);
+static void cb_typer_visit(CbSyntree** node, void* typer);
+static CbTypeSet cb_typer_infer_binary(CbTyper* typer, CbSyntree* node,
+                                       CbTypeSet l, CbTypeSet r);
+static CbTypeSet cb_typer_infer_comparison(CbTyper* typer, CbSyntree* node,
+                                           CbTypeSet l, CbTypeSet r);
+static void cb_typer_check_condition(CbTyper* typer, const CbSyntree* cond,
+                                     CbTypeSet types);
+static void cb_typer_infer_loop(CbTyper* typer, CbFlowNode* loop);
+static void cb_typer_infer_exception_block(CbTyper* typer,
+                                           CbExceptionBlockNode* node);
+static void cb_typer_report(CbTyper* typer, const CbSyntree* node,
+                            const char* message);
+
+static void cb_type_env_copy(CbTypeEnv* dest, const CbTypeEnv* src);
+static CbTypeSet cb_type_env_get(const CbTypeEnv* env, const char* id);
+static void cb_type_env_set(CbTypeEnv* env, const char* id,
+                            CbTypeSet types);
+static void cb_type_env_remove(CbTypeEnv* env, const char* id);
+static void cb_type_env_join(CbTypeEnv* env, const CbTypeEnv* other);
+static bool cb_type_env_equal(const CbTypeEnv* a, const CbTypeEnv* b);
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Optimize a syntax-tree (the root node may be replaced)
+//
+//    shared_symtab is set, if the symbols declared at top level are used after
+//    the execution, e.g. by the next input of a REPL session.
+// -----------------------------------------------------------------------------
+void cb_optimizer_run(CbSyntree** ast, bool shared_symtab)
+{
+    if (*ast == NULL)
+        return;
+    
+    cb_optimizer_eliminate(ast, shared_symtab);
+    
+    CbOptimizerNames names;
+    memset(&names, 0, sizeof(CbOptimizerNames));
+    cb_optimizer_collect_names(ast, &names);
+    
+    cb_optimizer_inline(ast, &names);
+    cb_optimizer_infer_types(ast, &names);
+    if (cb_jit_enabled)
+        cb_optimizer_compile_loops(ast, NULL);
+    cb_optimizer_hoist(ast, &names);
+    
+    cb_free(names.items, CB_ALLOC_AST);
+}
+
+// -----------------------------------------------------------------------------
+// Report the type errors of a syntax-tree, which occur whenever the failing
+// node is evaluated, without changing the syntax-tree (returns the count of
+// reported errors)
+// -----------------------------------------------------------------------------
+int cb_optimizer_check_types(CbSyntree* ast)
+{
+    if (ast == NULL)
+        return 0;
+    
+    CbOptimizerNames names;
+    memset(&names, 0, sizeof(CbOptimizerNames));
+    cb_optimizer_collect_names(&ast, &names);
+    
+    CbTyper typer;
+    memset(&typer, 0, sizeof(CbTyper));
+    typer.names  = &names;
+    typer.report = true;
+    
+    cb_typer_infer(&typer, &ast);
+    
+    cb_free(typer.env.items, CB_ALLOC_AST);
+    cb_free(names.items, CB_ALLOC_AST);
+    
+    return typer.error_count;
+}
+
+// -----------------------------------------------------------------------------
+// Call the visitor for every child-node of a node
+// -----------------------------------------------------------------------------
+void cb_optimizer_visit_children(CbSyntree* node, CbOptimizerVisitor visitor,
+                                 void* context)
+{
+    CbStrlist* item = NULL;
+    
+    switch (node->type)
+    {
+        // two child-nodes
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case SNT_ASSIGNMENT:
+        case SNT_STATEMENTLIST:
+        case SNT_LOGICAL_AND:
+        case SNT_LOGICAL_OR:
+        case SNT_NUMERIC_ADD:
+        case SNT_NUMERIC_SUB:
+        case SNT_NUMERIC_MUL:
+        case SNT_NUMERIC_DIV:
+        case SNT_STRING_CONCAT:
+            if (node->l)
+                visitor(&node->l, context);
+            if (node->r)
+                visitor(&node->r, context);
+            break;
+        
+        // one child-node (left one)
+        case SNT_UNARYMINUS:
+        case SNT_DECLARATION:
+        case SNT_PRINT:
+        case SNT_LOGICAL_NOT:
+            visitor(&node->l, context);
+            break;
+        
+        case SNT_COMPARISON:
+        case SNT_NUMERIC_COMPARISON:
+            visitor(&((CbComparisonNode*) node)->l, context);
+            visitor(&((CbComparisonNode*) node)->r, context);
+            break;
+        
+        case SNT_FUNC_DECL:
+            if (((CbFuncDeclarationNode*) node)->body)
+                visitor(&((CbFuncDeclarationNode*) node)->body, context);
+            break;
+        
+        case SNT_FUNC_CALL:
+            item = ((CbFuncCallNode*) node)->args;
+            for (; item; item = item->next)
+                visitor((CbSyntree**) &item->data, context);
+            break;
+        
+        case SNT_INLINE_CALL:
+            item = ((CbInlineCallNode*) node)->call->args;
+            for (; item; item = item->next)
+                visitor((CbSyntree**) &item->data, context);
+            
+            visitor(&((CbInlineCallNode*) node)->body, context);
+            break;
+        
+        case SNT_INVARIANT_EXPR:
+            visitor(&((CbInvariantExprNode*) node)->expr, context);
+            break;
+        
+        case SNT_INVARIANT_LOOP:
+            visitor(&((CbInvariantLoopNode*) node)->loop, context);
+            break;
+        
+        case SNT_JIT_LOOP:
+            visitor(&((CbJitLoopNode*) node)->loop, context);
+            break;
+        
+        case SNT_FLOW_IF:
+        case SNT_FLOW_WHILE:
+            visitor(&((CbFlowNode*) node)->cond, context);
+            if (((CbFlowNode*) node)->tb)
+                visitor(&((CbFlowNode*) node)->tb, context);
+            if (((CbFlowNode*) node)->fb)
+                visitor(&((CbFlowNode*) node)->fb, context);
+            break;
+        
+        case SNT_VALARRAY:
+            item = ((CbArrayNode*) node)->values;
+            for (; item; item = item->next)
+                visitor((CbSyntree**) &item->data, context);
+            break;
+        
+        case SNT_VALARRAY_ASSIGNMENT:
+            visitor(&((CbArrayAssignmentNode*) node)->value_node, context);
+            break;
+        
+        case SNT_VALHASH:
+            item = ((CbHashNode*) node)->keys;
+            for (; item; item = item->next)
+                visitor((CbSyntree**) &item->data, context);
+            
+            item = ((CbHashNode*) node)->values;
+            for (; item; item = item->next)
+                visitor((CbSyntree**) &item->data, context);
+            break;
+        
+        case SNT_EXCEPTION_BLOCK:
+            if (((CbExceptionBlockNode*) node)->code_block)
+                visitor(&((CbExceptionBlockNode*) node)->code_block, context);
+            if (((CbExceptionBlockNode*) node)->exception_block)
+                visitor(&((CbExceptionBlockNode*) node)->exception_block,
+                        context);
+            break;
+        
+        default:
+            // no child-nodes
+            break;
+    }
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Collect the names declared by a syntax-tree (CbOptimizerVisitor) (internal)
+// -----------------------------------------------------------------------------
+static void cb_optimizer_collect_names(CbSyntree** node, void* names)
+{
+    if ((*node)->type == SNT_FUNC_DECL)
+    {
+        CbFuncDeclarationNode* fndecl = (CbFuncDeclarationNode*) *node;
+        cb_optimizer_add_name(names, fndecl->sym_id, true);
+        
+        CbStrlist* param = fndecl->params;
+        for (; param; param = param->next)
+            cb_optimizer_add_name(names, param->string, false);
+    }
+    else if ((*node)->type == SNT_DECLARATION)
+        cb_optimizer_add_name(names, ((CbSymref*) (*node)->l)->sym_id, false);
+    
+    cb_optimizer_visit_children(*node, cb_optimizer_collect_names, names);
+}
+
+// -----------------------------------------------------------------------------
+// Add a declared name (internal)
+// -----------------------------------------------------------------------------
+static void cb_optimizer_add_name(CbOptimizerNames* names, const char* id,
+                                  bool function)
+{
+    CbOptimizerName* name = cb_optimizer_find_name(names, id);
+    if (name == NULL)
+    {
+        if (names->count == names->capacity)
+        {
+            names->capacity = (names->capacity) ? names->capacity * 2 : 16;
+            names->items    = cb_realloc(names->items, names->capacity *
+                                         sizeof(CbOptimizerName),
+                                         CB_ALLOC_AST);
+        }
+        
+        name                 = &names->items[names->count++];
+        name->id             = id;
+        name->function_count = 0;
+        name->variable       = false;
+    }
+    
+    if (function)
+        name->function_count++;
+    else
+        name->variable = true;
+}
+
+// -----------------------------------------------------------------------------
+// Find a declared name (NULL, if the script doesn't declare it) (internal)
+// -----------------------------------------------------------------------------
+static CbOptimizerName* cb_optimizer_find_name(const CbOptimizerNames* names,
+                                               const char* id)
+{
+    size_t i = 0;
+    for (; i < names->count; i++)
+        if (strcmp(names->items[i].id, id) == 0)
+            return &names->items[i];
+    
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Remove dead code and unused symbols (internal)
+//
+//    Removing code may leave further symbols unused, so the syntax-tree is
+//    processed, until it doesn't change anymore.
+// -----------------------------------------------------------------------------
+static void cb_optimizer_eliminate(CbSyntree** ast, bool shared_symtab)
+{
+    CbEliminator eliminator;
+    memset(&eliminator, 0, sizeof(CbEliminator));
+    eliminator.shared_symtab = shared_symtab;
+    
+    do
+    {
+        eliminator.name_count = 0;
+        eliminator.body       = *ast;
+        eliminator.leading    = true;
+        eliminator.changed    = false;
+        
+        cb_eliminator_collect(&eliminator, *ast, true);
+        *ast = cb_eliminator_sweep(&eliminator, *ast, false);
+        
+        size_t i = 0;
+        for (; i < eliminator.removed_count; i++)
+            cb_syntree_free(eliminator.removed[i]);
+        
+        eliminator.removed_count = 0;
+    } while (eliminator.changed);
+    
+    cb_free(eliminator.names, CB_ALLOC_AST);
+    cb_free(eliminator.removed, CB_ALLOC_AST);
+}
+
+// -----------------------------------------------------------------------------
+// Collect the uses of the names of a syntax-tree (internal)
+//
+//    Statements are the nodes of the statement-lists of a body (the script
+//    or a function), which are executed unconditionally one after another.
+// -----------------------------------------------------------------------------
+static void cb_eliminator_collect(CbEliminator* eliminator, CbSyntree* node,
+                                  bool statement)
+{
+    CbEliminatorName* name = NULL;
+    
+    switch (node->type)
+    {
+        case SNT_STATEMENTLIST:
+            if (!statement)
+                break;
+            
+            cb_eliminator_collect(eliminator, node->l, true);
+            cb_eliminator_collect(eliminator, node->r, true);
+            return;
+        
+        case SNT_DECLARATION:
+            name = cb_eliminator_get_name(eliminator,
+                                          ((CbSymref*) node->l)->sym_id);
+            if (name->declarations++ == 0 && statement && eliminator->leading)
+                name->body = eliminator->body;
+            return;
+        
+        case SNT_ASSIGNMENT:
+            name = cb_eliminator_get_name(eliminator,
+                                          ((CbSymref*) node->l)->sym_id);
+            if (name->assign_body == NULL)
+                name->assign_body = eliminator->body;
+            else if (name->assign_body != eliminator->body)
+                name->assigned_elsewhere = true;
+            
+            eliminator->leading = false;
+            cb_eliminator_collect(eliminator, node->r, false);
+            return;
+        
+        case SNT_SYMREF:
+            cb_eliminator_get_name(eliminator,
+                                   ((CbSymref*) node)->sym_id)->reads++;
+            break;
+        
+        case SNT_VALARRAY_ACCESS:
+            cb_eliminator_get_name(eliminator,
+                ((CbArrayAccessNode*) node)->sym_id)->reads++;
+            break;
+        
+        case SNT_VALARRAY_ASSIGNMENT:
+            cb_eliminator_get_name(eliminator,
+                ((CbArrayAssignmentNode*) node)->sym_id)->reads++;
+            break;
+        
+        case SNT_FUNC_CALL:
+            cb_eliminator_get_name(eliminator,
+                ((CbFuncCallNode*) node)->sym_id)->reads++;
+            break;
+        
+        case SNT_FUNC_DECL:
+        {
+            CbFuncDeclarationNode* fndecl = (CbFuncDeclarationNode*) node;
+            
+            name = cb_eliminator_get_name(eliminator, fndecl->sym_id);
+            name->functions++;
+            if (statement)
+                name->statement_functions++;
+            
+            CbStrlist* param = fndecl->params;
+            for (; param; param = param->next)
+                cb_eliminator_get_name(eliminator, param->string)->param =
+                    true;
+            
+            eliminator->leading = false;
+            if (fndecl->body == NULL)
+                return;
+            
+            // the body is a body of its own
+            const CbSyntree* body = eliminator->body;
+            eliminator->body      = fndecl->body;
+            eliminator->leading   = true;
+            
+            cb_eliminator_collect(eliminator, fndecl->body, true);
+            
+            eliminator->body    = body;
+            eliminator->leading = false;
+            return;
+        }
+        
+        default:
+            break;
+    }
+    
+    eliminator->leading = false;
+    cb_optimizer_visit_children(node, cb_eliminator_collect_child,
+                                eliminator);
+}
+
+// -----------------------------------------------------------------------------
+// Collect the uses of the names of a child-node, which isn't a statement
+// (CbOptimizerVisitor) (internal)
+// -----------------------------------------------------------------------------
+static void cb_eliminator_collect_child(CbSyntree** node, void* eliminator)
+{
+    cb_eliminator_collect((CbEliminator*) eliminator, *node, false);
+}
+
+// -----------------------------------------------------------------------------
+// Get the uses of a name (they are added, if the name is new) (internal)
+// -----------------------------------------------------------------------------
+static CbEliminatorName* cb_eliminator_get_name(CbEliminator* eliminator,
+                                                const char* id)
+{
+    size_t i = 0;
+    for (; i < eliminator->name_count; i++)
+        if (strcmp(eliminator->names[i].id, id) == 0)
+            return &eliminator->names[i];
+    
+    if (eliminator->name_count == eliminator->name_capacity)
+    {
+        eliminator->name_capacity = (eliminator->name_capacity)
+                                  ? eliminator->name_capacity * 2 : 16;
+        eliminator->names         = cb_realloc(eliminator->names,
+                                        eliminator->name_capacity *
+                                        sizeof(CbEliminatorName),
+                                        CB_ALLOC_AST);
+    }
+    
+    CbEliminatorName* name = &eliminator->names[eliminator->name_count++];
+    memset(name, 0, sizeof(CbEliminatorName));
+    name->id = id;
+    
+    return name;
+}
+
+// -----------------------------------------------------------------------------
+// Check if a variable is never read, so its declaration and assignments can
+// be removed (internal)
+//
+//    The variable has to be declared once at the beginning of a body, which
+//    assigns it exclusively, so the removed code can't have failed. Names of
+//    builtin functions and the default result symbol are declared by the
+//    interpreter, so declaring them again fails.
+// -----------------------------------------------------------------------------
+static bool cb_eliminator_is_unused_variable(CbEliminator* eliminator,
+                                             const char* id)
+{
+    if (eliminator->shared_symtab)
+        return false;
+    
+    const CbEliminatorName* name = cb_eliminator_get_name(eliminator, id);
+    
+    return name->reads == 0 && name->declarations == 1 &&
+           name->functions == 0 && !name->param && name->body != NULL &&
+           !name->assigned_elsewhere &&
+           (name->assign_body == NULL || name->assign_body == name->body) &&
+           strcmp(id, "Result") != 0 && !is_builtin_func(id);
+}
+
+// -----------------------------------------------------------------------------
+// Check if a function is never called, so its declaration can be removed
+// (internal)
+//
+//    The function has to be declared once as statement of a body, so the
+//    removed declaration can't have failed.
+// -----------------------------------------------------------------------------
+static bool cb_eliminator_is_unused_function(CbEliminator* eliminator,
+                                             const char* id)
+{
+    if (eliminator->shared_symtab)
+        return false;
+    
+    const CbEliminatorName* name = cb_eliminator_get_name(eliminator, id);
+    
+    return name->reads == 0 && name->functions == 1 &&
+           name->statement_functions == 1 && name->declarations == 0 &&
+           !name->param && strcmp(id, "Result") != 0 && !is_builtin_func(id);
+}
+
+// -----------------------------------------------------------------------------
+// Remove the dead code of a syntax-tree and return the remaining node (NULL,
+// if the node was removed)
+//
+//    Nodes are removed only, if their value is discarded, i.e. if they are
+//    followed by another statement. A removed assignment of an unused
+//    variable is replaced by its right-hand side, unless it is constant.
+// -----------------------------------------------------------------------------
+static CbSyntree* cb_eliminator_sweep(CbEliminator* eliminator,
+                                      CbSyntree* node, bool discarded)
+{
+    switch (node->type)
+    {
+        case SNT_STATEMENTLIST:
+        {
+            CbSyntree* l = cb_eliminator_sweep(eliminator, node->l, true);
+            CbSyntree* r = cb_eliminator_sweep(eliminator, node->r,
+                                               discarded);
+            if (l && r)
+            {
+                node->l = l;
+                node->r = r;
+                return node;
+            }
+            
+            cb_free(node, CB_ALLOC_AST);
+            return (l) ? l : r;
+        }
+        
+        case SNT_DECLARATION:
+            if (discarded && cb_eliminator_is_unused_variable(eliminator,
+                                 ((CbSymref*) node->l)->sym_id))
+                return cb_eliminator_remove(eliminator, node);
+            
+            return node;
+        
+        case SNT_ASSIGNMENT:
+        {
+            node->r = cb_eliminator_sweep(eliminator, node->r, false);
+            if (!cb_eliminator_is_unused_variable(eliminator,
+                     ((CbSymref*) node->l)->sym_id))
+                return node;
+            
+            if (discarded && cb_eliminator_is_constant(node->r))
+                return cb_eliminator_remove(eliminator, node);
+            
+            // the right-hand side is evaluated for its effects (or its
+            // value), which don't depend on the assignment
+            CbSyntree* rhs = node->r;
+            cb_eliminator_remove(eliminator, node->l);
+            cb_free(node, CB_ALLOC_AST);
+            
+            return rhs;
+        }
+        
+        case SNT_FUNC_DECL:
+        {
+            CbFuncDeclarationNode* fndecl = (CbFuncDeclarationNode*) node;
+            if (discarded &&
+                cb_eliminator_is_unused_function(eliminator, fndecl->sym_id))
+                return cb_eliminator_remove(eliminator, node);
+            
+            if (fndecl->body)
+                fndecl->body = cb_eliminator_sweep(eliminator, fndecl->body,
+                                                   false);
+            return node;
+        }
+        
+        case SNT_FLOW_IF:
+        {
+            CbFlowNode* flow = (CbFlowNode*) node;
+            if (flow->cond->type != SNT_CONSTBOOL)
+                break;
+            
+            bool condition = cb_boolean_get(
+                                 ((CbConstvalNode*) flow->cond)->value);
+            CbSyntree* kept    = (condition) ? flow->tb : flow->fb;
+            CbSyntree* dropped = (condition) ? flow->fb : flow->tb;
+            
+            // without a branch, the if-statement results in an empty value
+            if (kept == NULL && !discarded)
+                break;
+            
+            cb_eliminator_remove(eliminator, flow->cond);
+            if (dropped)
+                cb_eliminator_remove(eliminator, dropped);
+            cb_free(node, CB_ALLOC_AST);
+            
+            return (kept) ? cb_eliminator_sweep(eliminator, kept, discarded)
+                          : NULL;
+        }
+        
+        case SNT_FLOW_WHILE:
+        {
+            CbFlowNode* flow = (CbFlowNode*) node;
+            if (discarded && flow->cond->type == SNT_CONSTBOOL &&
+                !cb_boolean_get(((CbConstvalNode*) flow->cond)->value))
+                return cb_eliminator_remove(eliminator, node);
+            
+            break;
+        }
+        
+        default:
+            break;
+    }
+    
+    cb_optimizer_visit_children(node, cb_eliminator_sweep_child, eliminator);
+    
+    return node;
+}
+
+// -----------------------------------------------------------------------------
+// Remove a node, which is freed after the pass (internal)
+// -----------------------------------------------------------------------------
+static CbSyntree* cb_eliminator_remove(CbEliminator* eliminator,
+                                       CbSyntree* node)
+{
+    if (eliminator->removed_count == eliminator->removed_capacity)
+    {
+        eliminator->removed_capacity = (eliminator->removed_capacity)
+                                     ? eliminator->removed_capacity * 2 : 16;
+        eliminator->removed          = cb_realloc(eliminator->removed,
+                                           eliminator->removed_capacity *
+                                           sizeof(CbSyntree*),
+                                           CB_ALLOC_AST);
+    }
+    
+    eliminator->removed[eliminator->removed_count++] = node;
+    eliminator->changed                              = true;
+    
+    return NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Remove the dead code of a child-node, whose value is used
+// (CbOptimizerVisitor) (internal)
+// -----------------------------------------------------------------------------
+static void cb_eliminator_sweep_child(CbSyntree** node, void* eliminator)
+{
+    *node = cb_eliminator_sweep((CbEliminator*) eliminator, *node, false);
+}
+
+// -----------------------------------------------------------------------------
+// Check if an expression is a constant, whose evaluation can't fail
+// (internal)
+// -----------------------------------------------------------------------------
+static bool cb_eliminator_is_constant(const CbSyntree* node)
+{
+    const CbStrlist* item = NULL;
+    
+    switch (node->type)
+    {
+        case SNT_CONSTVAL:
+        case SNT_CONSTBOOL:
+        case SNT_CONSTSTR:
+            return true;
+        
+        case SNT_VALARRAY:
+            item = ((const CbArrayNode*) node)->values;
+            for (; item; item = item->next)
+                if (!cb_eliminator_is_constant((const CbSyntree*) item->data))
+                    return false;
+            
+            return true;
+        
+        default:
+            return false;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Inline calls of small user functions (internal)
+// -----------------------------------------------------------------------------
+static void cb_optimizer_inline(CbSyntree** ast,
+                                const CbOptimizerNames* names)
+{
+    CbInliner inliner;
+    memset(&inliner, 0, sizeof(CbInliner));
+    inliner.names = names;
+    
+    cb_inliner_process_statements(&inliner, ast);
+    
+    cb_free(inliner.functions, CB_ALLOC_AST);
+}
+
+// -----------------------------------------------------------------------------
+// Inline the calls of the top level statements in the order of their
+// execution and register the declared functions, which can be inlined
+// (internal)
+//
+//    A failed statement at top level ends the execution, so the calls after
+//    the declaration of a function are executed after the function was
+//    declared.
+// -----------------------------------------------------------------------------
+static void cb_inliner_process_statements(CbInliner* inliner,
+                                          CbSyntree** node)
+{
+    if ((*node)->type == SNT_STATEMENTLIST)
+    {
+        cb_inliner_process_statements(inliner, &(*node)->l);
+        cb_inliner_process_statements(inliner, &(*node)->r);
+        return;
+    }
+    
+    cb_inliner_rewrite_calls(node, inliner);
+    
+    if ((*node)->type == SNT_FUNC_DECL)
+        cb_inliner_add_function(inliner, (CbFuncDeclarationNode*) *node);
+}
+
+// -----------------------------------------------------------------------------
+// Register a declared function, if it can be inlined (internal)
+// -----------------------------------------------------------------------------
+static void cb_inliner_add_function(CbInliner* inliner,
+                                    const CbFuncDeclarationNode* fndecl)
+{
+    const CbOptimizerName* name = cb_optimizer_find_name(inliner->names,
+                                                         fndecl->sym_id);
+    if (name->function_count != 1 || name->variable || fndecl->body == NULL)
+        return;
+    
+    // parameters have to be unique, since each of them has a slot
+    int param_count         = 0;
+    const CbStrlist* param  = fndecl->params;
+    for (; param; param = param->next, param_count++)
+    {
+        if (param_count == CB_INLINE_MAX_PARAMS ||
+            cb_inliner_get_param_index(fndecl->params,
+                                       param->string) != param_count)
+            return;
+
+#ifdef _CBC_DEFAULT_FUNC_RESULT_SYMBOL
+        if (strcmp(param->string, "Result") == 0)
+            return;
+#endif // _CBC_DEFAULT_FUNC_RESULT_SYMBOL
+    }
+
+#ifdef _CBC_DEFAULT_FUNC_RESULT_SYMBOL
+    // the body has to be `Result := <expression>'
+    const CbSyntree* body = fndecl->body;
+    if (body->type != SNT_ASSIGNMENT ||
+        strcmp(((CbSymref*) body->l)->sym_id, "Result") != 0)
+        return;
+    
+    CbSyntree* expr = body->r;
+#else
+    // the body has to be an expression
+    CbSyntree* expr = fndecl->body;
+#endif // _CBC_DEFAULT_FUNC_RESULT_SYMBOL
+
+    int size = 0;
+    if (!cb_inliner_check_expr(inliner, expr, fndecl->params, &size) ||
+        size > CB_INLINE_MAX_NODES)
+        return;
+    
+    if (inliner->function_count == inliner->function_capacity)
+    {
+        inliner->function_capacity = (inliner->function_capacity)
+                                   ? inliner->function_capacity * 2 : 8;
+        inliner->functions         = cb_realloc(inliner->functions,
+                                                inliner->function_capacity *
+                                                sizeof(CbInlinerFunction),
+                                                CB_ALLOC_AST);
+    }
+    
+    CbInlinerFunction* function = &inliner->functions[inliner->function_count];
+    function->id                = fndecl->sym_id;
+    function->params            = fndecl->params;
+    function->param_count       = param_count;
+    function->expr              = expr;
+    inliner->function_count++;
+}
+
+// -----------------------------------------------------------------------------
+// Check if an expression can be inlined and add up its size (internal)
+// -----------------------------------------------------------------------------
+static bool cb_inliner_check_expr(const CbInliner* inliner,
+                                  const CbSyntree* node,
+                                  const CbStrlist* params, int* size)
+{
+    const CbStrlist* arg = NULL;
+    (*size)++;
+    
+    switch (node->type)
+    {
+        case SNT_CONSTVAL:
+        case SNT_CONSTBOOL:
+        case SNT_CONSTSTR:
+            return true;
+        
+        case SNT_SYMREF:
+            return cb_inliner_get_param_index(params,
+                       ((const CbSymref*) node)->sym_id) >= 0;
+        
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case SNT_LOGICAL_AND:
+        case SNT_LOGICAL_OR:
+            return cb_inliner_check_expr(inliner, node->l, params, size) &&
+                   cb_inliner_check_expr(inliner, node->r, params, size);
+        
+        case SNT_COMPARISON:
+            return cb_inliner_check_expr(inliner,
+                       ((const CbComparisonNode*) node)->l, params, size) &&
+                   cb_inliner_check_expr(inliner,
+                       ((const CbComparisonNode*) node)->r, params, size);
+        
+        case SNT_UNARYMINUS:
+        case SNT_LOGICAL_NOT:
+            return cb_inliner_check_expr(inliner, node->l, params, size);
+        
+        case SNT_FUNC_CALL:
+            // only builtin functions (calls of functions, which could be
+            // inlined, were inlined already)
+            if (cb_optimizer_find_name(inliner->names,
+                    ((const CbFuncCallNode*) node)->sym_id) != NULL)
+                return false;
+            
+            arg = ((const CbFuncCallNode*) node)->args;
+            break;
+        
+        case SNT_INLINE_CALL:
+        {
+            const CbInlineCallNode* inline_call =
+                (const CbInlineCallNode*) node;
+            *size += cb_inliner_count_nodes(inline_call->body);
+            arg    = inline_call->call->args;
+            break;
+        }
+        
+        default:
+            return false;
+    }
+    
+    // arguments of a call
+    for (; arg; arg = arg->next)
+        if (!cb_inliner_check_expr(inliner, (const CbSyntree*) arg->data,
+                                   params, size))
+            return false;
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Count the nodes of a syntax-tree (internal)
+// -----------------------------------------------------------------------------
+static int cb_inliner_count_nodes(const CbSyntree* node)
+{
+    int count = 1;
+    cb_optimizer_visit_children((CbSyntree*) node, cb_inliner_count_node,
+                                &count);
+    
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+// Replace the calls of registered functions in a syntax-tree by inlined calls
+// (CbOptimizerVisitor) (internal)
+// -----------------------------------------------------------------------------
+static void cb_inliner_rewrite_calls(CbSyntree** node, void* inliner)
+{
+    // arguments first, they may contain calls as well
+    cb_optimizer_visit_children(*node, cb_inliner_rewrite_calls, inliner);
+    
+    if ((*node)->type != SNT_FUNC_CALL)
+        return;
+    
+    CbFuncCallNode* call = (CbFuncCallNode*) *node;
+    const CbInliner* state = (const CbInliner*) inliner;
+    
+    size_t i = 0;
+    for (; i < state->function_count; i++)
+    {
+        const CbInlinerFunction* function = &state->functions[i];
+        if (strcmp(function->id, call->sym_id) != 0)
+            continue;
+        
+        // a call with a wrong count of arguments keeps reporting its error
+        int arg_count = (call->args) ? (int) call->args->count : 0;
+        if (arg_count == function->param_count)
+            *node = cb_inline_call_node_create(call,
+                        cb_inliner_clone(function->expr, function->params),
+                        function->param_count);
+        break;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Copy an expression, which can be inlined, and replace references to the
+// parameters (internal)
+//
+//    The result-expression of an inlined call is copied as it is (params is
+//    NULL then), since it refers to the parameters of that call.
+// -----------------------------------------------------------------------------
+static CbSyntree* cb_inliner_clone(const CbSyntree* node,
+                                   const CbStrlist* params)
+{
+    CbSyntree* copy = NULL;
+    
+    switch (node->type)
+    {
+        case SNT_CONSTVAL:
+        case SNT_CONSTBOOL:
+        case SNT_CONSTSTR:
+        {
+            CbConstvalNode* constval = cb_alloc(sizeof(CbConstvalNode),
+                                                CB_ALLOC_AST);
+            *constval       = *((const CbConstvalNode*) node);
+            constval->value = cb_value_copy(constval->value);
+            copy            = (CbSyntree*) constval;
+            break;
+        }
+        
+        case SNT_SYMREF:
+            copy = cb_inline_param_node_create(cb_inliner_get_param_index(
+                       params, ((const CbSymref*) node)->sym_id));
+            break;
+        
+        case SNT_INLINE_PARAM:
+            copy = cb_inline_param_node_create(
+                       ((const CbInlineParamNode*) node)->index);
+            break;
+        
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case SNT_LOGICAL_AND:
+        case SNT_LOGICAL_OR:
+            copy = cb_syntree_create(node->type,
+                                     cb_inliner_clone(node->l, params),
+                                     cb_inliner_clone(node->r, params));
+            break;
+        
+        case SNT_COMPARISON:
+            copy = cb_comparison_create(
+                       ((const CbComparisonNode*) node)->cmp_type,
+                       cb_inliner_clone(((const CbComparisonNode*) node)->l,
+                                        params),
+                       cb_inliner_clone(((const CbComparisonNode*) node)->r,
+                                        params));
+            break;
+        
+        case SNT_UNARYMINUS:
+        case SNT_LOGICAL_NOT:
+            copy = cb_syntree_create(node->type,
+                                     cb_inliner_clone(node->l, params), NULL);
+            break;
+        
+        case SNT_FUNC_CALL:
+        {
+            const CbFuncCallNode* call = (const CbFuncCallNode*) node;
+            copy = cb_funccall_create(call->sym_id,
+                                      cb_inliner_clone_args(call->args,
+                                                            params));
+            break;
+        }
+        
+        case SNT_INLINE_CALL:
+        {
+            const CbInlineCallNode* inline_call =
+                (const CbInlineCallNode*) node;
+            CbSyntree* call = cb_inliner_clone(
+                                  (const CbSyntree*) inline_call->call, params);
+            copy            = cb_inline_call_node_create(
+                                  (CbFuncCallNode*) call,
+                                  cb_inliner_clone(inline_call->body, NULL),
+                                  inline_call->param_count);
+            break;
+        }
+    }
+    
+    // errors are reported with the line numbers of the function's body
+    copy->line_no = node->line_no;
+    
+    return copy;
+}
+
+// -----------------------------------------------------------------------------
+// Copy the arguments of a call (internal)
+// -----------------------------------------------------------------------------
+static CbStrlist* cb_inliner_clone_args(const CbStrlist* args,
+                                        const CbStrlist* params)
+{
+    CbStrlist* copy = NULL;
+    
+    for (; args; args = args->next)
+    {
+        CbStrlist* item = (copy) ? cb_strlist_append(copy, "")
+                                 : (copy = cb_strlist_create(""));
+        item->data      = cb_inliner_clone((const CbSyntree*) args->data,
+                                           params);
+    }
+    
+    return copy;
+}
+
+// -----------------------------------------------------------------------------
+// Get the index of a parameter (-1, if there is no such parameter) (internal)
+// -----------------------------------------------------------------------------
+static int cb_inliner_get_param_index(const CbStrlist* params,
+                                      const char* id)
+{
+    int index = 0;
+    for (; params; params = params->next, index++)
+        if (strcmp(params->string, id) == 0)
+            return index;
+    
+    return -1;
+}
+
+// -----------------------------------------------------------------------------
+// Count a node and its child-nodes (CbOptimizerVisitor) (internal)
+// -----------------------------------------------------------------------------
+static void cb_inliner_count_node(CbSyntree** node, void* count)
+{
+    (*((int*) count))++;
+    cb_optimizer_visit_children(*node, cb_inliner_count_node, count);
+}
+
+// -----------------------------------------------------------------------------
+// Wrap the while-loops, which only compute integers, into loop nodes, which
+// are compiled, when they are hot (CbOptimizerVisitor) (internal)
+// -----------------------------------------------------------------------------
+static void cb_optimizer_compile_loops(CbSyntree** node, void* context)
+{
+    if ((*node)->type == SNT_FLOW_WHILE && cb_jit_can_compile(*node))
+    {
+        *node = cb_jit_loop_node_create(*node);
+        return;
+    }
+    
+    cb_optimizer_visit_children(*node, cb_optimizer_compile_loops, context);
+}
+
+// -----------------------------------------------------------------------------
+// Hoist the invariant expressions of while-loops (internal)
+// -----------------------------------------------------------------------------
+static void cb_optimizer_hoist(CbSyntree** ast, const CbOptimizerNames* names)
+{
+    CbHoister hoister;
+    memset(&hoister, 0, sizeof(CbHoister));
+    hoister.names = names;
+    
+    cb_hoister_process_loops(ast, &hoister);
+    
+    cb_free(hoister.changed, CB_ALLOC_AST);
+}
+
+// -----------------------------------------------------------------------------
+// Hoist the invariant expressions of the loops of a syntax-tree
+// (CbOptimizerVisitor) (internal)
+//
+//    Outer loops are processed first, so an expression is hoisted out of the
+//    outermost loop, in which it is invariant.
+// -----------------------------------------------------------------------------
+static void cb_hoister_process_loops(CbSyntree** node, void* hoister)
+{
+    // a compiled loop keeps its expressions in machine code
+    if ((*node)->type == SNT_JIT_LOOP)
+        return;
+    
+    if ((*node)->type != SNT_FLOW_WHILE)
+    {
+        cb_optimizer_visit_children(*node, cb_hoister_process_loops, hoister);
+        return;
+    }
+    
+    CbHoister* state          = (CbHoister*) hoister;
+    CbSyntree* loop           = *node;
+    state->changed_count      = 0;
+    state->changes_any        = false;
+    state->invariants         = NULL;
+    state->invariant_count    = 0;
+    state->invariant_capacity = 0;
+    
+    cb_optimizer_visit_children(loop, cb_hoister_find_changes, state);
+    if (!state->changes_any)
+        cb_optimizer_visit_children(loop, cb_hoister_hoist_invariants, state);
+    
+    // the state is reused for the inner loops
+    CbInvariantExprNode** invariants = state->invariants;
+    size_t invariant_count           = state->invariant_count;
+    
+    cb_optimizer_visit_children(loop, cb_hoister_process_loops, hoister);
+    
+    if (invariant_count > 0)
+        *node = cb_invariant_loop_node_create(loop, invariants,
+                                              invariant_count);
+}
+
+// -----------------------------------------------------------------------------
+// Find the symbols, which are changed by a part of a loop
+// (CbOptimizerVisitor) (internal)
+// -----------------------------------------------------------------------------
+static void cb_hoister_find_changes(CbSyntree** node, void* hoister)
+{
+    CbHoister* state = (CbHoister*) hoister;
+    
+    switch ((*node)->type)
+    {
+        case SNT_ASSIGNMENT:
+        case SNT_DECLARATION:
+            cb_hoister_add_changed(&(*node)->l, state);
+            break;
+        
+        case SNT_VALARRAY_ASSIGNMENT:
+            cb_hoister_add_changed(node, state);
+            break;
+        
+        case SNT_FUNC_DECL:
+            state->changes_any = true;
+            return;
+        
+        case SNT_FUNC_CALL:
+        {
+            const CbFuncCallNode* call = (const CbFuncCallNode*) *node;
+            
+            // functions declared by the script may change anything
+            enum cb_builtin_effect effect = CB_BIF_CHANGES_ANY;
+            if (cb_optimizer_find_name(state->names, call->sym_id) == NULL)
+                effect = get_builtin_func_effect(call->sym_id);
+            
+            if (effect == CB_BIF_CHANGES_ANY)
+            {
+                state->changes_any = true;
+                return;
+            }
+            else if (effect == CB_BIF_CHANGES_ARG && call->args)
+                // every symbol of the first argument could refer to the
+                // changed array or hash
+                cb_hoister_add_changed((CbSyntree**) &call->args->data,
+                                       state);
+            
+            break;
+        }
+        
+        default:
+            break;
+    }
+    
+    cb_optimizer_visit_children(*node, cb_hoister_find_changes, hoister);
+}
+
+// -----------------------------------------------------------------------------
+// Add the symbols referred to by an expression to the changed symbols
+// (CbOptimizerVisitor) (internal)
+// -----------------------------------------------------------------------------
+static void cb_hoister_add_changed(CbSyntree** node, void* hoister)
+{
+    CbHoister* state = (CbHoister*) hoister;
+    const char* id   = NULL;
+    
+    if ((*node)->type == SNT_SYMREF)
+        id = ((const CbSymref*) *node)->sym_id;
+    else if ((*node)->type == SNT_VALARRAY_ACCESS)
+        id = ((const CbArrayAccessNode*) *node)->sym_id;
+    else if ((*node)->type == SNT_VALARRAY_ASSIGNMENT)
+        id = ((const CbArrayAssignmentNode*) *node)->sym_id;
+    
+    if (id && !cb_hoister_is_changed(state, id))
+    {
+        if (state->changed_count == state->changed_capacity)
+        {
+            state->changed_capacity = (state->changed_capacity)
+                                    ? state->changed_capacity * 2 : 16;
+            state->changed          = cb_realloc(state->changed,
+                                                 state->changed_capacity *
+                                                 sizeof(const char*),
+                                                 CB_ALLOC_AST);
+        }
+        
+        state->changed[state->changed_count++] = id;
+    }
+    
+    cb_optimizer_visit_children(*node, cb_hoister_add_changed, hoister);
+}
+
+// -----------------------------------------------------------------------------
+// Check if a symbol is changed by the loop (internal)
+// -----------------------------------------------------------------------------
+static bool cb_hoister_is_changed(const CbHoister* hoister, const char* id)
+{
+    size_t i = 0;
+    for (; i < hoister->changed_count; i++)
+        if (strcmp(hoister->changed[i], id) == 0)
+            return true;
+    
+    return false;
+}
+
+// -----------------------------------------------------------------------------
+// Replace the largest invariant expressions of a part of a loop by invariant
+// expression nodes (CbOptimizerVisitor) (internal)
+//
+//    Constant expressions and single symbols aren't hoisted, since their
+//    evaluation isn't more expensive than copying a value.
+// -----------------------------------------------------------------------------
+static void cb_hoister_hoist_invariants(CbSyntree** node, void* hoister)
+{
+    CbHoister* state = (CbHoister*) hoister;
+    bool variable    = false;
+    
+    switch ((*node)->type)
+    {
+        case SNT_INVARIANT_EXPR:
+            // hoisted out of an outer loop already
+            return;
+        
+        case SNT_JIT_LOOP:
+            // the expressions of a compiled loop aren't hoisted
+            return;
+        
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case SNT_LOGICAL_AND:
+        case SNT_LOGICAL_OR:
+        case SNT_LOGICAL_NOT:
+        case SNT_UNARYMINUS:
+        case SNT_COMPARISON:
+        case SNT_NUMERIC_ADD:
+        case SNT_NUMERIC_SUB:
+        case SNT_NUMERIC_MUL:
+        case SNT_NUMERIC_DIV:
+        case SNT_STRING_CONCAT:
+        case SNT_NUMERIC_COMPARISON:
+        case SNT_FUNC_CALL:
+        case SNT_INLINE_CALL:
+            if (!cb_hoister_check_expr(state, *node, false, &variable) ||
+                !variable)
+                break;
+            
+            if (state->invariant_count == state->invariant_capacity)
+            {
+                state->invariant_capacity = (state->invariant_capacity)
+                                          ? state->invariant_capacity * 2 : 4;
+                state->invariants         = cb_realloc(state->invariants,
+                                                state->invariant_capacity *
+                                                sizeof(CbInvariantExprNode*),
+                                                CB_ALLOC_AST);
+            }
+            
+            *node = cb_invariant_expr_node_create(*node);
+            state->invariants[state->invariant_count++] =
+                (CbInvariantExprNode*) *node;
+            return;
+        
+        default:
+            break;
+    }
+    
+    cb_optimizer_visit_children(*node, cb_hoister_hoist_invariants, hoister);
+}
+
+// -----------------------------------------------------------------------------
+// Check if an expression is invariant in the loop and if it refers to any
+// symbol or function (internal)
+//
+//    The parameters of inlined calls are invariant inside of the result-
+//    expression of an invariant inlined call only (inlined is true then).
+// -----------------------------------------------------------------------------
+static bool cb_hoister_check_expr(const CbHoister* hoister,
+                                  const CbSyntree* node, bool inlined,
+                                  bool* variable)
+{
+    const CbStrlist* arg = NULL;
+    
+    switch (node->type)
+    {
+        case SNT_CONSTVAL:
+        case SNT_CONSTBOOL:
+        case SNT_CONSTSTR:
+            return true;
+        
+        case SNT_SYMREF:
+            *variable = true;
+            return !cb_hoister_is_changed(hoister,
+                        ((const CbSymref*) node)->sym_id);
+        
+        case SNT_VALARRAY_ACCESS:
+            *variable = true;
+            return !cb_hoister_is_changed(hoister,
+                        ((const CbArrayAccessNode*) node)->sym_id);
+        
+        case SNT_INLINE_PARAM:
+            *variable = true;
+            return inlined;
+        
+        case SNT_INVARIANT_EXPR:
+            *variable = true;
+            return true;
+        
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case SNT_LOGICAL_AND:
+        case SNT_LOGICAL_OR:
+        case SNT_NUMERIC_ADD:
+        case SNT_NUMERIC_SUB:
+        case SNT_NUMERIC_MUL:
+        case SNT_NUMERIC_DIV:
+        case SNT_STRING_CONCAT:
+            return cb_hoister_check_expr(hoister, node->l, inlined,
+                                         variable) &&
+                   cb_hoister_check_expr(hoister, node->r, inlined,
+                                         variable);
+        
+        case SNT_COMPARISON:
+        case SNT_NUMERIC_COMPARISON:
+            return cb_hoister_check_expr(hoister,
+                       ((const CbComparisonNode*) node)->l, inlined,
+                       variable) &&
+                   cb_hoister_check_expr(hoister,
+                       ((const CbComparisonNode*) node)->r, inlined,
+                       variable);
+        
+        case SNT_UNARYMINUS:
+        case SNT_LOGICAL_NOT:
+            return cb_hoister_check_expr(hoister, node->l, inlined,
+                                         variable);
+        
+        case SNT_FUNC_CALL:
+        {
+            // only pure builtin functions, which aren't hidden by the script
+            const char* id = ((const CbFuncCallNode*) node)->sym_id;
+            if (cb_optimizer_find_name(hoister->names, id) != NULL ||
+                get_builtin_func_effect(id) != CB_BIF_PURE)
+                return false;
+            
+            *variable = true;
+            arg       = ((const CbFuncCallNode*) node)->args;
+            break;
+        }
+        
+        case SNT_INLINE_CALL:
+        {
+            const CbInlineCallNode* inline_call =
+                (const CbInlineCallNode*) node;
+            if (!cb_hoister_check_expr(hoister, inline_call->body, true,
+                                       variable))
+                return false;
+            
+            *variable = true;
+            arg       = inline_call->call->args;
+            break;
+        }
+        
+        default:
+            return false;
+    }
+    
+    // arguments of a call
+    for (; arg; arg = arg->next)
+        if (!cb_hoister_check_expr(hoister, (const CbSyntree*) arg->data,
+                                   inlined, variable))
+            return false;
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Infer the value-types of a syntax-tree and replace operations, whose
+// operands have known value-types, by specialised nodes (internal)
+// -----------------------------------------------------------------------------
+static void cb_optimizer_infer_types(CbSyntree** ast,
+                                     const CbOptimizerNames* names)
+{
+    CbTyper typer;
+    memset(&typer, 0, sizeof(CbTyper));
+    typer.names      = names;
+    typer.specialize = true;
+    
+    cb_typer_infer(&typer, ast);
+    
+    cb_free(typer.env.items, CB_ALLOC_AST);
+}
+
+// -----------------------------------------------------------------------------
+// Infer the possible value-types of a node and update the value-types of the
+// symbols by the execution of the node (internal)
+//
+//    The value-types are over-approximated: An empty set means, that the
+//    evaluation of the node always fails.
+// -----------------------------------------------------------------------------
+static CbTypeSet cb_typer_infer(CbTyper* typer, CbSyntree** node)
+{
+    CbSyntree* current = *node;
+    CbTypeSet l        = CB_TYPES_ANY;
+    CbTypeSet r        = CB_TYPES_ANY;
+    
+    switch (current->type)
+    {
+        case SNT_CONSTVAL:
+            return CB_TYPE(CB_VT_NUMERIC);
+        
+        case SNT_CONSTBOOL:
+            return CB_TYPE(CB_VT_BOOLEAN);
+        
+        case SNT_CONSTSTR:
+            return CB_TYPE(CB_VT_STRING);
+        
+        case SNT_SYMREF:
+            return cb_type_env_get(&typer->env,
+                                   ((const CbSymref*) current)->sym_id);
+        
+        case SNT_INLINE_PARAM:
+            return typer->params[((const CbInlineParamNode*) current)->index];
+        
+        case SNT_VALARRAY:
+            cb_optimizer_visit_children(current, cb_typer_visit, typer);
+            return CB_TYPE(CB_VT_VALARRAY);
+        
+        case SNT_VALHASH:
+            cb_optimizer_visit_children(current, cb_typer_visit, typer);
+            return CB_TYPE(CB_VT_HASH);
+        
+        case SNT_ASSIGNMENT:
+            r = cb_typer_infer(typer, &current->r);
+            cb_type_env_set(&typer->env, ((const CbSymref*) current->l)->sym_id,
+                            r);
+            return r;
+        
+        case SNT_DECLARATION:
+            cb_type_env_set(&typer->env, ((const CbSymref*) current->l)->sym_id,
+                            CB_TYPE(CB_VT_UNDEFINED));
+            return CB_TYPE(CB_VT_UNDEFINED);
+        
+        case SNT_VALARRAY_ASSIGNMENT:
+            cb_optimizer_visit_children(current, cb_typer_visit, typer);
+            cb_type_env_remove(&typer->env,
+                ((const CbArrayAssignmentNode*) current)->sym_id);
+            return CB_TYPES_ANY;
+        
+        case SNT_STATEMENTLIST:
+            cb_typer_infer(typer, &current->l);
+            return cb_typer_infer(typer, &current->r);
+        
+        case '+':
+        case '-':
+        case '*':
+        case '/':
+        case SNT_LOGICAL_AND:
+        case SNT_LOGICAL_OR:
+            l = cb_typer_infer(typer, &current->l);
+            r = cb_typer_infer(typer, &current->r);
+            return cb_typer_infer_binary(typer, current, l, r);
+        
+        case SNT_COMPARISON:
+            l = cb_typer_infer(typer, &((CbComparisonNode*) current)->l);
+            r = cb_typer_infer(typer, &((CbComparisonNode*) current)->r);
+            return cb_typer_infer_comparison(typer, current, l, r);
+        
+        case SNT_LOGICAL_NOT:
+            l = cb_typer_infer(typer, &current->l) &
+                (CB_TYPE(CB_VT_BOOLEAN) | CB_TYPE(CB_VT_NUMERIC));
+            if (l == CB_TYPES_NONE)
+                cb_typer_report(typer, current, "Wrong value-type");
+            
+            return l;
+        
+        case SNT_UNARYMINUS:
+            l = cb_typer_infer(typer, &current->l);
+            if (l != CB_TYPES_NONE && !(l & CB_TYPE(CB_VT_NUMERIC)))
+                cb_typer_report(typer, current, "Wrong value-type");
+            
+            return l & CB_TYPE(CB_VT_NUMERIC);
+        
+        case SNT_FUNC_CALL:
+        {
+            cb_optimizer_visit_children(current, cb_typer_visit, typer);
+            
+            // functions declared by the script may change any symbol
+            const char* id = ((const CbFuncCallNode*) current)->sym_id;
+            if (cb_optimizer_find_name(typer->names, id) != NULL ||
+                get_builtin_func_effect(id) == CB_BIF_CHANGES_ANY)
+                typer->env.count = 0;
+            
+            return CB_TYPES_ANY;
+        }
+        
+        case SNT_INLINE_CALL:
+        {
+            // the result-expression of an inlined function doesn't change
+            // any symbol
+            CbInlineCallNode* inline_call = (CbInlineCallNode*) current;
+            CbTypeSet params[CB_INLINE_MAX_PARAMS];
+            
+            int i          = 0;
+            CbStrlist* arg = inline_call->call->args;
+            for (; arg && i < CB_INLINE_MAX_PARAMS; arg = arg->next, i++)
+                params[i] = cb_typer_infer(typer, (CbSyntree**) &arg->data);
+            
+            const CbTypeSet* outer = typer->params;
+            typer->params          = params;
+            CbTypeSet result       = cb_typer_infer(typer, &inline_call->body);
+            typer->params          = outer;
+            
+            return result;
+        }
+        
+        case SNT_FUNC_DECL:
+        {
+            // the body is executed by calls, so nothing is known about the
+            // symbols
+            CbFuncDeclarationNode* fndecl = (CbFuncDeclarationNode*) current;
+            CbTypeEnv outer               = typer->env;
+            memset(&typer->env, 0, sizeof(CbTypeEnv));
+            
+            if (fndecl->body)
+                cb_typer_infer(typer, &fndecl->body);
+            
+            cb_free(typer->env.items, CB_ALLOC_AST);
+            typer->env = outer;
+            cb_type_env_remove(&typer->env, fndecl->sym_id);
+            
+            return CB_TYPES_ANY;
+        }
+        
+        case SNT_FLOW_IF:
+        {
+            CbFlowNode* flow = (CbFlowNode*) current;
+            cb_typer_check_condition(typer, flow->cond,
+                                     cb_typer_infer(typer, &flow->cond));
+            
+            CbTypeEnv false_env;
+            cb_type_env_copy(&false_env, &typer->env);
+            
+            cb_typer_infer(typer, &flow->tb);
+            
+            // join the symbols of both branches
+            CbTypeEnv true_env = typer->env;
+            typer->env         = false_env;
+            if (flow->fb)
+                cb_typer_infer(typer, &flow->fb);
+            
+            cb_type_env_join(&typer->env, &true_env);
+            cb_free(true_env.items, CB_ALLOC_AST);
+            
+            return CB_TYPES_ANY;
+        }
+        
+        case SNT_FLOW_WHILE:
+            cb_typer_infer_loop(typer, (CbFlowNode*) current);
+            return CB_TYPES_ANY;
+        
+        case SNT_EXCEPTION_BLOCK:
+            cb_typer_infer_exception_block(typer,
+                                           (CbExceptionBlockNode*) current);
+            return CB_TYPES_ANY;
+        
+        case SNT_INVARIANT_EXPR:
+            return cb_typer_infer(typer,
+                                  &((CbInvariantExprNode*) current)->expr);
+        
+        default:
+            cb_optimizer_visit_children(current, cb_typer_visit, typer);
+            return CB_TYPES_ANY;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Infer the value-types of a child-node (CbOptimizerVisitor) (internal)
+// -----------------------------------------------------------------------------
+static void cb_typer_visit(CbSyntree** node, void* typer)
+{
+    cb_typer_infer((CbTyper*) typer, node);
+}
+
+// -----------------------------------------------------------------------------
+// Infer the value-types of a binary operation and specialise it (internal)
+//
+//    The operands must have the same value-type, which the operation has to
+//    support (see cb_syntree_eval()).
+// -----------------------------------------------------------------------------
+static CbTypeSet cb_typer_infer_binary(CbTyper* typer, CbSyntree* node,
+                                       CbTypeSet l, CbTypeSet r)
+{
+    const CbTypeSet numeric = CB_TYPE(CB_VT_NUMERIC);
+    CbTypeSet supported     = numeric;
+    const char* message     = "Binary arithmetic is only allowed for numeric "
+                              "values";
+    
+    if (node->type == '+')
+    {
+        supported = numeric | CB_TYPE(CB_VT_STRING);
+        message   = "Binary addition is only allowed for string and numeric "
+                    "values";
+    }
+    else if (node->type == SNT_LOGICAL_AND || node->type == SNT_LOGICAL_OR)
+    {
+        supported = numeric | CB_TYPE(CB_VT_BOOLEAN);
+        message   = (node->type == SNT_LOGICAL_AND)
+                  ? "Binary AND is only allowed for boolean and numeric values"
+                  : "Binary OR is only allowed for boolean and numeric values";
+    }
+    
+    CbTypeSet result = l & r & supported;
+    
+    // the operation fails for every possible value
+    if (result == CB_TYPES_NONE && l != CB_TYPES_NONE && r != CB_TYPES_NONE)
+    {
+        if ((l & r) == CB_TYPES_NONE)
+            message = "Node type of left-hand side differs from right-hand "
+                      "side";
+        
+        cb_typer_report(typer, node, message);
+    }
+    
+    if (typer->specialize && l == r && node->type != SNT_LOGICAL_AND &&
+        node->type != SNT_LOGICAL_OR)
+    {
+        if (l == numeric)
+            switch (node->type)
+            {
+                case '+': node->type = SNT_NUMERIC_ADD; break;
+                case '-': node->type = SNT_NUMERIC_SUB; break;
+                case '*': node->type = SNT_NUMERIC_MUL; break;
+                case '/': node->type = SNT_NUMERIC_DIV; break;
+                default:  break;
+            }
+        else if (l == CB_TYPE(CB_VT_STRING) && node->type == '+')
+            node->type = SNT_STRING_CONCAT;
+    }
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Infer the value-types of a comparison and specialise it (internal)
+// -----------------------------------------------------------------------------
+static CbTypeSet cb_typer_infer_comparison(CbTyper* typer, CbSyntree* node,
+                                           CbTypeSet l, CbTypeSet r)
+{
+    const CbTypeSet supported = CB_TYPE(CB_VT_NUMERIC) |
+                                CB_TYPE(CB_VT_STRING) |
+                                CB_TYPE(CB_VT_BOOLEAN);
+    
+    if (l == CB_TYPES_NONE || r == CB_TYPES_NONE)
+        return CB_TYPES_NONE;
+    
+    if ((l & r & supported) == CB_TYPES_NONE)
+    {
+        cb_typer_report(typer, node, ((l & r) == CB_TYPES_NONE)
+                        ? "Node type of left-hand side differs from "
+                          "right-hand side"
+                        : "Comparison is only allowed for numeric, string "
+                          "and boolean values");
+        return CB_TYPES_NONE;
+    }
+    
+    if (typer->specialize && l == CB_TYPE(CB_VT_NUMERIC) && l == r)
+        node->type = SNT_NUMERIC_COMPARISON;
+    
+    return CB_TYPE(CB_VT_BOOLEAN);
+}
+
+// -----------------------------------------------------------------------------
+// Check the value-types of the condition of an if-statement or a loop
+// (internal)
+// -----------------------------------------------------------------------------
+static void cb_typer_check_condition(CbTyper* typer, const CbSyntree* cond,
+                                     CbTypeSet types)
+{
+    if (types != CB_TYPES_NONE && !(types & CB_TYPE(CB_VT_BOOLEAN)))
+        cb_typer_report(typer, cond, "Condition is not a boolean value");
+}
+
+// -----------------------------------------------------------------------------
+// Infer the value-types of a while-loop (internal)
+//
+//    The value-types at the start of an iteration are joined with the ones
+//    at its end, until they don't change anymore. Nodes are specialised and
+//    errors are reported by the last pass only, which uses the final
+//    value-types.
+// -----------------------------------------------------------------------------
+static void cb_typer_infer_loop(CbTyper* typer, CbFlowNode* loop)
+{
+    bool specialize    = typer->specialize;
+    bool report        = typer->report;
+    typer->specialize  = false;
+    typer->report      = false;
+    
+    CbTypeEnv entry;
+    cb_type_env_copy(&entry, &typer->env);
+    
+    while (true)
+    {
+        CbTypeEnv start;
+        cb_type_env_copy(&start, &typer->env);
+        
+        cb_typer_infer(typer, &loop->cond);
+        cb_typer_infer(typer, &loop->tb);
+        
+        // the symbols at the end of an iteration are joined with the ones
+        // at the first evaluation of the condition
+        cb_type_env_join(&typer->env, &entry);
+        
+        bool fixpoint = cb_type_env_equal(&typer->env, &start);
+        cb_free(start.items, CB_ALLOC_AST);
+        if (fixpoint)
+            break;
+    }
+    
+    cb_free(entry.items, CB_ALLOC_AST);
+    
+    typer->specialize = specialize;
+    typer->report     = report;
+    
+    cb_typer_check_condition(typer, loop->cond,
+                             cb_typer_infer(typer, &loop->cond));
+    
+    // the loop is left after an evaluation of the condition
+    CbTypeEnv exit_env;
+    cb_type_env_copy(&exit_env, &typer->env);
+    
+    cb_typer_infer(typer, &loop->tb);
+    
+    cb_free(typer->env.items, CB_ALLOC_AST);
+    typer->env = exit_env;
+}
+
+// -----------------------------------------------------------------------------
+// Infer the value-types of an exception block (internal)
+//
+//    An error may interrupt the code block at any point, so the symbols it
+//    changes may have any value-type in the exception-block.
+// -----------------------------------------------------------------------------
+static void cb_typer_infer_exception_block(CbTyper* typer,
+                                           CbExceptionBlockNode* node)
+{
+    CbHoister changes;
+    memset(&changes, 0, sizeof(CbHoister));
+    changes.names = typer->names;
+    
+    CbTypeEnv error_env;
+    cb_type_env_copy(&error_env, &typer->env);
+    
+    if (node->code_block)
+    {
+        cb_hoister_find_changes(&node->code_block, &changes);
+        cb_typer_infer(typer, &node->code_block);
+    }
+    
+    if (changes.changes_any)
+        error_env.count = 0;
+    
+    size_t i = 0;
+    for (; i < changes.changed_count; i++)
+        cb_type_env_remove(&error_env, changes.changed[i]);
+    
+    cb_free(changes.changed, CB_ALLOC_AST);
+    
+    // the exception-block is executed after an error (or always)
+    CbTypeEnv block_env = typer->env;
+    typer->env          = error_env;
+    if (node->exception_block)
+        cb_typer_infer(typer, &node->exception_block);
+    
+    if (node->block_type == EXBL_ONERROR)
+        cb_type_env_join(&typer->env, &block_env);
+    
+    cb_free(block_env.items, CB_ALLOC_AST);
+}
+
+// -----------------------------------------------------------------------------
+// Report a type error, which occurs whenever a node is evaluated (internal)
+// -----------------------------------------------------------------------------
+static void cb_typer_report(CbTyper* typer, const CbSyntree* node,
+                            const char* message)
+{
+    if (!typer->report)
+        return;
+    
+    cb_print_error(CB_ERR_TYPE, node->line_no, message);
+    typer->error_count++;
+}
+
+// -----------------------------------------------------------------------------
+// Copy the value-types of the symbols (internal)
+// -----------------------------------------------------------------------------
+static void cb_type_env_copy(CbTypeEnv* dest, const CbTypeEnv* src)
+{
+    dest->count    = src->count;
+    dest->capacity = src->count;
+    dest->items    = NULL;
+    
+    if (src->count > 0)
+    {
+        dest->items = cb_alloc(src->count * sizeof(CbTypeBinding),
+                               CB_ALLOC_AST);
+        memcpy(dest->items, src->items, src->count * sizeof(CbTypeBinding));
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Get the value-types of a symbol (internal)
+// -----------------------------------------------------------------------------
+static CbTypeSet cb_type_env_get(const CbTypeEnv* env, const char* id)
+{
+    size_t i = 0;
+    for (; i < env->count; i++)
+        if (strcmp(env->items[i].id, id) == 0)
+            return env->items[i].types;
+    
+    return CB_TYPES_ANY;
+}
+
+// -----------------------------------------------------------------------------
+// Set the value-types of a symbol (internal)
+// -----------------------------------------------------------------------------
+static void cb_type_env_set(CbTypeEnv* env, const char* id, CbTypeSet types)
+{
+    if (types == CB_TYPES_ANY)
+    {
+        cb_type_env_remove(env, id);
+        return;
+    }
+    
+    size_t i = 0;
+    for (; i < env->count; i++)
+        if (strcmp(env->items[i].id, id) == 0)
+        {
+            env->items[i].types = types;
+            return;
+        }
+    
+    if (env->count == env->capacity)
+    {
+        env->capacity = (env->capacity) ? env->capacity * 2 : 8;
+        env->items    = cb_realloc(env->items,
+                                   env->capacity * sizeof(CbTypeBinding),
+                                   CB_ALLOC_AST);
+    }
+    
+    env->items[env->count].id    = id;
+    env->items[env->count].types = types;
+    env->count++;
+}
+
+// -----------------------------------------------------------------------------
+// Forget the value-types of a symbol, so it may have any value-type (internal)
+// -----------------------------------------------------------------------------
+static void cb_type_env_remove(CbTypeEnv* env, const char* id)
+{
+    size_t i = 0;
+    for (; i < env->count; i++)
+        if (strcmp(env->items[i].id, id) == 0)
+        {
+            env->items[i] = env->items[--env->count];
+            return;
+        }
+}
+
+// -----------------------------------------------------------------------------
+// Join the value-types of two points of the execution, which continue at
+// the same point (internal)
+// -----------------------------------------------------------------------------
+static void cb_type_env_join(CbTypeEnv* env, const CbTypeEnv* other)
+{
+    size_t i = 0;
+    while (i < env->count)
+    {
+        CbTypeSet types = env->items[i].types |
+                          cb_type_env_get(other, env->items[i].id);
+        if (types == CB_TYPES_ANY)
+        {
+            env->items[i] = env->items[--env->count];
+            continue;
+        }
+        
+        env->items[i++].types = types;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Check if the value-types of two points of the execution are equal
+// (internal)
+// -----------------------------------------------------------------------------
+static bool cb_type_env_equal(const CbTypeEnv* a, const CbTypeEnv* b)
+{
+    if (a->count != b->count)
+        return false;
+    
+    size_t i = 0;
+    for (; i < a->count; i++)
+        if (cb_type_env_get(b, a->items[i].id) != a->items[i].types)
+            return false;
+    
+    return true;
+}
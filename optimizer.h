@@ -0,0 +1,83 @@
+/*******************************************************************************
+ * CbOptimizer -- Optimization passes over the abstract syntax-tree
+ *
+ *      The syntax-tree of a codeblock is optimized once, before it is executed
+ *      the first time, so compiled images contain the syntax-tree as parsed.
+ *      Every pass preserves the results and the reported errors (including
+ *      their line numbers) of the script.
+ *
+ *      Dead code elimination: Variables, which are never read, and functions,
+ *      which are never called, are removed with their declarations and
+ *      assignments, as well as branches of if-statements and while-loops,
+ *      whose conditions are constant. Symbols are looked up by their names
+ *      only, so a name, which isn't referred to anywhere in the script,
+ *      isn't used. A removed declaration mustn't have failed, so the
+ *      variable has to be declared once at the beginning of the body
+ *      assigning it, and the function once as statement. The right-hand
+ *      side of a removed assignment is still evaluated, unless it is a
+ *      constant. If the symbol-table is shared (e.g. by a REPL session),
+ *      the symbols are kept, since they are used after the execution.
+ *
+ *      Inlining: Calls of small user functions are replaced by nodes of the
+ *      type SNT_INLINE_CALL (see inline_call_node.h). A function is inlined,
+ *      if its body just assigns an expression of at most CB_INLINE_MAX_NODES
+ *      nodes to `Result' (or, without the default result symbol, is such an
+ *      expression), which only refers to its parameters and calls builtin
+ *      functions or functions inlined already. Since symbols are looked up at
+ *      run-time, the function has to be declared at top level and its name
+ *      mustn't be declared otherwise, and only calls after its declaration
+ *      are inlined. Names of called builtin functions mustn't be declared by
+ *      the script, so they can't be hidden by a caller's local symbol.
+ *      Recursive functions are never inlined, since a function isn't known
+ *      to the pass, while its own body is processed.
+ *
+ *      Loop-invariant code motion: Expressions of a while-loop, which only
+ *      refer to symbols not changed by the loop and call pure builtin
+ *      functions (see builtin.h) or inlined functions, are evaluated once per
+ *      execution of the loop (see invariant_node.h). A loop, which declares
+ *      functions or calls user functions or functions like Eval(), may change
+ *      any symbol, so nothing is hoisted out of it. Builtin functions, which
+ *      change the array or hash of their first argument, change every symbol
+ *      referred to by that argument.
+ *
+ *      Type inference: The possible value-types of every expression are
+ *      inferred along the flow of the execution. The value-types of the
+ *      symbols are joined, where branches meet, and iterated for loops,
+ *      until they don't change anymore. Assignments in a code block of an
+ *      exception block may have been executed partially, when the error
+ *      occurs, and calls, which may change any symbol (see above), make
+ *      every value-type possible again. Arithmetic operations and
+ *      comparisons, whose operands are always numeric values, and additions
+ *      of strings are replaced by specialised nodes (e.g. SNT_NUMERIC_ADD),
+ *      which don't check and dispatch the value-types. The same analysis
+ *      reports the type errors, which occur whenever a node is evaluated
+ *      (cb_optimizer_check_types()).
+ *
+ *      JIT compilation: If the JIT compiler is enabled, while-loops, which
+ *      only compute integers, are wrapped into nodes of the type
+ *      SNT_JIT_LOOP, which are compiled to machine code, when they are hot
+ *      (see jit.h). Nothing is hoisted out of these loops.
+ ******************************************************************************/
+
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+
+#include <stdbool.h>
+#include "syntree_if.h"
+
+// maximum size of an inlined result-expression (count of nodes)
+#define CB_INLINE_MAX_NODES 32
+
+// visitor of a child-node, which may replace the node
+typedef void (*CbOptimizerVisitor)(CbSyntree** node, void* context);
+
+
+// interface functions
+void cb_optimizer_run(CbSyntree** ast, bool shared_symtab);
+int cb_optimizer_check_types(CbSyntree* ast);
+void cb_optimizer_visit_children(CbSyntree* node, CbOptimizerVisitor visitor,
+                                 void* context);
+
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,301 @@
+/*******************************************************************************
+ * CbOutput -- Implementation of a buffered output sink
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <errno.h>
+#include <assert.h>
+#ifdef _CBC_PLAT_WNDS
+#include <io.h>
+#define STDOUT_FILENO 1
+#else
+#include <unistd.h>
+#include <sys/uio.h>
+#endif // _CBC_PLAT_WNDS
+#include "output.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+enum cb_output_type
+{
+    CB_OUTPUT_FD,
+    CB_OUTPUT_MEMORY,
+    CB_OUTPUT_CALLBACK
+};
+
+struct CbOutput
+{
+    enum cb_output_type type;
+    int fd;                         // file descriptor (CB_OUTPUT_FD)
+    CbOutputCallback callback;      // callback (CB_OUTPUT_CALLBACK)
+    void* context;                  // passed to the callback
+    bool line_flush;                // flush after every line
+    CbStrbuf buf;                   // buffered output
+    char* storage;                  // storage of a stream buffer
+};
+
+// sink writing to stdout, created on first use
+static CbOutput* stdout_output = NULL;
+// sink of the running codeblock
+static CbOutput* current_output = NULL;
+
+static CbOutput* cb_output_create_stream(enum cb_output_type type);
+static void cb_output_flush_fd(void* context, const char* data, size_t length,
+                               const char* extra, size_t extra_length);
+static void cb_output_flush_callback(void* context, const char* data,
+                                     size_t length, const char* extra,
+                                     size_t extra_length);
+static void cb_output_free_stdout();
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Create a sink writing to a file descriptor
+// -----------------------------------------------------------------------------
+CbOutput* cb_output_create_fd(int fd)
+{
+    CbOutput* output   = cb_output_create_stream(CB_OUTPUT_FD);
+    output->fd         = fd;
+    output->line_flush = isatty(fd);
+    
+    return output;
+}
+
+// -----------------------------------------------------------------------------
+// Create a sink collecting the output in memory
+// -----------------------------------------------------------------------------
+CbOutput* cb_output_create_memory()
+{
+    CbOutput* output   = (CbOutput*) malloc(sizeof(CbOutput));
+    output->type       = CB_OUTPUT_MEMORY;
+    output->fd         = -1;
+    output->callback   = NULL;
+    output->context    = NULL;
+    output->line_flush = false;
+    output->storage    = NULL;
+    cb_strbuf_init(&output->buf);
+    
+    return output;
+}
+
+// -----------------------------------------------------------------------------
+// Create a sink passing the output to a callback function
+// -----------------------------------------------------------------------------
+CbOutput* cb_output_create_callback(CbOutputCallback callback, void* context)
+{
+    assert(callback);
+    
+    CbOutput* output = cb_output_create_stream(CB_OUTPUT_CALLBACK);
+    output->callback = callback;
+    output->context  = context;
+    
+    return output;
+}
+
+// -----------------------------------------------------------------------------
+// Destructor (pending output is written)
+// -----------------------------------------------------------------------------
+void cb_output_free(CbOutput* output)
+{
+    if (current_output == output)
+        current_output = NULL;
+    
+    cb_strbuf_release(&output->buf);
+    free(output->storage);
+    free(output);
+}
+
+// -----------------------------------------------------------------------------
+// Write data
+// -----------------------------------------------------------------------------
+void cb_output_write(CbOutput* output, const char* data, size_t length)
+{
+    cb_strbuf_append(&output->buf, data, length);
+}
+
+// -----------------------------------------------------------------------------
+// Write a formatted value
+// -----------------------------------------------------------------------------
+void cb_output_write_value(CbOutput* output, const CbValue* val)
+{
+    cb_value_format(&output->buf, val);
+}
+
+// -----------------------------------------------------------------------------
+// Write a formatted value, followed by a newline
+// -----------------------------------------------------------------------------
+void cb_output_write_line(CbOutput* output, const CbValue* val)
+{
+    cb_value_format(&output->buf, val);
+    cb_strbuf_append_char(&output->buf, '\n');
+    
+    if (output->line_flush)
+        cb_strbuf_flush(&output->buf);
+}
+
+// -----------------------------------------------------------------------------
+// Write pending output
+// -----------------------------------------------------------------------------
+void cb_output_flush(CbOutput* output)
+{
+    cb_strbuf_flush(&output->buf);
+}
+
+// -----------------------------------------------------------------------------
+// Get the output collected by a memory sink
+//
+//    The string is still owned by the sink and valid until the next write.
+// -----------------------------------------------------------------------------
+const char* cb_output_get_memory(CbOutput* output, size_t* length)
+{
+    assert(output->type == CB_OUTPUT_MEMORY);
+    
+    if (length)
+        *length = output->buf.length;
+    
+    return cb_strbuf_get_string(&output->buf);
+}
+
+// -----------------------------------------------------------------------------
+// Get the sink writing to stdout
+//
+//    The sink is created on first use and flushed at program exit.
+// -----------------------------------------------------------------------------
+CbOutput* cb_output_get_stdout()
+{
+    if (stdout_output == NULL)
+    {
+        stdout_output = cb_output_create_fd(STDOUT_FILENO);
+        atexit(cb_output_free_stdout);
+    }
+    
+    return stdout_output;
+}
+
+// -----------------------------------------------------------------------------
+// Get the current output (stdout, if no codeblock set its own sink)
+// -----------------------------------------------------------------------------
+CbOutput* cb_output_get_current()
+{
+    if (current_output)
+        return current_output;
+    
+    return cb_output_get_stdout();
+}
+
+// -----------------------------------------------------------------------------
+// Set the current output, returns the previous one
+// -----------------------------------------------------------------------------
+CbOutput* cb_output_set_current(CbOutput* output)
+{
+    CbOutput* previous = current_output;
+    current_output     = output;
+    
+    return previous;
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Create a sink using a fixed buffer (internal)
+// -----------------------------------------------------------------------------
+static CbOutput* cb_output_create_stream(enum cb_output_type type)
+{
+    CbOutput* output   = (CbOutput*) malloc(sizeof(CbOutput));
+    output->type       = type;
+    output->fd         = -1;
+    output->callback   = NULL;
+    output->context    = NULL;
+    output->line_flush = false;
+    output->storage    = (char*) malloc(CB_OUTPUT_BUFFER_SIZE);
+    
+    cb_strbuf_init_stream(&output->buf, output->storage, CB_OUTPUT_BUFFER_SIZE,
+                          (type == CB_OUTPUT_FD) ? cb_output_flush_fd
+                                                 : cb_output_flush_callback,
+                          output);
+    
+    return output;
+}
+
+// -----------------------------------------------------------------------------
+// Flush-function for a file descriptor (internal)
+//
+//    Buffered and additional data are written with a single system call.
+// -----------------------------------------------------------------------------
+static void cb_output_flush_fd(void* context, const char* data, size_t length,
+                               const char* extra, size_t extra_length)
+{
+    CbOutput* output = (CbOutput*) context;
+
+#ifdef _CBC_PLAT_WNDS
+    // no writev() available
+    if (length > 0)
+        write(output->fd, data, length);
+    if (extra_length > 0)
+        write(output->fd, extra, extra_length);
+#else
+    struct iovec iov[2];
+    iov[0].iov_base = (void*) data;
+    iov[0].iov_len  = length;
+    iov[1].iov_base = (void*) extra;
+    iov[1].iov_len  = extra_length;
+    
+    int first = 0;
+    int count = (extra_length > 0) ? 2 : 1;
+    
+    // write until all data was written, continue after partial writes
+    while (first < count)
+    {
+        ssize_t written = writev(output->fd, iov + first, count - first);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            
+            break; // output is lost, e.g. for a closed pipe
+        }
+        
+        for (; first < count && (size_t) written >= iov[first].iov_len; first++)
+            written -= iov[first].iov_len;
+        
+        if (first < count)
+        {
+            iov[first].iov_base  = (char*) iov[first].iov_base + written;
+            iov[first].iov_len  -= written;
+        }
+    }
+#endif // _CBC_PLAT_WNDS
+}
+
+// -----------------------------------------------------------------------------
+// Flush-function for a callback (internal)
+// -----------------------------------------------------------------------------
+static void cb_output_flush_callback(void* context, const char* data,
+                                     size_t length, const char* extra,
+                                     size_t extra_length)
+{
+    CbOutput* output = (CbOutput*) context;
+    
+    if (length > 0)
+        output->callback(output->context, data, length);
+    if (extra_length > 0)
+        output->callback(output->context, extra, extra_length);
+}
+
+// -----------------------------------------------------------------------------
+// Write pending output to stdout and free the sink at program exit (internal)
+// -----------------------------------------------------------------------------
+static void cb_output_free_stdout()
+{
+    cb_output_free(stdout_output);
+    stdout_output = NULL;
+}
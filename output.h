@@ -0,0 +1,48 @@
+/*******************************************************************************
+ * CbOutput -- Implementation of a buffered output sink
+ *
+ *             The sink collects the output of print-statements and WriteLn()
+ *             in a user-space buffer and writes it to a file descriptor, a
+ *             memory buffer or a callback function. Pending output is written
+ *             as soon as the buffer is full, on cb_output_flush() and when
+ *             the sink is freed. Output to a terminal is flushed per line.
+ *
+ *             The sink of the running codeblock is the current output, which
+ *             is used by the builtin functions.
+ ******************************************************************************/
+
+#ifndef OUTPUT_H
+#define OUTPUT_H
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "strbuf.h"
+#include "value.h"
+
+// size of the user-space buffer
+#define CB_OUTPUT_BUFFER_SIZE 65536
+
+typedef struct CbOutput CbOutput;
+typedef void (*CbOutputCallback)(void* context, const char* data,
+                                 size_t length);
+
+
+// interface functions
+CbOutput* cb_output_create_fd(int fd);
+CbOutput* cb_output_create_memory();
+CbOutput* cb_output_create_callback(CbOutputCallback callback, void* context);
+void cb_output_free(CbOutput* output);
+
+void cb_output_write(CbOutput* output, const char* data, size_t length);
+void cb_output_write_value(CbOutput* output, const CbValue* val);
+void cb_output_write_line(CbOutput* output, const CbValue* val);
+void cb_output_flush(CbOutput* output);
+const char* cb_output_get_memory(CbOutput* output, size_t* length);
+
+CbOutput* cb_output_get_stdout();
+CbOutput* cb_output_get_current();
+CbOutput* cb_output_set_current(CbOutput* output);
+
+
+#endif // OUTPUT_H
@@ -0,0 +1,298 @@
+/*******************************************************************************
+ * CbPool -- Slab allocator for small objects
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <assert.h>
+#if defined(_CBC_PLAT_WNDS)
+#include <malloc.h>
+#endif
+#include "pool.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+#define CB_POOL_CLASS_COUNT   (CB_POOL_MAX_SIZE / CB_POOL_GRANULE)
+#define CB_POOL_CLASS(size)   (((size) + CB_POOL_GRANULE - 1) \
+                               / CB_POOL_GRANULE - 1)
+#define CB_POOL_CLASS_SIZE(i) (((i) + 1) * CB_POOL_GRANULE)
+#define CB_POOL_POISON        0xDD
+
+// header of a slab, followed by its objects
+typedef struct CbPoolSlab
+{
+    struct CbPoolSlab* next;        // next slab of the class with free objects
+    struct CbPoolSlab* prior;       // prior slab of the class with free objects
+    void* free_list;                // first free object
+    unsigned int live;              // count of allocated objects
+    unsigned int size_class;        // index of the size class
+} CbPoolSlab;
+
+// objects start at the first granule behind the header
+#define CB_POOL_HEADER_SIZE   ((sizeof(CbPoolSlab) + CB_POOL_GRANULE - 1) \
+                               / CB_POOL_GRANULE * CB_POOL_GRANULE)
+
+// size class
+typedef struct
+{
+    CbPoolSlab* slabs;              // slabs with free and live objects
+    CbPoolSlab* empty;              // slab without live objects (or NULL)
+} CbPoolClass;
+
+static CbPoolClass classes[CB_POOL_CLASS_COUNT];
+static size_t slab_count   = 0;
+static size_t object_count = 0;
+
+#ifndef CB_POOL_DISABLED
+static CbPoolSlab* cb_pool_create_slab(unsigned int size_class);
+static void cb_pool_release_slab(CbPoolSlab* slab);
+static void cb_pool_link_slab(CbPoolClass* pool_class, CbPoolSlab* slab);
+static void cb_pool_unlink_slab(CbPoolClass* pool_class, CbPoolSlab* slab);
+#ifdef _CBC_DEBUG
+static void cb_pool_poison(void* memory, size_t size);
+static bool cb_pool_is_poisoned(const void* memory, size_t size);
+#endif // _CBC_DEBUG
+#endif // CB_POOL_DISABLED
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Allocate an object of the given size
+// -----------------------------------------------------------------------------
+void* cb_pool_alloc(size_t size, enum cb_alloc_subsystem subsystem)
+{
+#ifdef CB_POOL_DISABLED
+    return cb_alloc(size, subsystem);
+#else
+    if (size == 0 || size > CB_POOL_MAX_SIZE)
+        return cb_alloc(size, subsystem);
+    
+    unsigned int size_class = CB_POOL_CLASS(size);
+    CbPoolClass* pool_class = &classes[size_class];
+    CbPoolSlab* slab        = pool_class->slabs;
+    
+    if (slab == NULL) // reuse the empty slab or create a new one
+    {
+        slab = pool_class->empty;
+        if (slab != NULL)
+            pool_class->empty = NULL;
+        else if ((slab = cb_pool_create_slab(size_class)) == NULL)
+            return NULL;
+        
+        cb_pool_link_slab(pool_class, slab);
+    }
+    
+    void* memory    = slab->free_list;
+    slab->free_list = *((void**) memory);
+    slab->live++;
+    object_count++;
+    
+    if (slab->free_list == NULL) // full slabs aren't linked
+        cb_pool_unlink_slab(pool_class, slab);
+    
+#ifdef _CBC_DEBUG
+    assert(cb_pool_is_poisoned(memory, CB_POOL_CLASS_SIZE(size_class)) &&
+           "pooled object was modified after it was freed");
+#endif // _CBC_DEBUG
+    
+    cb_alloc_account_size(CB_POOL_CLASS_SIZE(size_class), subsystem);
+    
+    return memory;
+#endif // CB_POOL_DISABLED
+}
+
+// -----------------------------------------------------------------------------
+// Free an object allocated by cb_pool_alloc() with the same size
+// -----------------------------------------------------------------------------
+void cb_pool_free(void* memory, size_t size, enum cb_alloc_subsystem subsystem)
+{
+#ifdef CB_POOL_DISABLED
+    (void) size;
+    cb_free(memory, subsystem);
+#else
+    if (memory == NULL)
+        return;
+    
+    if (size == 0 || size > CB_POOL_MAX_SIZE)
+    {
+        cb_free(memory, subsystem);
+        return;
+    }
+    
+    CbPoolSlab* slab        = (CbPoolSlab*) ((uintptr_t) memory &
+                                  ~((uintptr_t) CB_POOL_SLAB_SIZE - 1));
+    CbPoolClass* pool_class = &classes[slab->size_class];
+    assert(slab->size_class == CB_POOL_CLASS(size));
+    
+    cb_alloc_account_free(CB_POOL_CLASS_SIZE(slab->size_class), subsystem);
+    
+#ifdef _CBC_DEBUG
+    cb_pool_poison(memory, CB_POOL_CLASS_SIZE(slab->size_class));
+#endif // _CBC_DEBUG
+    
+    if (slab->free_list == NULL) // the slab was full
+        cb_pool_link_slab(pool_class, slab);
+    
+    *((void**) memory) = slab->free_list;
+    slab->free_list    = memory;
+    object_count--;
+    
+    if (--slab->live > 0)
+        return;
+    
+    // keep one empty slab per class, so alternating allocations and frees
+    // don't create and release a slab every time
+    cb_pool_unlink_slab(pool_class, slab);
+    if (pool_class->empty == NULL)
+        pool_class->empty = slab;
+    else
+        cb_pool_release_slab(slab);
+#endif // CB_POOL_DISABLED
+}
+
+// -----------------------------------------------------------------------------
+// Get the statistics of the pool
+// -----------------------------------------------------------------------------
+void cb_pool_get_stats(CbPoolStats* stats)
+{
+    stats->slabs   = slab_count;
+    stats->objects = object_count;
+}
+
+// -----------------------------------------------------------------------------
+// Print the statistics of the pool
+// -----------------------------------------------------------------------------
+void cb_pool_print_stats(FILE* output)
+{
+    fprintf(output, "\nPool: %lu slabs (%lu bytes), %lu live objects\n",
+            (unsigned long) slab_count,
+            (unsigned long) (slab_count * CB_POOL_SLAB_SIZE),
+            (unsigned long) object_count);
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+#ifndef CB_POOL_DISABLED
+
+// -----------------------------------------------------------------------------
+// Create a slab and link its objects to the free list (internal)
+// -----------------------------------------------------------------------------
+static CbPoolSlab* cb_pool_create_slab(unsigned int size_class)
+{
+    CbPoolSlab* slab = NULL;
+#if defined(_CBC_PLAT_WNDS)
+    slab = (CbPoolSlab*) _aligned_malloc(CB_POOL_SLAB_SIZE, CB_POOL_SLAB_SIZE);
+#else
+    if (posix_memalign((void**) &slab, CB_POOL_SLAB_SIZE, CB_POOL_SLAB_SIZE))
+        slab = NULL;
+#endif
+    if (slab == NULL)
+        return NULL;
+    
+    size_t size      = CB_POOL_CLASS_SIZE(size_class);
+    char* object     = (char*) slab + CB_POOL_HEADER_SIZE;
+    char* end        = (char*) slab + CB_POOL_SLAB_SIZE;
+    slab->next       = NULL;
+    slab->prior      = NULL;
+    slab->free_list  = NULL;
+    slab->live       = 0;
+    slab->size_class = size_class;
+    
+    // link the objects in the order of their addresses
+    void** link = &slab->free_list;
+    for (; object + size <= end; object += size)
+    {
+#ifdef _CBC_DEBUG
+        cb_pool_poison(object, size);
+#endif // _CBC_DEBUG
+        *link = object;
+        link  = (void**) object;
+    }
+    *link = NULL;
+    
+    slab_count++;
+    
+    return slab;
+}
+
+// -----------------------------------------------------------------------------
+// Return a slab to the system (internal)
+// -----------------------------------------------------------------------------
+static void cb_pool_release_slab(CbPoolSlab* slab)
+{
+#if defined(_CBC_PLAT_WNDS)
+    _aligned_free(slab);
+#else
+    free(slab);
+#endif
+    slab_count--;
+}
+
+// -----------------------------------------------------------------------------
+// Link a slab at the head of the slabs of its class (internal)
+// -----------------------------------------------------------------------------
+static void cb_pool_link_slab(CbPoolClass* pool_class, CbPoolSlab* slab)
+{
+    slab->prior = NULL;
+    slab->next  = pool_class->slabs;
+    if (slab->next)
+        slab->next->prior = slab;
+    
+    pool_class->slabs = slab;
+}
+
+// -----------------------------------------------------------------------------
+// Unlink a slab from the slabs of its class (internal)
+// -----------------------------------------------------------------------------
+static void cb_pool_unlink_slab(CbPoolClass* pool_class, CbPoolSlab* slab)
+{
+    if (slab->prior)
+        slab->prior->next = slab->next;
+    else
+        pool_class->slabs = slab->next;
+    
+    if (slab->next)
+        slab->next->prior = slab->prior;
+    
+    slab->next  = NULL;
+    slab->prior = NULL;
+}
+
+#ifdef _CBC_DEBUG
+// -----------------------------------------------------------------------------
+// Poison a free object behind its link (internal)
+// -----------------------------------------------------------------------------
+static void cb_pool_poison(void* memory, size_t size)
+{
+    memset((char*) memory + sizeof(void*), CB_POOL_POISON,
+           size - sizeof(void*));
+}
+
+// -----------------------------------------------------------------------------
+// Check if the poison of a free object is intact (internal)
+// -----------------------------------------------------------------------------
+static bool cb_pool_is_poisoned(const void* memory, size_t size)
+{
+    const unsigned char* byte = (const unsigned char*) memory;
+    size_t i                  = sizeof(void*);
+    for (; i < size; i++)
+        if (byte[i] != CB_POOL_POISON)
+            return false;
+    
+    return true;
+}
+#endif // _CBC_DEBUG
+
+#endif // CB_POOL_DISABLED
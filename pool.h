@@ -0,0 +1,65 @@
+/*******************************************************************************
+ * CbPool -- Slab allocator for small objects
+ *
+ *           Values, array headers, symbols and stack items are created and
+ *           freed at a very high rate, so they are allocated from slabs of
+ *           equally sized objects instead of by malloc(). Every size up to
+ *           CB_POOL_MAX_SIZE is rounded up to a multiple of CB_POOL_GRANULE,
+ *           which determines its size class. A slab is aligned to its size,
+ *           so the slab of an object is found by masking its address, and
+ *           freed objects are kept in a free list per slab.
+ *
+ *           Allocations prefer slabs, which already have live objects. A
+ *           slab, whose objects were all freed, is returned to the system,
+ *           unless it is the only empty slab of its size class, so the
+ *           retained memory of long-running processes stays bounded.
+ *
+ *           The objects are accounted by the allocation hooks (see alloc.h)
+ *           with the size of their class, so statistics and quotas apply.
+ *           The interpreter is single-threaded (every worker of the server
+ *           is a pre-forked process serving its requests one after another),
+ *           so the pool isn't locked.
+ *
+ *           Debug builds (_CBC_DEBUG) poison freed objects and check the
+ *           poison on reuse, so writes to freed objects are detected. If
+ *           the pool is disabled by _CBC_NO_POOL or an AddressSanitizer
+ *           build, the objects are allocated by the allocation hooks, so
+ *           memory checkers see every object.
+ ******************************************************************************/
+
+#ifndef POOL_H
+#define POOL_H
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "alloc.h"
+
+// size classes are multiples of the granule up to the maximum size
+#define CB_POOL_GRANULE    16
+#define CB_POOL_MAX_SIZE   128
+// size (and alignment) of a slab
+#define CB_POOL_SLAB_SIZE  16384
+
+#if defined(_CBC_NO_POOL) || defined(__SANITIZE_ADDRESS__)
+#define CB_POOL_DISABLED
+#endif
+
+// statistics of the pool
+typedef struct
+{
+    size_t slabs;                   // count of allocated slabs
+    size_t objects;                 // count of live objects
+} CbPoolStats;
+
+
+// interface functions
+void* cb_pool_alloc(size_t size, enum cb_alloc_subsystem subsystem);
+void cb_pool_free(void* memory, size_t size,
+                  enum cb_alloc_subsystem subsystem);
+
+void cb_pool_get_stats(CbPoolStats* stats);
+void cb_pool_print_stats(FILE* output);
+
+
+#endif // POOL_H
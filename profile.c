@@ -0,0 +1,809 @@
+/*******************************************************************************
+ * CbProfile -- Implementation of an execution profiler
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#ifndef _CBC_PLAT_WNDS
+#include <signal.h>
+#include <sys/time.h>
+#endif // _CBC_PLAT_WNDS
+#include "profile.h"
+#include "syntree.h"
+#include "hash.h"
+#include "strbuf.h"
+#include "reader.h"
+#include "error_handling.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+// count of rows in the hot spot tables
+#define CB_PROFILE_REPORT_ROWS 20
+
+// name of the outermost frame
+#define CB_PROFILE_ROOT_FRAME "main"
+
+// maximum count of function frames recorded by a sample
+#define CB_PROFILE_SAMPLE_FRAMES 32
+
+// count of entries of the cache of function names (power of two)
+#define CB_PROFILE_NAME_CACHE_SIZE 256
+
+// count of samples in the ring buffer (power of two)
+#define CB_PROFILE_RING_SIZE 8192
+
+// statistics of a line (times in nanoseconds)
+typedef struct
+{
+    uint64_t count;                 // count of evaluated nodes
+    uint64_t inclusive;             // time including nested nodes
+    uint64_t exclusive;             // time excluding nested nodes
+    int active;                     // count of nodes being evaluated
+} CbProfileLine;
+
+// statistics of a function (times in nanoseconds)
+typedef struct
+{
+    char* name;                     // function identifier
+    uint64_t calls;                 // count of calls
+    uint64_t inclusive;             // time including called functions
+    uint64_t exclusive;             // time excluding called functions
+    int active;                     // count of running calls (recursion)
+} CbProfileFunction;
+
+// node being evaluated
+typedef struct
+{
+    uint64_t start;                 // time stamp of the evaluation's begin
+    uint64_t children;              // time spent in nested nodes
+    int line_no;                    // line of the node
+} CbProfileNode;
+
+// function being called
+typedef struct
+{
+    size_t function;                // index of the function
+    size_t path_length;             // length of the stack-path up to the caller
+    uint64_t start;                 // time stamp of the call
+    uint64_t children;              // time spent in called functions
+} CbProfileFrame;
+
+// sample taken by the signal handler
+typedef struct
+{
+    int line_no;                    // line of the executed node
+    int depth;                      // count of recorded frames
+    uint32_t function[CB_PROFILE_SAMPLE_FRAMES]; // functions, outermost first
+    int call_line[CB_PROFILE_SAMPLE_FRAMES];     // lines of the calls
+} CbProfileSample;
+
+bool cb_profile_enabled = false;
+
+static CbProfileLine* lines         = NULL;
+static size_t line_count            = 0;
+static CbProfileFunction* functions = NULL;
+static size_t function_count        = 0;
+static CbHash* function_index       = NULL; // maps names to indices
+static const char* name_cache[CB_PROFILE_NAME_CACHE_SIZE]; // recent names
+static size_t name_cache_index[CB_PROFILE_NAME_CACHE_SIZE];
+static CbProfileNode* nodes         = NULL;
+static size_t node_depth            = 0;
+static size_t node_capacity         = 0;
+static CbProfileFrame* frames       = NULL;
+static size_t frame_depth           = 0;
+static size_t frame_capacity        = 0;
+static CbStrbuf path;                       // stack-path of the current frame
+static CbHash* stacks               = NULL; // maps stack-paths to exclusive time
+
+// state of the sampling profiler, shared with the signal handler
+static bool sampling                            = false;
+static uint64_t sample_interval                 = 0;    // in nanoseconds
+static uint64_t sample_count                    = 0;
+static uint64_t sample_dropped                  = 0;
+static CbSyntree* volatile current_node         = NULL; // published node
+static volatile size_t call_depth               = 0;
+static volatile uint32_t call_function[CB_PROFILE_SAMPLE_FRAMES];
+static volatile int call_line[CB_PROFILE_SAMPLE_FRAMES];
+static CbProfileSample* ring                    = NULL;
+static volatile size_t ring_head                = 0;    // written by handler
+static volatile size_t ring_tail                = 0;    // written by consumer
+
+static uint64_t cb_profile_now();
+static CbProfileLine* cb_profile_get_line(int line_no);
+static size_t cb_profile_get_function(const char* name);
+static void cb_profile_push_frame(size_t function);
+static void cb_profile_pop_frame();
+static int cb_profile_compare_lines(const void* a, const void* b);
+static int cb_profile_compare_functions(const void* a, const void* b);
+static char** cb_profile_read_source(const char* source_name, size_t count);
+static void cb_profile_handle_signal(int signal_number);
+static void cb_profile_drain();
+static void cb_profile_account_sample(const CbProfileSample* sample);
+static void cb_profile_add_stack(const char* stack, uint64_t time);
+static void cb_profile_leave_node(size_t depth);
+static void cb_profile_cleanup_node(void* depth);
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Enable the profiler
+// -----------------------------------------------------------------------------
+void cb_profile_start()
+{
+    if (stacks == NULL)
+    {
+        function_index = cb_hash_create();
+        stacks         = cb_hash_create();
+        cb_strbuf_init(&path);
+    }
+    
+    if (frame_depth == 0)
+        cb_profile_push_frame((size_t) -1);
+    
+    cb_profile_enabled = true;
+}
+
+// -----------------------------------------------------------------------------
+// Enable the sampling profiler
+//
+//    The executed line and the calls of user functions are sampled every
+//    interval of CPU time (in microseconds). EXIT_FAILURE is returned, if the
+//    timer isn't available.
+// -----------------------------------------------------------------------------
+int cb_profile_start_sampling(int interval)
+{
+#ifdef _CBC_PLAT_WNDS
+    (void) interval;
+    return EXIT_FAILURE;
+#else
+    if (stacks == NULL)
+    {
+        function_index = cb_hash_create();
+        stacks         = cb_hash_create();
+        cb_strbuf_init(&path);
+    }
+    
+    if (ring == NULL)
+        ring = (CbProfileSample*) malloc(CB_PROFILE_RING_SIZE *
+                                         sizeof(CbProfileSample));
+    
+    if (interval <= 0)
+        interval = CB_PROFILE_SAMPLE_INTERVAL;
+    
+    sample_interval = (uint64_t) interval * 1000;
+    current_node    = NULL;
+    call_depth      = 0;
+    
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = cb_profile_handle_signal;
+    action.sa_flags   = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    
+    struct itimerval timer;
+    timer.it_interval.tv_sec  = interval / 1000000;
+    timer.it_interval.tv_usec = interval % 1000000;
+    timer.it_value            = timer.it_interval;
+    
+    if (sigaction(SIGPROF, &action, NULL) != 0)
+        return EXIT_FAILURE;
+    
+    sampling           = true;
+    cb_profile_enabled = true;
+    
+    if (setitimer(ITIMER_PROF, &timer, NULL) != 0)
+    {
+        cb_profile_stop();
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+#endif // _CBC_PLAT_WNDS
+}
+
+// -----------------------------------------------------------------------------
+// Disable the profiler, the statistics are kept for the report
+// -----------------------------------------------------------------------------
+void cb_profile_stop()
+{
+    cb_profile_enabled = false;
+
+#ifndef _CBC_PLAT_WNDS
+    if (sampling)
+    {
+        struct itimerval timer;
+        memset(&timer, 0, sizeof(timer));
+        setitimer(ITIMER_PROF, &timer, NULL);
+        signal(SIGPROF, SIG_IGN); // a pending signal may still arrive
+        
+        sampling = false;
+        cb_profile_drain();
+    }
+#endif // _CBC_PLAT_WNDS
+    
+    while (frame_depth > 0)
+        cb_profile_pop_frame();
+}
+
+// -----------------------------------------------------------------------------
+// Disable the profiler and discard the statistics
+// -----------------------------------------------------------------------------
+void cb_profile_reset()
+{
+    cb_profile_stop();
+    
+    size_t i = 0;
+    for (; i < function_count; i++)
+        free(functions[i].name);
+    
+    free(lines);
+    free(functions);
+    free(nodes);
+    free(frames);
+    free(ring);
+    
+    if (stacks)
+    {
+        cb_hash_free(function_index);
+        cb_hash_free(stacks);
+        cb_strbuf_release(&path);
+    }
+    
+    lines          = NULL;
+    line_count     = 0;
+    functions      = NULL;
+    function_count = 0;
+    function_index = NULL;
+    nodes          = NULL;
+    node_depth     = 0;
+    node_capacity  = 0;
+    frames         = NULL;
+    frame_capacity = 0;
+    stacks         = NULL;
+    ring           = NULL;
+    ring_head      = 0;
+    memset(name_cache, 0, sizeof(name_cache));
+    ring_tail      = 0;
+    sample_count   = 0;
+    sample_dropped = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Evaluate a node and record count and time of its line
+// -----------------------------------------------------------------------------
+CbValue* cb_profile_eval(CbSyntree* node, CbSymtab* symtab,
+                         CbProfileEvalFunction eval)
+{
+    if (sampling) // just publish the node for the signal handler
+    {
+        // an unwound evaluation leaves an inner node published until the
+        // next evaluation, which only attributes a few samples to it
+        CbSyntree* parent = current_node;
+        current_node      = node;
+        CbValue* result   = eval(node, symtab);
+        current_node      = parent;
+        
+        if (ring_head - ring_tail >= CB_PROFILE_RING_SIZE / 2)
+            cb_profile_drain();
+        
+        return result;
+    }
+    
+    if (node_depth == node_capacity)
+    {
+        node_capacity = (node_capacity) ? node_capacity * 2 : 256;
+        nodes         = (CbProfileNode*) realloc(nodes, node_capacity *
+                                                 sizeof(CbProfileNode));
+    }
+    
+    CbProfileLine* line  = cb_profile_get_line(node->line_no);
+    line->count++;
+    line->active++;
+    
+    size_t depth          = node_depth++;
+    nodes[depth].children = 0;
+    nodes[depth].line_no  = node->line_no;
+    nodes[depth].start    = cb_profile_now();
+    
+    // an unwound evaluation is accounted as well
+    cb_error_push_cleanup(&depth, cb_profile_cleanup_node);
+    CbValue* result = eval(node, symtab);
+    cb_error_pop_cleanup();
+    
+    cb_profile_leave_node(depth);
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Record the begin of a function call
+// -----------------------------------------------------------------------------
+void cb_profile_enter_function(const char* name)
+{
+    size_t function = cb_profile_get_function(name);
+    
+    functions[function].calls++;
+    
+    if (sampling)
+    {
+        size_t depth = call_depth;
+        if (depth < CB_PROFILE_SAMPLE_FRAMES)
+        {
+            call_function[depth] = (uint32_t) function;
+            call_line[depth]     = (current_node) ? current_node->line_no : 0;
+        }
+        
+        call_depth = depth + 1; // published after the frame is complete
+        return;
+    }
+    
+    functions[function].active++;
+    
+    cb_profile_push_frame(function);
+}
+
+// -----------------------------------------------------------------------------
+// Record the end of the current function call
+// -----------------------------------------------------------------------------
+void cb_profile_leave_function()
+{
+    if (sampling)
+    {
+        if (call_depth > 0)
+            call_depth = call_depth - 1;
+        
+        return;
+    }
+    
+    if (frame_depth > 1) // the root frame is popped by cb_profile_stop()
+        cb_profile_pop_frame();
+}
+
+// -----------------------------------------------------------------------------
+// Print the hot spot tables of lines and functions
+//
+//    If the name of the source file is passed, the source code of the lines
+//    is printed as well.
+// -----------------------------------------------------------------------------
+void cb_profile_report(FILE* output, const char* source_name)
+{
+    // sort line indices by exclusive time
+    size_t* order  = (size_t*) malloc((line_count + 1) * sizeof(size_t));
+    size_t count   = 0;
+    uint64_t total = 0;
+    
+    size_t i = 0;
+    for (; i < line_count; i++)
+    {
+        if (lines[i].count > 0)
+            order[count++] = i;
+        
+        total += lines[i].exclusive;
+    }
+    
+    qsort(order, count, sizeof(size_t), cb_profile_compare_lines);
+    
+    char** source = cb_profile_read_source(source_name, line_count);
+    
+    if (sample_count > 0)
+        fprintf(output, "\nHot spots by line (%.3f ms total, %llu samples, "
+                "%llu dropped)\n", total / 1e6,
+                (unsigned long long) sample_count,
+                (unsigned long long) sample_dropped);
+    else
+        fprintf(output, "\nHot spots by line (%.3f ms total)\n", total / 1e6);
+    fprintf(output, "%6s %12s %12s %12s %7s  %s\n", "Line", "Count",
+            "Incl (ms)", "Excl (ms)", "Excl %", "Source");
+    
+    for (i = 0; i < count && i < CB_PROFILE_REPORT_ROWS; i++)
+    {
+        const CbProfileLine* line = &lines[order[i]];
+        
+        fprintf(output, "%6zu %12llu %12.3f %12.3f %6.1f%%  %.40s\n",
+                order[i], (unsigned long long) line->count,
+                line->inclusive / 1e6, line->exclusive / 1e6,
+                (total) ? 100.0 * line->exclusive / total : 0.0,
+                (source && source[order[i]]) ? source[order[i]] : "");
+    }
+    
+    if (source)
+    {
+        for (i = 0; i < line_count; i++)
+            free(source[i]);
+        
+        free(source);
+    }
+    
+    free(order);
+    
+    if (function_count == 0)
+        return;
+    
+    // sort functions by exclusive time
+    CbProfileFunction** sorted = (CbProfileFunction**) malloc(
+                                     function_count * sizeof(CbProfileFunction*));
+    for (i = 0; i < function_count; i++)
+        sorted[i] = &functions[i];
+    
+    qsort(sorted, function_count, sizeof(CbProfileFunction*),
+          cb_profile_compare_functions);
+    
+    fprintf(output, "\nHot spots by function\n");
+    fprintf(output, "%-24s %12s %12s %12s\n", "Function", "Calls",
+            "Incl (ms)", "Excl (ms)");
+    
+    for (i = 0; i < function_count && i < CB_PROFILE_REPORT_ROWS; i++)
+        fprintf(output, "%-24.24s %12llu %12.3f %12.3f\n", sorted[i]->name,
+                (unsigned long long) sorted[i]->calls,
+                sorted[i]->inclusive / 1e6, sorted[i]->exclusive / 1e6);
+    
+    free(sorted);
+}
+
+// -----------------------------------------------------------------------------
+// Write the collapsed stacks with their exclusive time in microseconds
+// -----------------------------------------------------------------------------
+int cb_profile_write_stacks(const char* file_name)
+{
+    FILE* output = fopen(file_name, "w");
+    if (!output)
+        return EXIT_FAILURE;
+    
+    if (stacks)
+    {
+        size_t position    = 0;
+        const CbValue* key = NULL;
+        CbValue* value     = NULL;
+        
+        while (cb_hash_iterate(stacks, &position, &key, &value))
+        {
+            CbNumeric microseconds = cb_numeric_get(value) / 1000;
+            if (microseconds > 0)
+                fprintf(output, "%s %lld\n", cb_string_get(key),
+                        (long long) microseconds);
+        }
+    }
+    
+    return (fclose(output) == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Get a monotonic time stamp in nanoseconds (internal)
+// -----------------------------------------------------------------------------
+static uint64_t cb_profile_now()
+{
+#ifdef _CBC_PLAT_WNDS
+    return (uint64_t) ((double) clock() * 1e9 / CLOCKS_PER_SEC);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+#endif // _CBC_PLAT_WNDS
+}
+
+// -----------------------------------------------------------------------------
+// Get the statistics of a line, grow the table if necessary (internal)
+// -----------------------------------------------------------------------------
+static CbProfileLine* cb_profile_get_line(int line_no)
+{
+    size_t index = (line_no > 0) ? (size_t) line_no : 0;
+    
+    if (index >= line_count)
+    {
+        size_t count = (index + 1 > line_count * 2) ? index + 1 : line_count * 2;
+        lines        = (CbProfileLine*) realloc(lines, count *
+                                                sizeof(CbProfileLine));
+        memset(lines + line_count, 0, (count - line_count) *
+                                      sizeof(CbProfileLine));
+        line_count   = count;
+    }
+    
+    return &lines[index];
+}
+
+// -----------------------------------------------------------------------------
+// Get the index of a function, add the function if necessary (internal)
+// -----------------------------------------------------------------------------
+static size_t cb_profile_get_function(const char* name)
+{
+    // the names are usually the same strings of the syntax-tree, the string
+    // is compared anyway, since a freed name's memory may be reused
+    size_t slot = ((uintptr_t) name >> 4) & (CB_PROFILE_NAME_CACHE_SIZE - 1);
+    if (name_cache[slot] == name &&
+        strcmp(functions[name_cache_index[slot]].name, name) == 0)
+        return name_cache_index[slot];
+    
+    CbValue* key   = cb_string_create(strdup(name));
+    CbValue* index = cb_hash_get(function_index, key);
+    size_t result  = function_count;
+    
+    if (index)
+        result = (size_t) cb_numeric_get(index);
+    else
+    {
+        functions = (CbProfileFunction*) realloc(functions,
+                        (function_count + 1) * sizeof(CbProfileFunction));
+        
+        CbProfileFunction* function = &functions[function_count++];
+        memset(function, 0, sizeof(CbProfileFunction));
+        function->name = strdup(name);
+        
+        cb_hash_set(function_index, key, cb_numeric_create(result));
+    }
+    
+    cb_value_free(key);
+    
+    name_cache[slot]       = name;
+    name_cache_index[slot] = result;
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Begin a new frame of the function (internal)
+// -----------------------------------------------------------------------------
+static void cb_profile_push_frame(size_t function)
+{
+    if (frame_depth == frame_capacity)
+    {
+        frame_capacity = (frame_capacity) ? frame_capacity * 2 : 64;
+        frames         = (CbProfileFrame*) realloc(frames, frame_capacity *
+                                                   sizeof(CbProfileFrame));
+    }
+    
+    CbProfileFrame* frame = &frames[frame_depth++];
+    frame->function       = function;
+    frame->path_length    = path.length;
+    frame->children       = 0;
+    
+    if (frame_depth > 1)
+        cb_strbuf_append_char(&path, ';');
+    
+    const char* name = (function == (size_t) -1) ? CB_PROFILE_ROOT_FRAME
+                                                 : functions[function].name;
+    cb_strbuf_append_string(&path, name);
+    
+    frame->start = cb_profile_now();
+}
+
+// -----------------------------------------------------------------------------
+// End the current frame and account its time (internal)
+// -----------------------------------------------------------------------------
+static void cb_profile_pop_frame()
+{
+    CbProfileFrame* frame = &frames[--frame_depth];
+    uint64_t elapsed      = cb_profile_now() - frame->start;
+    uint64_t exclusive    = elapsed - frame->children;
+    
+    if (frame_depth > 0)
+        frames[frame_depth - 1].children += elapsed;
+    
+    if (frame->function != (size_t) -1)
+    {
+        CbProfileFunction* function = &functions[frame->function];
+        function->exclusive += exclusive;
+        if (--function->active == 0) // count recursive calls once
+            function->inclusive += elapsed;
+    }
+    
+    cb_profile_add_stack(cb_strbuf_get_string(&path), exclusive);
+    path.length = frame->path_length;
+}
+
+// -----------------------------------------------------------------------------
+// Compare line indices by exclusive time, descending (internal)
+// -----------------------------------------------------------------------------
+static int cb_profile_compare_lines(const void* a, const void* b)
+{
+    uint64_t l = lines[*(const size_t*) a].exclusive;
+    uint64_t r = lines[*(const size_t*) b].exclusive;
+    
+    return (l < r) - (l > r);
+}
+
+// -----------------------------------------------------------------------------
+// Compare functions by exclusive time, descending (internal)
+// -----------------------------------------------------------------------------
+static int cb_profile_compare_functions(const void* a, const void* b)
+{
+    uint64_t l = (*(const CbProfileFunction* const*) a)->exclusive;
+    uint64_t r = (*(const CbProfileFunction* const*) b)->exclusive;
+    
+    return (l < r) - (l > r);
+}
+
+// -----------------------------------------------------------------------------
+// Read the first lines of the source file (NULL, if not available) (internal)
+//
+//    The lines are indexed by their line number, leading white-space is
+//    skipped.
+// -----------------------------------------------------------------------------
+static char** cb_profile_read_source(const char* source_name, size_t count)
+{
+    CbReader* reader = (source_name) ? cb_reader_open(source_name) : NULL;
+    if (reader == NULL)
+        return NULL;
+    
+    char** source    = (char**) calloc(count + 1, sizeof(char*));
+    const char* line = NULL;
+    size_t length    = 0;
+    
+    size_t line_no = 1;
+    for (; line_no < count && cb_reader_read_line(reader, &line, &length);
+         line_no++)
+    {
+        while (length > 0 && (*line == ' ' || *line == '\t'))
+        {
+            line++;
+            length--;
+        }
+        
+        source[line_no] = (char*) malloc(length + 1);
+        memcpy(source[line_no], line, length);
+        source[line_no][length] = '\0';
+    }
+    
+    cb_reader_free(reader);
+    
+    return source;
+}
+
+// -----------------------------------------------------------------------------
+// Take a sample of the executed line and the calls (internal)
+//
+//    Runs as signal handler, so it only writes the next slot of the ring
+//    buffer. The sample is dropped, if the ring buffer is full.
+// -----------------------------------------------------------------------------
+static void cb_profile_handle_signal(int signal_number)
+{
+    (void) signal_number;
+    
+    size_t head = ring_head;
+    if (!sampling || ring == NULL)
+        return;
+    
+    if (head - ring_tail >= CB_PROFILE_RING_SIZE)
+    {
+        sample_dropped++;
+        return;
+    }
+    
+    CbProfileSample* sample = &ring[head & (CB_PROFILE_RING_SIZE - 1)];
+    CbSyntree* node         = current_node;
+    size_t depth            = call_depth;
+    if (depth > CB_PROFILE_SAMPLE_FRAMES)
+        depth = CB_PROFILE_SAMPLE_FRAMES;
+    
+    sample->line_no = (node) ? node->line_no : 0;
+    sample->depth   = (int) depth;
+    
+    size_t i = 0;
+    for (; i < depth; i++)
+    {
+        sample->function[i]  = call_function[i];
+        sample->call_line[i] = call_line[i];
+    }
+    
+    ring_head = head + 1; // publish the sample
+}
+
+// -----------------------------------------------------------------------------
+// Account the samples of the ring buffer (internal)
+// -----------------------------------------------------------------------------
+static void cb_profile_drain()
+{
+    size_t tail = ring_tail;
+    
+    for (; tail != ring_head; tail++)
+    {
+        cb_profile_account_sample(&ring[tail & (CB_PROFILE_RING_SIZE - 1)]);
+        ring_tail = tail + 1; // release the slot
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Account a sample as interval of the executed line and the calls (internal)
+//
+//    The line and the innermost function get exclusive time, the line and
+//    the lines of the calls as well as the called functions get inclusive
+//    time, each once per sample.
+// -----------------------------------------------------------------------------
+static void cb_profile_account_sample(const CbProfileSample* sample)
+{
+    uint64_t time = sample_interval;
+    int depth     = sample->depth;
+    sample_count++;
+    
+    CbProfileLine* line = cb_profile_get_line(sample->line_no);
+    line->count++;
+    line->exclusive += time;
+    line->inclusive += time;
+    
+    CbStrbuf stack;
+    cb_strbuf_init(&stack);
+    cb_strbuf_append_string(&stack, CB_PROFILE_ROOT_FRAME);
+    
+    int i = 0;
+    for (; i < depth; i++)
+    {
+        bool seen_line     = sample->call_line[i] == sample->line_no;
+        bool seen_function = false;
+        
+        int j = 0;
+        for (; j < i; j++)
+        {
+            seen_line     |= sample->call_line[j] == sample->call_line[i];
+            seen_function |= sample->function[j] == sample->function[i];
+        }
+        
+        if (!seen_line)
+            cb_profile_get_line(sample->call_line[i])->inclusive += time;
+        
+        CbProfileFunction* function = &functions[sample->function[i]];
+        if (!seen_function)
+            function->inclusive += time;
+        if (i == depth - 1)
+            function->exclusive += time;
+        
+        cb_strbuf_append_char(&stack, ';');
+        cb_strbuf_append_string(&stack, function->name);
+    }
+    
+    cb_profile_add_stack(cb_strbuf_get_string(&stack), time);
+    cb_strbuf_release(&stack);
+}
+
+// -----------------------------------------------------------------------------
+// Accumulate the exclusive time of a stack-path (internal)
+// -----------------------------------------------------------------------------
+static void cb_profile_add_stack(const char* stack, uint64_t time)
+{
+    CbValue* key   = cb_string_create(strdup(stack));
+    CbValue* value = cb_hash_get(stacks, key);
+    if (value)
+        cb_numeric_set(value, cb_numeric_get(value) + (CbNumeric) time);
+    else
+        cb_hash_set(stacks, key, cb_numeric_create((CbNumeric) time));
+    
+    cb_value_free(key);
+}
+
+// -----------------------------------------------------------------------------
+// Account the time of a node, whose evaluation ended (internal)
+// -----------------------------------------------------------------------------
+static void cb_profile_leave_node(size_t depth)
+{
+    // the arrays may have been moved by nested evaluations
+    uint64_t elapsed = cb_profile_now() - nodes[depth].start;
+    node_depth       = depth;
+    if (depth > 0)
+        nodes[depth - 1].children += elapsed;
+    
+    CbProfileLine* line = cb_profile_get_line(nodes[depth].line_no);
+    line->exclusive    += elapsed - nodes[depth].children;
+    if (--line->active == 0) // count nested nodes of the same line once
+        line->inclusive += elapsed;
+}
+
+// -----------------------------------------------------------------------------
+// Account the time of a node, if an error unwinds its evaluation (internal)
+// -----------------------------------------------------------------------------
+static void cb_profile_cleanup_node(void* depth)
+{
+    cb_profile_leave_node(*((size_t*) depth));
+}
@@ -0,0 +1,59 @@
+/*******************************************************************************
+ * CbProfile -- Implementation of an execution profiler
+ *
+ *              While the profiler is enabled, every evaluation of a syntax
+ *              node is counted and timed per line number, every call of a
+ *              function per function. Inclusive time contains the time of
+ *              nested nodes or called functions, exclusive time doesn't.
+ *
+ *              The report consists of hot spot tables sorted by exclusive
+ *              time and a file with collapsed stacks, as used by flame graph
+ *              tools ("frame;frame;frame microseconds" per line).
+ *
+ *              The sampling profiler doesn't time every node, instead a
+ *              SIGPROF timer samples the executed line and the calls of user
+ *              functions into a ring buffer. The evaluation just publishes
+ *              the current node, so tight loops aren't distorted. Its report
+ *              and collapsed stacks have the same format, counts of lines
+ *              are counts of samples.
+ *
+ *              If the profiler is disabled, cb_syntree_eval() doesn't enter
+ *              the profiler's dispatch path at all.
+ ******************************************************************************/
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "syntree_if.h"
+#include "symtab_if.h"
+#include "value.h"
+
+// default interval of the sampling profiler in microseconds
+#define CB_PROFILE_SAMPLE_INTERVAL 1000
+
+// evaluation function used by the profiler's dispatch path
+typedef CbValue* (*CbProfileEvalFunction)(CbSyntree* node, CbSymtab* symtab);
+
+// determines whether the profiler is enabled
+extern bool cb_profile_enabled;
+
+
+// interface functions
+void cb_profile_start();
+int cb_profile_start_sampling(int interval);
+void cb_profile_stop();
+void cb_profile_reset();
+
+CbValue* cb_profile_eval(CbSyntree* node, CbSymtab* symtab,
+                         CbProfileEvalFunction eval);
+void cb_profile_enter_function(const char* name);
+void cb_profile_leave_function();
+
+void cb_profile_report(FILE* output, const char* source_name);
+int cb_profile_write_stacks(const char* file_name);
+
+
+#endif // PROFILE_H
@@ -0,0 +1,294 @@
+/*******************************************************************************
+ * CbReader -- Implementation of a line-oriented input reader
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <assert.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef _CBC_PLAT_WNDS
+#include <io.h>
+#define STDIN_FILENO 0
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif // _CBC_PLAT_WNDS
+#include "reader.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+#define CB_READER_CHUNK_SIZE 65536
+
+struct CbReader
+{
+    int fd;                         // -1, if the fd isn't owned by the reader
+    bool mapped;                    // data is a memory mapping of the file
+    bool borrowed;                  // data is owned by the caller
+    char* data;                     // mapping or read buffer
+    size_t length;                  // length of the valid data
+    size_t capacity;                // allocated size of the read buffer
+    size_t position;                // start of the next line
+    bool eof;                       // no more data can be read from the fd
+    int read_fd;                    // fd used for reading
+};
+
+// current input of ReadLn(), stdin if not set
+static CbReader* current_input = NULL;
+static CbReader* stdin_reader  = NULL;
+
+static CbReader* cb_reader_create(int fd, bool owned);
+static bool cb_reader_fill(CbReader* reader);
+static void cb_reader_free_stdin();
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Open a file (NULL, if the file can't be opened)
+// -----------------------------------------------------------------------------
+CbReader* cb_reader_open(const char* file_name)
+{
+    int fd = open(file_name, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    
+    return cb_reader_create(fd, true);
+}
+
+// -----------------------------------------------------------------------------
+// Create a reader for an open file descriptor (not closed by the reader)
+// -----------------------------------------------------------------------------
+CbReader* cb_reader_create_fd(int fd)
+{
+    return cb_reader_create(fd, false);
+}
+
+// -----------------------------------------------------------------------------
+// Create a reader for data in memory (not copied, must outlive the reader)
+// -----------------------------------------------------------------------------
+CbReader* cb_reader_create_memory(const char* data, size_t length)
+{
+    CbReader* reader = cb_reader_create(-1, false);
+    reader->borrowed = true;
+    reader->data     = (char*) data;
+    reader->length   = length;
+    reader->eof      = true;
+    
+    return reader;
+}
+
+// -----------------------------------------------------------------------------
+// Destructor
+// -----------------------------------------------------------------------------
+void cb_reader_free(CbReader* reader)
+{
+    if (current_input == reader)
+        current_input = NULL;
+
+#ifndef _CBC_PLAT_WNDS
+    if (reader->mapped)
+        munmap(reader->data, reader->length);
+    else
+#endif // not _CBC_PLAT_WNDS
+    if (!reader->borrowed)
+        free(reader->data);
+    
+    if (reader->fd >= 0)
+        close(reader->fd);
+    
+    free(reader);
+}
+
+// -----------------------------------------------------------------------------
+// Read the next line (false, if there are no more lines)
+//
+//    The line doesn't include the line break and isn't null-terminated. It
+//    points into the reader and is valid until the next call only.
+// -----------------------------------------------------------------------------
+bool cb_reader_read_line(CbReader* reader, const char** line, size_t* length)
+{
+    size_t scanned = 0; // data after the position without a line break
+    char* end      = NULL;
+    
+    for (;;)
+    {
+        size_t available = reader->length - reader->position - scanned;
+        if (available > 0)
+            end = memchr(reader->data + reader->position + scanned, '\n',
+                         available);
+        if (end)
+            break;
+        
+        // the unscanned data is kept from the position on, when filling
+        scanned += available;
+        if (!cb_reader_fill(reader))
+            break;
+    }
+    
+    size_t start = reader->position;
+    size_t stop  = (end) ? (size_t) (end - reader->data) : reader->length;
+    
+    if (end == NULL && start == stop) // end of input
+        return false;
+    
+    reader->position = (end) ? stop + 1 : stop;
+    
+    if (stop > start && reader->data[stop - 1] == '\r') // CRLF line break
+        stop--;
+    
+    *line   = reader->data + start;
+    *length = stop - start;
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Read the remaining input at once
+//
+//    The returned string is null-terminated and must be freed after usage.
+// -----------------------------------------------------------------------------
+char* cb_reader_read_all(CbReader* reader, size_t* length)
+{
+    while (cb_reader_fill(reader))
+        ; // read up to the end of the input
+    
+    size_t count = reader->length - reader->position;
+    char* result = (char*) malloc(count + 1);
+    if (count > 0)
+        memcpy(result, reader->data + reader->position, count);
+    result[count] = '\0';
+    
+    reader->position = reader->length;
+    if (length)
+        *length = count;
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Get the current input (stdin by default)
+// -----------------------------------------------------------------------------
+CbReader* cb_reader_get_input()
+{
+    if (current_input)
+        return current_input;
+    
+    if (stdin_reader == NULL)
+    {
+        stdin_reader = cb_reader_create_fd(STDIN_FILENO);
+        atexit(cb_reader_free_stdin);
+    }
+    
+    return stdin_reader;
+}
+
+// -----------------------------------------------------------------------------
+// Set the current input (NULL resets it to stdin)
+// -----------------------------------------------------------------------------
+void cb_reader_set_input(CbReader* reader)
+{
+    current_input = reader;
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Create a reader, regular files are memory-mapped (internal)
+// -----------------------------------------------------------------------------
+static CbReader* cb_reader_create(int fd, bool owned)
+{
+    CbReader* reader = (CbReader*) malloc(sizeof(CbReader));
+    reader->fd       = (owned) ? fd : -1;
+    reader->read_fd  = fd;
+    reader->mapped   = false;
+    reader->borrowed = false;
+    reader->data     = NULL;
+    reader->length   = 0;
+    reader->capacity = 0;
+    reader->position = 0;
+    reader->eof      = false;
+
+#ifndef _CBC_PLAT_WNDS
+    struct stat info;
+    if (fd >= 0 && fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0)
+    {
+        void* data = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE,
+                          fd, 0);
+        if (data != MAP_FAILED)
+        {
+            madvise(data, (size_t) info.st_size, MADV_SEQUENTIAL);
+            
+            reader->mapped = true;
+            reader->data   = (char*) data;
+            reader->length = (size_t) info.st_size;
+            reader->eof    = true;
+        }
+    }
+#endif // not _CBC_PLAT_WNDS
+
+    return reader;
+}
+
+// -----------------------------------------------------------------------------
+// Read the next chunk of input into the buffer (internal)
+//
+//    Consumed data is dropped from the buffer. Returns false at the end of
+//    the input.
+// -----------------------------------------------------------------------------
+static bool cb_reader_fill(CbReader* reader)
+{
+    if (reader->eof)
+        return false;
+    
+    // drop consumed data, so the buffer only grows for very long lines
+    if (reader->position > 0)
+    {
+        memmove(reader->data, reader->data + reader->position,
+                reader->length - reader->position);
+        reader->length  -= reader->position;
+        reader->position = 0;
+    }
+    
+    if (reader->capacity - reader->length < CB_READER_CHUNK_SIZE)
+    {
+        reader->capacity = reader->length + CB_READER_CHUNK_SIZE;
+        reader->data     = (char*) realloc(reader->data, reader->capacity);
+    }
+    
+    for (;;)
+    {
+        ssize_t count = read(reader->read_fd, reader->data + reader->length,
+                             reader->capacity - reader->length);
+        if (count < 0 && errno == EINTR)
+            continue;
+        
+        if (count <= 0)
+        {
+            reader->eof = true;
+            return false;
+        }
+        
+        reader->length += (size_t) count;
+        return true;
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Free the stdin reader at program exit (internal)
+// -----------------------------------------------------------------------------
+static void cb_reader_free_stdin()
+{
+    cb_reader_free(stdin_reader);
+    stdin_reader = NULL;
+}
@@ -0,0 +1,34 @@
+/*******************************************************************************
+ * CbReader -- Implementation of a line-oriented input reader
+ *
+ *             Regular files are memory-mapped, so lines are returned as views
+ *             into the mapping without copying. Other input, such as pipes
+ *             and terminals, is read into a growing buffer.
+ *
+ *             The current input is read by ReadLn() and defaults to stdin.
+ ******************************************************************************/
+
+#ifndef READER_H
+#define READER_H
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+
+typedef struct CbReader CbReader;
+
+
+// interface functions
+CbReader* cb_reader_open(const char* file_name);
+CbReader* cb_reader_create_fd(int fd);
+CbReader* cb_reader_create_memory(const char* data, size_t length);
+void cb_reader_free(CbReader* reader);
+
+bool cb_reader_read_line(CbReader* reader, const char** line, size_t* length);
+char* cb_reader_read_all(CbReader* reader, size_t* length);
+
+CbReader* cb_reader_get_input();
+void cb_reader_set_input(CbReader* reader);
+
+
+#endif // READER_H
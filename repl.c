@@ -0,0 +1,322 @@
+/*******************************************************************************
+ * CbRepl -- Implementation of an interactive read-eval-print loop
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "repl.h"
+#include "codeblock.h"
+#include "cbc_parse.h"
+#include "builtin.h"
+#include "symtab.h"
+#include "strbuf.h"
+#include "error_handling.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+struct CbRepl
+{
+    CbSymtab* symtab;               // global symbol-table of the session
+    Codeblock** chunks;             // executed chunks
+    size_t chunk_count;
+    size_t chunk_capacity;
+    CbStrbuf pending;               // lines of the current chunk
+    FILE* parser_errors;            // error messages of parse attempts
+    const CbValue* result;          // result of the last chunk
+    bool error_handling_owned;      // error handling initialized by the REPL
+};
+
+static bool cb_repl_is_blank(const char* string, size_t length);
+static bool cb_repl_ends_with_comma(const CbStrbuf* buf);
+static Codeblock* cb_repl_parse(CbRepl* repl, const char* source,
+                                bool* incomplete);
+static enum cb_repl_status cb_repl_execute(CbRepl* repl, Codeblock* cb);
+static void cb_repl_report_parser_errors(CbRepl* repl, long begin, long end);
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Constructor
+// -----------------------------------------------------------------------------
+CbRepl* cb_repl_create()
+{
+    CbRepl* repl         = (CbRepl*) malloc(sizeof(CbRepl));
+    repl->symtab         = cb_symtab_create();
+    repl->chunks         = NULL;
+    repl->chunk_count    = 0;
+    repl->chunk_capacity = 0;
+    repl->parser_errors  = tmpfile();
+    repl->result         = NULL;
+    cb_strbuf_init(&repl->pending);
+    
+    register_builtin_all(repl->symtab); // registered once per session
+    
+    repl->error_handling_owned = !cb_error_handling_is_initialized();
+    if (repl->error_handling_owned)
+        cb_error_handling_initialize();
+    
+    return repl;
+}
+
+// -----------------------------------------------------------------------------
+// Destructor
+// -----------------------------------------------------------------------------
+void cb_repl_free(CbRepl* repl)
+{
+    // functions in the symbol-table refer to the syntax-trees of the chunks
+    cb_symtab_free(repl->symtab);
+    
+    size_t i = 0;
+    for (; i < repl->chunk_count; i++)
+        codeblock_free(repl->chunks[i]);
+    
+    if (repl->parser_errors)
+        fclose(repl->parser_errors);
+    
+    if (repl->error_handling_owned)
+        cb_error_handling_finalize();
+    
+    cb_strbuf_release(&repl->pending);
+    free(repl->chunks);
+    free(repl);
+}
+
+// -----------------------------------------------------------------------------
+// Add a line to the current chunk and execute the chunk, if it is complete
+// -----------------------------------------------------------------------------
+enum cb_repl_status cb_repl_eval_line(CbRepl* repl, const char* line,
+                                     size_t length)
+{
+    bool blank = cb_repl_is_blank(line, length);
+    
+    if (blank && cb_repl_is_blank(repl->pending.data, repl->pending.length))
+        return CB_REPL_OK; // nothing to do
+    
+    // messages of previous chunks aren't needed anymore
+    if (repl->pending.length == 0 && repl->parser_errors)
+        rewind(repl->parser_errors);
+    
+    cb_strbuf_append(&repl->pending, line, length);
+    cb_strbuf_append_char(&repl->pending, '\n');
+    
+    // the trailing comma of the last statement may be omitted
+    bool terminated = cb_repl_ends_with_comma(&repl->pending);
+    if (!terminated)
+        cb_strbuf_append_char(&repl->pending, ',');
+    
+    long begin      = (repl->parser_errors) ? ftell(repl->parser_errors) : 0;
+    bool incomplete = false;
+    Codeblock* cb   = cb_repl_parse(repl, cb_strbuf_get_string(&repl->pending),
+                                    &incomplete);
+    long end        = (repl->parser_errors) ? ftell(repl->parser_errors) : 0;
+    
+    if (!terminated)
+        repl->pending.length--;
+    
+    // without the comma, the chunk could be an incomplete expression
+    if (cb == NULL && !terminated && !incomplete)
+    {
+        begin = end;
+        cb    = cb_repl_parse(repl, cb_strbuf_get_string(&repl->pending),
+                              &incomplete);
+        end   = (repl->parser_errors) ? ftell(repl->parser_errors) : 0;
+    }
+    
+    if (cb == NULL && incomplete && !blank)
+        return CB_REPL_INCOMPLETE;
+    
+    repl->pending.length = 0;
+    
+    if (cb == NULL)
+    {
+        cb_repl_report_parser_errors(repl, begin, end);
+        return CB_REPL_ERROR;
+    }
+    
+    return cb_repl_execute(repl, cb);
+}
+
+// -----------------------------------------------------------------------------
+// Get the result of the last chunk (NULL, if it failed)
+// -----------------------------------------------------------------------------
+const CbValue* cb_repl_get_result(const CbRepl* repl)
+{
+    return repl->result;
+}
+
+// -----------------------------------------------------------------------------
+// Read and execute chunks, until the input ends
+//
+//    The results are written to the output. If the session is interactive,
+//    a prompt is written before every line. EXIT_FAILURE is returned, if the
+//    last chunk failed.
+// -----------------------------------------------------------------------------
+int cb_repl_run(CbRepl* repl, CbReader* input, CbOutput* output,
+                bool interactive)
+{
+    enum cb_repl_status status = CB_REPL_OK;
+    const char* line           = NULL;
+    size_t length              = 0;
+    
+    for (;;)
+    {
+        if (interactive)
+        {
+            const char* prompt = (status == CB_REPL_INCOMPLETE) ? "...> "
+                                                                : "cbc> ";
+            cb_output_write(output, prompt, strlen(prompt));
+            cb_output_flush(output);
+        }
+        
+        if (!cb_reader_read_line(input, &line, &length))
+            break;
+        
+        status = cb_repl_eval_line(repl, line, length);
+        
+        if (status == CB_REPL_OK && repl->result &&
+            !cb_value_is_type(repl->result, CB_VT_UNDEFINED))
+        {
+            cb_output_write_value(output, repl->result);
+            cb_output_write(output, "\n", 1);
+        }
+        
+        cb_output_flush(output);
+    }
+    
+    // execute or reject the incomplete input at the end
+    if (status == CB_REPL_INCOMPLETE)
+        status = cb_repl_eval_line(repl, "", 0);
+    
+    if (interactive)
+        cb_output_write(output, "\n", 1);
+    
+    cb_output_flush(output);
+    
+    return (status == CB_REPL_ERROR) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Check if a string contains white-space only (internal)
+// -----------------------------------------------------------------------------
+static bool cb_repl_is_blank(const char* string, size_t length)
+{
+    size_t i = 0;
+    for (; i < length; i++)
+        if (string[i] != ' ' && string[i] != '\t' && string[i] != '\r' &&
+            string[i] != '\n')
+            return false;
+    
+    return true;
+}
+
+// -----------------------------------------------------------------------------
+// Check if the last character, which isn't white-space, is a comma (internal)
+// -----------------------------------------------------------------------------
+static bool cb_repl_ends_with_comma(const CbStrbuf* buf)
+{
+    size_t i = buf->length;
+    while (i > 0 && cb_repl_is_blank(buf->data + i - 1, 1))
+        i--;
+    
+    return i > 0 && buf->data[i - 1] == ',';
+}
+
+// -----------------------------------------------------------------------------
+// Parse a chunk (NULL, if the chunk is invalid) (internal)
+//
+//    Error messages are written to the parser-errors file, since they are
+//    irrelevant, if the chunk is just incomplete. A chunk is incomplete, if
+//    the parser failed at the end of the input.
+// -----------------------------------------------------------------------------
+static Codeblock* cb_repl_parse(CbRepl* repl, const char* source,
+                                bool* incomplete)
+{
+    Codeblock* cb = codeblock_create();
+    
+    if (repl->parser_errors)
+        cb_set_error_output(repl->parser_errors);
+    
+    int result = codeblock_parse_string(cb, source);
+    
+    cb_set_error_output(stderr);
+    
+    if (incomplete)
+        *incomplete = result != EXIT_SUCCESS && yychar == ENDOFFILE;
+    
+    if (result != EXIT_SUCCESS)
+    {
+        codeblock_free(cb);
+        return NULL;
+    }
+    
+    return cb;
+}
+
+// -----------------------------------------------------------------------------
+// Execute a chunk against the global symbol-table (internal)
+//
+//    The chunk is kept, since declared functions refer to its syntax-tree.
+// -----------------------------------------------------------------------------
+static enum cb_repl_status cb_repl_execute(CbRepl* repl, Codeblock* cb)
+{
+    if (repl->chunk_count == repl->chunk_capacity)
+    {
+        repl->chunk_capacity = (repl->chunk_capacity) ? repl->chunk_capacity * 2
+                                                      : 16;
+        repl->chunks         = (Codeblock**) realloc(repl->chunks,
+                                   repl->chunk_capacity * sizeof(Codeblock*));
+    }
+    
+    repl->chunks[repl->chunk_count++] = cb;
+    
+    cb_error_clear();
+    repl->result = NULL;
+    
+    if (codeblock_execute_with_symtab(cb, repl->symtab) != EXIT_SUCCESS ||
+        cb_error_is_set())
+        return CB_REPL_ERROR;
+    
+    repl->result = cb->result;
+    
+    return CB_REPL_OK;
+}
+
+// -----------------------------------------------------------------------------
+// Print the error messages written between two positions (internal)
+// -----------------------------------------------------------------------------
+static void cb_repl_report_parser_errors(CbRepl* repl, long begin, long end)
+{
+    if (repl->parser_errors == NULL)
+        return;
+    
+    char buffer[512];
+    fseek(repl->parser_errors, begin, SEEK_SET);
+    
+    while (begin < end)
+    {
+        size_t count = (size_t) (end - begin);
+        if (count > sizeof(buffer))
+            count = sizeof(buffer);
+        
+        count = fread(buffer, 1, count, repl->parser_errors);
+        if (count == 0)
+            break;
+        
+        fwrite(buffer, 1, count, stderr);
+        begin += (long) count;
+    }
+    
+    fseek(repl->parser_errors, 0, SEEK_END);
+}
@@ -0,0 +1,46 @@
+/*******************************************************************************
+ * CbRepl -- Implementation of an interactive read-eval-print loop
+ *
+ *           Every chunk of input is parsed and executed on its own against a
+ *           global symbol-table, which persists for the whole session. So
+ *           variables and functions declared by a chunk are available to all
+ *           following chunks, the builtin symbols are registered only once.
+ *
+ *           A chunk ends with a line, which completes a statement. The
+ *           trailing comma of a chunk's last statement is optional. An empty
+ *           line discards incomplete input.
+ ******************************************************************************/
+
+#ifndef REPL_H
+#define REPL_H
+
+
+#include <stdbool.h>
+#include "value.h"
+#include "output.h"
+#include "reader.h"
+
+typedef struct CbRepl CbRepl;
+
+// result of evaluating a line
+enum cb_repl_status
+{
+    CB_REPL_OK,                     // chunk was executed successfully
+    CB_REPL_INCOMPLETE,             // chunk needs more lines
+    CB_REPL_ERROR                   // chunk failed to parse or to execute
+};
+
+
+// interface functions
+CbRepl* cb_repl_create();
+void cb_repl_free(CbRepl* repl);
+
+enum cb_repl_status cb_repl_eval_line(CbRepl* repl, const char* line,
+                                     size_t length);
+const CbValue* cb_repl_get_result(const CbRepl* repl);
+
+int cb_repl_run(CbRepl* repl, CbReader* input, CbOutput* output,
+                bool interactive);
+
+
+#endif // REPL_H
@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "scope.h"
+#include "alloc.h"
 
 
 // #############################################################################
@@ -16,8 +17,8 @@
 // -----------------------------------------------------------------------------
 CbScope* cb_scope_create(char* context, int level)
 {
-    CbScope* scope = malloc(sizeof(CbScope));
-    scope->context = strdup(context);
+    CbScope* scope = cb_alloc(sizeof(CbScope), CB_ALLOC_SYMBOL);
+    scope->context = cb_alloc_strdup(context, CB_ALLOC_SYMBOL);
     scope->level   = level;
     
     return scope;
@@ -28,8 +29,8 @@ CbScope* cb_scope_create(char* context, int level)
 // -----------------------------------------------------------------------------
 void cb_scope_free(CbScope* scope)
 {
-    free(scope->context);
-    free(scope);
+    cb_free(scope->context, CB_ALLOC_SYMBOL);
+    cb_free(scope, CB_ALLOC_SYMBOL);
 }
 
 // -----------------------------------------------------------------------------
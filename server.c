@@ -0,0 +1,728 @@
+/*******************************************************************************
+ * CbServer -- Implementation of a daemon executing codeblocks
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include "server.h"
+#include "error_handling.h"
+
+#ifndef _CBC_PLAT_WNDS
+#include <unistd.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include "codeblock.h"
+#include "cblib.h"
+#include "image.h"
+#include "output.h"
+#include "reader.h"
+#include "strbuf.h"
+#include "syntree.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+// cached syntax-tree of a script
+typedef struct
+{
+    char* script;                   // script (NULL, if the entry is unused)
+    size_t length;                  // length of the script
+    uint64_t hash;                  // hash of the script
+    Codeblock* cb;                  // codeblock holding the syntax-tree
+    unsigned long last_used;        // value of the cache clock on last use
+} CbServerCacheEntry;
+
+static CbServerCacheEntry cache[CB_SERVER_CACHE_SIZE];
+static unsigned long cache_clock = 0;
+
+// limits of every request
+static CbLimits request_limits = { CB_SERVER_MAX_STEPS, CB_SERVER_TIMEOUT,
+                                   0, 0 };
+
+// set by SIGINT/SIGTERM to stop the daemon
+static volatile sig_atomic_t stop_requested = 0;
+
+static void cb_server_handle_signal(int signal_number);
+static pid_t cb_server_start_worker(int listen_fd);
+static void cb_server_worker(int listen_fd);
+static void cb_server_serve_connection(int fd);
+static int cb_server_execute(int fd, const char* script, size_t script_length,
+                             const char* input, size_t input_length);
+static Codeblock* cb_server_compile(const char* script, size_t script_length,
+                                    FILE* errors);
+static uint64_t cb_server_hash(const char* data, size_t length);
+static int cb_server_read_full(int fd, void* data, size_t length);
+static int cb_server_write_full(int fd, struct iovec* iov, int count);
+static double cb_server_now();
+static int cb_server_compare_double(const void* a, const void* b);
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Run the daemon until SIGINT or SIGTERM is received
+//
+//    If worker_count isn't positive, a worker per processor is started. If
+//    limits is NULL, the default limits of a request are used.
+// -----------------------------------------------------------------------------
+int cb_server_run(const char* socket_name, int worker_count,
+                  const CbLimits* limits)
+{
+    if (limits)
+        request_limits = *limits;
+    
+    if (worker_count <= 0)
+        worker_count = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    if (worker_count <= 0)
+        worker_count = 1;
+    
+    struct sockaddr_un address;
+    if (strlen(socket_name) >= sizeof(address.sun_path))
+    {
+        cb_print_error_msg("Socket name too long `%s'", socket_name);
+        return EXIT_FAILURE;
+    }
+    
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_name);
+    
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_name); // remove a stale socket of a previous run
+    
+    if (listen_fd < 0 ||
+        bind(listen_fd, (struct sockaddr*) &address, sizeof(address)) != 0 ||
+        listen(listen_fd, SOMAXCONN) != 0)
+    {
+        cb_print_error_msg("Unable to listen on `%s': %s", socket_name,
+                           strerror(errno));
+        if (listen_fd >= 0)
+            close(listen_fd);
+        
+        return EXIT_FAILURE;
+    }
+    
+    // no SA_RESTART, so wait() is interrupted by the signals
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = cb_server_handle_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN); // clients may disconnect at any time
+    
+    pid_t* workers = (pid_t*) malloc(worker_count * sizeof(pid_t));
+    
+    int i = 0;
+    for (; i < worker_count; i++)
+        workers[i] = cb_server_start_worker(listen_fd);
+    
+    // restart workers, which terminated unexpectedly
+    while (!stop_requested)
+    {
+        pid_t pid = wait(NULL);
+        if (pid < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            
+            break;
+        }
+        
+        for (i = 0; i < worker_count && !stop_requested; i++)
+            if (workers[i] == pid)
+                workers[i] = cb_server_start_worker(listen_fd);
+    }
+    
+    for (i = 0; i < worker_count; i++)
+        if (workers[i] > 0)
+            kill(workers[i], SIGTERM);
+    
+    while (wait(NULL) > 0 || errno == EINTR)
+        ; // wait for all workers
+    
+    free(workers);
+    close(listen_fd);
+    unlink(socket_name);
+    
+    return EXIT_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+// Connect to a daemon (-1, if the connection failed)
+// -----------------------------------------------------------------------------
+int cb_server_connect(const char* socket_name)
+{
+    struct sockaddr_un address;
+    if (strlen(socket_name) >= sizeof(address.sun_path))
+        return -1;
+    
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket_name);
+    
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 &&
+        connect(fd, (struct sockaddr*) &address, sizeof(address)) != 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+    
+    return fd;
+}
+
+// -----------------------------------------------------------------------------
+// Send a request and receive its response
+//
+//    The response has to be released by cb_server_response_release().
+// -----------------------------------------------------------------------------
+int cb_server_request(int fd, const char* script, size_t script_length,
+                      const char* input, size_t input_length,
+                      CbServerResponse* response)
+{
+    CbServerRequestHeader request;
+    request.script_length = (uint32_t) script_length;
+    request.input_length  = (uint32_t) input_length;
+    
+    struct iovec iov[3] = {
+        {&request, sizeof(request)},
+        {(void*) script, script_length},
+        {(void*) input, input_length}
+    };
+    
+    CbServerResponseHeader header;
+    if (cb_server_write_full(fd, iov, 3) != EXIT_SUCCESS ||
+        cb_server_read_full(fd, &header, sizeof(header)) != EXIT_SUCCESS)
+        return EXIT_FAILURE;
+    
+    response->status        = (enum cb_server_status) header.status;
+    response->output_length = header.output_length;
+    response->result_length = header.result_length;
+    response->output        = (char*) malloc(header.output_length + 1);
+    response->result        = (char*) malloc(header.result_length + 1);
+    
+    response->output[header.output_length] = '\0';
+    response->result[header.result_length] = '\0';
+    
+    if (cb_server_read_full(fd, response->output,
+                            header.output_length) != EXIT_SUCCESS ||
+        cb_server_read_full(fd, response->result,
+                            header.result_length) != EXIT_SUCCESS)
+    {
+        cb_server_response_release(response);
+        return EXIT_FAILURE;
+    }
+    
+    return EXIT_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+// Release the buffers of a response
+// -----------------------------------------------------------------------------
+void cb_server_response_release(CbServerResponse* response)
+{
+    free(response->output);
+    free(response->result);
+    response->output = NULL;
+    response->result = NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Generate load on a daemon and print requests per second and latencies
+//
+//    Every connection is served by a process of its own, sending its share
+//    of the requests one after another.
+// -----------------------------------------------------------------------------
+int cb_server_load_test(const char* socket_name, const char* file_name,
+                        int request_count, int connection_count)
+{
+    CbReader* reader = cb_reader_open(file_name);
+    if (!reader)
+    {
+        cb_print_error_msg("Unable to open file `%s'", file_name);
+        return EXIT_FAILURE;
+    }
+    
+    size_t script_length = 0;
+    char* script         = cb_reader_read_all(reader, &script_length);
+    cb_reader_free(reader);
+    
+    // warm-up request, which also shows the result
+    CbServerResponse response;
+    int fd = cb_server_connect(socket_name);
+    if (fd < 0 || cb_server_request(fd, script, script_length, NULL, 0,
+                                    &response) != EXIT_SUCCESS)
+    {
+        cb_print_error_msg("Unable to send request to `%s'", socket_name);
+        if (fd >= 0)
+            close(fd);
+        
+        free(script);
+        return EXIT_FAILURE;
+    }
+    
+    printf("%s: %s\n", (response.status == CB_SERVER_OK) ? "Result" : "Error",
+           response.result);
+    cb_server_response_release(&response);
+    close(fd);
+    
+    // latencies are collected in shared memory, errors are marked negative
+    size_t size      = request_count * sizeof(double);
+    double* latency  = (double*) mmap(NULL, size, PROT_READ | PROT_WRITE,
+                                      MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (latency == MAP_FAILED)
+    {
+        free(script);
+        return EXIT_FAILURE;
+    }
+    
+    double begin = cb_server_now();
+    
+    int connection = 0;
+    for (; connection < connection_count; connection++)
+    {
+        if (fork() != 0)
+            continue;
+        
+        // client process
+        fd = cb_server_connect(socket_name);
+        
+        int i = connection;
+        for (; i < request_count; i += connection_count)
+        {
+            double start = cb_server_now();
+            int result   = (fd < 0) ? EXIT_FAILURE
+                                    : cb_server_request(fd, script,
+                                                        script_length, NULL,
+                                                        0, &response);
+            latency[i] = cb_server_now() - start;
+            
+            if (result != EXIT_SUCCESS)
+                latency[i] = -1;
+            else
+            {
+                if (response.status != CB_SERVER_OK)
+                    latency[i] = -1;
+                
+                cb_server_response_release(&response);
+            }
+        }
+        
+        _exit(EXIT_SUCCESS);
+    }
+    
+    while (wait(NULL) > 0 || errno == EINTR)
+        ; // wait for all clients
+    
+    double duration = cb_server_now() - begin;
+    
+    int errors = 0;
+    int count  = 0;
+    double sum = 0;
+    
+    int i = 0;
+    for (; i < request_count; i++)
+    {
+        if (latency[i] < 0)
+            errors++;
+        else
+        {
+            latency[count++] = latency[i];
+            sum             += latency[i];
+        }
+    }
+    
+    qsort(latency, count, sizeof(double), cb_server_compare_double);
+    
+    printf("Requests:    %d (%d errors) over %d connections\n", request_count,
+           errors, connection_count);
+    printf("Duration:    %.3f s\n", duration);
+    printf("Throughput:  %.0f requests/s\n", request_count / duration);
+    
+    if (count > 0)
+        printf("Latency:     avg %.3f ms, p50 %.3f ms, p90 %.3f ms, "
+               "p99 %.3f ms, max %.3f ms\n", sum / count * 1000,
+               latency[count / 2] * 1000, latency[count * 90 / 100] * 1000,
+               latency[count * 99 / 100] * 1000, latency[count - 1] * 1000);
+    
+    munmap(latency, size);
+    free(script);
+    
+    return (errors == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Signal handler of the daemon (internal)
+// -----------------------------------------------------------------------------
+static void cb_server_handle_signal(int signal_number)
+{
+    (void) signal_number;
+    stop_requested = 1;
+}
+
+// -----------------------------------------------------------------------------
+// Fork a worker process (internal)
+// -----------------------------------------------------------------------------
+static pid_t cb_server_start_worker(int listen_fd)
+{
+    pid_t pid = fork();
+    
+    if (pid == 0)
+    {
+        signal(SIGINT, SIG_DFL);
+        signal(SIGTERM, SIG_DFL);
+        
+        cb_server_worker(listen_fd);
+        _exit(EXIT_SUCCESS);
+    }
+    
+    return pid;
+}
+
+// -----------------------------------------------------------------------------
+// Accept and serve connections (internal)
+// -----------------------------------------------------------------------------
+static void cb_server_worker(int listen_fd)
+{
+    // initialized once, instead of once per execution
+    cb_error_handling_initialize();
+    
+    for (;;)
+    {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            
+            break;
+        }
+        
+        cb_server_serve_connection(fd);
+        close(fd);
+    }
+    
+    cb_error_handling_finalize();
+}
+
+// -----------------------------------------------------------------------------
+// Serve the requests of a connection, until it is closed (internal)
+// -----------------------------------------------------------------------------
+static void cb_server_serve_connection(int fd)
+{
+    CbServerRequestHeader header;
+    char* payload           = NULL;
+    size_t payload_capacity = 0;
+    
+    while (cb_server_read_full(fd, &header, sizeof(header)) == EXIT_SUCCESS)
+    {
+        size_t length = (size_t) header.script_length + header.input_length;
+        if (length > CB_SERVER_MAX_REQUEST)
+            break;
+        
+        if (length + 1 > payload_capacity)
+        {
+            payload_capacity = length + 1;
+            payload          = (char*) realloc(payload, payload_capacity);
+        }
+        
+        if (cb_server_read_full(fd, payload, length) != EXIT_SUCCESS ||
+            cb_server_execute(fd, payload, header.script_length,
+                              payload + header.script_length,
+                              header.input_length) != EXIT_SUCCESS)
+            break;
+    }
+    
+    free(payload);
+}
+
+// -----------------------------------------------------------------------------
+// Execute a request and send the response (internal)
+// -----------------------------------------------------------------------------
+static int cb_server_execute(int fd, const char* script, size_t script_length,
+                             const char* input, size_t input_length)
+{
+    // error messages of parser and codeblock are sent as result
+    char* errors_text  = NULL;
+    size_t errors_size = 0;
+    FILE* errors       = open_memstream(&errors_text, &errors_size);
+    cb_set_error_output(errors);
+    cb_error_clear();
+    
+    Codeblock* cb    = cb_server_compile(script, script_length, errors);
+    CbOutput* output = cb_output_create_memory();
+    CbStrbuf result;
+    cb_strbuf_init(&result);
+    
+    bool success = false;
+    if (cb)
+    {
+        CbReader* reader = cb_reader_create_memory(input, input_length);
+        cb_reader_set_input(reader);
+        
+        cb->output = output;
+        cb->limits = &request_limits;
+        success    = codeblock_execute(cb) == EXIT_SUCCESS &&
+                     !cb_error_is_set();
+        cb->output = NULL;
+        
+        cb_reader_set_input(NULL);
+        cb_reader_free(reader);
+        
+        // files left open by the script aren't passed to the next request
+        cb_lib_close_files();
+        
+        if (success)
+            cb_value_format(&result, cb->result);
+    }
+    
+    cb_set_error_output(stderr);
+    fclose(errors);
+    
+    size_t output_length    = 0;
+    const char* output_data = cb_output_get_memory(output, &output_length);
+    
+    CbServerResponseHeader header;
+    header.status        = (success) ? CB_SERVER_OK : CB_SERVER_ERROR;
+    header.output_length = (uint32_t) output_length;
+    header.result_length = (uint32_t) ((success) ? result.length : errors_size);
+    
+    struct iovec iov[3] = {
+        {&header, sizeof(header)},
+        {(void*) output_data, output_length},
+        {(success) ? result.data : errors_text, header.result_length}
+    };
+    
+    int status = cb_server_write_full(fd, iov, 3);
+    
+    cb_strbuf_release(&result);
+    cb_output_free(output);
+    free(errors_text);
+    
+    return status;
+}
+
+// -----------------------------------------------------------------------------
+// Get the codeblock of a script from the cache or compile it (internal)
+//
+//    NULL is returned, if the script is invalid. The least recently used
+//    script is dropped from a full cache.
+// -----------------------------------------------------------------------------
+static Codeblock* cb_server_compile(const char* script, size_t script_length,
+                                    FILE* errors)
+{
+    uint64_t hash             = cb_server_hash(script, script_length);
+    CbServerCacheEntry* entry = &cache[0];
+    
+    int i = 0;
+    for (; i < CB_SERVER_CACHE_SIZE; i++)
+    {
+        CbServerCacheEntry* current = &cache[i];
+        
+        if (current->script && current->hash == hash &&
+            current->length == script_length &&
+            memcmp(current->script, script, script_length) == 0)
+        {
+            current->last_used = ++cache_clock;
+            return current->cb;
+        }
+        
+        if (current->last_used < entry->last_used)
+            entry = current;
+    }
+    
+    // compile the script
+    Codeblock* cb = codeblock_create();
+    int result    = EXIT_FAILURE;
+    
+    if (cb_image_is_image(script, script_length))
+    {
+        cb->ast = cb_image_read(script, script_length);
+        if (cb->ast)
+            result = EXIT_SUCCESS;
+        else
+            fprintf(errors, "Error: Invalid or corrupted image\n");
+    }
+    else
+    {
+        char* source = (char*) malloc(script_length + 1);
+        memcpy(source, script, script_length);
+        source[script_length] = '\0';
+        
+        result = codeblock_parse_string(cb, source);
+        free(source);
+    }
+    
+    if (result != EXIT_SUCCESS)
+    {
+        codeblock_free(cb);
+        return NULL;
+    }
+    
+    // replace least recently used entry
+    if (entry->script)
+    {
+        free(entry->script);
+        codeblock_free(entry->cb);
+    }
+    
+    entry->script    = (char*) malloc(script_length + 1);
+    entry->length    = script_length;
+    entry->hash      = hash;
+    entry->cb        = cb;
+    entry->last_used = ++cache_clock;
+    memcpy(entry->script, script, script_length);
+    
+    return cb;
+}
+
+// -----------------------------------------------------------------------------
+// FNV-1a hash of a script (internal)
+// -----------------------------------------------------------------------------
+static uint64_t cb_server_hash(const char* data, size_t length)
+{
+    uint64_t h = 0xCBF29CE484222325ULL;
+    
+    size_t i = 0;
+    for (; i < length; i++)
+    {
+        h ^= (unsigned char) data[i];
+        h *= 0x100000001B3ULL;
+    }
+    
+    return h;
+}
+
+// -----------------------------------------------------------------------------
+// Read exactly length bytes (internal)
+// -----------------------------------------------------------------------------
+static int cb_server_read_full(int fd, void* data, size_t length)
+{
+    char* position = (char*) data;
+    
+    while (length > 0)
+    {
+        ssize_t count = read(fd, position, length);
+        if (count < 0 && errno == EINTR)
+            continue;
+        
+        if (count <= 0)
+            return EXIT_FAILURE;
+        
+        position += count;
+        length   -= (size_t) count;
+    }
+    
+    return EXIT_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+// Write all buffers, continuing after partial writes (internal)
+// -----------------------------------------------------------------------------
+static int cb_server_write_full(int fd, struct iovec* iov, int count)
+{
+    while (count > 0)
+    {
+        ssize_t written = writev(fd, iov, count);
+        if (written < 0 && errno == EINTR)
+            continue;
+        
+        if (written < 0)
+            return EXIT_FAILURE;
+        
+        // skip the written buffers
+        while (count > 0 && (size_t) written >= iov->iov_len)
+        {
+            written -= (ssize_t) iov->iov_len;
+            iov++;
+            count--;
+        }
+        
+        if (count > 0)
+        {
+            iov->iov_base  = (char*) iov->iov_base + written;
+            iov->iov_len  -= (size_t) written;
+        }
+    }
+    
+    return EXIT_SUCCESS;
+}
+
+// -----------------------------------------------------------------------------
+// Get a monotonic time stamp in seconds (internal)
+// -----------------------------------------------------------------------------
+static double cb_server_now()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+// -----------------------------------------------------------------------------
+// Compare two doubles for qsort() (internal)
+// -----------------------------------------------------------------------------
+static int cb_server_compare_double(const void* a, const void* b)
+{
+    double l = *(const double*) a;
+    double r = *(const double*) b;
+    
+    return (l > r) - (l < r);
+}
+
+
+#else // _CBC_PLAT_WNDS
+
+// #############################################################################
+// interface-functions (Unix domain sockets aren't supported)
+// #############################################################################
+
+int cb_server_run(const char* socket_name, int worker_count,
+                  const CbLimits* limits)
+{
+    cb_print_error_msg("Daemon mode isn't supported on this platform");
+    return EXIT_FAILURE;
+}
+
+int cb_server_connect(const char* socket_name)
+{
+    return -1;
+}
+
+int cb_server_request(int fd, const char* script, size_t script_length,
+                      const char* input, size_t input_length,
+                      CbServerResponse* response)
+{
+    return EXIT_FAILURE;
+}
+
+void cb_server_response_release(CbServerResponse* response)
+{
+}
+
+int cb_server_load_test(const char* socket_name, const char* file_name,
+                        int request_count, int connection_count)
+{
+    cb_print_error_msg("Daemon mode isn't supported on this platform");
+    return EXIT_FAILURE;
+}
+
+#endif // _CBC_PLAT_WNDS
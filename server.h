@@ -0,0 +1,88 @@
+/*******************************************************************************
+ * CbServer -- Implementation of a daemon executing codeblocks
+ *
+ *             The daemon listens on a Unix domain socket. Requests are served
+ *             by a pool of pre-forked worker processes, so every worker owns
+ *             its parser and error state. A connection may carry any number
+ *             of requests, each answered by a response before the next
+ *             request is read.
+ *
+ *             Request:  CbServerRequestHeader, script (source text or
+ *                       compiled image), input of ReadLn()
+ *             Response: CbServerResponseHeader, output of the script, result
+ *                       (or error message, if status is CB_SERVER_ERROR)
+ *
+ *             Each worker caches the syntax-trees of the recently executed
+ *             scripts, so a script is only parsed on its first request.
+ *
+ *             Every request is executed with limits (see exec_limits.h), so a
+ *             runaway script can't occupy a worker. Without explicit limits,
+ *             CB_SERVER_MAX_STEPS and CB_SERVER_TIMEOUT apply.
+ ******************************************************************************/
+
+#ifndef SERVER_H
+#define SERVER_H
+
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "exec_limits.h"
+
+// maximum size of a request's script and input
+#define CB_SERVER_MAX_REQUEST (64 * 1024 * 1024)
+
+// count of cached scripts per worker
+#define CB_SERVER_CACHE_SIZE 64
+
+// default limits of a request
+#define CB_SERVER_MAX_STEPS 100000000
+#define CB_SERVER_TIMEOUT   10000
+
+// response status
+enum cb_server_status
+{
+    CB_SERVER_OK = 0,
+    CB_SERVER_ERROR
+};
+
+// header of a request (native byte order)
+typedef struct
+{
+    uint32_t script_length;         // length of the script
+    uint32_t input_length;          // length of the input
+} CbServerRequestHeader;
+
+// header of a response (native byte order)
+typedef struct
+{
+    uint32_t status;                // see cb_server_status
+    uint32_t output_length;         // length of the script's output
+    uint32_t result_length;         // length of the result or error message
+} CbServerResponseHeader;
+
+// response received by a client
+typedef struct
+{
+    enum cb_server_status status;
+    char* output;                   // output (null-terminated)
+    size_t output_length;
+    char* result;                   // result or error message (null-terminated)
+    size_t result_length;
+} CbServerResponse;
+
+
+// interface functions
+int cb_server_run(const char* socket_name, int worker_count,
+                  const CbLimits* limits);
+
+int cb_server_connect(const char* socket_name);
+int cb_server_request(int fd, const char* script, size_t script_length,
+                      const char* input, size_t input_length,
+                      CbServerResponse* response);
+void cb_server_response_release(CbServerResponse* response);
+
+int cb_server_load_test(const char* socket_name, const char* file_name,
+                        int request_count, int connection_count);
+
+
+#endif // SERVER_H
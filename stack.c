@@ -4,6 +4,8 @@
 
 #include <stdlib.h>
 #include "stack.h"
+#include "alloc.h"
+#include "pool.h"
 
 
 // #############################################################################
@@ -27,7 +29,7 @@ struct CbStackItem
 // -----------------------------------------------------------------------------
 CbStack* cb_stack_create()
 {
-    CbStack* stack = (CbStack*) malloc(sizeof(CbStack));
+    CbStack* stack = (CbStack*) cb_alloc(sizeof(CbStack), CB_ALLOC_STACK);
     stack->top     = NULL;
     stack->count   = 0;
     
@@ -40,7 +42,7 @@ CbStack* cb_stack_create()
 void cb_stack_free(CbStack* stack)
 {
     // TODO: Print warning, if stack is not empty
-    free(stack);
+    cb_free(stack, CB_ALLOC_STACK);
 }
 
 // -----------------------------------------------------------------------------
@@ -48,7 +50,8 @@ void cb_stack_free(CbStack* stack)
 // -----------------------------------------------------------------------------
 void cb_stack_push(CbStack* stack, const void* item)
 {
-    CbStackItem* stack_item = (CbStackItem*) malloc(sizeof(CbStackItem));
+    CbStackItem* stack_item = (CbStackItem*) cb_pool_alloc(
+                                  sizeof(CbStackItem), CB_ALLOC_STACK);
     stack_item->data        = item;
     stack_item->prior       = stack->top;
     
@@ -68,7 +71,8 @@ int cb_stack_pop(CbStack* stack, void** dest)
         
         CbStackItem* temp = stack->top;
         stack->top        = stack->top->prior; // move top to prior item
-        free(temp);                            // free former top-item
+        // free former top-item
+        cb_pool_free(temp, sizeof(CbStackItem), CB_ALLOC_STACK);
         
         stack->count--;
     }
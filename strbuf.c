@@ -0,0 +1,246 @@
+/*******************************************************************************
+ * CbStrbuf -- Implementation of a string buffer for formatting output
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "strbuf.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+#define CB_STRBUF_MIN_CAPACITY 64
+
+// all two-digit pairs, so an integer can be formatted two digits at a time
+static const char cb_strbuf_digit_pairs[] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334"
+    "3536373839404142434445464748495051525354555657585960616263646566676869"
+    "707172737475767778798081828384858687888990919293949596979899";
+
+static void cb_strbuf_reserve(CbStrbuf* buf, size_t length);
+
+
+// #############################################################################
+// interface-functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Initialize a growable buffer
+// -----------------------------------------------------------------------------
+void cb_strbuf_init(CbStrbuf* buf)
+{
+    buf->data     = NULL;
+    buf->length   = 0;
+    buf->capacity = 0;
+    buf->flush    = NULL;
+    buf->context  = NULL;
+}
+
+// -----------------------------------------------------------------------------
+// Initialize a stream buffer using a fixed storage
+//
+//    The content is passed to the flush-function, whenever the storage is full
+//    and on cb_strbuf_flush().
+// -----------------------------------------------------------------------------
+void cb_strbuf_init_stream(CbStrbuf* buf, char* storage, size_t capacity,
+                           CbStrbufFlushFunc flush, void* context)
+{
+    assert(flush);
+    
+    buf->data     = storage;
+    buf->length   = 0;
+    buf->capacity = capacity;
+    buf->flush    = flush;
+    buf->context  = context;
+}
+
+// -----------------------------------------------------------------------------
+// Release a buffer (a stream buffer is flushed, a growable one freed)
+// -----------------------------------------------------------------------------
+void cb_strbuf_release(CbStrbuf* buf)
+{
+    if (buf->flush)
+    {
+        cb_strbuf_flush(buf);
+        return;
+    }
+    
+    free(buf->data);
+    cb_strbuf_init(buf);
+}
+
+// -----------------------------------------------------------------------------
+// Take the content of a growable buffer as null-terminated string
+//
+//    The string must be freed after usage, the buffer is empty afterwards.
+// -----------------------------------------------------------------------------
+char* cb_strbuf_detach(CbStrbuf* buf)
+{
+    assert(buf->flush == NULL);
+    
+    cb_strbuf_reserve(buf, 1);
+    buf->data[buf->length] = '\0';
+    
+    char* string = buf->data;
+    cb_strbuf_init(buf);
+    
+    return string;
+}
+
+// -----------------------------------------------------------------------------
+// Get the content of a growable buffer as null-terminated string
+//
+//    The string is still owned by the buffer and valid until the next append.
+// -----------------------------------------------------------------------------
+const char* cb_strbuf_get_string(CbStrbuf* buf)
+{
+    assert(buf->flush == NULL);
+    
+    cb_strbuf_reserve(buf, 1);
+    buf->data[buf->length] = '\0';
+    
+    return buf->data;
+}
+
+// -----------------------------------------------------------------------------
+// Pass the content of a stream buffer to its flush-function
+// -----------------------------------------------------------------------------
+void cb_strbuf_flush(CbStrbuf* buf)
+{
+    if (buf->flush == NULL || buf->length == 0)
+        return;
+    
+    buf->flush(buf->context, buf->data, buf->length, NULL, 0);
+    buf->length = 0;
+}
+
+// -----------------------------------------------------------------------------
+// Append data
+// -----------------------------------------------------------------------------
+void cb_strbuf_append(CbStrbuf* buf, const char* data, size_t length)
+{
+    if (length == 0) // data may be NULL
+        return;
+    
+    if (buf->length + length > buf->capacity)
+    {
+        if (buf->flush)
+        {
+            // data that doesn't fit into the storage is passed directly,
+            // together with the buffered data
+            if (length > buf->capacity)
+            {
+                buf->flush(buf->context, buf->data, buf->length, data, length);
+                buf->length = 0;
+                return;
+            }
+            
+            cb_strbuf_flush(buf);
+        }
+        else
+            cb_strbuf_reserve(buf, length);
+    }
+    
+    memcpy(buf->data + buf->length, data, length);
+    buf->length += length;
+}
+
+// -----------------------------------------------------------------------------
+// Append a single character
+// -----------------------------------------------------------------------------
+void cb_strbuf_append_char(CbStrbuf* buf, char c)
+{
+    if (buf->length < buf->capacity)
+        buf->data[buf->length++] = c;
+    else
+        cb_strbuf_append(buf, &c, 1);
+}
+
+// -----------------------------------------------------------------------------
+// Append a null-terminated string
+// -----------------------------------------------------------------------------
+void cb_strbuf_append_string(CbStrbuf* buf, const char* string)
+{
+    cb_strbuf_append(buf, string, strlen(string));
+}
+
+// -----------------------------------------------------------------------------
+// Append a formatted integer
+// -----------------------------------------------------------------------------
+void cb_strbuf_append_integer(CbStrbuf* buf, int64_t value)
+{
+    // format directly into the buffer, if there is enough space left
+    if (buf->length + CB_STRBUF_INTEGER_MAX_LENGTH <= buf->capacity)
+    {
+        buf->length += cb_strbuf_format_integer(buf->data + buf->length, value);
+        return;
+    }
+    
+    char digits[CB_STRBUF_INTEGER_MAX_LENGTH];
+    cb_strbuf_append(buf, digits, cb_strbuf_format_integer(digits, value));
+}
+
+// -----------------------------------------------------------------------------
+// Format an integer in decimal notation
+//
+//    The buffer must provide CB_STRBUF_INTEGER_MAX_LENGTH characters, the
+//    result isn't null-terminated. Returns the length of the result.
+// -----------------------------------------------------------------------------
+size_t cb_strbuf_format_integer(char* buffer, int64_t value)
+{
+    char digits[CB_STRBUF_INTEGER_MAX_LENGTH];
+    char* end     = digits + CB_STRBUF_INTEGER_MAX_LENGTH;
+    char* current = end;
+    // negate as unsigned value, which is well-defined for INT64_MIN as well
+    uint64_t magnitude = (value < 0) ? 0 - (uint64_t) value : (uint64_t) value;
+    
+    while (magnitude >= 100)
+    {
+        size_t pair = (size_t) (magnitude % 100) * 2;
+        magnitude  /= 100;
+        current    -= 2;
+        current[0]  = cb_strbuf_digit_pairs[pair];
+        current[1]  = cb_strbuf_digit_pairs[pair + 1];
+    }
+    
+    if (magnitude >= 10)
+    {
+        current    -= 2;
+        current[0]  = cb_strbuf_digit_pairs[magnitude * 2];
+        current[1]  = cb_strbuf_digit_pairs[magnitude * 2 + 1];
+    }
+    else
+        *--current = (char) ('0' + magnitude);
+    
+    if (value < 0)
+        *--current = '-';
+    
+    size_t length = (size_t) (end - current);
+    memcpy(buffer, current, length);
+    
+    return length;
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Make room for additional characters in a growable buffer (internal)
+// -----------------------------------------------------------------------------
+static void cb_strbuf_reserve(CbStrbuf* buf, size_t length)
+{
+    if (buf->length + length <= buf->capacity)
+        return;
+    
+    size_t capacity = (buf->capacity) ? buf->capacity : CB_STRBUF_MIN_CAPACITY;
+    while (capacity < buf->length + length)
+        capacity *= 2;
+    
+    buf->data     = (char*) realloc(buf->data, capacity);
+    buf->capacity = capacity;
+}
@@ -0,0 +1,55 @@
+/*******************************************************************************
+ * CbStrbuf -- Implementation of a string buffer for formatting output
+ *
+ *             A growable buffer collects the whole output on the heap, while a
+ *             stream buffer uses a fixed storage and passes its content to a
+ *             flush-function as soon as it is full. Appending to a buffer is
+ *             linear in the length of the appended data.
+ ******************************************************************************/
+
+#ifndef STRBUF_H
+#define STRBUF_H
+
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// maximum length of a formatted 64-bit integer (sign and 19 digits)
+#define CB_STRBUF_INTEGER_MAX_LENGTH 20
+
+// flush-function of a stream buffer: the buffered data is followed by an
+// optional second chunk, so both can be written at once (see cb_strbuf_append)
+typedef void (*CbStrbufFlushFunc)(void* context, const char* data,
+                                  size_t length, const char* extra,
+                                  size_t extra_length);
+
+// CbStrbuf struct
+typedef struct
+{
+    char* data;
+    size_t length;
+    size_t capacity;
+    CbStrbufFlushFunc flush;        // NULL for a growable buffer
+    void* context;                  // passed to the flush-function
+} CbStrbuf;
+
+
+// interface functions
+void cb_strbuf_init(CbStrbuf* buf);
+void cb_strbuf_init_stream(CbStrbuf* buf, char* storage, size_t capacity,
+                           CbStrbufFlushFunc flush, void* context);
+void cb_strbuf_release(CbStrbuf* buf);
+char* cb_strbuf_detach(CbStrbuf* buf);
+const char* cb_strbuf_get_string(CbStrbuf* buf);
+void cb_strbuf_flush(CbStrbuf* buf);
+
+void cb_strbuf_append(CbStrbuf* buf, const char* data, size_t length);
+void cb_strbuf_append_char(CbStrbuf* buf, char c);
+void cb_strbuf_append_string(CbStrbuf* buf, const char* string);
+void cb_strbuf_append_integer(CbStrbuf* buf, int64_t value);
+
+size_t cb_strbuf_format_integer(char* buffer, int64_t value);
+
+
+#endif // STRBUF_H
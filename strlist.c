@@ -5,6 +5,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "strlist.h"
+#include "alloc.h"
 
 
 // #############################################################################
@@ -25,7 +26,7 @@ static void cb_strlist_item_free(CbStrlist* item);
 CbStrlist* cb_strlist_create(char* string)
 {
     CbStrlist* sl = cb_strlist_item_create();
-    sl->string    = strdup(string);
+    sl->string    = cb_alloc_strdup(string, CB_ALLOC_AST);
     // item was created by default -> increase count to 1
     sl->count     = 1;
     
@@ -59,7 +60,7 @@ CbStrlist* cb_strlist_append(CbStrlist* list, char* string)
     
     // append item
     current->next         = cb_strlist_item_create();
-    current->next->string = strdup(string);
+    current->next->string = cb_alloc_strdup(string, CB_ALLOC_AST);
     
     list->count++; // increase count of elements in the list
     
@@ -76,7 +77,7 @@ CbStrlist* cb_strlist_append(CbStrlist* list, char* string)
 // -----------------------------------------------------------------------------
 static CbStrlist* cb_strlist_item_create()
 {
-    CbStrlist* si = (CbStrlist*) malloc(sizeof(CbStrlist));
+    CbStrlist* si = (CbStrlist*) cb_alloc(sizeof(CbStrlist), CB_ALLOC_AST);
     si->next      = NULL;
     si->string    = NULL;
     si->data      = NULL;
@@ -91,7 +92,7 @@ static CbStrlist* cb_strlist_item_create()
 static void cb_strlist_item_free(CbStrlist* item)
 {
     if (item->string)
-        free(item->string);
+        cb_free(item->string, CB_ALLOC_AST);
     
-    free(item);
+    cb_free(item, CB_ALLOC_AST);
 }
@@ -7,6 +7,8 @@
 #include <string.h>
 #include <assert.h>
 #include "symbol.h"
+#include "alloc.h"
+#include "pool.h"
 
 
 // #############################################################################
@@ -39,9 +41,10 @@ struct CbSymbol
 // -----------------------------------------------------------------------------
 static CbSymbol* symbol_create(char* identifier)
 {
-    CbSymbol* s = (CbSymbol*) malloc(sizeof(CbSymbol));
+    CbSymbol* s = (CbSymbol*) cb_pool_alloc(sizeof(CbSymbol),
+                                            CB_ALLOC_SYMBOL);
     s->type     = SYM_TYPE_UNDEFINED;
-    s->id       = strdup(identifier);
+    s->id       = cb_alloc_strdup(identifier, CB_ALLOC_SYMBOL);
     s->next     = NULL;
     s->previous = NULL;
     s->scope    = NULL;
@@ -83,7 +86,7 @@ CbSymbol* cb_symbol_create_function(char* identifier, CbFunction* func_object)
 // -----------------------------------------------------------------------------
 void cb_symbol_free(CbSymbol* s)
 {
-    free(s->id);
+    cb_free(s->id, CB_ALLOC_SYMBOL);
     
     switch (s->type)
     {
@@ -96,7 +99,7 @@ void cb_symbol_free(CbSymbol* s)
             break;
     }
     
-    free(s);
+    cb_pool_free(s, sizeof(CbSymbol), CB_ALLOC_SYMBOL);
 }
 
 // -----------------------------------------------------------------------------
@@ -169,6 +172,14 @@ void cb_symbol_set_scope(CbSymbol* s, const CbScope* scope)
     s->scope = scope;
 }
 
+// -----------------------------------------------------------------------------
+// check if the symbol is a variable
+// -----------------------------------------------------------------------------
+bool cb_symbol_is_variable(const CbSymbol* s)
+{
+    return s->type == SYM_TYPE_VARIABLE;
+}
+
 // -----------------------------------------------------------------------------
 // get value-object of an variable-symbol (variables only!)
 // -----------------------------------------------------------------------------
@@ -189,6 +200,28 @@ void cb_symbol_variable_assign_value(CbSymbol* s, const CbValue* new_value)
     cb_value_assign(new_value, s->value);
 }
 
+// -----------------------------------------------------------------------------
+// assign new value to the symbol-value and free the new value
+// (variables only!)
+// -----------------------------------------------------------------------------
+void cb_symbol_variable_assign_and_free_value(CbSymbol* s, CbValue* new_value)
+{
+    assert(s->type == SYM_TYPE_VARIABLE);
+    
+    cb_value_assign_and_free_source(new_value, s->value);
+}
+
+// -----------------------------------------------------------------------------
+// make sure, that the array or hash of the symbol-value isn't shared with any
+// other value, before it is changed in place (variables only!)
+// -----------------------------------------------------------------------------
+void cb_symbol_variable_detach_value(CbSymbol* s)
+{
+    assert(s->type == SYM_TYPE_VARIABLE);
+    
+    cb_value_detach(s->value);
+}
+
 // -----------------------------------------------------------------------------
 // get function-object of an function-symbol (functions only!)
 // -----------------------------------------------------------------------------
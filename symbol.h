@@ -37,8 +37,11 @@ const CbScope* cb_symbol_get_scope(const CbSymbol* s);
 void cb_symbol_set_next(CbSymbol* s, const CbSymbol* next);
 void cb_symbol_set_previous(CbSymbol* s, const CbSymbol* previous);
 void cb_symbol_set_scope(CbSymbol* s, const CbScope* scope);
+bool cb_symbol_is_variable(const CbSymbol* s);
 const CbValue* cb_symbol_variable_get_value(const CbSymbol* s);
 void cb_symbol_variable_assign_value(CbSymbol* s, const CbValue* new_value);
+void cb_symbol_variable_assign_and_free_value(CbSymbol* s, CbValue* new_value);
+void cb_symbol_variable_detach_value(CbSymbol* s);
 CbFunction* cb_symbol_function_get_function(const CbSymbol* s);
 
 
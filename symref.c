@@ -7,6 +7,7 @@
 #include <string.h>
 #include <assert.h>
 #include "symref.h"
+#include "alloc.h"
 #include "symtab.h"
 #include "syntree.h"
 #include "error_handling.h"
@@ -21,10 +22,10 @@
 // -----------------------------------------------------------------------------
 CbSyntree* cb_symref_create(char* identifier)
 {
-    CbSymref* node  = malloc(sizeof(CbSymref));
+    CbSymref* node  = cb_alloc(sizeof(CbSymref), CB_ALLOC_AST);
     node->type      = SNT_SYMREF;
     node->line_no   = 0;
-    node->sym_id    = strdup(identifier);
+    node->sym_id    = cb_alloc_strdup(identifier, CB_ALLOC_AST);
     node->table_sym = NULL;
     
     return (CbSyntree*) node;
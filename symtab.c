@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "symtab.h"
+#include "alloc.h"
 #include "scope.h"
 #include "error_handling.h"
 
@@ -14,7 +15,7 @@
 // -----------------------------------------------------------------------------
 CbSymtab* cb_symtab_create()
 {
-    CbSymtab* st    = (CbSymtab*) malloc(sizeof(CbSymtab));
+    CbSymtab* st    = (CbSymtab*) cb_alloc(sizeof(CbSymtab), CB_ALLOC_SYMBOL);
     st->first       = NULL;
     st->last        = NULL;
     st->current     = NULL;
@@ -40,7 +41,7 @@ void cb_symtab_free(CbSymtab* st)
     }
     
     cb_stack_free(st->scope_stack);
-    free(st);
+    cb_free(st, CB_ALLOC_SYMBOL);
 }
 
 // -----------------------------------------------------------------------------
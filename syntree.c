@@ -7,6 +7,7 @@
 #include <string.h>
 #include <assert.h>
 #include "syntree.h"
+#include "alloc.h"
 #include "symbol.h"
 #include "symref.h"
 #include "funccall.h"
@@ -15,9 +16,26 @@
 #include "array_node.h"
 #include "array_access_node.h"
 #include "array_assignment_node.h"
+#include "hash_node.h"
+#include "inline_call_node.h"
+#include "invariant_node.h"
+#include "jit.h"
+#include "output.h"
+#include "profile.h"
+#include "exec_limits.h"
 #include "error_handling.h"
 
 
+// #############################################################################
+// declarations
+// #############################################################################
+
+static CbValue* cb_syntree_eval_node(CbSyntree* node, CbSymtab* symtab);
+static void cb_syntree_cleanup_value_ref(void* value_ref);
+static enum cb_operation_type cb_syntree_get_operation(
+                                   enum cb_syntree_node_type type);
+
+
 // #############################################################################
 // interface-functions
 // #############################################################################
@@ -28,7 +46,7 @@
 CbSyntree* cb_syntree_create(enum cb_syntree_node_type type,
                              CbSyntree* left_node, CbSyntree* right_node)
 {
-    CbSyntree* node = malloc(sizeof(CbSyntree));
+    CbSyntree* node = cb_alloc(sizeof(CbSyntree), CB_ALLOC_AST);
     node->type      = type;
     node->line_no   = 0;
     node->l         = left_node;
@@ -42,7 +60,7 @@ CbSyntree* cb_syntree_create(enum cb_syntree_node_type type,
 // -----------------------------------------------------------------------------
 CbSyntree* cb_constval_create(CbNumeric value)
 {
-    CbConstvalNode* node = malloc(sizeof(CbConstvalNode));
+    CbConstvalNode* node = cb_alloc(sizeof(CbConstvalNode), CB_ALLOC_AST);
     node->type           = SNT_CONSTVAL;
     node->line_no        = 0;
     node->value          = cb_numeric_create(value);
@@ -50,12 +68,25 @@ CbSyntree* cb_constval_create(CbNumeric value)
     return (CbSyntree*) node;
 }
 
+// -----------------------------------------------------------------------------
+// create a syntax-tree value-node with a float value
+// -----------------------------------------------------------------------------
+CbSyntree* cb_constfloat_create(CbFloat value)
+{
+    CbConstvalNode* node = cb_alloc(sizeof(CbConstvalNode), CB_ALLOC_AST);
+    node->type           = SNT_CONSTVAL;
+    node->line_no        = 0;
+    node->value          = cb_float_create(value);
+    
+    return (CbSyntree*) node;
+}
+
 // -----------------------------------------------------------------------------
 // create a string-node
 // -----------------------------------------------------------------------------
 CbSyntree* cb_conststr_create(CbString string)
 {
-    CbConstvalNode* node = malloc(sizeof(CbConstvalNode));
+    CbConstvalNode* node = cb_alloc(sizeof(CbConstvalNode), CB_ALLOC_AST);
     node->type           = SNT_CONSTSTR;
     node->line_no        = 0;
     node->value          = cb_string_create(strdup(string));
@@ -68,7 +99,7 @@ CbSyntree* cb_conststr_create(CbString string)
 // -----------------------------------------------------------------------------
 CbSyntree* cb_constbool_create(CbBoolean boolean)
 {
-    CbConstvalNode* node = malloc(sizeof(CbConstvalNode));
+    CbConstvalNode* node = cb_alloc(sizeof(CbConstvalNode), CB_ALLOC_AST);
     node->type           = SNT_CONSTBOOL;
     node->line_no        = 0;
     node->value          = cb_boolean_create(boolean);
@@ -84,7 +115,7 @@ CbSyntree* cb_flow_create(enum cb_syntree_node_type type, CbSyntree* condition,
 {
     assert(type == SNT_FLOW_IF || type == SNT_FLOW_WHILE);
     
-    CbFlowNode* node = malloc(sizeof(CbFlowNode));
+    CbFlowNode* node = cb_alloc(sizeof(CbFlowNode), CB_ALLOC_AST);
     node->type       = type;
     node->line_no    = 0;
     node->cond       = condition;
@@ -100,7 +131,7 @@ CbSyntree* cb_flow_create(enum cb_syntree_node_type type, CbSyntree* condition,
 CbSyntree* cb_comparison_create(enum cb_comparison_type type,
                                 CbSyntree* left_node, CbSyntree* right_node)
 {
-    CbComparisonNode* node = malloc(sizeof(CbComparisonNode));
+    CbComparisonNode* node = cb_alloc(sizeof(CbComparisonNode), CB_ALLOC_AST);
     node->type             = SNT_COMPARISON;
     node->line_no          = 0;
     node->cmp_type         = type;
@@ -126,6 +157,11 @@ void cb_syntree_free(CbSyntree* node)
         case SNT_STATEMENTLIST:
         case SNT_LOGICAL_AND:
         case SNT_LOGICAL_OR:
+        case SNT_NUMERIC_ADD:
+        case SNT_NUMERIC_SUB:
+        case SNT_NUMERIC_MUL:
+        case SNT_NUMERIC_DIV:
+        case SNT_STRING_CONCAT:
             cb_syntree_free(node->r);
             // no break here to free left child-node as well
         
@@ -141,14 +177,14 @@ void cb_syntree_free(CbSyntree* node)
         case SNT_FUNC_DECL:
         {
             CbFuncDeclarationNode* fndecl = ((CbFuncDeclarationNode*) node);
-            free(fndecl->sym_id);
+            cb_free(fndecl->sym_id, CB_ALLOC_AST);
             cb_syntree_free(fndecl->body);
             cb_strlist_free(fndecl->params);
             break;
         }
         
         case SNT_SYMREF:
-            free(((CbSymref*) node)->sym_id);
+            cb_free(((CbSymref*) node)->sym_id, CB_ALLOC_AST);
             break;
         
         case SNT_FLOW_IF:
@@ -178,7 +214,7 @@ void cb_syntree_free(CbSyntree* node)
                 cb_strlist_free(args);
             }
             
-            free(((CbFuncCallNode*) node)->sym_id);
+            cb_free(((CbFuncCallNode*) node)->sym_id, CB_ALLOC_AST);
             
             break;
         }
@@ -203,19 +239,37 @@ void cb_syntree_free(CbSyntree* node)
         }
         
         case SNT_VALARRAY_ACCESS:
-            free(((CbArrayAccessNode*) node)->sym_id);
+            cb_free(((CbArrayAccessNode*) node)->sym_id, CB_ALLOC_AST);
             break;
         
         case SNT_VALARRAY_ASSIGNMENT:
         {
             CbArrayAssignmentNode* array_assignment_node =
                 ((CbArrayAssignmentNode*) node);
-            free(array_assignment_node->sym_id);
+            cb_free(array_assignment_node->sym_id, CB_ALLOC_AST);
             cb_syntree_free(array_assignment_node->value_node);
             break;
         }
         
+        case SNT_VALHASH:
+        {
+            CbStrlist* key   = ((CbHashNode*) node)->keys;
+            CbStrlist* value = ((CbHashNode*) node)->values;
+            while (key)
+            {
+                cb_syntree_free((CbSyntree*) key->data);
+                cb_syntree_free((CbSyntree*) value->data);
+                key   = key->next;
+                value = value->next;
+            }
+            cb_strlist_free(((CbHashNode*) node)->keys);
+            cb_strlist_free(((CbHashNode*) node)->values);
+            
+            break;
+        }
+        
         case SNT_COMPARISON:
+        case SNT_NUMERIC_COMPARISON:
             cb_syntree_free(((CbComparisonNode*) node)->l);
             cb_syntree_free(((CbComparisonNode*) node)->r);
             break;
@@ -225,13 +279,35 @@ void cb_syntree_free(CbSyntree* node)
             cb_syntree_free(((CbExceptionBlockNode*) node)->exception_block);
             break;
         
+        case SNT_INLINE_CALL:
+            cb_syntree_free((CbSyntree*) ((CbInlineCallNode*) node)->call);
+            cb_syntree_free(((CbInlineCallNode*) node)->body);
+            break;
+        
+        case SNT_INVARIANT_EXPR:
+            cb_syntree_free(((CbInvariantExprNode*) node)->expr);
+            if (((CbInvariantExprNode*) node)->value)
+                cb_value_free(((CbInvariantExprNode*) node)->value);
+            break;
+        
+        case SNT_INVARIANT_LOOP:
+            // the invariant expressions are nodes of the loop
+            cb_syntree_free(((CbInvariantLoopNode*) node)->loop);
+            cb_free(((CbInvariantLoopNode*) node)->invariants, CB_ALLOC_AST);
+            break;
+        
+        case SNT_JIT_LOOP:
+            cb_jit_loop_node_free_code((CbJitLoopNode*) node);
+            cb_syntree_free(((CbJitLoopNode*) node)->loop);
+            break;
+        
         default:
             // do not report errors if the node type is not reckognized, since
             // the syntax tree is being freed anyway
             break;
     }
     // always free node itself at the end
-    free(node);
+    cb_free(node, CB_ALLOC_AST);
 }
 
 // -----------------------------------------------------------------------------
@@ -241,11 +317,24 @@ void cb_syntree_free(CbSyntree* node)
 // -----------------------------------------------------------------------------
 CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
 {
-    CbValue* result = NULL;
+    // the profiler has a dispatch path of its own
+    if (cb_profile_enabled)
+        return cb_profile_eval(node, symtab, cb_syntree_eval_node);
     
-    // Check for uncatched errors
-    if ((cb_error_is_set()) && !cb_error_is_catched())
-        return NULL;
+    return cb_syntree_eval_node(node, symtab);
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Evaluate a node (internal)
+// -----------------------------------------------------------------------------
+static CbValue* cb_syntree_eval_node(CbSyntree* node, CbSymtab* symtab)
+{
+    CbValue* result = NULL;
     
     switch (node->type)
     {
@@ -259,34 +348,25 @@ CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
             result = cb_array_node_eval((CbArrayNode*) node, symtab);
             break;
         
+        case SNT_VALHASH:
+            result = cb_hash_node_eval((CbHashNode*) node, symtab);
+            break;
+        
         case SNT_VALARRAY_ACCESS:
-        {
-            CbValue* value = cb_array_access_node_eval((CbArrayAccessNode*) node, symtab);
-            if (value)
-                result = cb_value_copy(value);
-            else
-                result = NULL;
-            
+            // the element is a value of its own already
+            result = cb_array_access_node_eval((CbArrayAccessNode*) node, symtab);
             break;
-        }
         
         case SNT_VALARRAY_ASSIGNMENT:
-        {
-            CbValue* value =
-                cb_array_assignment_node_eval((CbArrayAssignmentNode*) node, symtab);
-            if (value)
-                result = cb_value_copy(value);
-            else
-                result = NULL;
-            
+            result = cb_array_assignment_node_eval((CbArrayAssignmentNode*) node,
+                                                   symtab);
             break;
-        }
         
         case SNT_SYMREF:
         {
             CbSymref* sr = (CbSymref*) node;
             if (cb_symref_set_symbol_from_table(sr, symtab) == EXIT_SUCCESS)
-                result = cb_value_copy(cb_symbol_variable_get_value(sr->table_sym));
+                result = cb_value_share(cb_symbol_variable_get_value(sr->table_sym));
             
             break;
         }
@@ -308,13 +388,10 @@ CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
                 break;
             }
             
-            if (!cb_error_is_set() || cb_error_is_catched())
-                // assign right-hand-side expression
-                cb_symbol_variable_assign_value(sr->table_sym, rhs);
+            // assign right-hand-side expression
+            cb_symbol_variable_assign_and_free_value(sr->table_sym, rhs);
             
-            cb_value_free(rhs);
-            
-            result = cb_value_copy(cb_symbol_variable_get_value(sr->table_sym));
+            result = cb_value_share(cb_symbol_variable_get_value(sr->table_sym));
             break;
         }
         
@@ -361,10 +438,9 @@ CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
             if (temp == NULL)
                 break;
             
-            cb_value_print(temp);
+            // print value and newline
+            cb_output_write_line(cb_output_get_current(), temp);
             cb_value_free(temp);
-            // print newline
-            printf("\n");
             // return empty value
             result = cb_value_create();
             break;
@@ -385,6 +461,55 @@ CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
             break;
         }
         
+        case SNT_INLINE_CALL:
+        {
+            CbInlineCallNode* inline_call = (CbInlineCallNode*) node;
+            
+            // the profiler records the calls of the original function
+            if (cb_profile_enabled)
+                result = cb_syntree_eval_node((CbSyntree*) inline_call->call,
+                                              symtab);
+            else
+                result = cb_inline_call_node_eval(inline_call, symtab);
+            
+            break;
+        }
+        
+        case SNT_INLINE_PARAM:
+            result = cb_inline_param_node_eval((CbInlineParamNode*) node);
+            break;
+        
+        case SNT_INVARIANT_EXPR:
+            // the profiler records every evaluation of the expression
+            if (cb_profile_enabled)
+                result = cb_syntree_eval_node(
+                             ((CbInvariantExprNode*) node)->expr, symtab);
+            else
+                result = cb_invariant_expr_node_eval(
+                             (CbInvariantExprNode*) node, symtab);
+            
+            break;
+        
+        case SNT_INVARIANT_LOOP:
+            if (cb_profile_enabled)
+                result = cb_syntree_eval_node(
+                             ((CbInvariantLoopNode*) node)->loop, symtab);
+            else
+                result = cb_invariant_loop_node_eval(
+                             (CbInvariantLoopNode*) node, symtab);
+            
+            break;
+        
+        case SNT_JIT_LOOP:
+            // the profiler records every step of the loop
+            if (cb_profile_enabled)
+                result = cb_syntree_eval_node(((CbJitLoopNode*) node)->loop,
+                                              symtab);
+            else
+                result = cb_jit_loop_node_eval((CbJitLoopNode*) node, symtab);
+            
+            break;
+        
         case SNT_FLOW_IF:
         {
             CbValue* condition = cb_syntree_eval(((CbFlowNode*) node)->cond, symtab);
@@ -393,8 +518,11 @@ CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
             
             assert(cb_value_is_type(condition, CB_VT_BOOLEAN));
             
+            bool condition_true = cb_boolean_get(condition);
+            cb_value_free(condition);
+            
             // evaluate condition and check its result
-            if (cb_boolean_get(condition))
+            if (condition_true)
             {
                 // condition is ture -> evaluate the true-branch
                 result = cb_syntree_eval(((CbFlowNode*) node)->tb, symtab);
@@ -410,7 +538,6 @@ CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
                     result = cb_value_create();
             }
             
-            cb_value_free(condition);
             break;
         }
         
@@ -425,21 +552,40 @@ CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
             // default result (in case the while-loop won't be entered)
             result = cb_value_create();
             
+            // the result of the last iteration is held, while the condition
+            // is evaluated
+            cb_error_push_cleanup(&result, cb_syntree_cleanup_value_ref);
+            
             // evaluate true-branch while the condition returns true
             while (cb_boolean_get(temp))
             {
                 cb_value_free(temp);
-                if (result) // TODO: Check is not necessary since result is
-                            //       assigend before, so it can't be NULL.
-                    cb_value_free(result);
+                cb_value_free(result);
+                temp   = NULL;
+                result = NULL;
+                
+                // every iteration is a step of the execution limits
+                if (cb_limits_enabled && !cb_limits_step())
+                {
+                    cb_error_throw();
+                    break;
+                }
                 
                 result = cb_syntree_eval(((CbFlowNode*) node)->tb, symtab);
-                temp   = cb_syntree_eval(((CbFlowNode*) node)->cond, symtab);
+                if (result == NULL)
+                    break;
                 
-                if (result == NULL || temp == NULL)
+                temp = cb_syntree_eval(((CbFlowNode*) node)->cond, symtab);
+                if (temp == NULL)
+                {
+                    cb_value_free(result);
+                    result = NULL;
                     break;
+                }
             }
             
+            cb_error_pop_cleanup();
+            
             if (temp)
                 // free last dummy-value
                 cb_value_free(temp);
@@ -451,33 +597,37 @@ CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
             CbComparisonNode* cmp = ((CbComparisonNode*) node);
             
             CbValue* l = cb_syntree_eval(cmp->l, symtab);
+            if (l == NULL)
+                break;
+            
+            cb_error_push_temporary(l);
             CbValue* r = cb_syntree_eval(cmp->r, symtab);
+            cb_error_pop_temporaries(1);
             
-            if (l && r) // both values of left and right syntax node must be valid
+            if (r == NULL)
             {
-                switch (cb_value_get_type(l))
-                {
-                    case CB_VT_NUMERIC:
-                        result = cb_numeric_compare(cmp->cmp_type, l, r);
-                        break;
-                    
-                    case CB_VT_STRING:
-                        result = cb_string_compare(cmp->cmp_type, l, r);
-                        break;
-                    
-                    case CB_VT_BOOLEAN:
-                        result = cb_boolean_compare(cmp->cmp_type, l, r);
-                        break;
-                }
-                
-                // free lhs and rhs
                 cb_value_free(l);
-                cb_value_free(r);
+                break;
             }
-            else if (l)
-                cb_value_free(l);
-            else
-                cb_value_free(r);
+            
+            switch (cb_value_get_type(l))
+            {
+                case CB_VT_NUMERIC:
+                    result = cb_numeric_compare(cmp->cmp_type, l, r);
+                    break;
+                
+                case CB_VT_STRING:
+                    result = cb_string_compare(cmp->cmp_type, l, r);
+                    break;
+                
+                case CB_VT_BOOLEAN:
+                    result = cb_boolean_compare(cmp->cmp_type, l, r);
+                    break;
+            }
+            
+            // free lhs and rhs
+            cb_value_free(l);
+            cb_value_free(r);
             
             break;
         }
@@ -490,16 +640,11 @@ CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
         case SNT_STATEMENTLIST:
         {
             CbValue* temp = cb_syntree_eval(node->l, symtab);
+            if (temp == NULL)
+                break; // an error occurred
             
-            // Check if returned value is valid and no uncatched errors occurred
-            if (temp && (!cb_error_is_set() || cb_error_is_catched()))
-            {
-                cb_value_free(temp);
-                result = cb_syntree_eval(node->r, symtab);
-            }
-            else
-                result = temp; // At least return result of first statement
-            
+            cb_value_free(temp);
+            result = cb_syntree_eval(node->r, symtab);
             break;
         }
         
@@ -514,13 +659,18 @@ CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
             if (l == NULL)
                 break;
             
+            cb_error_push_temporary(l);
             CbValue* r = cb_syntree_eval(node->r, symtab);
             if (r == NULL)
             {
+                cb_error_pop_temporaries(1);
                 cb_value_free(l);
                 break;
             }
             
+            // the operation may throw, while the operands are held
+            cb_error_push_temporary(r);
+            
             // value type of rhs and lhs must be equal!
             if (!cb_value_is_type(r, cb_value_get_type(l)))
             {
@@ -595,6 +745,89 @@ CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
                 }
             
             // free lhs and rhs
+            cb_error_pop_temporaries(2);
+            cb_value_free(l);
+            cb_value_free(r);
+            
+            break;
+        }
+        
+        // the types of the operands are known, they aren't checked
+        case SNT_NUMERIC_ADD:
+        case SNT_NUMERIC_SUB:
+        case SNT_NUMERIC_MUL:
+        case SNT_NUMERIC_DIV:
+        {
+            CbValue* l = cb_syntree_eval(node->l, symtab);
+            if (l == NULL)
+                break;
+            
+            cb_error_push_temporary(l);
+            CbValue* r = cb_syntree_eval(node->r, symtab);
+            if (r == NULL)
+            {
+                cb_error_pop_temporaries(1);
+                cb_value_free(l);
+                break;
+            }
+            
+            // the operation may throw, while the operands are held
+            cb_error_push_temporary(r);
+            
+            // the left operand is a temporary value, which takes the result
+            cb_numeric_apply(cb_syntree_get_operation(node->type), l, r);
+            cb_error_pop_temporaries(2);
+            cb_value_free(r);
+            result = l;
+            
+            break;
+        }
+        
+        case SNT_STRING_CONCAT:
+        {
+            CbValue* l = cb_syntree_eval(node->l, symtab);
+            if (l == NULL)
+                break;
+            
+            cb_error_push_temporary(l);
+            CbValue* r = cb_syntree_eval(node->r, symtab);
+            if (r == NULL)
+            {
+                cb_error_pop_temporaries(1);
+                cb_value_free(l);
+                break;
+            }
+            
+            // the operation may throw, while the operands are held
+            cb_error_push_temporary(r);
+            
+            result = cb_string_concat(l, r);
+            cb_error_pop_temporaries(2);
+            cb_value_free(l);
+            cb_value_free(r);
+            
+            break;
+        }
+        
+        case SNT_NUMERIC_COMPARISON:
+        {
+            CbComparisonNode* cmp = ((CbComparisonNode*) node);
+            
+            CbValue* l = cb_syntree_eval(cmp->l, symtab);
+            if (l == NULL)
+                break;
+            
+            cb_error_push_temporary(l);
+            CbValue* r = cb_syntree_eval(cmp->r, symtab);
+            cb_error_pop_temporaries(1);
+            
+            if (r == NULL)
+            {
+                cb_value_free(l);
+                break;
+            }
+            
+            result = cb_numeric_compare(cmp->cmp_type, l, r);
             cb_value_free(l);
             cb_value_free(r);
             
@@ -631,10 +864,8 @@ CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
         case SNT_UNARYMINUS:
             result = cb_syntree_eval(node->l, symtab);
             if (result)
-            {
-                CbNumeric new_value = - cb_numeric_get(result);
-                cb_numeric_set(result, new_value);
-            }
+                cb_numeric_negate(result);
+            
             break;
         
         default:
@@ -644,3 +875,28 @@ CbValue* cb_syntree_eval(CbSyntree* node, CbSymtab* symtab)
     
     return result;
 }
+
+// -----------------------------------------------------------------------------
+// Free the value a variable refers to, if any (CbErrorCleanup) (internal)
+// -----------------------------------------------------------------------------
+static void cb_syntree_cleanup_value_ref(void* value_ref)
+{
+    CbValue* value = *((CbValue**) value_ref);
+    if (value)
+        cb_value_free(value);
+}
+
+// -----------------------------------------------------------------------------
+// Get the operation of a numeric operation node (internal)
+// -----------------------------------------------------------------------------
+static enum cb_operation_type cb_syntree_get_operation(
+                                   enum cb_syntree_node_type type)
+{
+    switch (type)
+    {
+        case SNT_NUMERIC_SUB: return OPR_SUB;
+        case SNT_NUMERIC_MUL: return OPR_MUL;
+        case SNT_NUMERIC_DIV: return OPR_DIV;
+        default:              return OPR_ADD;
+    }
+}
@@ -53,6 +53,7 @@ struct comparison_node
 CbSyntree* cb_syntree_create(enum cb_syntree_node_type type,
                              CbSyntree* left_node, CbSyntree* right_node);
 CbSyntree* cb_constval_create(CbNumeric value);
+CbSyntree* cb_constfloat_create(CbFloat value);
 CbSyntree* cb_conststr_create(CbString string);
 CbSyntree* cb_constbool_create(CbBoolean boolean);
 CbSyntree* cb_flow_create(enum cb_syntree_node_type type, CbSyntree* condition,
@@ -29,10 +29,25 @@ enum cb_syntree_node_type
     SNT_VALARRAY,
     SNT_VALARRAY_ACCESS,
     SNT_VALARRAY_ASSIGNMENT,
+    SNT_VALHASH,
     SNT_SYMREF,
     SNT_FLOW_IF,
     SNT_FLOW_WHILE,
-    SNT_EXCEPTION_BLOCK
+    SNT_EXCEPTION_BLOCK,
+    // the following node-types are created by the optimizer only
+    SNT_INLINE_CALL,
+    SNT_INLINE_PARAM,
+    SNT_INVARIANT_EXPR,
+    SNT_INVARIANT_LOOP,
+    // operations, whose operands are known to be of the same type
+    SNT_NUMERIC_ADD,
+    SNT_NUMERIC_SUB,
+    SNT_NUMERIC_MUL,
+    SNT_NUMERIC_DIV,
+    SNT_STRING_CONCAT,
+    SNT_NUMERIC_COMPARISON,
+    // loop compiled to machine code, when it is hot (see jit.h)
+    SNT_JIT_LOOP
 };
 
 // forward-declarations
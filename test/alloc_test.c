@@ -0,0 +1,202 @@
+/*******************************************************************************
+ * alloc_test -- Testing the allocation hooks and memory statistics
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <CuTest.h>
+#include "CuTestCustomUtils.h"
+#include "../alloc.h"
+#include "../codeblock.h"
+#include "../hash.h"
+#include "../exec_limits.h"
+#include "../error_handling.h"
+
+// #############################################################################
+// utilities
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Get an entry of the hash at an index of MemStats()'s array (internal)
+// -----------------------------------------------------------------------------
+static const CbValue* test_alloc_memstats_get(CbArray* array, int index,
+                                              const char* name)
+{
+    CbValue* element = NULL;
+    if (!cb_array_get(array, index, (CbArrayItem*) &element))
+        return NULL;
+    
+    CbValue* key         = cb_string_create(strdup(name));
+    const CbValue* value = cb_hash_get(cb_valhash_get(element), key);
+    cb_value_free(key);
+    
+    return value;
+}
+
+
+// #############################################################################
+// test procedures
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Test: test_alloc_balance() -- Frees balance allocations per subsystem
+// -----------------------------------------------------------------------------
+void test_alloc_balance(CuTest *tc)
+{
+    CbAllocStats before, after, total;
+    cb_alloc_get_stats(CB_ALLOC_STACK, &before);
+    
+    char* memory = (char*) cb_alloc(100, CB_ALLOC_STACK);
+    char* copy   = cb_alloc_strdup("abc", CB_ALLOC_STACK);
+    
+    cb_alloc_get_stats(CB_ALLOC_STACK, &after);
+    CuAssertTrue(tc, after.allocations == before.allocations + 2);
+    CuAssertTrue(tc, after.live >= before.live + 104);
+    CuAssertTrue(tc, after.peak >= after.live);
+    CuAssertStrEquals(tc, "abc", copy);
+    
+    // growing adds to the bytes, but isn't another allocation
+    memory = (char*) cb_realloc(memory, 1000, CB_ALLOC_STACK);
+    cb_alloc_get_stats(CB_ALLOC_STACK, &after);
+    CuAssertTrue(tc, after.allocations == before.allocations + 2);
+    CuAssertTrue(tc, after.live >= before.live + 1004);
+    
+    cb_free(memory, CB_ALLOC_STACK);
+    cb_free(copy, CB_ALLOC_STACK);
+    cb_free(NULL, CB_ALLOC_STACK);
+    
+    cb_alloc_get_stats(CB_ALLOC_STACK, &after);
+    CuAssertTrue(tc, after.frees == before.frees + 2);
+    CuAssertTrue(tc, after.live == before.live);
+    
+    cb_alloc_get_total_stats(&total);
+    CuAssertTrue(tc, total.peak >= after.peak);
+    CuAssertStrEquals(tc, "stacks",
+                      cb_alloc_get_subsystem_name(CB_ALLOC_STACK));
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_alloc_adopt() -- String values account adopted buffers
+// -----------------------------------------------------------------------------
+void test_alloc_adopt(CuTest *tc)
+{
+    CbAllocStats before, after;
+    cb_alloc_get_stats(CB_ALLOC_STRING, &before);
+    
+    CbValue* value = cb_string_create(strdup("adopted"));
+    cb_alloc_get_stats(CB_ALLOC_STRING, &after);
+    CuAssertTrue(tc, after.allocations == before.allocations + 1);
+    CuAssertTrue(tc, after.live > before.live);
+    
+    cb_value_free(value);
+    cb_alloc_get_stats(CB_ALLOC_STRING, &after);
+    CuAssertTrue(tc, after.live == before.live);
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_alloc_memstats() -- MemStats() returns a hash per subsystem
+// -----------------------------------------------------------------------------
+void test_alloc_memstats(CuTest *tc)
+{
+    Codeblock* cb = codeblock_create();
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_parse_string(cb,
+                      "| s | s := MemStats(), s,"));
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_execute(cb));
+    
+    CbArray* array = cb_valarray_get(cb->result);
+    CuAssertIntEquals(tc, CB_ALLOC_SUBSYSTEM_COUNT + 1,
+                      cb_array_get_count(array));
+    
+    CuAssertStrEquals(tc, "values", cb_string_get(test_alloc_memstats_get(
+                          array, CB_ALLOC_VALUE, "subsystem")));
+    CuAssertStrEquals(tc, "total", cb_string_get(test_alloc_memstats_get(
+                          array, CB_ALLOC_SUBSYSTEM_COUNT, "subsystem")));
+    CuAssertTrue(tc, cb_numeric_get(test_alloc_memstats_get(array,
+                     CB_ALLOC_SUBSYSTEM_COUNT, "allocations")) > 0);
+    
+    codeblock_free(cb);
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_alloc_quota() -- Exceeding the memory quota raises an error
+// -----------------------------------------------------------------------------
+void test_alloc_quota(CuTest *tc)
+{
+    CbLimits limits = { 0, 0, 0, 1024 * 1024 };
+    CbAllocStats before, after;
+    
+    cb_alloc_get_total_stats(&before);
+    cb_error_handling_initialize();
+    
+    // a single allocation beyond the quota fails
+    Codeblock* cb = codeblock_create();
+    cb->embedded  = true;
+    cb->limits    = &limits;
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_parse_string(cb,
+                      "Replicate('x', 100000000),"));
+    codeblock_execute(cb);
+    CuAssertIntEquals(tc, CB_ERR_CODE_MEMORYQUOTA, cb_error_get());
+    codeblock_free(cb);
+    cb_error_clear();
+    
+    // a growing array is stopped, the exception block releases it
+    cb            = codeblock_create();
+    cb->embedded  = true;
+    cb->limits    = &limits;
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_parse_string(cb,
+                      "| a, s |\n"
+                      "a := ArrayNew(0),\n"
+                      "startseq\n"
+                      "    while True do AAdd(a, 'xxxxxxxxxxxxxxxx'), end,\n"
+                      "onerror\n"
+                      "    a := 0,\n"
+                      "    s := GetErrorText(),\n"
+                      "stopseq,\n"
+                      "s,"));
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_execute(cb));
+    CuAssertTrue(tc, !cb_error_is_set());
+    CuAssertStrEquals(tc, "Memory quota exceeded", cb_string_get(cb->result));
+    codeblock_free(cb);
+    
+    // the exception block has some headroom, even if the array is kept
+    cb            = codeblock_create();
+    cb->embedded  = true;
+    cb->limits    = &limits;
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_parse_string(cb,
+                      "| a, m |\n"
+                      "a := ArrayNew(0),\n"
+                      "startseq\n"
+                      "    while True do AAdd(a, 'xxxxxxxxxxxxxxxx'), end,\n"
+                      "onerror\n"
+                      "    m := GetErrorText(),\n"
+                      "stopseq,\n"
+                      "m + ' ' + Str(ASize(a)),"));
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_execute(cb));
+    CuAssertTrue(tc, !cb_error_is_set());
+    const char* result = cb_string_get(cb->result);
+    CuAssertIntEquals(tc, 0, strncmp(result, "Memory quota exceeded ", 22));
+    CuAssertTrue(tc, atoi(result + 22) > 0);
+    codeblock_free(cb);
+    
+    cb_error_handling_finalize();
+    
+    // the quota is stopped and the memory is accounted correctly
+    CuAssertTrue(tc, cb_alloc_reserve(2 * 1024 * 1024));
+    cb_alloc_get_total_stats(&after);
+    CuAssertTrue(tc, after.live == before.live);
+}
+
+
+// #############################################################################
+// make suite
+// #############################################################################
+
+CuSuite* make_suite_alloc()
+{
+    CuSuite* suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_alloc_balance);
+    SUITE_ADD_TEST(suite, test_alloc_adopt);
+    SUITE_ADD_TEST(suite, test_alloc_memstats);
+    SUITE_ADD_TEST(suite, test_alloc_quota);
+    return suite;
+}
@@ -254,6 +254,220 @@ void test_valarray_value_to_string(CuTest *tc)
     cb_value_free(val2);
 }
 
+// -----------------------------------------------------------------------------
+// Test for the packed numeric layout
+// -----------------------------------------------------------------------------
+void test_array_packed_numeric(CuTest *tc)
+{
+    CbValue* item = NULL;
+    CbArray* a    = cb_array_create_valarray();
+    
+    int i = 0;
+    for (; i < 40; i++)
+        cb_array_append(a, cb_numeric_create(i));
+    
+    CuAssertIntEquals(tc, CB_ARRAY_LAYOUT_NUMERIC, cb_array_get_layout(a));
+    CuAssertIntEquals(tc, 40, cb_array_get_count(a));
+    
+    const CbNumeric* data = cb_array_get_numeric_data(a);
+    CuAssertPtrNotNull(tc, data);
+    CuAssertIntEquals(tc, 39, data[39]);
+    
+    CuAssertTrue(tc, cb_array_insert(a, cb_numeric_create(-5), 5));
+    CuAssertTrue(tc, cb_array_remove(a, 0));
+    CuAssertTrue(tc, cb_array_set(a, 1, cb_numeric_create(42)));
+    
+    // packed elements aren't stored as items
+    CuAssertTrue(tc, cb_array_get(a, 1, NULL));
+    CuAssertFalse(tc, cb_array_get(a, 1, (CbArrayItem*) &item));
+    CuAssertPtrEquals(tc, NULL, item);
+    
+    item = cb_array_get_value(a, 1);
+    CuAssertIntEquals(tc, CB_VT_NUMERIC, cb_value_get_type(item));
+    CuAssertIntEquals(tc, 42, cb_numeric_get(item));
+    cb_value_free(item);
+    
+    item = cb_array_get_value(a, 4);
+    CuAssertIntEquals(tc, -5, cb_numeric_get(item));
+    cb_value_free(item);
+    
+    item = cb_array_get_value(a, 5);
+    CuAssertIntEquals(tc, 5, cb_numeric_get(item));
+    cb_value_free(item);
+    
+    CuAssertPtrEquals(tc, NULL, cb_array_get_value(a, 40));
+    
+    CbArray* new_array = cb_array_copy(a);
+    CuAssertIntEquals(tc, CB_ARRAY_LAYOUT_NUMERIC,
+                      cb_array_get_layout(new_array));
+    item = cb_array_get_value(new_array, 39);
+    CuAssertIntEquals(tc, 39, cb_numeric_get(item));
+    cb_value_free(item);
+    
+    cb_array_free(new_array);
+    cb_array_free(a);
+}
+
+// -----------------------------------------------------------------------------
+// Test for cb_array_get_value() -- elements of a dense layout are independent
+//                                  values
+// -----------------------------------------------------------------------------
+void test_array_packed_values(CuTest *tc)
+{
+    CbArray* a = cb_array_create_valarray();
+    cb_array_append(a, cb_numeric_create(1));
+    cb_array_append(a, cb_numeric_create(2));
+    
+    CbArray* b = cb_array_create_valarray();
+    cb_array_append(b, cb_boolean_create(true));
+    cb_array_append(b, cb_boolean_create(false));
+    
+    // hold two elements of the same array at once
+    CbValue* first   = cb_array_get_value(a, 0);
+    CbValue* second  = cb_array_get_value(a, 1);
+    CbValue* flag    = cb_array_get_value(b, 0);
+    CbValue* no_flag = cb_array_get_value(b, 1);
+    
+    CuAssertIntEquals(tc, 1, cb_numeric_get(first));
+    CuAssertIntEquals(tc, 2, cb_numeric_get(second));
+    CuAssertTrue(tc, cb_boolean_get(flag));
+    CuAssertTrue(tc, !cb_boolean_get(no_flag));
+    
+    // change, grow and free the arrays
+    cb_array_set(a, 0, cb_numeric_create(10));
+    cb_array_set(b, 0, cb_boolean_create(false));
+    
+    int i = 0;
+    for (; i < 100; i++)
+    {
+        cb_array_append(a, cb_numeric_create(i));
+        cb_array_append(b, cb_boolean_create(true));
+    }
+    
+    cb_array_free(a);
+    cb_array_free(b);
+    
+    CuAssertIntEquals(tc, 1, cb_numeric_get(first));
+    CuAssertIntEquals(tc, 2, cb_numeric_get(second));
+    CuAssertTrue(tc, cb_boolean_get(flag));
+    CuAssertTrue(tc, !cb_boolean_get(no_flag));
+    
+    cb_value_free(first);
+    cb_value_free(second);
+    cb_value_free(flag);
+    cb_value_free(no_flag);
+}
+
+// -----------------------------------------------------------------------------
+// Test for the packed boolean layout
+// -----------------------------------------------------------------------------
+void test_array_packed_boolean(CuTest *tc)
+{
+    CbValue* item = NULL;
+    CbArray* a    = cb_array_create_valarray();
+    
+    int i = 0;
+    for (; i < 20; i++)
+        cb_array_append(a, cb_boolean_create(i % 3 == 0));
+    
+    CuAssertIntEquals(tc, CB_ARRAY_LAYOUT_BOOLEAN, cb_array_get_layout(a));
+    CuAssertPtrEquals(tc, NULL, (void*) cb_array_get_numeric_data(a));
+    
+    CuAssertTrue(tc, cb_array_insert(a, cb_boolean_create(true), 1));
+    CuAssertTrue(tc, cb_array_remove(a, 0));
+    
+    for (i = 0; i < 20; i++)
+    {
+        item = cb_array_get_value(a, i);
+        CuAssertPtrNotNull(tc, item);
+        CuAssertIntEquals(tc, CB_VT_BOOLEAN, cb_value_get_type(item));
+        CuAssertTrue(tc, cb_boolean_get(item) == (i == 0 || i % 3 == 0));
+        cb_value_free(item);
+    }
+    
+    cb_array_free(a);
+}
+
+// -----------------------------------------------------------------------------
+// Test fallback to the boxed layout for heterogeneous arrays
+// -----------------------------------------------------------------------------
+void test_array_packed_fallback(CuTest *tc)
+{
+    CbValue* item = NULL;
+    CbArray* a    = cb_array_create_valarray();
+    
+    cb_array_append(a, cb_numeric_create(1));
+    cb_array_append(a, cb_numeric_create(2));
+    CuAssertIntEquals(tc, CB_ARRAY_LAYOUT_NUMERIC, cb_array_get_layout(a));
+    
+    cb_array_append(a, cb_string_create(strdup("three")));
+    CuAssertIntEquals(tc, CB_ARRAY_LAYOUT_BOXED, cb_array_get_layout(a));
+    CuAssertPtrEquals(tc, NULL, (void*) cb_array_get_numeric_data(a));
+    
+    CuAssertTrue(tc, cb_array_get(a, 1, (CbArrayItem*) &item));
+    CuAssertIntEquals(tc, 2, cb_numeric_get(item));
+    
+    CuAssertTrue(tc, cb_array_get(a, 2, (CbArrayItem*) &item));
+    CuAssertStrEquals(tc, "three", cb_string_get(item));
+    
+    CbValue* val       = cb_valarray_create(a);
+    char* value_string = cb_value_to_string(val);
+    CuAssertStrEquals(tc, "{1,2,\"three\"}", value_string);
+    
+    free(value_string);
+    cb_value_free(val);
+}
+
+// -----------------------------------------------------------------------------
+// Test for cb_array_reserve() and cb_array_append_many()
+// -----------------------------------------------------------------------------
+void test_array_append_many(CuTest *tc)
+{
+    CbValue* item        = NULL;
+    CbArrayItem items[3] = {cb_numeric_create(1), cb_numeric_create(2),
+                            cb_numeric_create(3)};
+    CbArray* a           = cb_array_create_valarray();
+    
+    CuAssertTrue(tc, cb_array_reserve(a, 1000));
+    CuAssertIntEquals(tc, 0, cb_array_get_count(a));
+    
+    int i = 0;
+    for (; i < 1000; i++)
+        CuAssertTrue(tc, cb_array_append(a, cb_numeric_create(i)));
+    
+    CuAssertTrue(tc, cb_array_append_many(a, items, 3));
+    CuAssertIntEquals(tc, 1003, cb_array_get_count(a));
+    
+    item = cb_array_get_value(a, 999);
+    CuAssertIntEquals(tc, 999, cb_numeric_get(item));
+    cb_value_free(item);
+    
+    item = cb_array_get_value(a, 1002);
+    CuAssertIntEquals(tc, 3, cb_numeric_get(item));
+    cb_value_free(item);
+    
+    cb_array_free(a);
+}
+
+// -----------------------------------------------------------------------------
+// Test for cb_array_share()
+// -----------------------------------------------------------------------------
+void test_array_share(CuTest *tc)
+{
+    CbArray* a = cb_array_create_valarray();
+    cb_array_append(a, cb_numeric_create(1));
+    
+    CuAssertTrue(tc, !cb_array_is_shared(a));
+    CuAssertPtrEquals(tc, a, cb_array_share(a));
+    CuAssertTrue(tc, cb_array_is_shared(a));
+    
+    cb_array_free(a);
+    CuAssertTrue(tc, !cb_array_is_shared(a));
+    CuAssertIntEquals(tc, 1, cb_array_get_count(a));
+    
+    cb_array_free(a);
+}
+
 
 // #############################################################################
 // make suite
@@ -269,5 +483,11 @@ CuSuite* make_suite_array()
     SUITE_ADD_TEST(suite, test_array_remove);
     SUITE_ADD_TEST(suite, test_array_copy);
     SUITE_ADD_TEST(suite, test_valarray_value_to_string);
+    SUITE_ADD_TEST(suite, test_array_packed_numeric);
+    SUITE_ADD_TEST(suite, test_array_packed_values);
+    SUITE_ADD_TEST(suite, test_array_packed_boolean);
+    SUITE_ADD_TEST(suite, test_array_packed_fallback);
+    SUITE_ADD_TEST(suite, test_array_append_many);
+    SUITE_ADD_TEST(suite, test_array_share);
     return suite;
 }
@@ -40,6 +40,19 @@ int main(int argc, char *argv[])
     CuSuiteAddSuite_Custom(suite, make_suite_syntree());
     CuSuiteAddSuite_Custom(suite, make_suite_error_handling());
     CuSuiteAddSuite_Custom(suite, make_suite_array());
+    CuSuiteAddSuite_Custom(suite, make_suite_hash());
+    CuSuiteAddSuite_Custom(suite, make_suite_strbuf());
+    CuSuiteAddSuite_Custom(suite, make_suite_output());
+    CuSuiteAddSuite_Custom(suite, make_suite_reader());
+    CuSuiteAddSuite_Custom(suite, make_suite_image());
+    CuSuiteAddSuite_Custom(suite, make_suite_server());
+    CuSuiteAddSuite_Custom(suite, make_suite_repl());
+    CuSuiteAddSuite_Custom(suite, make_suite_profile());
+    CuSuiteAddSuite_Custom(suite, make_suite_alloc());
+    CuSuiteAddSuite_Custom(suite, make_suite_exec_limits());
+    CuSuiteAddSuite_Custom(suite, make_suite_pool());
+    CuSuiteAddSuite_Custom(suite, make_suite_optimizer());
+    CuSuiteAddSuite_Custom(suite, make_suite_jit());
     
     // run tests
     CuSuiteRun(suite);
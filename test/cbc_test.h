@@ -23,6 +23,19 @@ extern CuSuite* make_suite_codeblock_generic();
 extern CuSuite* make_suite_syntree();
 extern CuSuite* make_suite_error_handling();
 extern CuSuite* make_suite_array();
+extern CuSuite* make_suite_hash();
+extern CuSuite* make_suite_strbuf();
+extern CuSuite* make_suite_output();
+extern CuSuite* make_suite_reader();
+extern CuSuite* make_suite_image();
+extern CuSuite* make_suite_server();
+extern CuSuite* make_suite_repl();
+extern CuSuite* make_suite_profile();
+extern CuSuite* make_suite_alloc();
+extern CuSuite* make_suite_exec_limits();
+extern CuSuite* make_suite_pool();
+extern CuSuite* make_suite_optimizer();
+extern CuSuite* make_suite_jit();
 
 
 #endif // CBC_TEST_H
@@ -64,6 +64,30 @@ static const char cbstr_exception_block3[] =
     "   1,"\
     "stopseq,"\
     "foo,";
+static const char cbstr_exception_block4[] =
+    "| foo |"\
+    "function Fail(x)"\
+    "   Result := x / 0,"\
+    "end,"\
+    "foo := 'none',"\
+    "startseq"\
+    "   foo := { 1, 'a' + Str(1 + Fail(2)), { 'k' => Fail(3) } },"\
+    "onerror"\
+    "   foo := GetErrorText(),"\
+    "stopseq,"\
+    "foo,";
+static const char cbstr_exception_block5[] =
+    "| n, s |"\
+    "n := 2,"\
+    "s := '',"\
+    "startseq n := (n * 3) + (n - 1) / (n - 2), onerror s := s + 'a', stopseq,"\
+    "startseq n := n + Mod(n, 0), onerror s := s + 'b', stopseq,"\
+    "startseq"\
+    "   s := s + ('x' + Str(n < ASum({ 1, 'y' }))),"\
+    "onerror"\
+    "   s := s + 'c',"\
+    "stopseq,"\
+    "s + Str(n),";
 
 static void test_error(CuTest* tc, const char* codeblock_string,
                        const char* expected_error_message, cb_error_type type);
@@ -294,6 +318,17 @@ void test_exception_blocks(CuTest *tc)
     expected_value = cb_numeric_create(123);
     test_error_and_result(tc, cbstr_exception_block3, "", expected_value);
     cb_value_free(expected_value);
+    
+    // Test 4: an error unwinds nested expressions and calls
+    expected_value = cb_string_create(strdup("Division by zero is not "\
+                                             "allowed"));
+    test_error_and_result(tc, cbstr_exception_block4, "", expected_value);
+    cb_value_free(expected_value);
+    
+    // Test 5: operations and builtin functions throw, while operands are held
+    expected_value = cb_string_create(strdup("abc2"));
+    test_error_and_result(tc, cbstr_exception_block5, "", expected_value);
+    cb_value_free(expected_value);
 }
 
 void test_constant_error_messages(CuTest *tc)
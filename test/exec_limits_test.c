@@ -0,0 +1,215 @@
+/*******************************************************************************
+ * exec_limits_test -- Testing the execution limits
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <CuTest.h>
+#include "../exec_limits.h"
+#include "../codeblock.h"
+#include "../error_handling.h"
+#include "../jit.h"
+
+
+// #############################################################################
+// test scripts
+// #############################################################################
+
+// an endless loop, the handler takes some more steps after the limit
+static const char cbstr_exec_limits_handler[] =
+    "| i, m |\n"
+    "i := 0,\n"
+    "startseq\n"
+    "    while True do i := i + 1, end,\n"
+    "onerror\n"
+    "    m := GetErrorText(),\n"
+    "    i := 0,\n"
+    "    while i < 10 do i := i + 1, end,\n"
+    "stopseq,\n"
+    "m + ' ' + Str(i),";
+
+// endless recursion
+static const char cbstr_exec_limits_handler_recursion[] =
+    "| m |\n"
+    "function F(x)\n"
+    "    Result := F(x + 1),\n"
+    "end,\n"
+    "startseq\n"
+    "    F(1),\n"
+    "onerror\n"
+    "    m := GetErrorText(),\n"
+    "stopseq,\n"
+    "m,";
+
+
+// #############################################################################
+// utilities
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Execute a script with limits and get the error code (internal)
+// -----------------------------------------------------------------------------
+static CbErrorCode test_exec_limits_run(CuTest *tc, const char* script,
+                                        CbLimits* limits, Codeblock** result)
+{
+    Codeblock* cb = codeblock_create();
+    cb->embedded  = true; // don't print the error message
+    cb->limits    = limits;
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_parse_string(cb, script));
+    
+    cb_error_handling_initialize();
+    codeblock_execute(cb);
+    CbErrorCode code = cb_error_get();
+    cb_error_handling_finalize();
+    
+    CuAssertTrue(tc, !cb_limits_enabled);
+    
+    if (result)
+        *result = cb;
+    else
+        codeblock_free(cb);
+    
+    return code;
+}
+
+// -----------------------------------------------------------------------------
+// Execute a script catching an exceeded limit, check the handler's result
+// -----------------------------------------------------------------------------
+static void test_exec_limits_handle(CuTest *tc, const char* script,
+                                    CbLimits* limits, const char* expected)
+{
+    Codeblock* cb = NULL;
+    CuAssertIntEquals(tc, CB_ERR_CODE_NOERROR,
+                      test_exec_limits_run(tc, script, limits, &cb));
+    CuAssertPtrNotNull(tc, cb->result);
+    CuAssertStrEquals(tc, expected, cb_string_get(cb->result));
+    codeblock_free(cb);
+}
+
+
+// #############################################################################
+// test procedures
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Test: cb_limits_step() -- an endless loop exceeds the step limit
+// -----------------------------------------------------------------------------
+void test_exec_limits_steps(CuTest *tc)
+{
+    CbLimits limits = { 1000, 0, 0, 0 };
+    CuAssertIntEquals(tc, CB_ERR_CODE_STEPLIMIT,
+                      test_exec_limits_run(tc, "while True do 1, end,",
+                                           &limits, NULL));
+    CuAssertIntEquals(tc, 1001, (int) cb_limits_get_steps());
+    
+    // a script within the limit isn't affected
+    Codeblock* cb = NULL;
+    CuAssertIntEquals(tc, CB_ERR_CODE_NOERROR,
+                      test_exec_limits_run(tc, "| i | i := 0, "
+                                               "while i < 10 do i := i + 1, end, "
+                                               "i,",
+                                           &limits, &cb));
+    CuAssertPtrNotNull(tc, cb->result);
+    CuAssertIntEquals(tc, 10, (int) cb_numeric_get(cb->result));
+    CuAssertIntEquals(tc, 10, (int) cb_limits_get_steps());
+    codeblock_free(cb);
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_limits_step() -- an endless loop exceeds the deadline
+// -----------------------------------------------------------------------------
+void test_exec_limits_deadline(CuTest *tc)
+{
+    CbLimits limits = { 0, 50, 0, 0 };
+    CuAssertIntEquals(tc, CB_ERR_CODE_DEADLINE,
+                      test_exec_limits_run(tc, "while True do 1, end,",
+                                           &limits, NULL));
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_limits_enter_call() -- endless recursion exceeds the call depth
+// -----------------------------------------------------------------------------
+void test_exec_limits_call_depth(CuTest *tc)
+{
+    CbLimits limits = { 0, 0, 64, 0 };
+    CuAssertIntEquals(tc, CB_ERR_CODE_CALLDEPTH,
+                      test_exec_limits_run(tc, "function F(x) "
+                                               "    Result := F(x + 1), "
+                                               "end, "
+                                               "F(1),",
+                                           &limits, NULL));
+}
+
+// -----------------------------------------------------------------------------
+// Test: exceeded limits raise errors, which can be catched
+// -----------------------------------------------------------------------------
+void test_exec_limits_catch(CuTest *tc)
+{
+    CbLimits limits = { 100, 0, 0, 0 };
+    Codeblock* cb   = NULL;
+    CuAssertIntEquals(tc, CB_ERR_CODE_NOERROR,
+                      test_exec_limits_run(tc, "| s | "
+                                               "startseq "
+                                               "    while True do 1, end, "
+                                               "onerror "
+                                               "    s := 'stopped', "
+                                               "stopseq, "
+                                               "s,",
+                                           &limits, &cb));
+    CuAssertPtrNotNull(tc, cb->result);
+    CuAssertStrEquals(tc, "stopped", cb_string_get(cb->result));
+    codeblock_free(cb);
+}
+
+// -----------------------------------------------------------------------------
+// Test: the handler of an exceeded limit may take some more steps
+// -----------------------------------------------------------------------------
+void test_exec_limits_handler(CuTest *tc)
+{
+    CbLimits steps = { 1000, 0, 0, 0 };
+    test_exec_limits_handle(tc, cbstr_exec_limits_handler, &steps,
+                            "Step limit exceeded 10");
+    
+    CbLimits timeout = { 0, 50, 0, 0 };
+    test_exec_limits_handle(tc, cbstr_exec_limits_handler, &timeout,
+                            "Execution deadline exceeded 10");
+    
+    CbLimits call_depth = { 0, 0, 64, 0 };
+    test_exec_limits_handle(tc, cbstr_exec_limits_handler_recursion,
+                            &call_depth, "Call depth limit exceeded");
+    
+    // the JIT compiler leaves loops to the interpreter under limits
+    if (cb_jit_enable() == EXIT_SUCCESS)
+    {
+        test_exec_limits_handle(tc, cbstr_exec_limits_handler, &steps,
+                                "Step limit exceeded 10");
+        cb_jit_disable();
+    }
+    
+    // the extension is granted once, an endless handler is stopped as well
+    CuAssertIntEquals(tc, CB_ERR_CODE_STEPLIMIT,
+                      test_exec_limits_run(tc, "startseq "
+                                               "    while True do 1, end, "
+                                               "onerror "
+                                               "    while True do 1, end, "
+                                               "stopseq,",
+                                           &steps, NULL));
+    CuAssertIntEquals(tc, 1001 + CB_LIMITS_HANDLER_STEPS + 1,
+                      (int) cb_limits_get_steps());
+}
+
+
+// #############################################################################
+// make suite
+// #############################################################################
+
+CuSuite* make_suite_exec_limits()
+{
+    CuSuite* suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_exec_limits_steps);
+    SUITE_ADD_TEST(suite, test_exec_limits_deadline);
+    SUITE_ADD_TEST(suite, test_exec_limits_call_depth);
+    SUITE_ADD_TEST(suite, test_exec_limits_catch);
+    SUITE_ADD_TEST(suite, test_exec_limits_handler);
+    return suite;
+}
@@ -11,6 +11,7 @@
 #include "../value.h"
 #include "../codeblock.h"
 #include "../syntree.h"
+#include "../image.h"
 
 
 // #############################################################################
@@ -80,7 +81,23 @@ const CbTestValue expected_results[] = {
     {CB_VT_NUMERIC, 8},
     {CB_VT_NUMERIC, 0},
     {CB_VT_STRING, (CbNumeric) "1234567890"},
-    {CB_VT_STRING, (CbNumeric) "LNCU"}     // Testcase 45
+    {CB_VT_STRING, (CbNumeric) "LNCU"},    // Testcase 45
+    {CB_VT_NUMERIC, 31},
+    {CB_VT_NUMERIC, 14},
+    {CB_VT_NUMERIC, 28},
+    {CB_VT_STRING, (CbNumeric) "Array must contain numeric values only"},
+    {CB_VT_NUMERIC, 500500},
+    {CB_VT_NUMERIC, 35},
+    {CB_VT_NUMERIC, 1227},
+    {CB_VT_STRING, (CbNumeric) "Hash key not found"},
+    {CB_VT_STRING, (CbNumeric) "7.25 2 9.223372036854776e+18 1.5"},
+    {CB_VT_NUMERIC, 1008999999989LL},       // Testcase 55
+    {CB_VT_NUMERIC, 7263},
+    {CB_VT_STRING, (CbNumeric) "Invalid file handle"},
+    {CB_VT_STRING, (CbNumeric) "6 Argument has an invalid value-type"},
+    {CB_VT_STRING, (CbNumeric) "5 Argument has an invalid value-type"},
+    {CB_VT_NUMERIC, 1292332},               // Testcase 60
+    {CB_VT_STRING, (CbNumeric) "0.3333333333333333 0.30000000000000004 0.25"}
 };
 
 // CbTestString -- Combination of a test codeblock string and the expected result
@@ -127,9 +144,13 @@ static const CbTestString cbstrings_logical_gates[] = {
 
 // -----------------------------------------------------------------------------
 // Test a specific codeblock script file (internal)
+//
+//    If use_image is set, the parsed syntax-tree is replaced by the tree
+//    rebuilt from its compiled image.
 // -----------------------------------------------------------------------------
 static void test_codeblock_file(CuTest *tc, const char* test_file_name,
-                                const CbTestValue* expected_result)
+                                const CbTestValue* expected_result,
+                                bool use_image)
 {
     FILE* test_file = fopen(test_file_name, "r");
     if (!test_file)
@@ -143,6 +164,19 @@ static void test_codeblock_file(CuTest *tc, const char* test_file_name,
     
     fclose(test_file);
     
+    if (use_image)
+    {
+        CbStrbuf image;
+        cb_strbuf_init(&image);
+        cb_image_write(cb->ast, &image);
+        
+        cb_syntree_free(cb->ast);
+        cb->ast = cb_image_read(image.data, image.length);
+        cb_strbuf_release(&image);
+        
+        CuAssertPtrNotNull(tc, cb->ast);
+    }
+    
     codeblock_execute(cb);
     
     CuAssertIntEquals(tc, expected_result->type, cb_value_get_type(cb->result));
@@ -153,7 +187,9 @@ static void test_codeblock_file(CuTest *tc, const char* test_file_name,
             break;
         
         case CB_VT_NUMERIC:
-            CuAssertIntEquals(tc, expected_result->value, cb_numeric_get(cb->result));
+            // CuAssertIntEquals() would truncate 64-bit values
+            CuAssert(tc, test_file_name,
+                     expected_result->value == cb_numeric_get(cb->result));
             break;
         
         case CB_VT_STRING:
@@ -209,9 +245,9 @@ void test_codeblock_string(CuTest *tc, const CbTestString* test_data)
 // #############################################################################
 
 // -----------------------------------------------------------------------------
-// Test: test_codeblock_all_files() -- Test all codeblock script files
+// Test all codeblock script files (internal)
 // -----------------------------------------------------------------------------
-void test_codeblock_all_files(CuTest *tc)
+static void test_codeblock_files(CuTest *tc, bool use_image)
 {
     int testcase       = 0;
     int testcase_count = sizeof(expected_results) / sizeof(CbTestValue);
@@ -221,11 +257,28 @@ void test_codeblock_all_files(CuTest *tc)
         char* file_name = (char*) malloc(256);
         *file_name      = '\0';
         sprintf(file_name, TEST_FILES_DIR "/testcase_%d.dwp", testcase);
-        test_codeblock_file(tc, file_name, &expected_results[testcase]);
+        test_codeblock_file(tc, file_name, &expected_results[testcase],
+                            use_image);
         free(file_name);
     }
 }
 
+// -----------------------------------------------------------------------------
+// Test: test_codeblock_all_files() -- Test all codeblock script files
+// -----------------------------------------------------------------------------
+void test_codeblock_all_files(CuTest *tc)
+{
+    test_codeblock_files(tc, false);
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_codeblock_all_images() -- Test all script files as images
+// -----------------------------------------------------------------------------
+void test_codeblock_all_images(CuTest *tc)
+{
+    test_codeblock_files(tc, true);
+}
+
 // -----------------------------------------------------------------------------
 // Test logical gates (such as: AND, OR, NOT)
 // -----------------------------------------------------------------------------
@@ -247,6 +300,7 @@ CuSuite* make_suite_codeblock_generic()
 {
     CuSuite* suite = CuSuiteNew();
     SUITE_ADD_TEST(suite, test_codeblock_all_files);
+    SUITE_ADD_TEST(suite, test_codeblock_all_images);
     SUITE_ADD_TEST(suite, test_codeblock_logical_gates);
     return suite;
 }
@@ -0,0 +1,148 @@
+/*******************************************************************************
+ * hash_test -- Testing the CbHash structure
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <CuTest.h>
+#include "CuTestCustomUtils.h"
+#include "../hash.h"
+#include "../value.h"
+
+// #############################################################################
+// test procedures
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Test: test_hash() -- Simple test for CbHash
+// -----------------------------------------------------------------------------
+void test_hash(CuTest *tc)
+{
+    CbHash* h      = cb_hash_create();
+    CbValue* key   = cb_string_create(strdup("foo"));
+    CbValue* value = NULL;
+    
+    CuAssertTrue(tc, cb_hash_set(h, key, cb_numeric_create(123)));
+    CuAssertIntEquals(tc, 1, cb_hash_get_count(h));
+    
+    value = cb_hash_get(h, key);
+    CuAssertPtrNotNull(tc, value);
+    CuAssertIntEquals(tc, 123, cb_numeric_get(value));
+    
+    // replace value of existing key
+    CuAssertTrue(tc, cb_hash_set(h, key, cb_numeric_create(321)));
+    CuAssertIntEquals(tc, 1, cb_hash_get_count(h));
+    CuAssertIntEquals(tc, 321, cb_numeric_get(cb_hash_get(h, key)));
+    
+    CuAssertTrue(tc, cb_hash_remove(h, key));
+    CuAssertTrue(tc, !cb_hash_has(h, key));
+    CuAssertTrue(tc, !cb_hash_remove(h, key));
+    CuAssertIntEquals(tc, 0, cb_hash_get_count(h));
+    
+    cb_value_free(key);
+    cb_hash_free(h);
+}
+
+// -----------------------------------------------------------------------------
+// Test numeric and string keys
+// -----------------------------------------------------------------------------
+void test_hash_keys(CuTest *tc)
+{
+    CbHash* h         = cb_hash_create();
+    CbValue* num_key  = cb_numeric_create(1);
+    CbValue* str_key  = cb_string_create(strdup("1"));
+    CbValue* bool_key = cb_boolean_create(true);
+    
+    CuAssertTrue(tc, cb_hash_set(h, num_key, cb_numeric_create(10)));
+    CuAssertTrue(tc, cb_hash_set(h, str_key, cb_numeric_create(20)));
+    CuAssertTrue(tc, !cb_hash_set(h, bool_key, cb_numeric_create(30)));
+    
+    CuAssertIntEquals(tc, 2, cb_hash_get_count(h));
+    CuAssertIntEquals(tc, 10, cb_numeric_get(cb_hash_get(h, num_key)));
+    CuAssertIntEquals(tc, 20, cb_numeric_get(cb_hash_get(h, str_key)));
+    CuAssertPtrEquals(tc, NULL, cb_hash_get(h, bool_key));
+    
+    cb_value_free(num_key);
+    cb_value_free(str_key);
+    cb_value_free(bool_key);
+    cb_hash_free(h);
+}
+
+// -----------------------------------------------------------------------------
+// Test growth, removal and insertion order
+// -----------------------------------------------------------------------------
+void test_hash_iterate(CuTest *tc)
+{
+    CbHash* h = cb_hash_create();
+    
+    int i = 0;
+    for (; i < 1000; i++)
+    {
+        CbValue* key = cb_numeric_create(i);
+        cb_hash_set(h, key, cb_numeric_create(i * 2));
+        cb_value_free(key);
+    }
+    
+    // remove all odd keys
+    for (i = 1; i < 1000; i += 2)
+    {
+        CbValue* key = cb_numeric_create(i);
+        CuAssertTrue(tc, cb_hash_remove(h, key));
+        cb_value_free(key);
+    }
+    
+    CuAssertIntEquals(tc, 500, cb_hash_get_count(h));
+    
+    CbHash* copy       = cb_hash_copy(h);
+    size_t position    = 0;
+    const CbValue* key = NULL;
+    CbValue* value     = NULL;
+    
+    for (i = 0; cb_hash_iterate(copy, &position, &key, &value); i += 2)
+    {
+        CuAssertIntEquals(tc, i, cb_numeric_get(key));
+        CuAssertIntEquals(tc, i * 2, cb_numeric_get(value));
+    }
+    
+    CuAssertIntEquals(tc, 1000, i);
+    
+    cb_hash_free(copy);
+    cb_hash_free(h);
+}
+
+// -----------------------------------------------------------------------------
+// Test CbValHash cb_value_to_string() function
+// -----------------------------------------------------------------------------
+void test_valhash_value_to_string(CuTest *tc)
+{
+    CbHash* h   = cb_hash_create();
+    CbValue* k1 = cb_string_create(strdup("foo"));
+    CbValue* k2 = cb_numeric_create(2);
+    
+    cb_hash_set(h, k1, cb_numeric_create(-5));
+    cb_hash_set(h, k2, cb_string_create(strdup("bar")));
+    
+    CbValue* val       = cb_valhash_create(h);
+    char* value_string = cb_value_to_string(val);
+    CuAssertStrEquals(tc, "{\"foo\"=>-5,2=>\"bar\"}", value_string);
+    
+    free(value_string);
+    cb_value_free(val);
+    cb_value_free(k1);
+    cb_value_free(k2);
+}
+
+
+// #############################################################################
+// make suite
+// #############################################################################
+
+CuSuite* make_suite_hash()
+{
+    CuSuite* suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_hash);
+    SUITE_ADD_TEST(suite, test_hash_keys);
+    SUITE_ADD_TEST(suite, test_hash_iterate);
+    SUITE_ADD_TEST(suite, test_valhash_value_to_string);
+    return suite;
+}
@@ -0,0 +1,204 @@
+/*******************************************************************************
+ * image_test -- Testing the compiled image format
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <CuTest.h>
+#include "CuTestCustomUtils.h"
+#include "../image.h"
+#include "../codeblock.h"
+#include "../syntree.h"
+#include "../exception_block_node.h"
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+#define TEST_IMAGE_FILE "./image_test.cbo"
+
+static const char* test_image_script =
+    "| s, a, h | s := 'abc', a := {1, 2.5, s}, h := {'x' => s},\n"
+    "if Len(s) > 2 then s := s + 'd', else s := '', endif,\n"
+    "s + HGet(h, 'x'),\n";
+
+
+// #############################################################################
+// utilities
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Parse the test script and write its image (internal)
+// -----------------------------------------------------------------------------
+static void test_image_create(CuTest *tc, CbStrbuf* image)
+{
+    Codeblock* cb = codeblock_create();
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      codeblock_parse_string(cb, test_image_script));
+    
+    cb_strbuf_init(image);
+    cb_image_write(cb->ast, image);
+    
+    codeblock_free(cb);
+}
+
+// -----------------------------------------------------------------------------
+// Write the image of a tree and read it back (internal)
+// -----------------------------------------------------------------------------
+static CbSyntree* test_image_reread(CbSyntree* ast)
+{
+    CbStrbuf image;
+    cb_strbuf_init(&image);
+    cb_image_write(ast, &image);
+    cb_syntree_free(ast);
+    
+    CbSyntree* result = cb_image_read(image.data, image.length);
+    cb_strbuf_release(&image);
+    
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// Create a chain of nested nodes (internal)
+// -----------------------------------------------------------------------------
+static CbSyntree* test_image_nested_tree(int depth)
+{
+    CbSyntree* ast = cb_constbool_create(true);
+    
+    int i = 1;
+    for (; i < depth; i++)
+        ast = cb_syntree_create(SNT_LOGICAL_NOT, ast, NULL);
+    
+    return ast;
+}
+
+
+// #############################################################################
+// test procedures
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Test: test_image_header() -- Check header and interned strings
+// -----------------------------------------------------------------------------
+void test_image_header(CuTest *tc)
+{
+    CbStrbuf image;
+    test_image_create(tc, &image);
+    
+    CbImageHeader header;
+    memcpy(&header, image.data, sizeof(header));
+    
+    CuAssertTrue(tc, cb_image_is_image(image.data, image.length));
+    CuAssertIntEquals(tc, CB_IMAGE_VERSION, header.version);
+    CuAssertIntEquals(tc, image.length, header.size);
+    // s, a, h, 'abc', 'x', Len, 'd', '', HGet
+    CuAssertIntEquals(tc, 9, header.string_count);
+    
+    cb_strbuf_release(&image);
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_image_file() -- Save and execute an image file
+// -----------------------------------------------------------------------------
+void test_image_file(CuTest *tc)
+{
+    Codeblock* cb = codeblock_create();
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      codeblock_parse_string(cb, test_image_script));
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      codeblock_save_image(cb, TEST_IMAGE_FILE));
+    codeblock_free(cb);
+    
+    CuAssertTrue(tc, cb_image_file_is_image(TEST_IMAGE_FILE));
+    
+    cb = codeblock_create();
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      codeblock_load_image(cb, TEST_IMAGE_FILE));
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_execute(cb));
+    CuAssertStrEquals(tc, "abcdabc", cb_string_get(cb->result));
+    codeblock_free(cb);
+    
+    unlink(TEST_IMAGE_FILE);
+    
+    CuAssertTrue(tc, !cb_image_file_is_image("./testfiles/testcase_0.dwp"));
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_image_corrupted() -- Reject corrupted and truncated images
+// -----------------------------------------------------------------------------
+void test_image_corrupted(CuTest *tc)
+{
+    CbStrbuf image;
+    test_image_create(tc, &image);
+    
+    CbSyntree* ast = cb_image_read(image.data, image.length);
+    CuAssertPtrNotNull(tc, ast);
+    cb_syntree_free(ast);
+    
+    // truncated
+    CuAssertPtrEquals(tc, NULL, cb_image_read(image.data, image.length - 1));
+    
+    // a single flipped bit of a node
+    image.data[image.length - 5] ^= 0x10;
+    CuAssertPtrEquals(tc, NULL, cb_image_read(image.data, image.length));
+    image.data[image.length - 5] ^= 0x10;
+    
+    // unsupported version
+    image.data[8]++;
+    CuAssertPtrEquals(tc, NULL, cb_image_read(image.data, image.length));
+    
+    cb_strbuf_release(&image);
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_image_nesting() -- Reject images nested too deeply
+// -----------------------------------------------------------------------------
+void test_image_nesting(CuTest *tc)
+{
+    CbSyntree* ast = test_image_reread(
+                         test_image_nested_tree(CB_IMAGE_MAX_DEPTH));
+    CuAssertPtrNotNull(tc, ast);
+    cb_syntree_free(ast);
+    
+    CuAssertPtrEquals(tc, NULL, test_image_reread(
+                          test_image_nested_tree(CB_IMAGE_MAX_DEPTH + 1)));
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_image_enums() -- Reject nodes with an invalid enum value
+// -----------------------------------------------------------------------------
+void test_image_enums(CuTest *tc)
+{
+    CbSyntree* ast = test_image_reread(cb_comparison_create(CMP_LT,
+                                           cb_constbool_create(true),
+                                           cb_constbool_create(false)));
+    CuAssertPtrNotNull(tc, ast);
+    cb_syntree_free(ast);
+    
+    CuAssertPtrEquals(tc, NULL, test_image_reread(
+                          cb_comparison_create(CMP_LT + 1,
+                                               cb_constbool_create(true),
+                                               cb_constbool_create(false))));
+    
+    CuAssertPtrEquals(tc, NULL, test_image_reread(
+                          cb_exception_block_create(EXBL_ALWAYS + 1,
+                              cb_constbool_create(true),
+                              cb_constbool_create(false))));
+}
+
+
+// #############################################################################
+// make suite
+// #############################################################################
+
+CuSuite* make_suite_image()
+{
+    CuSuite* suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_image_header);
+    SUITE_ADD_TEST(suite, test_image_file);
+    SUITE_ADD_TEST(suite, test_image_corrupted);
+    SUITE_ADD_TEST(suite, test_image_nesting);
+    SUITE_ADD_TEST(suite, test_image_enums);
+    return suite;
+}
@@ -0,0 +1,307 @@
+/*******************************************************************************
+ * jit_test -- Testing the JIT compiler
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <CuTest.h>
+#include "../jit.h"
+#include "../optimizer.h"
+#include "../syntree.h"
+#include "../codeblock.h"
+#include "../error_handling.h"
+#include "../exec_limits.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+static const char cbstr_jit_loops[] =
+    "| i, j, n, m |"\
+    "function Sq(x)"\
+    "   Result := x * x,"\
+    "end,"\
+    "i := 0, n := 0, m := 0,"\
+    "while i < 200 do"\
+    "   j := 0,"\
+    "   while (j < i) and not (j = 150) do"\
+    "      if j > 100 then n := n + Sq(j), else m := m - j, endif,"\
+    "      j := j + 1,"\
+    "   end,"\
+    "   i := i + 1,"\
+    "end,"\
+    "i := 0,"\
+    "while i < 1000 do"\
+    "   i := i + 1,"\
+    "   n := n + i * m,"\
+    "end,";
+static const char cbstr_jit_kept[] =
+    "| i, s, f |"\
+    "i := 0, s := '', f := 0.5,"\
+    "while i < 100 do s := s + 'a', i := i + 1, end,"\
+    "while i < 200 do i := i + 1, f := f * 2.0, end,"\
+    "while i < 300 do i := i + Len(s), end,"\
+    "while i < 400 do i := i + 1, if i > 350 then f := 1, endif, end,"\
+    "i + Len(s) + f,";
+static const char cbstr_jit_deoptimise[] =
+    "| i, big, q |"\
+    "i := 0, big := 9223372036854775000, q := 0,"\
+    "while i < 1000 do big := big + 1, i := i + 1, end,"\
+    "i := 0,"\
+    "while i < 100 do i := i + 1, q := q + 1000 / (i * 2), end,"\
+    "big + q,";
+static const char cbstr_jit_error[] =
+    "| i, n, x |\n"\
+    "i := 0, n := 0, x := 100,\n"\
+    "startseq\n"\
+    "   while i < 200 do\n"\
+    "      i := i + 1,\n"\
+    "      n := n + (x - i) / (x - i),\n"\
+    "   end,\n"\
+    "onerror\n"\
+    "   n := n * 1000 + i,\n"\
+    "stopseq,\n"\
+    "n,\n";
+static const char cbstr_jit_guard[] =
+    "| k, i, n |\n"\
+    "k := 0, n := 0,\n"\
+    "while k < 3 do\n"\
+    "   i := 0,\n"\
+    "   while i < 100 do\n"\
+    "      n := n + i,\n"\
+    "      i := i + 1,\n"\
+    "   end,\n"\
+    "   if k = 1 then n := 'a', endif,\n"\
+    "   k := k + 1,\n"\
+    "end,\n"\
+    "n,\n";
+
+// count of loops wrapped for the JIT compiler, if it is available
+#ifdef CB_JIT_AVAILABLE
+#define TEST_JIT_LOOPS(count) (count)
+#else
+#define TEST_JIT_LOOPS(count) 0
+#endif // CB_JIT_AVAILABLE
+
+// count of nodes of a type
+typedef struct
+{
+    enum cb_syntree_node_type type;
+    int count;
+} TestJitCount;
+
+static void test_jit_count_node(CbSyntree** node, void* count);
+static void test_jit_read_stream(FILE* stream, char* string, size_t size);
+
+
+// #############################################################################
+// utilities
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Execute a script, check its numeric result or error message and get the
+// count of loops wrapped for the JIT compiler (internal)
+// -----------------------------------------------------------------------------
+static int test_jit_execute(CuTest *tc, const char* script, bool jit,
+                            double expected_result,
+                            const char* expected_error)
+{
+    FILE* err_out = tmpfile();
+    cb_set_error_output(err_out);
+    
+    if (jit)
+        cb_jit_enable();
+    
+    Codeblock* cb = codeblock_create();
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_parse_string(cb, script));
+    codeblock_execute(cb);
+    cb_jit_disable();
+    
+    char error[256];
+    test_jit_read_stream(err_out, error, sizeof(error));
+    cb_set_error_output(stderr);
+    fclose(err_out);
+    
+    if (expected_error)
+    {
+        CuAssertStrEquals(tc, expected_error, error);
+        CuAssertPtrEquals(tc, NULL, cb->result);
+    }
+    else
+    {
+        CuAssertStrEquals(tc, "", error);
+        CuAssertPtrNotNull(tc, cb->result);
+        CuAssertDblEquals(tc, expected_result,
+                          cb_numeric_get_float(cb->result), 0.0);
+    }
+    
+    TestJitCount count = { SNT_JIT_LOOP, 0 };
+    test_jit_count_node(&cb->ast, &count);
+    codeblock_free(cb);
+    
+    return count.count;
+}
+
+// -----------------------------------------------------------------------------
+// Execute a script with and without the JIT compiler, compare the numeric
+// results and error messages and get the count of loops wrapped for the JIT
+// compiler (internal)
+// -----------------------------------------------------------------------------
+static int test_jit_run(CuTest *tc, const char* script,
+                        double expected_result, const char* expected_error)
+{
+    CuAssertIntEquals(tc, 0, test_jit_execute(tc, script, false,
+                                              expected_result,
+                                              expected_error));
+    
+    return test_jit_execute(tc, script, true, expected_result,
+                            expected_error);
+}
+
+
+// #############################################################################
+// test procedures
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Test: cb_jit_loop_node_eval() -- hot integer loops are compiled
+// -----------------------------------------------------------------------------
+void test_jit_compile(CuTest *tc)
+{
+    CbJitStats before, after;
+    cb_jit_get_stats(&before);
+    
+    // the inner loop with an inlined call and the last loop, whose result is
+    // the result of the script, but not the outer loop
+    CuAssertIntEquals(tc, TEST_JIT_LOOPS(2),
+                      test_jit_run(tc, cbstr_jit_loops, -333578368550.0,
+                                   NULL));
+    cb_jit_get_stats(&after);
+    
+    CuAssertTrue(tc, after.compiled_loops == before.compiled_loops +
+                                             TEST_JIT_LOOPS(2));
+    CuAssertTrue(tc, after.deopts == before.deopts);
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_jit_can_compile() -- loops, which don't only compute integers, are
+//                               interpreted
+// -----------------------------------------------------------------------------
+void test_jit_kept(CuTest *tc)
+{
+    // strings, floats, calls of builtin functions and a loop, whose last
+    // statement isn't an assignment
+    CuAssertIntEquals(tc, 0, test_jit_run(tc, cbstr_jit_kept, 501.0, NULL));
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_jit_loop_node_eval() -- overflows and divisions with a remainder
+//                                  deoptimise the loop
+// -----------------------------------------------------------------------------
+void test_jit_deoptimise(CuTest *tc)
+{
+    CbJitStats before, after;
+    cb_jit_get_stats(&before);
+    
+    // the sum becomes a float, after it exceeds the integer range
+    CuAssertIntEquals(tc, TEST_JIT_LOOPS(2),
+                      test_jit_run(tc, cbstr_jit_deoptimise,
+                                   9.2233720368547779e+18, NULL));
+    cb_jit_get_stats(&after);
+    
+    CuAssertTrue(tc, after.deopts >= before.deopts + TEST_JIT_LOOPS(1));
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_jit_loop_node_eval() -- errors are raised by the interpreter at the
+//                                  same point of the execution
+// -----------------------------------------------------------------------------
+void test_jit_error(CuTest *tc)
+{
+    // the division by zero is caught in the 100th iteration
+    CuAssertIntEquals(tc, TEST_JIT_LOOPS(1),
+                      test_jit_run(tc, cbstr_jit_error, 99100.0, NULL));
+    
+    // the inner loop is entered with a string
+    CuAssertIntEquals(tc, TEST_JIT_LOOPS(1),
+                      test_jit_run(tc, cbstr_jit_guard, 0.0,
+                                   "Runtime error: Line 6: "
+                                   "Node type of left-hand side differs "
+                                   "from right-hand side"));
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_jit_loop_node_eval() -- the execution limits count every iteration
+// -----------------------------------------------------------------------------
+void test_jit_limits(CuTest *tc)
+{
+    CbLimits limits = { 1000, 0, 0, 0 };
+    
+    cb_jit_enable();
+    
+    Codeblock* cb = codeblock_create();
+    cb->embedded  = true; // don't print the error message
+    cb->limits    = &limits;
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      codeblock_parse_string(cb, "| i | i := 0, "
+                                                 "while i < 5000 do "
+                                                 "i := i + 1, end, i,"));
+    
+    cb_error_handling_initialize();
+    codeblock_execute(cb);
+    CuAssertIntEquals(tc, CB_ERR_CODE_STEPLIMIT, cb_error_get());
+    cb_error_handling_finalize();
+    
+    CuAssertIntEquals(tc, 1001, (int) cb_limits_get_steps());
+    
+    cb_jit_disable();
+    codeblock_free(cb);
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Count a node and its child-nodes, if they are of the counted type (internal)
+// -----------------------------------------------------------------------------
+static void test_jit_count_node(CbSyntree** node, void* count)
+{
+    if ((*node)->type == ((TestJitCount*) count)->type)
+        ((TestJitCount*) count)->count++;
+    
+    cb_optimizer_visit_children(*node, test_jit_count_node, count);
+}
+
+// -----------------------------------------------------------------------------
+// Read the content of a stream without trailing line breaks (internal)
+// -----------------------------------------------------------------------------
+static void test_jit_read_stream(FILE* stream, char* string, size_t size)
+{
+    fseek(stream, 0, SEEK_SET);
+    size_t length = fread(string, 1, size - 1, stream);
+    
+    while (length > 0 && (string[length - 1] == '\n' ||
+                          string[length - 1] == '\r'))
+        length--;
+    
+    string[length] = '\0';
+}
+
+
+// #############################################################################
+// make suite
+// #############################################################################
+
+CuSuite* make_suite_jit()
+{
+    CuSuite* suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_jit_compile);
+    SUITE_ADD_TEST(suite, test_jit_kept);
+    SUITE_ADD_TEST(suite, test_jit_deoptimise);
+    SUITE_ADD_TEST(suite, test_jit_error);
+    SUITE_ADD_TEST(suite, test_jit_limits);
+    return suite;
+}
@@ -0,0 +1,421 @@
+/*******************************************************************************
+ * microbench -- Microbenchmarks of the core data structures
+ *
+ *               Every case runs with input sizes from 10 to 10^6 (up to the
+ *               case's maximum, since some operations are quadratic). A case
+ *               is repeated until it ran for MICROBENCH_MIN_TIME in total,
+ *               the fastest repetition is reported as nanoseconds per
+ *               operation. The results are printed as table and written as
+ *               CSV:
+ *
+ *                 microbench [<file.csv>] [<case-prefix>]
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "../stack.h"
+#include "../strlist.h"
+#include "../array.h"
+#include "../symtab.h"
+#include "../symbol.h"
+#include "../value.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+// minimum run-time of a case per input size in nanoseconds
+#define MICROBENCH_MIN_TIME 20000000u
+
+// maximum count of repetitions per input size
+#define MICROBENCH_MAX_REPEAT 1000
+
+// largest input size
+#define MICROBENCH_MAX_SIZE 1000000
+
+// default file of the CSV output
+#define MICROBENCH_CSV_FILE "microbench.csv"
+
+// count of items processed per run by the value cases
+#define MICROBENCH_BATCH_ITEMS 1000000
+
+// runs a case with an input size, returns the measured nanoseconds
+typedef uint64_t (*MicrobenchFunction)(size_t size, size_t* ops);
+
+typedef struct
+{
+    const char* name;
+    MicrobenchFunction function;
+    size_t max_size;                // larger sizes are skipped
+} MicrobenchCase;
+
+static uint64_t microbench_now();
+static size_t microbench_batch(size_t size);
+static CbValue* microbench_create_array(size_t size);
+static uint64_t microbench_stack_push_pop(size_t size, size_t* ops);
+static uint64_t microbench_strlist_append(size_t size, size_t* ops);
+static uint64_t microbench_array_append(size_t size, size_t* ops);
+static uint64_t microbench_array_insert(size_t size, size_t* ops);
+static uint64_t microbench_array_remove(size_t size, size_t* ops);
+static uint64_t microbench_symtab_lookup(size_t size, size_t* ops);
+static uint64_t microbench_scope_enter_leave(size_t size, size_t* ops);
+static uint64_t microbench_value_copy_string(size_t size, size_t* ops);
+static uint64_t microbench_value_copy_array(size_t size, size_t* ops);
+static uint64_t microbench_value_to_string(size_t size, size_t* ops);
+
+static const MicrobenchCase cases[] = {
+    {"stack_push_pop",      microbench_stack_push_pop,    1000000},
+    {"strlist_append",      microbench_strlist_append,    10000},
+    {"array_append",        microbench_array_append,      1000000},
+    {"array_insert_front",  microbench_array_insert,      10000},
+    {"array_remove_front",  microbench_array_remove,      10000},
+    {"symtab_lookup",       microbench_symtab_lookup,     10000},
+    {"scope_enter_leave",   microbench_scope_enter_leave, 10000},
+    {"value_copy_string",   microbench_value_copy_string, 1000000},
+    {"value_copy_array",    microbench_value_copy_array,  1000000},
+    {"value_to_string",     microbench_value_to_string,   1000000}
+};
+
+
+// #############################################################################
+// main
+// #############################################################################
+
+int main(int argc, char* argv[])
+{
+    const char* csv_name = (argc > 1) ? argv[1] : MICROBENCH_CSV_FILE;
+    const char* prefix   = (argc > 2) ? argv[2] : "";
+    
+    FILE* csv = fopen(csv_name, "w");
+    if (!csv)
+    {
+        fprintf(stderr, "Unable to write file `%s'\n", csv_name);
+        return EXIT_FAILURE;
+    }
+    
+    fprintf(csv, "case,size,ns_per_op,ops_per_sec\n");
+    printf("%-20s %8s %14s %14s\n", "Case", "Size", "ns/op", "ops/sec");
+    
+    size_t c = 0;
+    for (; c < sizeof(cases) / sizeof(cases[0]); c++)
+    {
+        if (strncmp(cases[c].name, prefix, strlen(prefix)) != 0)
+            continue;
+        
+        size_t size = 10;
+        for (; size <= MICROBENCH_MAX_SIZE; size *= 10)
+        {
+            if (size > cases[c].max_size)
+            {
+                printf("%-20s %8zu %14s %14s\n", cases[c].name, size, "-",
+                       "-");
+                continue;
+            }
+            
+            // take the fastest repetition
+            double best    = -1.0;
+            uint64_t total = 0;
+            
+            int repeat = 0;
+            for (; repeat < MICROBENCH_MAX_REPEAT &&
+                   total < MICROBENCH_MIN_TIME; repeat++)
+            {
+                size_t ops       = 1;
+                uint64_t elapsed = cases[c].function(size, &ops);
+                double per_op    = (double) elapsed / ops;
+                
+                total += elapsed;
+                if (best < 0 || per_op < best)
+                    best = per_op;
+            }
+            
+            double ops_per_sec = (best > 0) ? 1e9 / best : 0.0;
+            
+            printf("%-20s %8zu %14.1f %14.0f\n", cases[c].name, size, best,
+                   ops_per_sec);
+            fprintf(csv, "%s,%zu,%.3f,%.0f\n", cases[c].name, size, best,
+                    ops_per_sec);
+            fflush(stdout);
+        }
+    }
+    
+    fclose(csv);
+    printf("\nCSV written to `%s'\n", csv_name);
+    
+    return EXIT_SUCCESS;
+}
+
+
+// #############################################################################
+// utilities
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Get a monotonic time stamp in nanoseconds
+// -----------------------------------------------------------------------------
+static uint64_t microbench_now()
+{
+#ifdef _CBC_PLAT_WNDS
+    return (uint64_t) ((double) clock() * 1e9 / CLOCKS_PER_SEC);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    
+    return (uint64_t) now.tv_sec * 1000000000u + (uint64_t) now.tv_nsec;
+#endif // _CBC_PLAT_WNDS
+}
+
+// -----------------------------------------------------------------------------
+// Get the count of operations per run of a case processing size items each
+// -----------------------------------------------------------------------------
+static size_t microbench_batch(size_t size)
+{
+    return (size < MICROBENCH_BATCH_ITEMS) ? MICROBENCH_BATCH_ITEMS / size : 1;
+}
+
+// -----------------------------------------------------------------------------
+// Create an array value of size numerics
+// -----------------------------------------------------------------------------
+static CbValue* microbench_create_array(size_t size)
+{
+    CbArray* array = cb_array_create_valarray();
+    cb_array_reserve(array, size);
+    
+    size_t i = 0;
+    for (; i < size; i++)
+        cb_array_append(array, (CbArrayItem) cb_numeric_create(i * 7));
+    
+    return cb_valarray_create(array);
+}
+
+
+// #############################################################################
+// cases
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Case: push size items, then pop them
+// -----------------------------------------------------------------------------
+static uint64_t microbench_stack_push_pop(size_t size, size_t* ops)
+{
+    CbStack* stack = cb_stack_create();
+    uint64_t start = microbench_now();
+    
+    size_t i = 0;
+    for (; i < size; i++)
+        cb_stack_push(stack, (const void*) i);
+    
+    void* item = NULL;
+    while (!cb_stack_is_empty(stack))
+        cb_stack_pop(stack, &item);
+    
+    uint64_t elapsed = microbench_now() - start;
+    cb_stack_free(stack);
+    
+    *ops = size * 2;
+    return elapsed;
+}
+
+// -----------------------------------------------------------------------------
+// Case: append size strings to a list
+// -----------------------------------------------------------------------------
+static uint64_t microbench_strlist_append(size_t size, size_t* ops)
+{
+    CbStrlist* list = cb_strlist_create("item");
+    uint64_t start  = microbench_now();
+    
+    size_t i = 0;
+    for (; i < size; i++)
+        cb_strlist_append(list, "item");
+    
+    uint64_t elapsed = microbench_now() - start;
+    cb_strlist_free(list);
+    
+    *ops = size;
+    return elapsed;
+}
+
+// -----------------------------------------------------------------------------
+// Case: append size numerics to an array
+// -----------------------------------------------------------------------------
+static uint64_t microbench_array_append(size_t size, size_t* ops)
+{
+    CbArray* array = cb_array_create_valarray();
+    uint64_t start = microbench_now();
+    
+    size_t i = 0;
+    for (; i < size; i++)
+        cb_array_append(array, (CbArrayItem) cb_numeric_create(i));
+    
+    uint64_t elapsed = microbench_now() - start;
+    cb_array_free(array);
+    
+    *ops = size;
+    return elapsed;
+}
+
+// -----------------------------------------------------------------------------
+// Case: insert size numerics at the front of an array
+// -----------------------------------------------------------------------------
+static uint64_t microbench_array_insert(size_t size, size_t* ops)
+{
+    CbArray* array = cb_array_create_valarray();
+    cb_array_append(array, (CbArrayItem) cb_numeric_create(0));
+    uint64_t start = microbench_now();
+    
+    size_t i = 0;
+    for (; i < size; i++)
+        cb_array_insert(array, (CbArrayItem) cb_numeric_create(i), 0);
+    
+    uint64_t elapsed = microbench_now() - start;
+    cb_array_free(array);
+    
+    *ops = size;
+    return elapsed;
+}
+
+// -----------------------------------------------------------------------------
+// Case: remove all of size numerics from the front of an array
+// -----------------------------------------------------------------------------
+static uint64_t microbench_array_remove(size_t size, size_t* ops)
+{
+    CbValue* value = microbench_create_array(size);
+    CbArray* array = cb_valarray_get(value);
+    uint64_t start = microbench_now();
+    
+    size_t i = 0;
+    for (; i < size; i++)
+        cb_array_remove(array, 0);
+    
+    uint64_t elapsed = microbench_now() - start;
+    cb_value_free(value);
+    
+    *ops = size;
+    return elapsed;
+}
+
+// -----------------------------------------------------------------------------
+// Case: look up 1000 symbols in a table of size symbols
+// -----------------------------------------------------------------------------
+static uint64_t microbench_symtab_lookup(size_t size, size_t* ops)
+{
+    const size_t lookups = 1000;
+    CbSymtab* symtab     = cb_symtab_create();
+    char id[32];
+    
+    size_t i = 0;
+    for (; i < size; i++)
+    {
+        sprintf(id, "symbol_%zu", i);
+        cb_symtab_append(symtab, cb_symbol_create_variable(id));
+    }
+    
+    uint64_t start = microbench_now();
+    
+    for (i = 0; i < lookups; i++)
+    {
+        sprintf(id, "symbol_%zu", (i * 7919) % size);
+        cb_symtab_lookup(symtab, id, false);
+    }
+    
+    uint64_t elapsed = microbench_now() - start;
+    cb_symtab_free(symtab);
+    
+    *ops = lookups;
+    return elapsed;
+}
+
+// -----------------------------------------------------------------------------
+// Case: enter a scope, declare size locals and leave the scope
+// -----------------------------------------------------------------------------
+static uint64_t microbench_scope_enter_leave(size_t size, size_t* ops)
+{
+    CbSymtab* symtab = cb_symtab_create();
+    char id[32];
+    
+    uint64_t start = microbench_now();
+    cb_symtab_enter_scope(symtab, "microbench");
+    
+    size_t i = 0;
+    for (; i < size; i++)
+    {
+        sprintf(id, "local_%zu", i);
+        cb_symtab_append(symtab, cb_symbol_create_variable(id));
+    }
+    
+    cb_symtab_leave_scope(symtab);
+    uint64_t elapsed = microbench_now() - start;
+    
+    cb_symtab_free(symtab);
+    
+    *ops = 1; // per scope
+    return elapsed;
+}
+
+// -----------------------------------------------------------------------------
+// Case: copy a string value of size characters
+// -----------------------------------------------------------------------------
+static uint64_t microbench_value_copy_string(size_t size, size_t* ops)
+{
+    char* string = (char*) malloc(size + 1);
+    memset(string, 'x', size);
+    string[size] = '\0';
+    
+    CbValue* value = cb_string_create(string);
+    size_t count   = microbench_batch(size);
+    uint64_t start = microbench_now();
+    
+    size_t i = 0;
+    for (; i < count; i++)
+        cb_value_free(cb_value_copy(value));
+    
+    uint64_t elapsed = microbench_now() - start;
+    cb_value_free(value);
+    
+    *ops = count;
+    return elapsed;
+}
+
+// -----------------------------------------------------------------------------
+// Case: copy an array value of size numerics
+// -----------------------------------------------------------------------------
+static uint64_t microbench_value_copy_array(size_t size, size_t* ops)
+{
+    CbValue* value = microbench_create_array(size);
+    size_t count   = microbench_batch(size);
+    uint64_t start = microbench_now();
+    
+    size_t i = 0;
+    for (; i < count; i++)
+        cb_value_free(cb_value_copy(value));
+    
+    uint64_t elapsed = microbench_now() - start;
+    cb_value_free(value);
+    
+    *ops = count;
+    return elapsed;
+}
+
+// -----------------------------------------------------------------------------
+// Case: convert an array value of size numerics to a string
+// -----------------------------------------------------------------------------
+static uint64_t microbench_value_to_string(size_t size, size_t* ops)
+{
+    CbValue* value = microbench_create_array(size);
+    size_t count   = microbench_batch(size);
+    uint64_t start = microbench_now();
+    
+    size_t i = 0;
+    for (; i < count; i++)
+        free(cb_value_to_string(value));
+    
+    uint64_t elapsed = microbench_now() - start;
+    cb_value_free(value);
+    
+    *ops = count;
+    return elapsed;
+}
@@ -0,0 +1,579 @@
+/*******************************************************************************
+ * optimizer_test -- Testing the optimization passes
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <CuTest.h>
+#include "../optimizer.h"
+#include "../syntree.h"
+#include "../codeblock.h"
+#include "../error_handling.h"
+#include "../symtab.h"
+#include "../builtin.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+static const char cbstr_inline[] =
+    "| i, n |"\
+    "function Square(x)"\
+    "   Result := x * x,"\
+    "end,"\
+    "function SumSq(a, b)"\
+    "   Result := Square(a) + Square(b),"\
+    "end,"\
+    "i := 0, n := 0,"\
+    "while i < 10 do"\
+    "   n := n + SumSq(i, i + 1),"\
+    "   i := i + 1,"\
+    "end,"\
+    "n,";
+static const char cbstr_inline_array[] =
+    "| a, b |"\
+    "function Id(x)"\
+    "   Result := x,"\
+    "end,"\
+    "a := { 1, 2 },"\
+    "b := Id(a),"\
+    "AAdd(b, 3),"\
+    "ASize(a) * 10 + ASize(b),";
+static const char cbstr_inline_not_declared[] =
+    "| n |"\
+    "n := Twice(2),"\
+    "function Twice(x)"\
+    "   Result := x * 2,"\
+    "end,"\
+    "n,";
+static const char cbstr_inline_recursive[] =
+    "function Fac(n)"\
+    "   Result := 1,"\
+    "   if n > 1 then Result := n * Fac(n - 1), endif,"\
+    "end,"\
+    "function Loop(n)"\
+    "   Result := Loop(n),"\
+    "end,"\
+    "Fac(5),";
+static const char cbstr_inline_shadowed[] =
+    "function Inc(x)"\
+    "   Result := x + Offset(),"\
+    "end,"\
+    "function Offset()"\
+    "   Result := 1,"\
+    "end,"\
+    "function Local()"\
+    "   | Inc |"\
+    "   Inc := 5,"\
+    "   Result := Inc,"\
+    "end,"\
+    "Inc(1) + Local(),";
+static const char cbstr_inline_error[] =
+    "function Half(x)\n"\
+    "   Result := x / 2 + 'a',\n"\
+    "end,\n"\
+    "Half(4),\n";
+static const char cbstr_hoist[] =
+    "| s, i, n, m |"\
+    "s := 'abcabc',"\
+    "i := 0, n := 0, m := 3,"\
+    "while i < Len(s) do"\
+    "   n := n + m * 2,"\
+    "   i := i + 1,"\
+    "end,"\
+    "n,";
+static const char cbstr_hoist_nested[] =
+    "| a, i, j, n, t |"\
+    "a := { 1, 2, 3 },"\
+    "i := 0, n := 0,"\
+    "while i < 3 do"\
+    "   j := 0,"\
+    "   t := i * 10,"\
+    "   while j < (ASize(a) + i) do"\
+    "      n := n + t + ASize(a),"\
+    "      j := j + 1,"\
+    "   end,"\
+    "   AAdd(a, i),"\
+    "   i := i + 1,"\
+    "end,"\
+    "n,";
+static const char cbstr_hoist_kept[] =
+    "| a, s, i, n |"\
+    "a := { 1 }, s := 'ab', i := 0, n := 0,"\
+    "function Grow()"\
+    "   s := s + 'ab',"\
+    "end,"\
+    "while (i < Len(s)) and (i < 10) do"\
+    "   Grow(),"\
+    "   n := n + 1,"\
+    "   i := i + 1,"\
+    "end,"\
+    "i := 0,"\
+    "while (i < ASize(a)) and (i < 5) do"\
+    "   AAdd(a, i),"\
+    "   i := i + 1,"\
+    "end,"\
+    "n * 10 + i,";
+static const char cbstr_hoist_error[] =
+    "| i, n, x |\n"\
+    "i := 0, n := 0, x := 'a',\n"\
+    "while i < 3 do\n"\
+    "   i := i + 1,\n"\
+    "   if i > 2 then n := n + (x - 1), endif,\n"\
+    "end,\n"\
+    "n,\n";
+static const char cbstr_types[] =
+    "| i, n, s |"\
+    "i := 0, n := 0, s := '',"\
+    "while i < 10 do"\
+    "   n := n + i * 2,"\
+    "   if n > 50 then s := s + 'a', endif,"\
+    "   i := i + 1,"\
+    "end,"\
+    "n + Len(s),";
+static const char cbstr_types_kept[] =
+    "| a, x, n |"\
+    "function Change()"\
+    "   x := 'a',"\
+    "end,"\
+    "a := { 1, 2 }, n := 0,"\
+    "if ASize(a) > 1 then x := 2, else x := 'b', endif,"\
+    "n := a[1] + x,"\
+    "startseq"\
+    "   x := 3,"\
+    "   x := 'c',"\
+    "   n := n / 0,"\
+    "onerror"\
+    "   n := n + 1,"\
+    "stopseq,"\
+    "Change(),"\
+    "while ValType(x) = 'C' do"\
+    "   x := 7,"\
+    "end,"\
+    "n + x,";
+static const char cbstr_types_error[] =
+    "| a, b, n |\n"\
+    "a := 1, b := 'x', n := 0,\n"\
+    "startseq\n"\
+    "   a := 'y',\n"\
+    "onerror\n"\
+    "   n := a + b,\n"\
+    "stopseq,\n"\
+    "while n < 3 do\n"\
+    "   n := n + 1,\n"\
+    "   if n > 2 then n := n + b, endif,\n"\
+    "end,\n"\
+    "n,\n";
+static const char cbstr_eliminate[] =
+    "| a, b, n, unused |"\
+    "function Never(x)"\
+    "   Result := Helper(x),"\
+    "end,"\
+    "function Helper(y)"\
+    "   Result := y + 1,"\
+    "end,"\
+    "function Twice(p)"\
+    "   | dead |"\
+    "   dead := 'zzz',"\
+    "   Result := p * 2,"\
+    "end,"\
+    "unused := { 1, 2 },"\
+    "a := 3, n := 0,"\
+    "if False then n := 100, endif,"\
+    "if True then b := 4, else b := 5, endif,"\
+    "Twice(a) + b,";
+static const char cbstr_eliminate_kept[] =
+    "| s, t |"\
+    "s := 2,"\
+    "function Get()"\
+    "   Result := s,"\
+    "end,"\
+    "function Set()"\
+    "   t := 1,"\
+    "end,"\
+    "Set(),"\
+    "| late |"\
+    "late := 5,"\
+    "if s = 2 then late := 6, endif,"\
+    "Get() + 1,";
+static const char cbstr_eliminate_error[] =
+    "| q, r |\n"\
+    "r := 1,\n"\
+    "q := r / 0,\n"\
+    "2,\n";
+
+// count of nodes of a type
+typedef struct
+{
+    enum cb_syntree_node_type type;
+    int count;
+} TestOptimizerCount;
+
+static int test_optimizer_count_nodes(CbSyntree* node,
+                                      enum cb_syntree_node_type type);
+static void test_optimizer_count_node(CbSyntree** node, void* count);
+static void test_optimizer_read_stream(FILE* stream, char* string,
+                                       size_t size);
+
+
+// #############################################################################
+// utilities
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Execute a script, check its numeric result or error message and get the
+// count of nodes of a type after the execution (internal)
+// -----------------------------------------------------------------------------
+static int test_optimizer_execute(CuTest *tc, const char* script,
+                                  bool optimize,
+                                  enum cb_syntree_node_type type,
+                                  int expected_result,
+                                  const char* expected_error)
+{
+    FILE* err_out = tmpfile();
+    cb_set_error_output(err_out);
+    
+    Codeblock* cb = codeblock_create();
+    cb->optimize  = optimize;
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_parse_string(cb, script));
+    codeblock_execute(cb);
+    
+    char error[256];
+    test_optimizer_read_stream(err_out, error, sizeof(error));
+    cb_set_error_output(stderr);
+    fclose(err_out);
+    
+    if (expected_error)
+    {
+        CuAssertStrEquals(tc, expected_error, error);
+        CuAssertPtrEquals(tc, NULL, cb->result);
+    }
+    else
+    {
+        CuAssertStrEquals(tc, "", error);
+        CuAssertPtrNotNull(tc, cb->result);
+        CuAssertIntEquals(tc, expected_result,
+                          (int) cb_numeric_get(cb->result));
+    }
+    
+    int count = test_optimizer_count_nodes(cb->ast, type);
+    codeblock_free(cb);
+    
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+// Execute a script with and without optimization, compare the numeric results
+// and error messages and get the count of optimized nodes of a type (internal)
+// -----------------------------------------------------------------------------
+static int test_optimizer_run(CuTest *tc, const char* script,
+                              enum cb_syntree_node_type type,
+                              int expected_result, const char* expected_error)
+{
+    CuAssertIntEquals(tc, 0, test_optimizer_execute(tc, script, false, type,
+                                                    expected_result,
+                                                    expected_error));
+    
+    return test_optimizer_execute(tc, script, true, type, expected_result,
+                                  expected_error);
+}
+
+// -----------------------------------------------------------------------------
+// Execute a script with and without optimization, compare the numeric results
+// and error messages and get the count of removed nodes of a type (internal)
+// -----------------------------------------------------------------------------
+static int test_optimizer_remove(CuTest *tc, const char* script,
+                                 enum cb_syntree_node_type type,
+                                 int expected_result,
+                                 const char* expected_error)
+{
+    int count = test_optimizer_execute(tc, script, false, type,
+                                       expected_result, expected_error);
+    
+    return count - test_optimizer_execute(tc, script, true, type,
+                                          expected_result, expected_error);
+}
+
+// #############################################################################
+// test procedures
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Test: cb_optimizer_run() -- calls of small functions are inlined
+// -----------------------------------------------------------------------------
+void test_optimizer_inline(CuTest *tc)
+{
+    // the calls of Square in the declaration of SumSq and the call of SumSq,
+    // which contains them, too
+    CuAssertIntEquals(tc, 5, test_optimizer_run(tc, cbstr_inline,
+                                                SNT_INLINE_CALL, 670, NULL));
+    
+    // the argument is copied like a parameter, the result like a result
+    CuAssertIntEquals(tc, 1, test_optimizer_run(tc, cbstr_inline_array,
+                                                SNT_INLINE_CALL, 23, NULL));
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_optimizer_run() -- calls, which can't be inlined, are kept
+// -----------------------------------------------------------------------------
+void test_optimizer_inline_kept(CuTest *tc)
+{
+    // calls before the declaration fail
+    CuAssertIntEquals(tc, 0, test_optimizer_run(tc, cbstr_inline_not_declared,
+                                                SNT_INLINE_CALL, 0,
+                                                "Runtime error: Line 1: "
+                                                "Undefined symbol: Twice"));
+    
+    // recursive functions
+    CuAssertIntEquals(tc, 0, test_optimizer_run(tc, cbstr_inline_recursive,
+                                                SNT_INLINE_CALL, 120, NULL));
+    
+    // a function calling a function declared later, a function whose name is
+    // declared as variable, too, and a function with local symbols
+    CuAssertIntEquals(tc, 0, test_optimizer_run(tc, cbstr_inline_shadowed,
+                                                SNT_INLINE_CALL, 7, NULL));
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_optimizer_run() -- errors of inlined calls report the line number
+//                             of the function's body
+// -----------------------------------------------------------------------------
+void test_optimizer_inline_error(CuTest *tc)
+{
+    CuAssertIntEquals(tc, 1, test_optimizer_run(tc, cbstr_inline_error,
+                                                SNT_INLINE_CALL, 0,
+                                                "Runtime error: Line 2: "
+                                                "Node type of left-hand side "
+                                                "differs from right-hand "
+                                                "side"));
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_optimizer_run() -- loop-invariant expressions are hoisted
+// -----------------------------------------------------------------------------
+void test_optimizer_hoist(CuTest *tc)
+{
+    // Len(s) of the condition and m * 2 of the body
+    CuAssertIntEquals(tc, 2, test_optimizer_run(tc, cbstr_hoist,
+                                                SNT_INVARIANT_EXPR, 36, NULL));
+    
+    // nothing is invariant in the outer loop, which changes the array,
+    // (ASize(a) + i) and ASize(a) are invariant in the inner loop
+    CuAssertIntEquals(tc, 2, test_optimizer_run(tc, cbstr_hoist_nested,
+                                                SNT_INVARIANT_EXPR, 254,
+                                                NULL));
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_optimizer_run() -- nothing is hoisted out of loops, which may
+//                             change the symbols of the expressions
+// -----------------------------------------------------------------------------
+void test_optimizer_hoist_kept(CuTest *tc)
+{
+    // a user function changes the string, AAdd() changes the array
+    CuAssertIntEquals(tc, 0, test_optimizer_run(tc, cbstr_hoist_kept,
+                                                SNT_INVARIANT_EXPR, 105,
+                                                NULL));
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_optimizer_run() -- an invariant expression fails, when it is
+//                             reached, with the line number of the expression
+// -----------------------------------------------------------------------------
+void test_optimizer_hoist_error(CuTest *tc)
+{
+    CuAssertIntEquals(tc, 1, test_optimizer_run(tc, cbstr_hoist_error,
+                                                SNT_INVARIANT_EXPR, 0,
+                                                "Runtime error: Line 5: "
+                                                "Node type of left-hand side "
+                                                "differs from right-hand "
+                                                "side"));
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_optimizer_run() -- operations on known value-types are specialised
+// -----------------------------------------------------------------------------
+void test_optimizer_types(CuTest *tc)
+{
+    // n + i * 2 and i + 1, but not n + Len(s)
+    CuAssertIntEquals(tc, 2, test_optimizer_run(tc, cbstr_types,
+                                                SNT_NUMERIC_ADD, 93, NULL));
+    CuAssertIntEquals(tc, 1, test_optimizer_run(tc, cbstr_types,
+                                                SNT_NUMERIC_MUL, 93, NULL));
+    CuAssertIntEquals(tc, 2, test_optimizer_run(tc, cbstr_types,
+                                                SNT_NUMERIC_COMPARISON, 93,
+                                                NULL));
+    CuAssertIntEquals(tc, 1, test_optimizer_run(tc, cbstr_types,
+                                                SNT_STRING_CONCAT, 93, NULL));
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_optimizer_run() -- operations on values, whose value-types depend
+//                             on the execution, aren't specialised
+// -----------------------------------------------------------------------------
+void test_optimizer_types_kept(CuTest *tc)
+{
+    // branches, array elements, exception blocks, user functions and loops
+    CuAssertIntEquals(tc, 0, test_optimizer_run(tc, cbstr_types_kept,
+                                                SNT_NUMERIC_ADD, 11, NULL));
+    CuAssertIntEquals(tc, 0, test_optimizer_run(tc, cbstr_types_kept,
+                                                SNT_NUMERIC_DIV, 11, NULL));
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_optimizer_check_types() -- only type errors, which occur whenever
+//                                     the node is evaluated, are reported
+// -----------------------------------------------------------------------------
+void test_optimizer_check_types(CuTest *tc)
+{
+    FILE* err_out = tmpfile();
+    cb_set_error_output(err_out);
+    
+    Codeblock* cb = codeblock_create();
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      codeblock_parse_string(cb, cbstr_types_error));
+    CuAssertIntEquals(tc, 1, cb_optimizer_check_types(cb->ast));
+    
+    char error[256];
+    test_optimizer_read_stream(err_out, error, sizeof(error));
+    cb_set_error_output(stderr);
+    fclose(err_out);
+    
+    CuAssertStrEquals(tc, "Type error: Line 10: Node type of left-hand side "
+                          "differs from right-hand side", error);
+    
+    // the syntax-tree isn't changed
+    CuAssertIntEquals(tc, 0, test_optimizer_count_nodes(cb->ast,
+                                                        SNT_NUMERIC_ADD));
+    
+    codeblock_free(cb);
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_optimizer_run() -- unused symbols and dead branches are removed
+// -----------------------------------------------------------------------------
+void test_optimizer_eliminate(CuTest *tc)
+{
+    // unused, n (assigned only) and dead (local symbol)
+    CuAssertIntEquals(tc, 3, test_optimizer_remove(tc, cbstr_eliminate,
+                                                   SNT_DECLARATION, 10,
+                                                   NULL));
+    
+    // Never and Helper, which is called by Never only
+    CuAssertIntEquals(tc, 2, test_optimizer_remove(tc, cbstr_eliminate,
+                                                   SNT_FUNC_DECL, 10, NULL));
+    
+    // both if-statements with constant conditions
+    CuAssertIntEquals(tc, 2, test_optimizer_remove(tc, cbstr_eliminate,
+                                                   SNT_FLOW_IF, 10, NULL));
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_optimizer_run() -- symbols, whose removal could change the
+//                             execution, are kept
+// -----------------------------------------------------------------------------
+void test_optimizer_eliminate_kept(CuTest *tc)
+{
+    // s is read by a function, t is assigned by another body, late isn't
+    // declared at the beginning of the script
+    CuAssertIntEquals(tc, 0, test_optimizer_remove(tc, cbstr_eliminate_kept,
+                                                   SNT_DECLARATION, 3,
+                                                   NULL));
+    CuAssertIntEquals(tc, 0, test_optimizer_remove(tc, cbstr_eliminate_kept,
+                                                   SNT_FUNC_DECL, 3, NULL));
+    
+    // the symbols declared at top level are kept in a shared symbol-table
+    CbSymtab* symtab = cb_symtab_create();
+    register_builtin_all(symtab);
+    
+    Codeblock* cb = codeblock_create();
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      codeblock_parse_string(cb, cbstr_eliminate));
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      codeblock_execute_with_symtab(cb, symtab));
+    CuAssertPtrNotNull(tc, cb_symtab_lookup(symtab, "unused", false));
+    CuAssertPtrNotNull(tc, cb_symtab_lookup(symtab, "Never", false));
+    
+    cb_symtab_free(symtab);
+    codeblock_free(cb);
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_optimizer_run() -- the right-hand side of a removed assignment is
+//                             still evaluated
+// -----------------------------------------------------------------------------
+void test_optimizer_eliminate_error(CuTest *tc)
+{
+    CuAssertIntEquals(tc, 1, test_optimizer_remove(tc, cbstr_eliminate_error,
+                                                   SNT_DECLARATION, 0,
+                                                   "Error: Division by zero "
+                                                   "is not allowed"));
+}
+
+
+// #############################################################################
+// internal functions
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Count the nodes of a type in a syntax-tree (internal)
+// -----------------------------------------------------------------------------
+static int test_optimizer_count_nodes(CbSyntree* node,
+                                      enum cb_syntree_node_type type)
+{
+    TestOptimizerCount count = { type, 0 };
+    test_optimizer_count_node(&node, &count);
+    
+    return count.count;
+}
+
+// -----------------------------------------------------------------------------
+// Count a node and its child-nodes, if they are of the counted type (internal)
+// -----------------------------------------------------------------------------
+static void test_optimizer_count_node(CbSyntree** node, void* count)
+{
+    if ((*node)->type == ((TestOptimizerCount*) count)->type)
+        ((TestOptimizerCount*) count)->count++;
+    
+    cb_optimizer_visit_children(*node, test_optimizer_count_node, count);
+}
+
+// -----------------------------------------------------------------------------
+// Read the content of a stream without trailing line breaks (internal)
+// -----------------------------------------------------------------------------
+static void test_optimizer_read_stream(FILE* stream, char* string,
+                                       size_t size)
+{
+    fseek(stream, 0, SEEK_SET);
+    size_t length = fread(string, 1, size - 1, stream);
+    
+    while (length > 0 && (string[length - 1] == '\n' ||
+                          string[length - 1] == '\r'))
+        length--;
+    
+    string[length] = '\0';
+}
+
+
+// #############################################################################
+// make suite
+// #############################################################################
+
+CuSuite* make_suite_optimizer()
+{
+    CuSuite* suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_optimizer_inline);
+    SUITE_ADD_TEST(suite, test_optimizer_inline_kept);
+    SUITE_ADD_TEST(suite, test_optimizer_inline_error);
+    SUITE_ADD_TEST(suite, test_optimizer_hoist);
+    SUITE_ADD_TEST(suite, test_optimizer_hoist_kept);
+    SUITE_ADD_TEST(suite, test_optimizer_hoist_error);
+    SUITE_ADD_TEST(suite, test_optimizer_types);
+    SUITE_ADD_TEST(suite, test_optimizer_types_kept);
+    SUITE_ADD_TEST(suite, test_optimizer_check_types);
+    SUITE_ADD_TEST(suite, test_optimizer_eliminate);
+    SUITE_ADD_TEST(suite, test_optimizer_eliminate_kept);
+    SUITE_ADD_TEST(suite, test_optimizer_eliminate_error);
+    return suite;
+}
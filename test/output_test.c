@@ -0,0 +1,108 @@
+/*******************************************************************************
+ * output_test -- Testing the CbOutput structure
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <CuTest.h>
+#include "CuTestCustomUtils.h"
+#include "../output.h"
+#include "../codeblock.h"
+#include "../strbuf.h"
+#include "../value.h"
+
+// #############################################################################
+// utilities
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Callback collecting the output in a growable buffer (internal)
+// -----------------------------------------------------------------------------
+static void test_output_collect(void* context, const char* data, size_t length)
+{
+    cb_strbuf_append((CbStrbuf*) context, data, length);
+}
+
+
+// #############################################################################
+// test procedures
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Test: test_output_memory() -- Collect output in memory
+// -----------------------------------------------------------------------------
+void test_output_memory(CuTest *tc)
+{
+    CbOutput* output = cb_output_create_memory();
+    CbValue* value   = cb_numeric_create(-42);
+    size_t length    = 0;
+    
+    cb_output_write_line(output, value);
+    cb_output_write(output, "foo", 3);
+    cb_output_write_value(output, value);
+    
+    CuAssertStrEquals(tc, "-42\nfoo-42", cb_output_get_memory(output, &length));
+    CuAssertIntEquals(tc, 10, length);
+    
+    cb_value_free(value);
+    cb_output_free(output);
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_output_callback() -- Pass buffered output to a callback
+// -----------------------------------------------------------------------------
+void test_output_callback(CuTest *tc)
+{
+    CbStrbuf collected;
+    cb_strbuf_init(&collected);
+    
+    CbOutput* output = cb_output_create_callback(test_output_collect,
+                                                 &collected);
+    CbValue* value   = cb_numeric_create(1234567890);
+    
+    // write more than the buffer size, to force intermediate flushes
+    int i = 0;
+    for (; i < CB_OUTPUT_BUFFER_SIZE / 10; i++)
+        cb_output_write_line(output, value);
+    
+    CuAssertTrue(tc, collected.length > 0);
+    cb_output_flush(output);
+    CuAssertIntEquals(tc, CB_OUTPUT_BUFFER_SIZE / 10 * 11, collected.length);
+    
+    cb_value_free(value);
+    cb_output_free(output);
+    cb_strbuf_release(&collected);
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_output_codeblock() -- Redirect the output of a codeblock
+// -----------------------------------------------------------------------------
+void test_output_codeblock(CuTest *tc)
+{
+    Codeblock* cb = codeblock_create();
+    cb->output    = cb_output_create_memory();
+    
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      codeblock_parse_string(cb, "WriteLn('foo'), "
+                                                 "WriteLn({1, 'bar'}), 5,"));
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_execute(cb));
+    CuAssertStrEquals(tc, "foo\n{1,\"bar\"}\n",
+                      cb_output_get_memory(cb->output, NULL));
+    
+    cb_output_free(cb->output);
+    codeblock_free(cb);
+}
+
+
+// #############################################################################
+// make suite
+// #############################################################################
+
+CuSuite* make_suite_output()
+{
+    CuSuite* suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_output_memory);
+    SUITE_ADD_TEST(suite, test_output_callback);
+    SUITE_ADD_TEST(suite, test_output_codeblock);
+    return suite;
+}
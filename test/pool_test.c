@@ -0,0 +1,109 @@
+/*******************************************************************************
+ * pool_test -- Testing the slab allocator
+ ******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <CuTest.h>
+#include "../pool.h"
+#include "../alloc.h"
+
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+// count of objects, which fills more than one slab
+#define TEST_POOL_OBJECTS 2000
+
+
+// #############################################################################
+// test procedures
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Test: cb_pool_alloc() -- Freed objects are reused and accounted
+// -----------------------------------------------------------------------------
+void test_pool_reuse(CuTest *tc)
+{
+    CbAllocStats before, after;
+    cb_alloc_get_stats(CB_ALLOC_STACK, &before);
+    
+    char* first = (char*) cb_pool_alloc(24, CB_ALLOC_STACK);
+    CuAssertPtrNotNull(tc, first);
+    memset(first, 'x', 24);
+    cb_pool_free(first, 24, CB_ALLOC_STACK);
+    
+    char* second = (char*) cb_pool_alloc(32, CB_ALLOC_STACK);
+    CuAssertPtrNotNull(tc, second);
+    cb_alloc_get_stats(CB_ALLOC_STACK, &after);
+    CuAssertTrue(tc, after.allocations == before.allocations + 2);
+#ifndef CB_POOL_DISABLED
+    // an object of the same size class takes the freed memory
+    CuAssertPtrEquals(tc, first, second);
+    CuAssertTrue(tc, after.live == before.live + 32);
+#endif
+
+    cb_pool_free(second, 32, CB_ALLOC_STACK);
+    
+    // objects beyond the maximum size are allocated by the hooks
+    char* large = (char*) cb_pool_alloc(CB_POOL_MAX_SIZE + 1, CB_ALLOC_STACK);
+    CuAssertPtrNotNull(tc, large);
+    cb_pool_free(large, CB_POOL_MAX_SIZE + 1, CB_ALLOC_STACK);
+    
+    cb_alloc_get_stats(CB_ALLOC_STACK, &after);
+    CuAssertTrue(tc, after.frees == before.frees + 3);
+    CuAssertTrue(tc, after.live == before.live);
+}
+
+// -----------------------------------------------------------------------------
+// Test: cb_pool_free() -- Empty slabs are returned to the system
+// -----------------------------------------------------------------------------
+void test_pool_release(CuTest *tc)
+{
+    CbPoolStats before, after;
+    cb_pool_get_stats(&before);
+    
+    void** objects = (void**) malloc(TEST_POOL_OBJECTS * sizeof(void*));
+    int i          = 0;
+    for (; i < TEST_POOL_OBJECTS; i++)
+    {
+        objects[i] = cb_pool_alloc(CB_POOL_MAX_SIZE, CB_ALLOC_STACK);
+        CuAssertPtrNotNull(tc, objects[i]);
+        memset(objects[i], i & 0xFF, CB_POOL_MAX_SIZE);
+    }
+
+#ifndef CB_POOL_DISABLED
+    CbPoolStats filled;
+    cb_pool_get_stats(&filled);
+    CuAssertTrue(tc, filled.objects == before.objects + TEST_POOL_OBJECTS);
+    CuAssertTrue(tc, filled.slabs > before.slabs + 1);
+#endif
+
+    // the objects don't overlap
+    for (i = 0; i < TEST_POOL_OBJECTS; i++)
+        CuAssertIntEquals(tc, i & 0xFF,
+                          ((unsigned char*) objects[i])[CB_POOL_MAX_SIZE - 1]);
+    
+    for (i = 0; i < TEST_POOL_OBJECTS; i++)
+        cb_pool_free(objects[i], CB_POOL_MAX_SIZE, CB_ALLOC_STACK);
+    free(objects);
+    
+    // at most one empty slab of the class is kept
+    cb_pool_get_stats(&after);
+    CuAssertTrue(tc, after.objects == before.objects);
+    CuAssertTrue(tc, after.slabs <= before.slabs + 1);
+}
+
+
+// #############################################################################
+// make suite
+// #############################################################################
+
+CuSuite* make_suite_pool()
+{
+    CuSuite* suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_pool_reuse);
+    SUITE_ADD_TEST(suite, test_pool_release);
+    return suite;
+}
@@ -0,0 +1,196 @@
+/*******************************************************************************
+ * profile_test -- Testing the execution profiler
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <CuTest.h>
+#include "CuTestCustomUtils.h"
+#include "../profile.h"
+#include "../codeblock.h"
+
+static const char* test_profile_script =
+    "| n |\n"
+    "function Twice(x)\n"
+    "    Result := x * 2,\n"
+    "end,\n"
+    "function Quad(x)\n"
+    "    Result := Twice(Twice(x)),\n"
+    "end,\n"
+    "n := Quad(3) + Quad(4),\n"
+    "n,\n";
+
+
+// #############################################################################
+// utilities
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Read a file into a null-terminated buffer (internal)
+// -----------------------------------------------------------------------------
+static char* test_profile_read(FILE* file)
+{
+    long length = ftell(file);
+    char* data  = (char*) calloc((size_t) length + 1, 1);
+    
+    rewind(file);
+    if (fread(data, 1, (size_t) length, file) != (size_t) length)
+        data[0] = '\0';
+    
+    return data;
+}
+
+// -----------------------------------------------------------------------------
+// Get the count of calls of a function from the report (internal)
+// -----------------------------------------------------------------------------
+static long test_profile_calls(const char* report, const char* name)
+{
+    size_t length    = strlen(name);
+    const char* line = report;
+    
+    for (; line; line = strchr(line, '\n'))
+    {
+        line += (*line == '\n') ? 1 : 0;
+        if (strncmp(line, name, length) == 0 && line[length] == ' ')
+            return strtol(line + length, NULL, 10);
+    }
+    
+    return -1;
+}
+
+
+// #############################################################################
+// test procedures
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Test: test_profile_report() -- Lines and functions are counted
+// -----------------------------------------------------------------------------
+void test_profile_report(CuTest *tc)
+{
+    Codeblock* cb = codeblock_create();
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      codeblock_parse_string(cb, test_profile_script));
+    
+    cb_profile_start();
+    CuAssertTrue(tc, cb_profile_enabled);
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_execute(cb));
+    cb_profile_stop();
+    CuAssertTrue(tc, !cb_profile_enabled);
+    CuAssertIntEquals(tc, 28, cb_numeric_get(cb->result));
+    
+    FILE* report = tmpfile();
+    cb_profile_report(report, NULL);
+    char* text = test_profile_read(report);
+    fclose(report);
+    
+    CuAssertTrue(tc, strstr(text, "Hot spots by line") != NULL);
+    CuAssertIntEquals(tc, 4, test_profile_calls(text, "Twice"));
+    CuAssertIntEquals(tc, 2, test_profile_calls(text, "Quad"));
+    free(text);
+    
+    cb_profile_reset();
+    codeblock_free(cb);
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_profile_stacks() -- Collapsed stacks contain the call paths
+// -----------------------------------------------------------------------------
+void test_profile_stacks(CuTest *tc)
+{
+    const char* file_name = "profile_test.collapsed";
+    Codeblock* cb         = codeblock_create();
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      codeblock_parse_string(cb, test_profile_script));
+    
+    cb_profile_start();
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_execute(cb));
+    cb_profile_stop();
+    
+    CuAssertIntEquals(tc, EXIT_SUCCESS, cb_profile_write_stacks(file_name));
+    cb_profile_reset();
+    codeblock_free(cb);
+    
+    FILE* file = fopen(file_name, "r");
+    CuAssertPtrNotNull(tc, file);
+    fseek(file, 0, SEEK_END);
+    char* text = test_profile_read(file);
+    fclose(file);
+    remove(file_name);
+    
+    CuAssertTrue(tc, strncmp(text, "main ", 5) == 0 ||
+                     strstr(text, "\nmain ") != NULL);
+    CuAssertTrue(tc, strstr(text, "main;Quad ") != NULL);
+    CuAssertTrue(tc, strstr(text, "main;Quad;Twice ") != NULL);
+    free(text);
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_profile_sampling() -- Samples are accounted like timed nodes
+// -----------------------------------------------------------------------------
+void test_profile_sampling(CuTest *tc)
+{
+    const char* file_name = "profile_test.collapsed";
+    const char* script    = "| i, s |\n"
+                            "function Twice(x)\n"
+                            "    Result := x * 2,\n"
+                            "end,\n"
+                            "i := 0, s := 0,\n"
+                            "while i < 100000 do\n"
+                            "    s := s + Twice(i), i := i + 1,\n"
+                            "end,\n"
+                            "s,\n";
+    
+    Codeblock* cb = codeblock_create();
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_parse_string(cb, script));
+    
+    if (cb_profile_start_sampling(100) != EXIT_SUCCESS)
+    {
+        codeblock_free(cb); // no timer on this platform
+        return;
+    }
+    
+    CuAssertIntEquals(tc, EXIT_SUCCESS, codeblock_execute(cb));
+    cb_profile_stop();
+    CuAssertTrue(tc, !cb_profile_enabled);
+    
+    FILE* report = tmpfile();
+    cb_profile_report(report, NULL);
+    char* text = test_profile_read(report);
+    fclose(report);
+    
+    // the calls are counted exactly
+    CuAssertTrue(tc, strstr(text, " samples, ") != NULL);
+    CuAssertIntEquals(tc, 100000, test_profile_calls(text, "Twice"));
+    free(text);
+    
+    CuAssertIntEquals(tc, EXIT_SUCCESS, cb_profile_write_stacks(file_name));
+    cb_profile_reset();
+    codeblock_free(cb);
+    
+    FILE* file = fopen(file_name, "r");
+    CuAssertPtrNotNull(tc, file);
+    fseek(file, 0, SEEK_END);
+    text = test_profile_read(file);
+    fclose(file);
+    remove(file_name);
+    
+    CuAssertTrue(tc, strncmp(text, "main", 4) == 0 ||
+                     strstr(text, "\nmain") != NULL);
+    free(text);
+}
+
+
+// #############################################################################
+// make suite
+// #############################################################################
+
+CuSuite* make_suite_profile()
+{
+    CuSuite* suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_profile_report);
+    SUITE_ADD_TEST(suite, test_profile_stacks);
+    SUITE_ADD_TEST(suite, test_profile_sampling);
+    return suite;
+}
@@ -0,0 +1,106 @@
+/*******************************************************************************
+ * reader_test -- Testing the CbReader structure
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <CuTest.h>
+#include "CuTestCustomUtils.h"
+#include "../reader.h"
+
+// #############################################################################
+// utilities
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Read all lines and join them with '|' (internal)
+// -----------------------------------------------------------------------------
+static void test_reader_join_lines(CbReader* reader, char* buffer)
+{
+    const char* line = NULL;
+    size_t length    = 0;
+    
+    *buffer = '\0';
+    while (cb_reader_read_line(reader, &line, &length))
+    {
+        strncat(buffer, line, length);
+        strcat(buffer, "|");
+    }
+}
+
+
+// #############################################################################
+// test procedures
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Test: test_reader_file() -- Read lines of a memory-mapped file
+// -----------------------------------------------------------------------------
+void test_reader_file(CuTest *tc)
+{
+    char buffer[64];
+    CbReader* reader = cb_reader_open("./testfiles/testcase_56.txt");
+    CuAssertPtrNotNull(tc, reader);
+    
+    test_reader_join_lines(reader, buffer);
+    CuAssertStrEquals(tc, "10|20||30|12|", buffer);
+    
+    cb_reader_free(reader);
+    
+    CuAssertPtrEquals(tc, NULL, cb_reader_open("./testfiles/missing.txt"));
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_reader_pipe() -- Read lines from a pipe
+// -----------------------------------------------------------------------------
+void test_reader_pipe(CuTest *tc)
+{
+    char buffer[64];
+    int fds[2];
+    CuAssertIntEquals(tc, 0, pipe(fds));
+    
+    const char* data = "first\r\nsecond\n\nlast";
+    CuAssertIntEquals(tc, strlen(data), write(fds[1], data, strlen(data)));
+    close(fds[1]);
+    
+    CbReader* reader = cb_reader_create_fd(fds[0]);
+    test_reader_join_lines(reader, buffer);
+    CuAssertStrEquals(tc, "first|second||last|", buffer);
+    
+    cb_reader_free(reader);
+    close(fds[0]);
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_reader_read_all() -- Read the remaining input at once
+// -----------------------------------------------------------------------------
+void test_reader_read_all(CuTest *tc)
+{
+    CbReader* reader = cb_reader_open("./testfiles/testcase_56.txt");
+    const char* line = NULL;
+    size_t length    = 0;
+    
+    CuAssertTrue(tc, cb_reader_read_line(reader, &line, &length));
+    
+    char* rest = cb_reader_read_all(reader, &length);
+    CuAssertStrEquals(tc, "20\r\n\n30\n12", rest);
+    CuAssertIntEquals(tc, 10, length);
+    free(rest);
+    
+    cb_reader_free(reader);
+}
+
+
+// #############################################################################
+// make suite
+// #############################################################################
+
+CuSuite* make_suite_reader()
+{
+    CuSuite* suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_reader_file);
+    SUITE_ADD_TEST(suite, test_reader_pipe);
+    SUITE_ADD_TEST(suite, test_reader_read_all);
+    return suite;
+}
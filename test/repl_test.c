@@ -0,0 +1,93 @@
+/*******************************************************************************
+ * repl_test -- Testing the read-eval-print loop
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <CuTest.h>
+#include "CuTestCustomUtils.h"
+#include "../repl.h"
+#include "../error_handling.h"
+
+// #############################################################################
+// utilities
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Evaluate a line (internal)
+// -----------------------------------------------------------------------------
+static enum cb_repl_status test_repl_eval(CbRepl* repl, const char* line)
+{
+    return cb_repl_eval_line(repl, line, strlen(line));
+}
+
+
+// #############################################################################
+// test procedures
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Test: test_repl_persistent_state() -- Symbols are kept between chunks
+// -----------------------------------------------------------------------------
+void test_repl_persistent_state(CuTest *tc)
+{
+    CbRepl* repl = cb_repl_create();
+    
+    CuAssertIntEquals(tc, CB_REPL_OK, test_repl_eval(repl, "| a | a := 20"));
+    CuAssertIntEquals(tc, 20, cb_numeric_get(cb_repl_get_result(repl)));
+    
+    // multi-line chunk
+    CuAssertIntEquals(tc, CB_REPL_INCOMPLETE,
+                      test_repl_eval(repl, "function Twice(x)"));
+    CuAssertIntEquals(tc, CB_REPL_INCOMPLETE,
+                      test_repl_eval(repl, "    Result := x * 2,"));
+    CuAssertIntEquals(tc, CB_REPL_OK, test_repl_eval(repl, "end,"));
+    
+    CuAssertIntEquals(tc, CB_REPL_INCOMPLETE,
+                      test_repl_eval(repl, "a := Twice(a) +"));
+    CuAssertIntEquals(tc, CB_REPL_INCOMPLETE, test_repl_eval(repl, "    1 +"));
+    CuAssertIntEquals(tc, CB_REPL_OK, test_repl_eval(repl, "    1"));
+    CuAssertIntEquals(tc, 42, cb_numeric_get(cb_repl_get_result(repl)));
+    
+    cb_repl_free(repl);
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_repl_errors() -- Errors don't end the session
+// -----------------------------------------------------------------------------
+void test_repl_errors(CuTest *tc)
+{
+    FILE* errors = tmpfile();
+    cb_set_error_output(errors);
+    
+    CbRepl* repl = cb_repl_create();
+    
+    CuAssertIntEquals(tc, CB_REPL_ERROR, test_repl_eval(repl, "1 + ,"));
+    CuAssertIntEquals(tc, CB_REPL_ERROR, test_repl_eval(repl, "Undefined()"));
+    CuAssertPtrEquals(tc, NULL, (void*) cb_repl_get_result(repl));
+    
+    // an empty line rejects incomplete input
+    CuAssertIntEquals(tc, CB_REPL_INCOMPLETE, test_repl_eval(repl, "1 +"));
+    CuAssertIntEquals(tc, CB_REPL_ERROR, test_repl_eval(repl, ""));
+    
+    CuAssertIntEquals(tc, CB_REPL_OK, test_repl_eval(repl, "3 * 4,"));
+    CuAssertIntEquals(tc, 12, cb_numeric_get(cb_repl_get_result(repl)));
+    
+    cb_repl_free(repl);
+    
+    cb_set_error_output(stderr);
+    fclose(errors);
+}
+
+
+// #############################################################################
+// make suite
+// #############################################################################
+
+CuSuite* make_suite_repl()
+{
+    CuSuite* suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_repl_persistent_state);
+    SUITE_ADD_TEST(suite, test_repl_errors);
+    return suite;
+}
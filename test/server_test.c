@@ -0,0 +1,173 @@
+/*******************************************************************************
+ * server_test -- Testing the daemon executing codeblocks
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <CuTest.h>
+#include "CuTestCustomUtils.h"
+#include "../server.h"
+
+// #############################################################################
+// declarations
+// #############################################################################
+
+#define TEST_SOCKET "./server_test.sock"
+
+
+// #############################################################################
+// utilities
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Start a daemon with a single worker and connect to it (internal)
+// -----------------------------------------------------------------------------
+static int test_server_start(CuTest *tc, pid_t* pid, const CbLimits* limits)
+{
+    *pid = fork();
+    if (*pid == 0)
+        _exit(cb_server_run(TEST_SOCKET, 1, limits));
+    
+    // wait until the daemon is listening
+    int fd    = -1;
+    int tries = 0;
+    for (; fd < 0 && tries < 100; tries++)
+    {
+        usleep(10000);
+        fd = cb_server_connect(TEST_SOCKET);
+    }
+    
+    CuAssertTrue(tc, fd >= 0);
+    
+    return fd;
+}
+
+// -----------------------------------------------------------------------------
+// Stop the daemon (internal)
+// -----------------------------------------------------------------------------
+static void test_server_stop(CuTest *tc, pid_t pid, int fd)
+{
+    close(fd);
+    kill(pid, SIGTERM);
+    
+    int status = -1;
+    waitpid(pid, &status, 0);
+    CuAssertIntEquals(tc, EXIT_SUCCESS, WEXITSTATUS(status));
+    CuAssertIntEquals(tc, -1, access(TEST_SOCKET, F_OK));
+}
+
+
+// #############################################################################
+// test procedures
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Test: test_server_requests() -- Execute requests on a daemon
+// -----------------------------------------------------------------------------
+void test_server_requests(CuTest *tc)
+{
+    pid_t pid;
+    int fd = test_server_start(tc, &pid, NULL);
+    
+    const char* script = "| s | s := ReadLn(), WriteLn(s + '!'), Len(s),\n";
+    CbServerResponse response;
+    
+    // the second request is served by the cached syntax-tree
+    int i = 0;
+    for (; i < 2; i++)
+    {
+        const char* input = (i == 0) ? "hello\nworld\n" : "abc";
+        
+        CuAssertIntEquals(tc, EXIT_SUCCESS,
+                          cb_server_request(fd, script, strlen(script), input,
+                                            strlen(input), &response));
+        CuAssertIntEquals(tc, CB_SERVER_OK, response.status);
+        CuAssertStrEquals(tc, (i == 0) ? "hello!\n" : "abc!\n",
+                          response.output);
+        CuAssertStrEquals(tc, (i == 0) ? "5" : "3", response.result);
+        cb_server_response_release(&response);
+    }
+    
+    // errors are returned as result
+    script = "WriteLn('x'), Undefined(),\n";
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      cb_server_request(fd, script, strlen(script), NULL, 0,
+                                        &response));
+    CuAssertIntEquals(tc, CB_SERVER_ERROR, response.status);
+    CuAssertStrEquals(tc, "x\n", response.output);
+    CuAssertTrue(tc, strstr(response.result, "Undefined symbol") != NULL);
+    cb_server_response_release(&response);
+    
+    script = "1 +,\n";
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      cb_server_request(fd, script, strlen(script), NULL, 0,
+                                        &response));
+    CuAssertIntEquals(tc, CB_SERVER_ERROR, response.status);
+    CuAssertTrue(tc, strstr(response.result, "Parsing failed") != NULL);
+    cb_server_response_release(&response);
+    
+    // a file left open by a request is closed after it
+    script = "FOpen('./testfiles/testcase_56.txt'),\n";
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      cb_server_request(fd, script, strlen(script), NULL, 0,
+                                        &response));
+    CuAssertIntEquals(tc, CB_SERVER_OK, response.status);
+    CuAssertStrEquals(tc, "1", response.result);
+    cb_server_response_release(&response);
+    
+    script = "FReadLine(1),\n";
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      cb_server_request(fd, script, strlen(script), NULL, 0,
+                                        &response));
+    CuAssertIntEquals(tc, CB_SERVER_ERROR, response.status);
+    CuAssertTrue(tc, strstr(response.result, "Invalid file handle") != NULL);
+    cb_server_response_release(&response);
+    
+    test_server_stop(tc, pid, fd);
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_server_limits() -- A runaway request is stopped by the limits
+// -----------------------------------------------------------------------------
+void test_server_limits(CuTest *tc)
+{
+    CbLimits limits = { 10000, 0, 0, 0 };
+    pid_t pid;
+    int fd = test_server_start(tc, &pid, &limits);
+    
+    const char* script = "while True do 1, end,\n";
+    CbServerResponse response;
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      cb_server_request(fd, script, strlen(script), NULL, 0,
+                                        &response));
+    CuAssertIntEquals(tc, CB_SERVER_ERROR, response.status);
+    CuAssertTrue(tc, strstr(response.result, "Step limit exceeded") != NULL);
+    cb_server_response_release(&response);
+    
+    // the worker serves the next request
+    script = "| i | i := 0, while i < 100 do i := i + 1, end, i,\n";
+    CuAssertIntEquals(tc, EXIT_SUCCESS,
+                      cb_server_request(fd, script, strlen(script), NULL, 0,
+                                        &response));
+    CuAssertIntEquals(tc, CB_SERVER_OK, response.status);
+    CuAssertStrEquals(tc, "100", response.result);
+    cb_server_response_release(&response);
+    
+    test_server_stop(tc, pid, fd);
+}
+
+
+// #############################################################################
+// make suite
+// #############################################################################
+
+CuSuite* make_suite_server()
+{
+    CuSuite* suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_server_requests);
+    SUITE_ADD_TEST(suite, test_server_limits);
+    return suite;
+}
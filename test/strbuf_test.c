@@ -0,0 +1,116 @@
+/*******************************************************************************
+ * strbuf_test -- Testing the CbStrbuf structure
+ ******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <CuTest.h>
+#include "CuTestCustomUtils.h"
+#include "../strbuf.h"
+#include "../array.h"
+#include "../value.h"
+
+// #############################################################################
+// utilities
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Flush-function collecting the stream into a growable buffer (internal)
+// -----------------------------------------------------------------------------
+static void test_strbuf_collect(void* context, const char* data, size_t length,
+                                const char* extra, size_t extra_length)
+{
+    cb_strbuf_append((CbStrbuf*) context, data, length);
+    if (extra_length > 0)
+        cb_strbuf_append((CbStrbuf*) context, extra, extra_length);
+}
+
+
+// #############################################################################
+// test procedures
+// #############################################################################
+
+// -----------------------------------------------------------------------------
+// Test: test_strbuf_integer() -- Format integers at the limits of the range
+// -----------------------------------------------------------------------------
+void test_strbuf_integer(CuTest *tc)
+{
+    const int64_t values[] = {0, 7, -7, 10, 99, 100, -12345, INT64_MAX,
+                              INT64_MIN};
+    const char* expected[] = {"0", "7", "-7", "10", "99", "100", "-12345",
+                              "9223372036854775807", "-9223372036854775808"};
+    
+    int i = 0;
+    for (; i < sizeof(values) / sizeof(int64_t); i++)
+    {
+        CbStrbuf buf;
+        cb_strbuf_init(&buf);
+        cb_strbuf_append_integer(&buf, values[i]);
+        
+        char* string = cb_strbuf_detach(&buf);
+        CuAssertStrEquals(tc, expected[i], string);
+        free(string);
+    }
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_strbuf_stream() -- Stream through a small storage
+// -----------------------------------------------------------------------------
+void test_strbuf_stream(CuTest *tc)
+{
+    CbStrbuf collected;
+    cb_strbuf_init(&collected);
+    
+    char storage[8];
+    CbStrbuf buf;
+    cb_strbuf_init_stream(&buf, storage, sizeof(storage), test_strbuf_collect,
+                          &collected);
+    
+    cb_strbuf_append_string(&buf, "abc");
+    cb_strbuf_append_integer(&buf, -1234567890);
+    cb_strbuf_append_char(&buf, ',');
+    cb_strbuf_append_string(&buf, "a string longer than the storage");
+    CuAssertTrue(tc, collected.length > 0);
+    cb_strbuf_release(&buf);
+    
+    char* string = cb_strbuf_detach(&collected);
+    CuAssertStrEquals(tc, "abc-1234567890,a string longer than the storage",
+                      string);
+    free(string);
+}
+
+// -----------------------------------------------------------------------------
+// Test: test_strbuf_value() -- Format a large packed array
+// -----------------------------------------------------------------------------
+void test_strbuf_value(CuTest *tc)
+{
+    CbArray* array = cb_array_create_valarray();
+    
+    int i = 0;
+    for (; i < 10000; i++)
+        cb_array_append(array, (CbArrayItem) cb_numeric_create(i % 10));
+    
+    CbValue* value = cb_valarray_create(array);
+    char* string   = cb_value_to_string(value);
+    
+    CuAssertIntEquals(tc, 2 * 10000 + 1, strlen(string));
+    CuAssertTrue(tc, strncmp(string, "{0,1,2,3,4,5,6,7,8,9,0,", 23) == 0);
+    
+    free(string);
+    cb_value_free(value);
+}
+
+
+// #############################################################################
+// make suite
+// #############################################################################
+
+CuSuite* make_suite_strbuf()
+{
+    CuSuite* suite = CuSuiteNew();
+    SUITE_ADD_TEST(suite, test_strbuf_integer);
+    SUITE_ADD_TEST(suite, test_strbuf_stream);
+    SUITE_ADD_TEST(suite, test_strbuf_value);
+    return suite;
+}
@@ -5,9 +5,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <inttypes.h>
 #include <assert.h>
 #include "value.h"
+#include "alloc.h"
+#include "pool.h"
 #include "array.h"
+#include "hash.h"
 #include "error_handling.h"
 #include "error_messages.h"
 
@@ -22,21 +27,33 @@ struct CbValue
 {
     // value-type
     enum cb_value_type type;
+    // numeric values are either stored as integer or as float
+    bool is_float;
     
     union
     {
         CbNumeric value;
+        CbFloat real;
         CbBoolean boolean;
         CbString string;
         CbArray* array;
+        CbHash* hash;
     };
 };
 
 
 static CbValue* cb_numeric_operation(enum cb_operation_type type, CbValue* l,
                                      CbValue* r);
+static void cb_float_apply(enum cb_operation_type type, CbValue* val,
+                           CbFloat l, CbFloat r);
 static CbValue* cb_boolean_operation(enum cb_operation_type type, CbValue* l,
                                      CbValue* r);
+static void cb_float_format(char* buffer, size_t size, CbFloat value);
+static void cb_value_free_content(CbValue* val);
+static void cb_value_format_element(CbStrbuf* buf, const CbValue* val);
+static void cb_value_print_flush(void* context, const char* data,
+                                 size_t length, const char* extra,
+                                 size_t extra_length);
 
 
 // #############################################################################
@@ -48,8 +65,11 @@ static CbValue* cb_boolean_operation(enum cb_operation_type type, CbValue* l,
 // -----------------------------------------------------------------------------
 CbValue* cb_value_create()
 {
-    CbValue* val = (CbValue*) malloc(sizeof(CbValue));
-    val->type    = CB_VT_UNDEFINED;
+    CbValue* val  = (CbValue*) cb_pool_alloc(sizeof(CbValue), CB_ALLOC_VALUE);
+    val->type     = CB_VT_UNDEFINED;
+    val->is_float = false;
+    
+    return val;
 }
 
 // -----------------------------------------------------------------------------
@@ -60,6 +80,21 @@ CbValue* cb_numeric_create(CbNumeric value)
     CbValue* val = cb_value_create();
     val->type    = CB_VT_NUMERIC;
     val->value   = value;
+    
+    return val;
+}
+
+// -----------------------------------------------------------------------------
+// create a numeric value with floating point representation
+// -----------------------------------------------------------------------------
+CbValue* cb_float_create(CbFloat value)
+{
+    CbValue* val  = cb_value_create();
+    val->type     = CB_VT_NUMERIC;
+    val->is_float = true;
+    val->real     = value;
+    
+    return val;
 }
 
 // -----------------------------------------------------------------------------
@@ -70,16 +105,22 @@ CbValue* cb_boolean_create(CbBoolean boolean)
     CbValue* val = cb_value_create();
     val->type    = CB_VT_BOOLEAN;
     val->boolean = boolean;
+    
+    return val;
 }
 
 // -----------------------------------------------------------------------------
-// create a string-value
+// create a string-value (the value takes ownership of the allocated string)
 // -----------------------------------------------------------------------------
 CbValue* cb_string_create(CbString string)
 {
+    cb_alloc_adopt(string, CB_ALLOC_STRING);
+    
     CbValue* val = cb_value_create();
     val->type    = CB_VT_STRING;
     val->string  = string;
+    
+    return val;
 }
 
 // -----------------------------------------------------------------------------
@@ -90,6 +131,20 @@ CbValue* cb_valarray_create(CbValArray array)
     CbValue* valarray = cb_value_create();
     valarray->type    = CB_VT_VALARRAY;
     valarray->array   = array;
+    
+    return valarray;
+}
+
+// -----------------------------------------------------------------------------
+// create a hash
+// -----------------------------------------------------------------------------
+CbValue* cb_valhash_create(CbValHash hash)
+{
+    CbValue* valhash = cb_value_create();
+    valhash->type    = CB_VT_HASH;
+    valhash->hash    = hash;
+    
+    return valhash;
 }
 
 // -----------------------------------------------------------------------------
@@ -97,12 +152,8 @@ CbValue* cb_valarray_create(CbValArray array)
 // -----------------------------------------------------------------------------
 void cb_value_free(CbValue* val)
 {
-    if (val->type == CB_VT_STRING && val->string)
-        free(val->string);
-    else if (val->type == CB_VT_VALARRAY && val->array)
-        cb_array_free(val->array);
-    
-    free(val);
+    cb_value_free_content(val);
+    cb_pool_free(val, sizeof(CbValue), CB_ALLOC_VALUE);
 }
 
 // -----------------------------------------------------------------------------
@@ -129,34 +180,30 @@ bool cb_value_is_type(const CbValue* val, enum cb_value_type type)
 // -----------------------------------------------------------------------------
 void cb_value_assign(const CbValue* source, CbValue* destination)
 {
+    CbValue content = *source;
+    
+    // strings, arrays and hashes are copied, before the old content is freed
     switch (source->type)
     {
-        case CB_VT_NUMERIC:
-            destination->value = source->value;
+        case CB_VT_STRING:
+            content.string = cb_alloc_strdup(source->string, CB_ALLOC_STRING);
             break;
         
-        case CB_VT_BOOLEAN:
-            destination->boolean = source->boolean;
+        case CB_VT_VALARRAY:
+            content.array = cb_array_copy(source->array);
             break;
         
-        case CB_VT_STRING:
-            // free old string
-            if (destination->type == CB_VT_STRING && destination->string)
-                free(destination->string);
-            // assign new one
-            destination->string = strdup(source->string);
+        case CB_VT_HASH:
+            content.hash = cb_hash_copy(source->hash);
             break;
         
-        case CB_VT_VALARRAY:
-            // free old array
-            if (destination->type == CB_VT_VALARRAY && destination->array)
-                cb_array_free(destination->array);
-            // assign new one
-            destination->array = cb_array_copy(source->array);
+        default:
             break;
     }
     
-    destination->type = source->type;
+    // free old string, array or hash (even if the type changes)
+    cb_value_free_content(destination);
+    *destination = content;
 }
 
 // -----------------------------------------------------------------------------
@@ -165,7 +212,25 @@ void cb_value_assign(const CbValue* source, CbValue* destination)
 // -----------------------------------------------------------------------------
 void cb_value_assign_and_free_source(CbValue* source, CbValue* destination)
 {
-    cb_value_assign(source, destination);
+    // an array or hash, which isn't shared, would be freed anyway -> take it
+    // over instead of copying it
+    if ((source->type == CB_VT_VALARRAY && !cb_array_is_shared(source->array)) ||
+        (source->type == CB_VT_HASH && !cb_hash_is_shared(source->hash)))
+    {
+        cb_value_free_content(destination);
+        
+        destination->type = source->type;
+        if (source->type == CB_VT_HASH)
+            destination->hash = source->hash;
+        else
+            destination->array = source->array;
+        
+        // keep the source from freeing it
+        source->type = CB_VT_UNDEFINED;
+    }
+    else
+        cb_value_assign(source, destination);
+    
     cb_value_free(source);
 }
 
@@ -180,6 +245,43 @@ CbValue* cb_value_copy(const CbValue* val)
     return copy;
 }
 
+// -----------------------------------------------------------------------------
+// copy a codeblock-value struct, but share its array or hash instead of
+// copying it
+//
+//    Used for temporary values, e.g. when a variable is evaluated. Changing the
+//    elements of the shared array affects the original value as well.
+// -----------------------------------------------------------------------------
+CbValue* cb_value_share(const CbValue* val)
+{
+    if (val->type == CB_VT_VALARRAY)
+        return cb_valarray_create(cb_array_share(val->array));
+    else if (val->type == CB_VT_HASH)
+        return cb_valhash_create(cb_hash_share(val->hash));
+    else
+        return cb_value_copy(val);
+}
+
+// -----------------------------------------------------------------------------
+// make sure, that the array or hash of a value isn't shared with any other
+// value (necessary before a value is stored, e.g. as an array element)
+// -----------------------------------------------------------------------------
+void cb_value_detach(CbValue* val)
+{
+    if (val->type == CB_VT_VALARRAY && cb_array_is_shared(val->array))
+    {
+        CbArray* array = cb_array_copy(val->array);
+        cb_array_free(val->array);
+        val->array = array;
+    }
+    else if (val->type == CB_VT_HASH && cb_hash_is_shared(val->hash))
+    {
+        CbHash* hash = cb_hash_copy(val->hash);
+        cb_hash_free(val->hash);
+        val->hash = hash;
+    }
+}
+
 // -----------------------------------------------------------------------------
 // convert a codeblock-value into a string
 // IMPORTANT:    the c-string must be freed after usage, since allocation occurs
@@ -187,88 +289,123 @@ CbValue* cb_value_copy(const CbValue* val)
 // -----------------------------------------------------------------------------
 char* cb_value_to_string(const CbValue* val)
 {
-    assert(val);
+    CbStrbuf buf;
+    cb_strbuf_init(&buf);
+    cb_value_format(&buf, val);
     
-    char* result_buf;
+    return cb_strbuf_detach(&buf);
+}
+
+// -----------------------------------------------------------------------------
+// format a codeblock-value into a string buffer
+// -----------------------------------------------------------------------------
+void cb_value_format(CbStrbuf* buf, const CbValue* val)
+{
+    assert(val);
     
     switch (val->type)
     {
         case CB_VT_NUMERIC:
-            // allocate 128 bytes buffer
-            result_buf = malloc(128);
-            sprintf(result_buf, "%d", val->value);
+            if (val->is_float)
+            {
+                char number[32]; // sufficient for doubles
+                cb_float_format(number, sizeof(number), val->real);
+                cb_strbuf_append_string(buf, number);
+            }
+            else
+                cb_strbuf_append_integer(buf, val->value);
+            
             break;
         
         case CB_VT_BOOLEAN:
             if (val->boolean)
-                result_buf = strdup(CB_BOOLEAN_TRUE_STR);
+                cb_strbuf_append_string(buf, CB_BOOLEAN_TRUE_STR);
             else
-                result_buf = strdup(CB_BOOLEAN_FALSE_STR);
+                cb_strbuf_append_string(buf, CB_BOOLEAN_FALSE_STR);
             
             break;
         
         case CB_VT_STRING:
-            result_buf = strdup(val->string);
+            cb_strbuf_append_string(buf, val->string);
             break;
         
         case CB_VT_UNDEFINED:
-            result_buf = strdup(NO_VALUE_AS_STRING);
+            cb_strbuf_append_string(buf, NO_VALUE_AS_STRING);
             break;
         
         case CB_VT_VALARRAY:
         {
-            // allocate memory for "{}" (including null termination)
-            result_buf  = (char*) malloc(2);
-            *result_buf = '\0';      // terminate string
-            strcat(result_buf, "{"); // open array
+            cb_strbuf_append_char(buf, '{'); // open array
             
-            int i             = 0;
-            int count         = cb_array_get_count(val->array);
-            bool last_element = false;
+            size_t i     = 0;
+            size_t count = cb_array_get_count(val->array);
+            
+            // packed integers are formatted without creating element values
+            if (cb_array_get_layout(val->array) == CB_ARRAY_LAYOUT_NUMERIC)
+            {
+                const CbNumeric* data = cb_array_get_numeric_data(val->array);
+                for (; i < count; i++)
+                {
+                    if (i > 0)
+                        cb_strbuf_append_char(buf, ',');
+                    
+                    cb_strbuf_append_integer(buf, data[i]);
+                }
+            }
+            
+            // packed booleans are formatted from temporary element values
+            bool packed = (cb_array_get_layout(val->array) !=
+                           CB_ARRAY_LAYOUT_BOXED);
             
             for (; i < count; i++)
             {
                 CbValue* item = NULL;
-                cb_array_get(val->array, i, (CbArrayItem*) &item);
-                char* value_string = NULL;
-                
-                if (item == NULL)
-                    value_string = "<NIL>";
+                if (packed)
+                    item = cb_array_get_value(val->array, i);
                 else
-                    value_string = cb_value_to_string(item);
-                
-                int n = 2;
+                    cb_array_get(val->array, i, (CbArrayItem*) &item);
                 
-                // check if there are still elements left
-                last_element = (i == count - 1);
-                if (last_element)
-                    n = 1;
-                
-                // if item is a string...
-                bool string_value = item->type == CB_VT_STRING;
-                if (string_value)
-                    n += 2; // increase memory by 2
-                
-                result_buf = realloc(result_buf, strlen(result_buf) +
-                                                 strlen(value_string) + n);
-                
-                if (string_value)
-                    strcat(result_buf, "\""); // add additional double quotes
-                
-                strcat(result_buf, value_string);
-                free(value_string); // free temporary value_string
+                if (i > 0)
+                    // append additional comma for further elements
+                    cb_strbuf_append_char(buf, ',');
                 
-                if (string_value)
-                    strcat(result_buf, "\""); // add additional double quotes
+                if (item == NULL)
+                    cb_strbuf_append_string(buf, "<NIL>");
+                else
+                    cb_value_format_element(buf, item);
                 
-                if (!last_element)
-                    // append additional comma for further elements
-                    strcat(result_buf, ",");
+                if (packed && item)
+                    cb_value_free(item);
             }
             
-            result_buf = realloc(result_buf, strlen(result_buf) + 2);
-            strcat(result_buf, "}"); // close array
+            cb_strbuf_append_char(buf, '}'); // close array
+            break;
+        }
+        
+        case CB_VT_HASH:
+        {
+            // open hash, an empty hash is written as "{=>}"
+            if (cb_hash_get_count(val->hash) > 0)
+                cb_strbuf_append_char(buf, '{');
+            else
+                cb_strbuf_append_string(buf, "{=>");
+            
+            size_t position    = 0;
+            const CbValue* key = NULL;
+            CbValue* item      = NULL;
+            bool first         = true;
+            while (cb_hash_iterate(val->hash, &position, &key, &item))
+            {
+                if (!first)
+                    cb_strbuf_append_char(buf, ',');
+                
+                cb_value_format_element(buf, key);
+                cb_strbuf_append_string(buf, "=>");
+                cb_value_format_element(buf, item);
+                first = false;
+            }
             
+            cb_strbuf_append_char(buf, '}'); // close hash
             break;
         }
         
@@ -276,8 +413,6 @@ char* cb_value_to_string(const CbValue* val)
             assert(("Invalid value type", false));
             break;
     }
-    
-    return result_buf;
 }
 
 // -----------------------------------------------------------------------------
@@ -285,9 +420,15 @@ char* cb_value_to_string(const CbValue* val)
 // -----------------------------------------------------------------------------
 void cb_value_print(const CbValue* val)
 {
-    char* string = cb_value_to_string(val);
-    printf("%s", string);
-    free(string);
+    // the value is streamed to stdout through a buffer on the stack, so even
+    // large arrays are printed without an intermediate string
+    char storage[4096];
+    CbStrbuf buf;
+    cb_strbuf_init_stream(&buf, storage, sizeof(storage), cb_value_print_flush,
+                          stdout);
+    
+    cb_value_format(&buf, val);
+    cb_strbuf_release(&buf);
 }
 
 // -----------------------------------------------------------------------------
@@ -295,9 +436,41 @@ void cb_value_print(const CbValue* val)
 // -----------------------------------------------------------------------------
 CbNumeric cb_numeric_get(const CbValue* val)
 {
+    // floats are truncated, values out of range are saturated
+    if (val->is_float)
+    {
+        if (val->real != val->real) // NaN
+            return 0;
+        if (val->real >= 9223372036854775808.0)
+            return INT64_MAX;
+        if (val->real < -9223372036854775808.0)
+            return INT64_MIN;
+        
+        return (CbNumeric) val->real;
+    }
+    
     return val->value;
 }
 
+// -----------------------------------------------------------------------------
+// get numeric value as float
+// -----------------------------------------------------------------------------
+CbFloat cb_numeric_get_float(const CbValue* val)
+{
+    if (val->is_float)
+        return val->real;
+    
+    return (CbFloat) val->value;
+}
+
+// -----------------------------------------------------------------------------
+// check if numeric value is stored as float
+// -----------------------------------------------------------------------------
+bool cb_numeric_is_float(const CbValue* val)
+{
+    return val->is_float;
+}
+
 // -----------------------------------------------------------------------------
 // set numeric value
 // -----------------------------------------------------------------------------
@@ -305,7 +478,52 @@ void cb_numeric_set(CbValue* val, CbNumeric value)
 {
     assert(cb_value_is_type(val, CB_VT_NUMERIC));
     
-    val->value = value;
+    val->is_float = false;
+    val->value    = value;
+}
+
+// -----------------------------------------------------------------------------
+// set numeric value as float
+// -----------------------------------------------------------------------------
+void cb_numeric_set_float(CbValue* val, CbFloat value)
+{
+    assert(cb_value_is_type(val, CB_VT_NUMERIC));
+    
+    val->is_float = true;
+    val->real     = value;
+}
+
+// -----------------------------------------------------------------------------
+// negate numeric value
+// -----------------------------------------------------------------------------
+void cb_numeric_negate(CbValue* val)
+{
+    assert(cb_value_is_type(val, CB_VT_NUMERIC));
+    
+    if (val->is_float)
+        val->real = - val->real;
+    else if (val->value == INT64_MIN) // can't be negated as integer
+        cb_numeric_set_float(val, - (CbFloat) val->value);
+    else
+        val->value = - val->value;
+}
+
+// -----------------------------------------------------------------------------
+// parse a numeric value from a string
+//
+//    Decimal fractions, exponents and integers out of the 64-bit range result
+//    in a float.
+// -----------------------------------------------------------------------------
+CbValue* cb_numeric_parse(const char* string)
+{
+    char* end       = NULL;
+    errno           = 0;
+    CbNumeric value = strtoll(string, &end, 10);
+    
+    if (*end == '.' || *end == 'e' || *end == 'E' || errno == ERANGE)
+        return cb_float_create(strtod(string, NULL));
+    
+    return cb_numeric_create(value);
 }
 
 // -----------------------------------------------------------------------------
@@ -319,6 +537,25 @@ CbValue* cb_numeric_compare(enum cb_comparison_type type, const CbValue* l,
     
     CbValue* result = cb_boolean_create(false);
     
+    // compare as floats, as soon as one operand is a float
+    if (l->is_float || r->is_float)
+    {
+        CbFloat lf = cb_numeric_get_float(l);
+        CbFloat rf = cb_numeric_get_float(r);
+        
+        switch (type)
+        {
+            case CMP_EQ: result->boolean = lf == rf; break;
+            case CMP_NE: result->boolean = lf != rf; break;
+            case CMP_GE: result->boolean = lf >= rf; break;
+            case CMP_LE: result->boolean = lf <= rf; break;
+            case CMP_GT: result->boolean = lf > rf; break;
+            case CMP_LT: result->boolean = lf < rf; break;
+        }
+        
+        return result;
+    }
+    
     switch (type)
     {
         case CMP_EQ: result->boolean = l->value == r->value; break;
@@ -364,6 +601,75 @@ CbValue* cb_numeric_div(CbValue* l, CbValue* r)
     return cb_numeric_operation(OPR_DIV, l, r);
 }
 
+// -----------------------------------------------------------------------------
+// apply a numerical operation to the left operand, which is replaced by the
+// result
+//
+//    Saves allocating the result, if the left operand is a temporary value. A
+//    division by zero leaves an empty value and throws the error, so the
+//    operands have to be pushed as temporaries (see cb_error_throw()).
+// -----------------------------------------------------------------------------
+void cb_numeric_apply(enum cb_operation_type type, CbValue* l,
+                      const CbValue* r)
+{
+    assert(cb_value_is_type(l, CB_VT_NUMERIC));
+    assert(cb_value_is_type(r, CB_VT_NUMERIC));
+    
+    // bitwise operations are defined for integers only
+    if ((l->is_float || r->is_float) && type != OPR_AND && type != OPR_OR)
+    {
+        cb_float_apply(type, l, cb_numeric_get_float(l),
+                       cb_numeric_get_float(r));
+        return;
+    }
+    
+    CbNumeric a      = cb_numeric_get(l);
+    CbNumeric b      = cb_numeric_get(r);
+    CbNumeric result = 0;
+    bool overflow    = false;
+    
+    switch (type)
+    {
+        case OPR_ADD:
+            overflow = __builtin_add_overflow(a, b, &result);
+            break;
+        case OPR_SUB:
+            overflow = __builtin_sub_overflow(a, b, &result);
+            break;
+        case OPR_MUL:
+            overflow = __builtin_mul_overflow(a, b, &result);
+            break;
+        case OPR_DIV:
+            if (b == 0) // check for division by zero first!
+            {
+                cb_error_set(CB_ERR_CODE_DIVISIONBYZERO);
+                l->type     = CB_VT_UNDEFINED; // empty value
+                l->is_float = false;
+                cb_error_throw();
+                return;
+            }
+            
+            // the result stays an integer, if the division has no remainder
+            overflow = (b == -1 && a == INT64_MIN) || (a % b != 0);
+            if (!overflow)
+                result = a / b;
+            
+            break;
+        case OPR_AND: result = a & b; break;
+        case OPR_OR:  result = a | b; break;
+        default:      break;
+    }
+    
+    // the result doesn't fit into an integer -> promote to float
+    if (overflow)
+    {
+        cb_float_apply(type, l, (CbFloat) a, (CbFloat) b);
+        return;
+    }
+    
+    cb_numeric_set(l, result);
+}
+
 // -----------------------------------------------------------------------------
 // binary AND for numerical values
 // -----------------------------------------------------------------------------
@@ -388,7 +694,7 @@ CbValue* cb_numeric_not(CbValue* operand)
     assert(cb_value_is_type(operand, CB_VT_NUMERIC));
     
     // IMPORTANT: Use bitwise negation (~) !
-    return cb_numeric_create(~ operand->value);
+    return cb_numeric_create(~ cb_numeric_get(operand));
 }
 
 // -----------------------------------------------------------------------------
@@ -435,14 +741,24 @@ CbValue* cb_string_compare(enum cb_comparison_type type, const CbValue* l,
 
 // -----------------------------------------------------------------------------
 // concatenate strings
+//
+//    Exceeding the memory quota throws the error, so the operands have to be
+//    pushed as temporaries.
 // -----------------------------------------------------------------------------
 CbValue* cb_string_concat(CbValue* l, CbValue* r)
 {
     assert(cb_value_is_type(l, CB_VT_STRING));
     assert(cb_value_is_type(r, CB_VT_STRING));
     
-    char* buffer = (char*) malloc(strlen(l->string) +
-                                  strlen(r->string) + 1);
+    size_t length_l = strlen(l->string);
+    size_t length_r = strlen(r->string);
+    if (!cb_alloc_reserve((double) length_l + length_r + 1))
+    {
+        cb_error_throw(); // the memory quota would be exceeded
+        return NULL;
+    }
+    
+    char* buffer = (char*) malloc(length_l + length_r + 1);
     *buffer = '\0';    // terminate string
     strcat(buffer, l->string);
     strcat(buffer, r->string);
@@ -459,6 +775,16 @@ CbBoolean cb_boolean_get(const CbValue* val)
     return val->boolean;
 }
 
+// -----------------------------------------------------------------------------
+// set boolean value
+// -----------------------------------------------------------------------------
+void cb_boolean_set(CbValue* val, CbBoolean boolean)
+{
+    assert(cb_value_is_type(val, CB_VT_BOOLEAN));
+    
+    val->boolean = boolean;
+}
+
 // -----------------------------------------------------------------------------
 // boolean comparison
 // -----------------------------------------------------------------------------
@@ -531,6 +857,7 @@ const CbValArray cb_valarray_get(const CbValue* val)
 
 // -----------------------------------------------------------------------------
 // get array element
+// (the returned value is owned by the caller, see cb_array_get_value())
 // -----------------------------------------------------------------------------
 CbValue* cb_valarray_get_element(const CbValue* val, int index)
 {
@@ -539,11 +866,7 @@ CbValue* cb_valarray_get_element(const CbValue* val, int index)
 #ifndef _CBC_ARRAY_INDEX_STARTS_WITH_ZERO
     index--;
 #endif // not _CBC_ARRAY_INDEX_
-    CbValue* element = NULL;
-    if (cb_array_get(val->array, index, (CbArrayItem*) &element))
-        return element;
-    else
-        return NULL;
+    return cb_array_get_value(val->array, index);
 }
 
 // -----------------------------------------------------------------------------
@@ -560,6 +883,16 @@ bool cb_valarray_set_element(const CbValue* val, int index,
     return cb_array_set(val->array, index, (const CbArrayItem) element);
 }
 
+// -----------------------------------------------------------------------------
+// get hash
+// -----------------------------------------------------------------------------
+const CbValHash cb_valhash_get(const CbValue* val)
+{
+    assert(cb_value_is_type(val, CB_VT_HASH));
+    
+    return val->hash;
+}
+
 
 // #############################################################################
 // internal functions
@@ -571,32 +904,43 @@ bool cb_valarray_set_element(const CbValue* val, int index,
 static CbValue* cb_numeric_operation(enum cb_operation_type type, CbValue* l,
                                      CbValue* r)
 {
-    assert(cb_value_is_type(l, CB_VT_NUMERIC));
-    assert(cb_value_is_type(r, CB_VT_NUMERIC));
+    // the result is allocated afterwards, since a division by zero throws
+    CbValue value = *l; // numeric values don't own any memory
+    cb_numeric_apply(type, &value, r);
     
-    CbValue* result = cb_numeric_create(0);
+    CbValue* result = cb_value_create();
+    *result         = value;
     
+    return result;
+}
+
+// -----------------------------------------------------------------------------
+// numerical operation with floats, which replaces a value (internal)
+// -----------------------------------------------------------------------------
+static void cb_float_apply(enum cb_operation_type type, CbValue* val,
+                           CbFloat l, CbFloat r)
+{
     switch (type)
     {
-        case OPR_ADD: result->value = l->value + r->value; break;
-        case OPR_SUB: result->value = l->value - r->value; break;
-        case OPR_MUL: result->value = l->value * r->value; break;
+        case OPR_ADD: cb_numeric_set_float(val, l + r); break;
+        case OPR_SUB: cb_numeric_set_float(val, l - r); break;
+        case OPR_MUL: cb_numeric_set_float(val, l * r); break;
         case OPR_DIV:
-            if (r->value == 0) // check for division by zero first!
+            if (r == 0) // check for division by zero first!
             {
                 cb_error_set(CB_ERR_CODE_DIVISIONBYZERO);
-                cb_value_free(result);      // free previously allocated value
-                result = cb_value_create(); // assign empty value
+                val->type     = CB_VT_UNDEFINED; // empty value
+                val->is_float = false;
+                cb_error_throw();
                 break;
             }
             
-            result->value = l->value / r->value;
+            cb_numeric_set_float(val, l / r);
+            break;
+        default:
+            assert(("Invalid float operation", false));
             break;
-        case OPR_AND: result->value = l->value & r->value; break;
-        case OPR_OR:  result->value = l->value | r->value; break;
     }
-    
-    return result;
 }
 
 // -----------------------------------------------------------------------------
@@ -618,3 +962,68 @@ static CbValue* cb_boolean_operation(enum cb_operation_type type, CbValue* l,
     
     return result;
 }
+
+// -----------------------------------------------------------------------------
+// format a float with the shortest representation, that reads back exactly
+// (internal)
+//
+//    15 significant digits are always exact for the decimal value, 17 digits
+//    always read back exactly.
+// -----------------------------------------------------------------------------
+static void cb_float_format(char* buffer, size_t size, CbFloat value)
+{
+    int precision = 15;
+    for (; precision < 17; precision++)
+    {
+        snprintf(buffer, size, "%.*g", precision, value);
+        if (strtod(buffer, NULL) == value)
+            return;
+    }
+    
+    snprintf(buffer, size, "%.17g", value);
+}
+
+// -----------------------------------------------------------------------------
+// format an array element or a hash key/value (internal)
+//
+//    Strings are enclosed in double quotes.
+// -----------------------------------------------------------------------------
+static void cb_value_format_element(CbStrbuf* buf, const CbValue* val)
+{
+    if (val->type != CB_VT_STRING)
+    {
+        cb_value_format(buf, val);
+        return;
+    }
+    
+    cb_strbuf_append_char(buf, '"');
+    cb_strbuf_append_string(buf, val->string);
+    cb_strbuf_append_char(buf, '"');
+}
+
+// -----------------------------------------------------------------------------
+// flush-function of cb_value_print() (internal)
+// -----------------------------------------------------------------------------
+static void cb_value_print_flush(void* context, const char* data,
+                                 size_t length, const char* extra,
+                                 size_t extra_length)
+{
+    fwrite(data, 1, length, (FILE*) context);
+    if (extra_length > 0)
+        fwrite(extra, 1, extra_length, (FILE*) context);
+}
+
+// -----------------------------------------------------------------------------
+// free the string, array or hash of a codeblock-value (internal)
+// -----------------------------------------------------------------------------
+static void cb_value_free_content(CbValue* val)
+{
+    if (val->type == CB_VT_STRING && val->string)
+        cb_free(val->string, CB_ALLOC_STRING);
+    else if (val->type == CB_VT_VALARRAY && val->array)
+        cb_array_free(val->array);
+    else if (val->type == CB_VT_HASH && val->hash)
+        cb_hash_free(val->hash);
+    
+    val->type = CB_VT_UNDEFINED;
+}
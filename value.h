@@ -7,7 +7,8 @@
 
 
 #include <stdbool.h>
-#include "array.h"
+#include <stdint.h>
+#include "strbuf.h"
 
 #define CB_BOOLEAN_TRUE_STR  "True"
 #define CB_BOOLEAN_FALSE_STR "False"
@@ -19,7 +20,8 @@ enum cb_value_type
     CB_VT_NUMERIC,
     CB_VT_BOOLEAN,
     CB_VT_STRING,
-    CB_VT_VALARRAY
+    CB_VT_VALARRAY,
+    CB_VT_HASH
 };
 
 // operation-types
@@ -46,20 +48,30 @@ enum cb_comparison_type
 };
 
 // definition of codeblock-types
-typedef int             CbNumeric;
+// (numeric values are either 64-bit integers or double precision floats)
+typedef int64_t         CbNumeric;
+typedef double          CbFloat;
 typedef char*           CbString;
 typedef bool            CbBoolean;
 typedef struct CbArray* CbValArray;
+typedef struct CbHash*  CbValHash;
 
 // codeblock-value structure
 typedef struct CbValue CbValue;
 
+// NOTE: array.h and hash.h depend on the codeblock-types above, so they must
+//       not be included before they are defined.
+#include "array.h"
+#include "hash.h"
+
 // interface functions
 CbValue* cb_value_create();
 CbValue* cb_numeric_create(CbNumeric value);
+CbValue* cb_float_create(CbFloat value);
 CbValue* cb_boolean_create(CbBoolean boolean);
 CbValue* cb_string_create(CbString string);
 CbValue* cb_valarray_create(CbValArray array);
+CbValue* cb_valhash_create(CbValHash hash);
 void cb_value_free(CbValue* val);
 
 enum cb_value_type cb_value_get_type(const CbValue* val);
@@ -67,12 +79,20 @@ bool cb_value_is_type(const CbValue* val, enum cb_value_type type);
 void cb_value_assign(const CbValue* source, CbValue* destination);
 void cb_value_assign_and_free_source(CbValue* source, CbValue* destination);
 CbValue* cb_value_copy(const CbValue* val);
+CbValue* cb_value_share(const CbValue* val);
+void cb_value_detach(CbValue* val);
 char* cb_value_to_string(const CbValue* val);
+void cb_value_format(CbStrbuf* buf, const CbValue* val);
 void cb_value_print(const CbValue* val);
 
 // CbNumeric interface functions
 CbNumeric cb_numeric_get(const CbValue* val);
+CbFloat cb_numeric_get_float(const CbValue* val);
+bool cb_numeric_is_float(const CbValue* val);
 void cb_numeric_set(CbValue* val, CbNumeric value);
+void cb_numeric_set_float(CbValue* val, CbFloat value);
+void cb_numeric_negate(CbValue* val);
+CbValue* cb_numeric_parse(const char* string);
 CbValue* cb_numeric_compare(enum cb_comparison_type type, const CbValue* l,
                             const CbValue* r);
 CbValue* cb_numeric_add(CbValue* l, CbValue* r);
@@ -81,6 +101,8 @@ CbValue* cb_numeric_mul(CbValue* l, CbValue* r);
 CbValue* cb_numeric_div(CbValue* l, CbValue* r);
 CbValue* cb_numeric_and(CbValue* l, CbValue* r);
 CbValue* cb_numeric_or(CbValue* l, CbValue* r);
+void cb_numeric_apply(enum cb_operation_type type, CbValue* l,
+                      const CbValue* r);
 CbValue* cb_numeric_not(CbValue* operand);
 
 // CbString interface functions
@@ -91,6 +113,7 @@ CbValue* cb_string_concat(CbValue* l, CbValue* r);
 
 // CbBoolean interface functions
 CbBoolean cb_boolean_get(const CbValue* val);
+void cb_boolean_set(CbValue* val, CbBoolean boolean);
 CbValue* cb_boolean_compare(enum cb_comparison_type type, const CbValue* l,
                             const CbValue* r);
 CbValue* cb_boolean_and(CbValue* l, CbValue* r);
@@ -103,5 +126,8 @@ CbValue* cb_valarray_get_element(const CbValue* val, int index);
 bool cb_valarray_set_element(const CbValue* val, int index,
                              const CbValue* element);
 
+// CbValHash interface functions
+const CbValHash cb_valhash_get(const CbValue* val);
+
 
 #endif // VALUE_H